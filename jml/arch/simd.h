@@ -39,6 +39,22 @@ JML_ALWAYS_INLINE bool has_sse3() { return cpu_info().sse3; }
 
 JML_ALWAYS_INLINE bool has_pni() { return cpu_info().pni; }
 
+JML_ALWAYS_INLINE bool has_sse41() { return cpu_info().sse41; }
+
+JML_ALWAYS_INLINE bool has_sse42() { return cpu_info().sse42; }
+
+JML_ALWAYS_INLINE bool has_popcnt() { return cpu_info().popcnt; }
+
+JML_ALWAYS_INLINE bool has_avx()
+{
+    return cpu_info().avx && cpu_info().os_avx;
+}
+
+JML_ALWAYS_INLINE bool has_avx2()
+{
+    return cpu_info().avx2 && has_avx();
+}
+
 
 #endif // __i686__
 
@@ -17,6 +17,7 @@
 #include "jml/utils/exc_assert.h"
 
 #include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/operations.hpp>
 #include <ios>
 #include <vector>
 #include <cstring>
@@ -336,14 +337,15 @@ private:
         }
 
         pos = 0;
+        buffer.resize(head.blockSize());
 
         if (notCompressed) {
+            if (compressedSize > buffer.size())
+                throw lz4_error("malformed lz4 stream");
             std::memcpy(buffer.data(), compressed, compressedSize);
             toRead = compressedSize;
         }
         else {
-            buffer.resize(head.blockSize());
-
             auto decompressed = LZ4_decompress_safe(
                     compressed,     buffer.data(),
                     compressedSize, buffer.size());
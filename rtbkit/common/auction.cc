@@ -226,13 +226,13 @@ Auction::
 Auction(ExchangeConnector * exchangeConnector,
         HandleAuction handleAuction,
         std::shared_ptr<BidRequest> request,
-        const std::string & requestStr,
+        LazyString requestStr,
         const std::string & requestStrFormat,
         Date start,
         Date expiry)
     : isZombie(false), start(start), expiry(expiry),
       request(request),
-      requestStr(requestStr),
+      requestStr(std::move(requestStr)),
       requestStrFormat(requestStrFormat),
       exchangeConnector(exchangeConnector),
       handleAuction(handleAuction),
@@ -241,7 +241,8 @@ Auction(ExchangeConnector * exchangeConnector,
     ML::atomic_add(created, 1);
 
     this->id = request->auctionId;
-    this->requestSerialized = request->serializeToString();
+    this->requestSerialized = LazyString([=] { return request->serializeToString(); });
+    this->requestBinary = LazyString([=] { return request->toBinaryStr(); });
 }
 
 Auction::
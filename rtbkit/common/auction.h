@@ -14,6 +14,7 @@
 #include "rtbkit/common/account_key.h"
 #include "rtbkit/common/augmentation.h"
 #include "rtbkit/common/win_cost_model.h"
+#include "rtbkit/common/lazy_string.h"
 #include <boost/function.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include "soa/jsoncpp/json.h"
@@ -49,7 +50,7 @@ struct Auction : public std::enable_shared_from_this<Auction> {
     Auction(ExchangeConnector * exchangeConnector,
             HandleAuction handleAuction,
             std::shared_ptr<BidRequest> request,
-            const std::string & requestStr,
+            LazyString requestStr,
             const std::string & requestStrFormat,
             Date start,
             Date expiry);
@@ -70,15 +71,20 @@ struct Auction : public std::enable_shared_from_this<Auction> {
 
     Id id;
     std::shared_ptr<BidRequest>  request;
-    std::string requestStr;  ///< Stringified version of request
+    LazyString requestStr;  ///< Stringified version of request
     std::string requestStrFormat;  ///< Format of stringified request
-    std::string requestSerialized; ///< Serialized bid request (canonical)
+    LazyString requestSerialized; ///< Serialized bid request (canonical)
+    LazyString requestBinary;  ///< Binary JSON bid request (canonical)
     std::string requestOriginal;
 
     ///< AugmentationList for each augmentors.
     std::unordered_map<std::string, AugmentationList> augmentations;
     AgentAugmentations agentAugmentations; ///< per agent augmentations.
 
+    /** Per agent augmentations in binary JSON, for the agents that get
+        binary auction messages. */
+    AgentAugmentations agentAugmentationsBinary;
+
     /** How much time is still available for the auction (in seconds). */
     double timeAvailable(Date now = Date::now()) const;
 
@@ -26,7 +26,7 @@ SubmittedAuctionEvent::
 bidRequest() const
 {
     if (!bidRequest_)
-        bidRequest_.reset(BidRequest::parse(bidRequestStrFormat, bidRequestStr));
+        bidRequest_.reset(BidRequest::parse(bidRequestStrFormat, bidRequestStr.str()));
     return bidRequest_;
 }
 
@@ -43,7 +43,7 @@ serialize(ML::DB::Store_Writer & store) const
 {
     store << (unsigned char)0
           << auctionId << adSpotId << lossTimeout << augmentations
-          << bidRequestStr << bidResponse << bidRequestStrFormat;
+          << bidRequestStr.str() << bidResponse << bidRequestStrFormat;
 }
 
 void
@@ -55,18 +55,51 @@ reconstitute(ML::DB::Store_Reader & store)
     if (version != 0)
         throw ML::Exception("unknown SubmittedAuctionEvent type");
 
+    std::string requestStr;
     store >> auctionId >> adSpotId >> lossTimeout >> augmentations
-          >> bidRequestStr >> bidResponse >> bidRequestStrFormat;
+          >> requestStr >> bidResponse >> bidRequestStrFormat;
+    bidRequestStr = std::move(requestStr);
 
 }
 
+namespace {
+
+/** Renders the lazy request string only when the event is printed. */
+struct LazyStringDescription : public ValueDescriptionT<LazyString> {
+
+    LazyStringDescription()
+        : ValueDescriptionT<LazyString>(ValueKind::STRING)
+    {
+    }
+
+    virtual void parseJsonTyped(LazyString * val,
+                                JsonParsingContext & context) const
+    {
+        *val = context.expectStringUtf8().rawString();
+    }
+
+    virtual void printJsonTyped(const LazyString * val,
+                                JsonPrintingContext & context) const
+    {
+        context.writeStringUtf8(Datacratic::UnicodeString(val->str()));
+    }
+
+    virtual bool isDefaultTyped(const LazyString * val) const
+    {
+        return val->empty();
+    }
+};
+
+} // namespace anonymous
+
 SubmittedAuctionEventDescription::
 SubmittedAuctionEventDescription() {
     addField("auctionId", &SubmittedAuctionEvent::auctionId, "");
     addField("adSpotId", &SubmittedAuctionEvent::adSpotId, "");
     addField("lossTimeout", &SubmittedAuctionEvent::lossTimeout, "");
     addField("augmentation", &SubmittedAuctionEvent::augmentations, "");
-    addField("bidRequest", &SubmittedAuctionEvent::bidRequestStr, "");
+    addField("bidRequest", &SubmittedAuctionEvent::bidRequestStr, "",
+             new LazyStringDescription);
     addField("bidResponse", &SubmittedAuctionEvent::bidResponse, "");
     addField("bidRequestStrFormat", &SubmittedAuctionEvent::bidRequestStrFormat, "");
 }
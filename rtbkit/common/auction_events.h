@@ -19,6 +19,7 @@
 #include "bid_request.h"
 #include "currency.h"
 #include "json_holder.h"
+#include "lazy_string.h"
 #include "win_cost_model.h"
 
 
@@ -41,7 +42,7 @@ struct SubmittedAuctionEvent {
     std::shared_ptr<BidRequest> bidRequest() const;
     void bidRequest(std::shared_ptr<BidRequest> event);
 
-    Datacratic::UnicodeString bidRequestStr;     ///< Bid request as string on the wire
+    LazyString bidRequestStr;      ///< Bid request as string on the wire
     Auction::Response bidResponse; ///< Bid response that was sent
     std::string bidRequestStrFormat;  ///< Format of stringified request(i.e "datacratic")
 
@@ -0,0 +1,245 @@
+/* auction_message.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Binary encoding of the auction messages sent to the bidding agents.
+*/
+
+#include "auction_message.h"
+#include "jml/arch/exception.h"
+#include "jml/utils/exc_assert.h"
+
+
+using namespace std;
+using namespace ML;
+
+
+namespace RTBKIT {
+
+namespace {
+
+struct Reader {
+    Reader(const char * data, size_t size)
+        : pos(data), end(data + size)
+    {
+    }
+
+    int32_t read()
+    {
+        if (end - pos < (ssize_t)sizeof(int32_t))
+            throw ML::Exception("truncated binary spots");
+        int32_t result;
+        std::memcpy(&result, pos, sizeof(result));
+        pos += sizeof(result);
+        return result;
+    }
+
+    /** Reads a count of items of size itemSize that follow it. */
+    int32_t readCount(size_t itemSize)
+    {
+        int32_t result = read();
+        if (result < 0 || result * itemSize > size_t(end - pos))
+            throw ML::Exception("invalid count in binary spots");
+        return result;
+    }
+
+    const char * pos;
+    const char * end;
+};
+
+} // file scope
+
+
+/*****************************************************************************/
+/* BINARY AUCTION MESSAGE                                                    */
+/*****************************************************************************/
+
+Bids
+decodeBinarySpots(const char * data, size_t size)
+{
+    Reader reader(data, size);
+
+    Bids result;
+
+    // Each spot takes at least its index and number of creatives
+    int32_t numSpots = reader.readCount(2 * sizeof(int32_t));
+    result.reserve(numSpots);
+
+    for (int32_t i = 0;  i < numSpots;  ++i) {
+        Bid bid;
+        bid.spotIndex = reader.read();
+
+        int32_t numCreatives = reader.readCount(sizeof(int32_t));
+        bid.availableCreatives.reserve(numCreatives);
+        for (int32_t j = 0;  j < numCreatives;  ++j)
+            bid.availableCreatives.push_back(reader.read());
+
+        result.push_back(bid);
+    }
+
+    if (reader.pos != reader.end)
+        throw ML::Exception("extra data after binary spots");
+
+    return result;
+}
+
+
+/*****************************************************************************/
+/* WIN COST MODEL ENCODER                                                    */
+/*****************************************************************************/
+
+WinCostModelEncoder::
+WinCostModelEncoder(size_t maxModels)
+    : maxModels(maxModels)
+{
+    ExcAssertGreater(maxModels, 0);
+}
+
+void
+WinCostModelEncoder::
+encode(const WinCostModel & model,
+       const std::function<void (const std::string &)> & send)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    send(encodeLocked(model));
+}
+
+std::string
+WinCostModelEncoder::
+encode(const WinCostModel & model)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return encodeLocked(model);
+}
+
+namespace {
+
+uint64_t hashCombine(uint64_t hash, uint64_t value)
+{
+    return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+uint64_t hashString(uint64_t hash, const char * str)
+{
+    // FNV-1a
+    uint64_t result = 0xcbf29ce484222325ULL;
+    for (;  *str;  ++str)
+        result = (result ^ (unsigned char)*str) * 0x100000001b3ULL;
+    return hashCombine(hash, result);
+}
+
+/** Hash of the value that is consistent with its operator ==, computed
+    without allocating anything.  Numbers all hash as doubles.
+*/
+uint64_t hashJson(uint64_t hash, const Json::Value & val)
+{
+    hash = hashCombine(hash, val.isNumeric() ? Json::realValue : val.type());
+
+    switch (val.type()) {
+    case Json::nullValue:
+        return hash;
+    case Json::intValue:
+    case Json::uintValue:
+    case Json::realValue: {
+        double d = val.asDouble();
+        if (d == 0.0) d = 0.0;  // same hash for -0.0
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return hashCombine(hash, bits);
+    }
+    case Json::stringValue:
+        return hashString(hash, val.asCString());
+    case Json::booleanValue:
+        return hashCombine(hash, val.asBool());
+    case Json::arrayValue:
+    case Json::objectValue:
+        for (auto it = val.begin(), end = val.end();  it != end;  ++it) {
+            if (val.isObject())
+                hash = hashString(hash, it.memberNameC());
+            hash = hashJson(hash, *it);
+        }
+        return hash;
+    }
+
+    return hash;
+}
+
+} // file scope
+
+std::string
+WinCostModelEncoder::
+encodeLocked(const WinCostModel & model)
+{
+    uint64_t hash = hashJson(hashString(0, model.name.c_str()), model.data);
+
+    auto range = ids.equal_range(hash);
+    for (auto it = range.first;  it != range.second;  ++it) {
+        const Entry & entry = it->second;
+        if (entry.model.name != model.name || !(entry.model.data == model.data))
+            continue;
+
+        std::string result(sizeof(entry.id), '\0');
+        std::memcpy(&result[0], &entry.id, sizeof(entry.id));
+        return result;
+    }
+
+    if (ids.size() == maxModels)
+        ids.clear();
+    uint32_t id = ids.size();
+    ids.insert(make_pair(hash, Entry{ model, id }));
+
+    std::string json = model.toJson().toStringNoNewLine();
+    std::string result(sizeof(id) + json.size(), '\0');
+    std::memcpy(&result[0], &id, sizeof(id));
+    std::memcpy(&result[sizeof(id)], json.data(), json.size());
+
+    return result;
+}
+
+void
+WinCostModelEncoder::
+clear()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    ids.clear();
+}
+
+size_t
+WinCostModelEncoder::
+size() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return ids.size();
+}
+
+
+/*****************************************************************************/
+/* WIN COST MODEL DECODER                                                    */
+/*****************************************************************************/
+
+const WinCostModel &
+WinCostModelDecoder::
+decode(const char * data, size_t size)
+{
+    uint32_t id;
+    if (size < sizeof(id))
+        throw ML::Exception("invalid win cost model reference");
+    std::memcpy(&id, data, sizeof(id));
+
+    if (size > sizeof(id)) {
+        std::string json(data + sizeof(id), data + size);
+        WinCostModel model = WinCostModel::fromJson(Json::parse(json));
+
+        if (id > models.size())
+            throw ML::Exception("win cost model %u defined out of order", id);
+        if (id == models.size())
+            models.push_back(std::move(model));
+        else models[id] = std::move(model);
+    }
+
+    if (id >= models.size())
+        throw ML::Exception("unknown win cost model %u", id);
+
+    return models[id];
+}
+
+} // namespace RTBKIT
@@ -0,0 +1,164 @@
+/* auction_message.h                                               -*- C++ -*-
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Binary encoding of the auction messages sent to the bidding agents.
+*/
+
+#pragma once
+
+#include "rtbkit/common/bids.h"
+#include "rtbkit/common/win_cost_model.h"
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* BINARY AUCTION MESSAGE                                                    */
+/*****************************************************************************/
+
+/** Agents that send version 1.1 or later with their CONFIG message to the
+    router get an AUCTION_BINARY message instead of AUCTION.  It has the same
+    frames, but none of them needs to be parsed as text:
+
+        AUCTION_BINARY
+        timestamp        Date, in a binaryFrame()
+        auction id       Id, in a binaryFrame()
+        request format   as in AUCTION
+        bid request      as in AUCTION
+        spots            see encodeBinarySpots()
+        time left (ms)   double, in a binaryFrame()
+        augmentations    binary JSON
+        win cost model   see WinCostModelEncoder
+*/
+
+/** Encodes the biddable spots, a list of (spot index, [creative indexes])
+    pairs, as packed 32 bit integers in native byte order: the number of
+    spots then, for each spot, its index, its number of creatives and their
+    indexes.
+*/
+template<typename Spots>
+std::string encodeBinarySpots(const Spots & spots)
+{
+    size_t count = 1;
+    for (const auto & spot: spots)
+        count += 2 + spot.second.size();
+
+    std::string result(count * sizeof(int32_t), '\0');
+    char * out = &result[0];
+
+    auto write = [&] (int32_t val)
+        {
+            std::memcpy(out, &val, sizeof(val));
+            out += sizeof(val);
+        };
+
+    write(spots.size());
+    for (const auto & spot: spots) {
+        write(spot.first);
+        write(spot.second.size());
+        for (int creative: spot.second)
+            write(creative);
+    }
+
+    return result;
+}
+
+/** Returns a bid for each spot encoded by encodeBinarySpots(), with its
+    spotIndex and availableCreatives set.
+*/
+Bids decodeBinarySpots(const char * data, size_t size);
+
+inline Bids decodeBinarySpots(const std::string & data)
+{
+    return decodeBinarySpots(data.data(), data.size());
+}
+
+
+/*****************************************************************************/
+/* WIN COST MODEL ENCODER                                                    */
+/*****************************************************************************/
+
+/** Sends references to win cost models rather than the models themselves,
+    which rarely change from one auction to the next.
+
+    Each distinct model gets an id.  The frame is that id as a native 32 bit
+    integer, followed by the JSON of the model the first time that it's sent
+    so that the receiver can cache it.  Models are recognized by a hash of
+    their name and data, so their JSON is only generated when they're first
+    defined.  The encoder must be cleared whenever the receiver may have
+    missed definitions, ie when it connects again; the receiver replaces the
+    definitions it already had as new ones arrive.
+
+    At most maxModels ids are given out.  Once they're all taken, the ids
+    are given out again from 0 and their new models are sent with their
+    definition, which replaces the previous one on the receiving end.
+
+    Thread safe.
+*/
+
+struct WinCostModelEncoder {
+
+    WinCostModelEncoder(size_t maxModels = 1024);
+
+    /** Calls send with the frame for the model.  The encoder is locked
+        during the call, so that the frame that defines a model is always
+        sent before the ones that refer to it.
+    */
+    void encode(const WinCostModel & model,
+                const std::function<void (const std::string &)> & send);
+
+    std::string encode(const WinCostModel & model);
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    size_t maxModels;
+    mutable std::mutex lock;
+
+    struct Entry {
+        WinCostModel model;
+        uint32_t id;
+    };
+
+    /// Models that were given an id, keyed on the hash of their contents
+    std::unordered_multimap<uint64_t, Entry> ids;
+
+    std::string encodeLocked(const WinCostModel & model);
+};
+
+
+/*****************************************************************************/
+/* WIN COST MODEL DECODER                                                    */
+/*****************************************************************************/
+
+/** Receiving end of a WinCostModelEncoder. */
+
+struct WinCostModelDecoder {
+
+    /** Returns the model referenced by the frame, caching its definition if
+        it has one.  Throws an ML::Exception if it references a model that
+        was never defined.
+    */
+    const WinCostModel & decode(const char * data, size_t size);
+
+    const WinCostModel & decode(const std::string & data)
+    {
+        return decode(data.data(), data.size());
+    }
+
+    void clear() { models.clear(); }
+
+private:
+    std::vector<WinCostModel> models;
+};
+
+} // namespace RTBKIT
@@ -185,4 +185,40 @@ fromJson(const Json::Value& json)
     return list;
 }
 
+
+/******************************************************************************/
+/* AUGMENTATION CACHE CONFIG                                                  */
+/******************************************************************************/
+
+Json::Value
+AugmentationCacheConfig::
+toJson() const
+{
+    Json::Value json;
+    json["ttl"] = ttl;
+
+    Json::Value& domains = json["keyDomains"];
+    domains = Json::Value(Json::arrayValue);
+    for (const auto& domain : keyDomains)
+        domains.append(domain);
+
+    return json;
+}
+
+AugmentationCacheConfig
+AugmentationCacheConfig::
+fromJson(const Json::Value& json)
+{
+    AugmentationCacheConfig config;
+
+    if (json.isMember("ttl"))
+        config.ttl = json["ttl"].asDouble();
+
+    const Json::Value& domains = json["keyDomains"];
+    for (auto it = domains.begin(), end = domains.end(); it != end; ++it)
+        config.keyDomains.push_back(it->asString());
+
+    return config;
+}
+
 } // namespace RTBKIT
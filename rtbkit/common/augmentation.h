@@ -14,6 +14,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 namespace RTBKIT {
 
@@ -87,6 +88,37 @@ struct AugmentationList : public AugmentationListBase
 };
 
 
+
+/******************************************************************************/
+/* AUGMENTATION CACHE CONFIG                                                  */
+/******************************************************************************/
+
+/** Declared by an augmentor in its CONFIG message to let the router cache its
+    responses.  A response is reused for any auction with the same ids in each
+    of the keyDomains of its UserIds (eg. "prov" or "xchg") and asked for the
+    same agents, for ttl seconds after it was received.
+
+    Caching is disabled unless both a positive ttl and key domains are given.
+ */
+struct AugmentationCacheConfig
+{
+    AugmentationCacheConfig() : ttl(0.0) {}
+
+    AugmentationCacheConfig(
+            double ttl, const std::vector<std::string>& keyDomains) :
+        ttl(ttl), keyDomains(keyDomains)
+    {}
+
+    double ttl;
+    std::vector<std::string> keyDomains;
+
+    bool enabled() const { return ttl > 0.0 && !keyDomains.empty(); }
+
+    Json::Value toJson() const;
+    static AugmentationCacheConfig fromJson(const Json::Value& json);
+};
+
+
 } // namespace RTBKIT
 
 #endif // __rtb__augmentation_h__
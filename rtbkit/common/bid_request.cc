@@ -15,6 +15,7 @@
 #include "jml/db/persistent.h"
 #include "rtbkit/openrtb/openrtb_parsing.h"
 #include "soa/types/json_printing.h"
+#include "soa/types/binary_json.h"
 #include "soa/service/json_codec.h"
 
 
@@ -982,6 +983,18 @@ toJsonStr() const
     //return boost::trim_copy(toJson().toString());
 }
 
+std::string
+BidRequest::
+toBinaryStr() const
+{
+    static const DefaultDescription<BidRequest> BidRequestDesc;
+
+    std::string result;
+    BinaryJsonPrintingContext context(result);
+    BidRequestDesc.printJson(this, context);
+    return result;
+}
+
 template<typename T>
 void fromJsonOptional(const Json::Value & val,
                       std::unique_ptr<T> & ptr,
@@ -1118,8 +1131,7 @@ struct CanonicalParser {
 #endif
 
         //cerr << "parsing " << str << endl;
-        StreamingJsonParsingContext context;
-        context.init("bid request", str.c_str(), str.size());
+        IndexedJsonParsingContext context(str, "bid request");
         auto_ptr<BidRequest> result(new BidRequest());
         BidRequestDesc.parseJsonTyped(result.get(), context);
 
@@ -1130,12 +1142,24 @@ struct CanonicalParser {
     }
 };
 
+struct BinaryParser {
+
+    static BidRequest * parse(const std::string & str)
+    {
+        BinaryJsonParsingContext context(str);
+        auto_ptr<BidRequest> result(new BidRequest());
+        BidRequestDesc.parseJsonTyped(result.get(), context);
+        return result.release();
+    }
+};
+
 struct AtInit {
     AtInit()
     {
         PluginInterface<BidRequest>::registerPlugin("recoset", CanonicalParser::parse);
         PluginInterface<BidRequest>::registerPlugin("datacratic", CanonicalParser::parse);
         PluginInterface<BidRequest>::registerPlugin("rtbkit", CanonicalParser::parse);
+        PluginInterface<BidRequest>::registerPlugin("datacratic-bin", BinaryParser::parse);
     }
 } atInit;
 } // file scope
@@ -1148,10 +1172,14 @@ parse(const std::string & source, const std::string & bidRequest)
         throw ML::Exception("'source' parameter cannot be empty");
     }
 
+    if (BinaryJson::isBinaryJson(bidRequest.c_str(), bidRequest.size()))
+        return BinaryParser::parse(bidRequest);
+
     if (source == "datacratic" || strncmp(bidRequest.c_str(), "{\"!!CV\":", 8) == 0)
     {
         return CanonicalParser::parse(bidRequest);
     }
+
     Parser parser = PluginInterface<BidRequest>::getPlugin(source);
 
     //cerr << "got parser for source " << source << endl;
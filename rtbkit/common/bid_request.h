@@ -367,6 +367,13 @@ struct BidRequest {
     /** Return a canonical stringified JSON version of the bid request. */
     std::string toJsonStr() const;
 
+    /** Return the canonical bid request in the binary JSON encoding.  It
+        carries exactly the same information as toJsonStr() but is smaller
+        and much cheaper to parse.  It can be read back with parse() using
+        the "datacratic-bin" source.
+    */
+    std::string toBinaryStr() const;
+
     /** Create a new BidRequest from a canonical JSON value. */
     static BidRequest createFromJson(const Json::Value & json);
 
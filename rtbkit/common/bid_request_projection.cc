@@ -0,0 +1,149 @@
+/* bid_request_projection.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Subset of the fields of a bid request.
+*/
+
+#include "bid_request_projection.h"
+#include "soa/types/binary_json.h"
+#include <boost/algorithm/string.hpp>
+
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+
+
+namespace RTBKIT {
+
+namespace {
+
+const ValueDescription & bidRequestDescription()
+{
+    static const DefaultDescription<BidRequest> desc;
+    return desc;
+}
+
+/** Description of the value held by a field, looking through optionals. */
+const ValueDescription & valueDescription(const ValueDescription & desc)
+{
+    if (desc.kind == ValueKind::OPTIONAL)
+        return desc.contained();
+    return desc;
+}
+
+} // file scope
+
+
+/*****************************************************************************/
+/* BID REQUEST PROJECTION                                                    */
+/*****************************************************************************/
+
+BidRequestProjection::
+BidRequestProjection(const std::vector<std::string> & fields)
+    : fields_(fields)
+{
+    for (const auto & field: fields) {
+        std::vector<std::string> path;
+        boost::split(path, field, boost::is_any_of("."));
+
+        Node * node = &root;
+        const ValueDescription * desc = &bidRequestDescription();
+
+        for (unsigned i = 0;  i < path.size();  ++i) {
+            if (node->whole) break;
+
+            if (desc->kind != ValueKind::STRUCTURE)
+                throw ML::Exception("can't project field '%s' of '%s': "
+                                    "not a structure",
+                                    path[i].c_str(), field.c_str());
+
+            const FieldDescription * fd = desc->hasField(nullptr, path[i]);
+            if (!fd)
+                throw ML::Exception("can't project field '%s' of '%s': "
+                                    "no such field in the bid request",
+                                    path[i].c_str(), field.c_str());
+
+            Node * child = nullptr;
+            for (auto & c: node->children) {
+                if (c.field == fd) {
+                    child = &c;
+                    break;
+                }
+            }
+
+            if (!child) {
+                node->children.emplace_back();
+                child = &node->children.back();
+                child->field = fd;
+            }
+
+            node = child;
+            desc = &valueDescription(*fd->description);
+        }
+
+        // Selecting a whole field overrides any of its subfields
+        node->whole = true;
+        node->children.clear();
+    }
+}
+
+std::string
+BidRequestProjection::
+project(const BidRequest & request) const
+{
+    std::string result;
+    BinaryJsonPrintingContext context(result);
+    print(&request, root, context);
+    return result;
+}
+
+void
+BidRequestProjection::
+print(const void * value,
+      const Node & node,
+      JsonPrintingContext & context) const
+{
+    context.startObject();
+
+    for (const auto & child: node.children) {
+        const FieldDescription & fd = *child.field;
+        const void * member = addOffset(value, fd.offset);
+        if (fd.description->isDefault(member))
+            continue;
+
+        context.startField(fd.fieldName.c_str(), fd.fieldTag);
+
+        if (child.whole)
+            fd.description->printJson(member, context);
+        else {
+            if (fd.description->kind == ValueKind::OPTIONAL)
+                member = fd.description->optionalGetValue(member);
+            print(member, child, context);
+        }
+    }
+
+    context.endObject();
+}
+
+Json::Value
+BidRequestProjection::
+toJson() const
+{
+    Json::Value result(Json::arrayValue);
+    for (const auto & field: fields_)
+        result.append(field);
+    return result;
+}
+
+BidRequestProjection
+BidRequestProjection::
+fromJson(const Json::Value & json)
+{
+    std::vector<std::string> fields;
+    for (auto it = json.begin(), end = json.end();  it != end;  ++it)
+        fields.push_back(it->asString());
+    return BidRequestProjection(fields);
+}
+
+} // namespace RTBKIT
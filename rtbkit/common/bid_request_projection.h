@@ -0,0 +1,71 @@
+/* bid_request_projection.h                                        -*- C++ -*-
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Subset of the fields of a bid request.
+*/
+
+#pragma once
+
+#include "rtbkit/common/bid_request.h"
+#include <string>
+#include <vector>
+
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* BID REQUEST PROJECTION                                                    */
+/*****************************************************************************/
+
+/** Selects the fields of a bid request that a consumer, such as an
+    augmentor, actually reads.
+
+    Fields are named as in the canonical JSON of the bid request, with a dot
+    to select a field within a structure: "userIds", "ipAddress",
+    "device.ip" or "site.domain" for example.  Naming a structure selects all
+    of its fields.
+
+    A projected request is a canonical bid request in the binary JSON
+    encoding which only contains the selected fields; it can be read back
+    with BidRequest::parse() using the "datacratic-bin" source, which gives a
+    bid request with all of the other fields left to their default.
+*/
+
+struct BidRequestProjection {
+
+    /** Throws an ML::Exception if a field doesn't exist in the bid request or
+        if a dotted path goes through a field that isn't a structure.
+    */
+    BidRequestProjection(const std::vector<std::string> & fields);
+
+    const std::vector<std::string> & fields() const { return fields_; }
+
+    /** Returns the selected fields of the request in the binary JSON
+        encoding.
+    */
+    std::string project(const BidRequest & request) const;
+
+    Json::Value toJson() const;
+    static BidRequestProjection fromJson(const Json::Value & json);
+
+private:
+    typedef Datacratic::ValueDescription::FieldDescription FieldDescription;
+
+    struct Node {
+        Node() : field(nullptr), whole(false) {}
+
+        const FieldDescription * field;
+        bool whole;                     ///< Print all of the field
+        std::vector<Node> children;     ///< Selected fields within the field
+    };
+
+    std::vector<std::string> fields_;
+    Node root;
+
+    void print(const void * value,
+               const Node & node,
+               Datacratic::JsonPrintingContext & context) const;
+};
+
+} // namespace RTBKIT
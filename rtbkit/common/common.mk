@@ -2,6 +2,7 @@
 
 LIBBIDREQUEST_SOURCES := \
 	bid_request.cc \
+	bid_request_projection.cc \
 	segments.cc \
 	json_holder.cc \
 	currency.cc \
@@ -21,6 +22,7 @@ LIBRTB_SOURCES := \
 	exchange_connector.cc \
 	bidder_interface.cc \
 	win_cost_model.cc \
+	auction_message.cc \
 	post_auction_proxy.cc \
 	analytics_publisher.cc \
 	extension.cc \
@@ -31,6 +33,13 @@ LIBRTB_LINK := \
 
 $(eval $(call library,rtb,$(LIBRTB_SOURCES),$(LIBRTB_LINK)))
 
-$(eval $(call library,filter_registry,filter.cc,arch utils rtb))
+LIBFILTER_REGISTRY_SOURCES := \
+	filter.cc \
+	config_set_kernels.cc \
+	config_set_kernels_avx2.cc
+
+$(eval $(call set_single_compile_option,config_set_kernels_avx2.cc,-mavx2))
+
+$(eval $(call library,filter_registry,$(LIBFILTER_REGISTRY_SOURCES),arch utils rtb))
 
 $(eval $(call include_sub_make,testing,,common_testing.mk))
@@ -0,0 +1,213 @@
+/** config_set_kernels.cc                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Scalar and SSE2 implementations of the ConfigSet kernels along with the
+    runtime dispatch. The AVX2 kernels live in config_set_kernels_avx2.cc as
+    they need to be compiled with different flags.
+
+*/
+
+#include "config_set_kernels.h"
+#include "jml/arch/simd.h"
+#include "jml/arch/bitops.h"
+#include "jml/arch/exception.h"
+
+#include <emmintrin.h>
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* SCALAR                                                                     */
+/******************************************************************************/
+
+namespace {
+
+typedef ConfigSetKernels::Word Word;
+
+void scalarAnd(Word* dst, const Word* src, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) dst[i] &= src[i];
+}
+
+void scalarOr(Word* dst, const Word* src, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) dst[i] |= src[i];
+}
+
+void scalarXor(Word* dst, const Word* src, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) dst[i] ^= src[i];
+}
+
+size_t scalarCount(const Word* words, size_t n)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!words[i]) continue;
+        total += ML::num_bits_set(words[i]);
+    }
+    return total;
+}
+
+bool scalarEmpty(const Word* words, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (words[i]) return false;
+    }
+    return true;
+}
+
+size_t scalarNextWord(const Word* words, size_t start, size_t n)
+{
+    for (size_t i = start; i < n; ++i) {
+        if (words[i]) return i;
+    }
+    return n;
+}
+
+} // namespace anonymous
+
+const ConfigSetKernels scalarConfigSetKernels = {
+    "scalar",
+    &scalarAnd, &scalarOr, &scalarXor,
+    &scalarCount, &scalarEmpty, &scalarNextWord
+};
+
+
+/******************************************************************************/
+/* SSE2                                                                       */
+/******************************************************************************/
+
+namespace {
+
+template<typename Op>
+void sse2Apply(Word* dst, const Word* src, size_t n, const Op& op)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128i d0 = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i d1 = _mm_loadu_si128((const __m128i*) (dst + i + 2));
+        __m128i s0 = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i s1 = _mm_loadu_si128((const __m128i*) (src + i + 2));
+        _mm_storeu_si128((__m128i*) (dst + i), op(d0, s0));
+        _mm_storeu_si128((__m128i*) (dst + i + 2), op(d1, s1));
+    }
+
+    for (; i + 2 <= n; i += 2) {
+        __m128i d = _mm_loadu_si128((const __m128i*) (dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_si128((__m128i*) (dst + i), op(d, s));
+    }
+
+    if (i < n) {
+        __m128i d = _mm_set_epi64x(0, dst[i]);
+        __m128i s = _mm_set_epi64x(0, src[i]);
+        dst[i] = _mm_cvtsi128_si64(op(d, s));
+    }
+}
+
+void sse2And(Word* dst, const Word* src, size_t n)
+{
+    sse2Apply(dst, src, n, [] (__m128i d, __m128i s) { return _mm_and_si128(d, s); });
+}
+
+void sse2Or(Word* dst, const Word* src, size_t n)
+{
+    sse2Apply(dst, src, n, [] (__m128i d, __m128i s) { return _mm_or_si128(d, s); });
+}
+
+void sse2Xor(Word* dst, const Word* src, size_t n)
+{
+    sse2Apply(dst, src, n, [] (__m128i d, __m128i s) { return _mm_xor_si128(d, s); });
+}
+
+bool sse2IsZero(__m128i v)
+{
+    __m128i zero = _mm_setzero_si128();
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) == 0xFFFF;
+}
+
+bool sse2Empty(const Word* words, size_t n)
+{
+    size_t i = 0;
+    __m128i acc = _mm_setzero_si128();
+
+    for (; i + 2 <= n; i += 2)
+        acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i*) (words + i)));
+
+    if (!sse2IsZero(acc)) return false;
+    return i == n || !words[i];
+}
+
+size_t sse2NextWord(const Word* words, size_t start, size_t n)
+{
+    size_t i = start;
+
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (words + i));
+        if (sse2IsZero(v)) continue;
+        return words[i] ? i : i + 1;
+    }
+
+    if (i < n && words[i]) return i;
+    return n;
+}
+
+} // namespace anonymous
+
+// SSE2 has no popcount so counting stays scalar.
+const ConfigSetKernels sse2ConfigSetKernels = {
+    "sse2",
+    &sse2And, &sse2Or, &sse2Xor,
+    &scalarCount, &sse2Empty, &sse2NextWord
+};
+
+
+/******************************************************************************/
+/* DISPATCH                                                                   */
+/******************************************************************************/
+
+bool
+isSupported(const ConfigSetKernels& kernels)
+{
+    if (&kernels == &avx2ConfigSetKernels) return ML::has_avx2();
+    if (&kernels == &sse2ConfigSetKernels) return ML::has_sse2();
+    return true;
+}
+
+void
+setConfigSetKernels(const ConfigSetKernels& kernels)
+{
+    if (!isSupported(kernels))
+        throw ML::Exception("cpu doesn't support the %s config set kernels",
+                kernels.name);
+
+    details::currentConfigSetKernels = &kernels;
+}
+
+namespace details {
+
+// Constant initialized so that ConfigSets are usable during static
+// initialization; upgraded below once the cpu has been queried.
+const ConfigSetKernels* currentConfigSetKernels = &scalarConfigSetKernels;
+
+} // namespace details
+
+namespace {
+
+struct AtInit {
+    AtInit()
+    {
+        if (isSupported(avx2ConfigSetKernels))
+            details::currentConfigSetKernels = &avx2ConfigSetKernels;
+        else if (isSupported(sse2ConfigSetKernels))
+            details::currentConfigSetKernels = &sse2ConfigSetKernels;
+    }
+} atInit;
+
+} // namespace anonymous
+
+} // namespace RTBKIT
@@ -0,0 +1,71 @@
+/** config_set_kernels.h                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Vectorized kernels for the ConfigSet bitfield operations.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* CONFIG SET KERNELS                                                         */
+/******************************************************************************/
+
+/** Table of the bitfield kernels used by ConfigSet on large sets.
+
+    The best set of kernels supported by the cpu is selected at startup; see
+    configSetKernels(). Small sets don't go through the table as the indirect
+    call would cost more than the operation itself.
+ */
+struct ConfigSetKernels
+{
+    typedef uint64_t Word;
+
+    const char* name;
+
+    void (*andWords)(Word* dst, const Word* src, size_t n);
+    void (*orWords)(Word* dst, const Word* src, size_t n);
+    void (*xorWords)(Word* dst, const Word* src, size_t n);
+
+    size_t (*count)(const Word* words, size_t n);
+
+    // Returns true if all the words are zero.
+    bool (*empty)(const Word* words, size_t n);
+
+    // Returns the index of the first non-zero word at or after start or n if
+    // there are none.
+    size_t (*nextWord)(const Word* words, size_t start, size_t n);
+};
+
+extern const ConfigSetKernels scalarConfigSetKernels;
+extern const ConfigSetKernels sse2ConfigSetKernels;
+extern const ConfigSetKernels avx2ConfigSetKernels;
+
+namespace details {
+
+extern const ConfigSetKernels* currentConfigSetKernels;
+
+} // namespace details
+
+/** Kernels currently in use. */
+inline const ConfigSetKernels& configSetKernels()
+{
+    return *details::currentConfigSetKernels;
+}
+
+/** Overrides the kernels selected at startup. Meant for tests and benchmarks;
+    throws if the cpu doesn't support the given kernels.
+ */
+void setConfigSetKernels(const ConfigSetKernels& kernels);
+
+/** Returns true if the cpu can run the given kernels. */
+bool isSupported(const ConfigSetKernels& kernels);
+
+} // namespace RTBKIT
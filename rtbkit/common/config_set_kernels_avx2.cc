@@ -0,0 +1,136 @@
+/** config_set_kernels_avx2.cc                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    AVX2 implementation of the ConfigSet kernels.
+
+    This file is compiled with -mavx2 so none of its functions may be called
+    unless ML::has_avx2() returns true; configSetKernels() takes care of that.
+
+*/
+
+#include "config_set_kernels.h"
+
+#include <immintrin.h>
+
+
+namespace RTBKIT {
+
+namespace {
+
+typedef ConfigSetKernels::Word Word;
+
+template<typename Op>
+void avx2Apply(Word* dst, const Word* src, size_t n, const Op& op)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i d0 = _mm256_loadu_si256((const __m256i*) (dst + i));
+        __m256i d1 = _mm256_loadu_si256((const __m256i*) (dst + i + 4));
+        __m256i s0 = _mm256_loadu_si256((const __m256i*) (src + i));
+        __m256i s1 = _mm256_loadu_si256((const __m256i*) (src + i + 4));
+        _mm256_storeu_si256((__m256i*) (dst + i), op(d0, s0));
+        _mm256_storeu_si256((__m256i*) (dst + i + 4), op(d1, s1));
+    }
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i d = _mm256_loadu_si256((const __m256i*) (dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i*) (src + i));
+        _mm256_storeu_si256((__m256i*) (dst + i), op(d, s));
+    }
+
+    for (; i < n; ++i) {
+        __m256i d = _mm256_set_epi64x(0, 0, 0, dst[i]);
+        __m256i s = _mm256_set_epi64x(0, 0, 0, src[i]);
+        dst[i] = _mm256_extract_epi64(op(d, s), 0);
+    }
+}
+
+void avx2And(Word* dst, const Word* src, size_t n)
+{
+    avx2Apply(dst, src, n, [] (__m256i d, __m256i s) { return _mm256_and_si256(d, s); });
+}
+
+void avx2Or(Word* dst, const Word* src, size_t n)
+{
+    avx2Apply(dst, src, n, [] (__m256i d, __m256i s) { return _mm256_or_si256(d, s); });
+}
+
+void avx2Xor(Word* dst, const Word* src, size_t n)
+{
+    avx2Apply(dst, src, n, [] (__m256i d, __m256i s) { return _mm256_xor_si256(d, s); });
+}
+
+/** Nibble lookup popcount (Mula et al.); the per-byte counts are summed into
+    64 bit lanes by psadbw.
+ */
+size_t avx2Count(const Word* words, size_t n)
+{
+    const __m256i lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (words + i));
+        __m256i lo = _mm256_and_si256(v, low);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+        __m256i bytes = _mm256_add_epi8(
+                _mm256_shuffle_epi8(lookup, lo),
+                _mm256_shuffle_epi8(lookup, hi));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+
+    size_t total =
+        _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+        _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+
+    for (; i < n; ++i) total += __builtin_popcountll(words[i]);
+
+    return total;
+}
+
+bool avx2Empty(const Word* words, size_t n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        acc = _mm256_or_si256(acc, _mm256_loadu_si256((const __m256i*) (words + i)));
+
+    if (!_mm256_testz_si256(acc, acc)) return false;
+
+    for (; i < n; ++i) {
+        if (words[i]) return false;
+    }
+    return true;
+}
+
+size_t avx2NextWord(const Word* words, size_t start, size_t n)
+{
+    size_t i = start;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (words + i));
+        if (_mm256_testz_si256(v, v)) continue;
+        break;
+    }
+
+    for (; i < n; ++i) {
+        if (words[i]) return i;
+    }
+    return n;
+}
+
+} // namespace anonymous
+
+const ConfigSetKernels avx2ConfigSetKernels = {
+    "avx2",
+    &avx2And, &avx2Or, &avx2Xor,
+    &avx2Count, &avx2Empty, &avx2NextWord
+};
+
+} // namespace RTBKIT
@@ -8,8 +8,10 @@
 #pragma once
 
 #include "rtbkit/core/router/router_types.h"
+#include "config_set_kernels.h"
 #include "jml/utils/compact_vector.h"
 #include "jml/arch/bitops.h"
+#include "jml/arch/exception.h"
 
 #include <vector>
 #include <string>
@@ -29,6 +31,14 @@ struct AgentConfig;
 /* CONFIG SET                                                                 */
 /******************************************************************************/
 
+/** When non-zero, fixes the maximum number of configs a ConfigSet can hold and
+    sizes its inline storage accordingly so that filtering never allocates.
+    Expanding a set past that capacity throws.
+ */
+#ifndef RTBKIT_CONFIG_SET_FIXED_CAPACITY
+#  define RTBKIT_CONFIG_SET_FIXED_CAPACITY 0
+#endif
+
 /** Represents a set of config ids as a bitfield to enable efficient batch
     processing of configs during filtering. A value of 1 at position i in the
     bitfield indicates the config id i is part of the set.
@@ -43,9 +53,17 @@ struct AgentConfig;
  */
 struct ConfigSet
 {
-    typedef uint64_t Word;
+    typedef ConfigSetKernels::Word Word;
     static constexpr size_t Div = sizeof(Word) * 8;
 
+    static constexpr size_t FixedCapacity = RTBKIT_CONFIG_SET_FIXED_CAPACITY;
+    static constexpr size_t InlineWords =
+        FixedCapacity ? (FixedCapacity - 1) / Div + 1 : 8;
+
+    // Below this many words, the operations are cheaper inline than through
+    // the vectorized kernels.
+    static constexpr size_t KernelThreshold = 4;
+
     explicit ConfigSet(bool defaultValue = false) :
         defaultValue(defaultValue ? ~Word(0) : 0)
     {}
@@ -62,6 +80,13 @@ struct ConfigSet
     {
         if (newSize) newSize = (newSize - 1) / Div + 1; // ceilDiv(newSize, Div)
         if (newSize <= bitfield.size()) return;
+
+        if (FixedCapacity && newSize > InlineWords) {
+            throw ML::Exception(
+                    "config set capacity exceeded: %lld > %lld configs",
+                    (long long) newSize * Div, (long long) FixedCapacity);
+        }
+
         bitfield.resize(newSize, defaultValue);
     }
 
@@ -94,9 +119,13 @@ struct ConfigSet
 
     size_t count() const
     {
+        size_t n = bitfield.size();
+        if (n >= KernelThreshold)
+            return configSetKernels().count(&bitfield[0], n);
+
         size_t total = 0;
 
-        for (size_t i = 0; i < bitfield.size(); ++i) {
+        for (size_t i = 0; i < n; ++i) {
             if (!bitfield[i]) continue;
             total += ML::num_bits_set(bitfield[i]);
         }
@@ -106,31 +135,39 @@ struct ConfigSet
 
     size_t empty() const
     {
-        if (bitfield.empty()) return !defaultValue;
+        size_t n = bitfield.size();
+        if (!n) return !defaultValue;
+        if (n >= KernelThreshold)
+            return configSetKernels().empty(&bitfield[0], n);
 
-        for (size_t i = 0; i < bitfield.size(); ++i) {
+        for (size_t i = 0; i < n; ++i) {
             if (bitfield[i]) return false;
         }
         return true;
     }
 
-#define RTBKIT_CONFIG_SET_OP(_op_)                                      \
+#define RTBKIT_CONFIG_SET_OP(_op_, _kernel_)                            \
     ConfigSet& operator _op_ (const ConfigSet& other)                   \
     {                                                                   \
         expand(other.size());                                           \
                                                                         \
-        for (size_t i = 0; i < other.bitfield.size(); ++i)              \
-            bitfield[i] _op_ other.bitfield[i];                         \
+        size_t n = other.bitfield.size();                               \
+        if (n >= KernelThreshold)                                       \
+            configSetKernels()._kernel_(&bitfield[0], &other.bitfield[0], n); \
+        else {                                                          \
+            for (size_t i = 0; i < n; ++i)                              \
+                bitfield[i] _op_ other.bitfield[i];                     \
+        }                                                               \
                                                                         \
-        for (size_t i = other.bitfield.size(); i < bitfield.size(); ++i) \
+        for (size_t i = n; i < bitfield.size(); ++i)                    \
             bitfield[i] _op_ other.defaultValue;                        \
                                                                         \
         return *this;                                                   \
     }
 
-    RTBKIT_CONFIG_SET_OP(&=)
-    RTBKIT_CONFIG_SET_OP(|=)
-    RTBKIT_CONFIG_SET_OP(^=)
+    RTBKIT_CONFIG_SET_OP(&=, andWords)
+    RTBKIT_CONFIG_SET_OP(|=, orWords)
+    RTBKIT_CONFIG_SET_OP(^=, xorWords)
 
 #undef RTBKIT_CONFIG_SET_OP
 
@@ -180,16 +217,22 @@ struct ConfigSet
         size_t subIndex = start % Div;
         Word mask = -1ULL & ~((1ULL << subIndex) - 1);
 
-        for (size_t i = topIndex; i < bitfield.size(); ++i) {
-            Word value = bitfield[i] & mask;
-            mask = -1ULL;
+        size_t n = bitfield.size();
+        if (topIndex >= n) return size();
 
-            if (!value) continue;
+        // The first word is masked so it's always handled inline.
+        Word value = bitfield[topIndex] & mask;
+        if (value) return (topIndex * Div) + ML::lowest_bit(value);
 
-            return (i * Div) + ML::lowest_bit(value);
+        size_t i = topIndex + 1;
+        if (n - i >= KernelThreshold)
+            i = configSetKernels().nextWord(&bitfield[0], i, n);
+        else {
+            while (i < n && !bitfield[i]) ++i;
         }
 
-        return size();
+        if (i == n) return size();
+        return (i * Div) + ML::lowest_bit(bitfield[i]);
     }
 
     std::string print() const
@@ -203,7 +246,7 @@ struct ConfigSet
     }
 
 private:
-    ML::compact_vector<Word, 8> bitfield;
+    ML::compact_vector<Word, InlineWords> bitfield;
     Word defaultValue;
 };
 
@@ -486,6 +529,35 @@ struct FilterBase
     virtual void filter(FilterState& state) const = 0;
 
 
+    /** Called by FilterPool once every config of a new generation has been
+        added and before the generation is used for filtering. Filters can use
+        it to build structures which would be too expensive to maintain on
+        every call to addConfig or removeConfig.
+
+        Filters must still behave correctly if this is never called.
+     */
+    virtual void compile() {}
+
+
+    /** Returns true if the filter only ever narrows the set of configs and if
+        its result depends solely on a small discrete property of the bid
+        request (the exchange name, the language, etc.) which can be extracted
+        through exactMatchKey.
+
+        FilterPool fuses all such filters into a single stage whose result is
+        memoized for each distinct key.
+     */
+    virtual bool isExactMatch() const { return false; }
+
+    /** Appends to key the property of the bid request which determines the
+        result of the filter. Only called if isExactMatch returns true.
+
+        The appended value must be unambiguous when concatenated with the keys
+        of the other exact-match filters.
+     */
+    virtual void exactMatchKey(const BidRequest& br, std::string& key) const {}
+
+
     /** Indicates that a new config is available and that it is associated with
         the given index. The configIndex should be used to manipulate the
         FilterState object during filtering.
@@ -0,0 +1,124 @@
+/** lazy_string.h                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Reference counted string that's only generated when first read.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <iostream>
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* LAZY STRING                                                                */
+/******************************************************************************/
+
+/** String whose value is produced by a generator the first time it's read.
+
+    Copies share the same buffer so a string can be handed to multiple
+    consumers without being copied and it will only be generated once no
+    matter how many consumers (or threads) read it. Assigning to a LazyString
+    detaches it from the buffer it was sharing.
+
+    Used for the stringified versions of a bid request in the Auction which
+    are only needed when the request makes it out of the filters.
+ */
+struct LazyString
+{
+    typedef std::function<std::string ()> Generator;
+
+    LazyString() {}
+
+    LazyString(std::string value) :
+        state(std::make_shared<State>(std::move(value)))
+    {}
+
+    LazyString(const char* value) :
+        state(std::make_shared<State>(std::string(value)))
+    {}
+
+    explicit LazyString(Generator generator) :
+        state(std::make_shared<State>(std::move(generator)))
+    {}
+
+    LazyString& operator=(std::string value)
+    {
+        state = std::make_shared<State>(std::move(value));
+        return *this;
+    }
+
+    LazyString& operator=(const char* value)
+    {
+        return *this = std::string(value);
+    }
+
+    /** Returns the value, generating it if needed. */
+    const std::string& str() const
+    {
+        if (!state) return emptyString();
+        if (state->generated.load(std::memory_order_acquire))
+            return state->value;
+
+        std::call_once(state->once, [&] {
+                    state->value = state->generator();
+                    state->generator = Generator();
+                    state->generated.store(true, std::memory_order_release);
+                });
+
+        return state->value;
+    }
+
+    operator const std::string& () const { return str(); }
+
+    /** True if the value has been generated. Doesn't trigger generation. */
+    bool isGenerated() const
+    {
+        return !state || state->generated.load(std::memory_order_acquire);
+    }
+
+    size_t size() const { return str().size(); }
+    bool empty() const { return str().empty(); }
+    const char* c_str() const { return str().c_str(); }
+
+private:
+
+    struct State
+    {
+        explicit State(std::string value) :
+            value(std::move(value)), generated(true)
+        {}
+
+        explicit State(Generator generator) :
+            generator(std::move(generator)), generated(false)
+        {}
+
+        std::once_flag once;
+        Generator generator;
+        std::string value;
+        std::atomic<bool> generated;
+    };
+
+    static const std::string& emptyString()
+    {
+        static const std::string empty;
+        return empty;
+    }
+
+    std::shared_ptr<State> state;
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const LazyString& str)
+{
+    return stream << str.str();
+}
+
+} // namespace RTBKIT
@@ -59,6 +59,9 @@ initHTTP()
     const auto& uris = proxies->params["postAuctionURIs"];
     ExcCheckEqual(uris.type(), Json::arrayValue, "invalid postAuctionURIs type");
 
+    // Only post auction services that accept binary bodies can be sent them
+    bool binary = proxies->params.get("postAuctionBinary", false).asBool();
+
     shards = uris.size();
     http.resize(uris.size());
 
@@ -66,9 +69,11 @@ initHTTP()
         std::string name = "postAuctionProxy" + std::to_string(i);
 
         if (parent)
-            http[i] = std::make_shared<EventForwarder>(*parent, uris[i].asString(), name);
+            http[i] = std::make_shared<EventForwarder>(
+                    *parent, uris[i].asString(), name, binary);
         else
-            http[i] = std::make_shared<EventForwarder>(proxies, uris[i].asString(), name);
+            http[i] = std::make_shared<EventForwarder>(
+                    proxies, uris[i].asString(), name, binary);
     }
 }
 
@@ -31,6 +31,10 @@ struct EventForwarder;
     Requires that the postAuctionShard configuration parameter be provided in
     the bootstrap.json to determine the number of active post auction shards. If
     not present, assumes that there's only one active post auction shard.
+
+    When the post auction shards are reached over HTTP (postAuctionURIs), the
+    postAuctionBinary parameter sends the auctions and events in binary
+    rather than as JSON.
  */
 struct PostAuctionProxy
 {
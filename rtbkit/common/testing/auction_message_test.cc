@@ -0,0 +1,153 @@
+/* auction_message_test.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Tests for the binary encoding of the auction messages.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "rtbkit/common/auction_message.h"
+#include "jml/arch/exception.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+BOOST_AUTO_TEST_CASE( test_binary_spots )
+{
+    std::vector<std::pair<int, std::vector<int> > > spots = {
+        { 0, { 1, 2, 3 } },
+        { 2, { } },
+        { 5, { 7 } }
+    };
+
+    std::string encoded = encodeBinarySpots(spots);
+    BOOST_CHECK_EQUAL(encoded.size(), 11 * sizeof(int32_t));
+
+    Bids bids = decodeBinarySpots(encoded);
+    BOOST_REQUIRE_EQUAL(bids.size(), 3);
+    for (unsigned i = 0;  i < spots.size();  ++i) {
+        BOOST_CHECK_EQUAL(bids[i].spotIndex, spots[i].first);
+        std::vector<int> creatives(bids[i].availableCreatives.begin(),
+                                   bids[i].availableCreatives.end());
+        BOOST_CHECK(creatives == spots[i].second);
+    }
+
+    spots.clear();
+    BOOST_CHECK(decodeBinarySpots(encodeBinarySpots(spots)).empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_spots_invalid )
+{
+    std::vector<std::pair<int, std::vector<int> > > spots = {
+        { 0, { 1, 2, 3 } }
+    };
+    std::string encoded = encodeBinarySpots(spots);
+
+    for (size_t size = 0;  size < encoded.size();  ++size)
+        BOOST_CHECK_THROW(decodeBinarySpots(encoded.data(), size),
+                          ML::Exception);
+
+    BOOST_CHECK_THROW(decodeBinarySpots(encoded + "x"), ML::Exception);
+
+    // A count larger than what follows doesn't allocate for it
+    int32_t count = 1 << 30;
+    std::memcpy(&encoded[0], &count, sizeof(count));
+    BOOST_CHECK_THROW(decodeBinarySpots(encoded), ML::Exception);
+}
+
+BOOST_AUTO_TEST_CASE( test_win_cost_model_references )
+{
+    WinCostModel model1("model1", Json::Value(1));
+    WinCostModel model2("model2", Json::Value(2));
+
+    WinCostModelEncoder encoder;
+    WinCostModelDecoder decoder;
+
+    // Models are only defined the first time that they're sent
+    std::string frame1 = encoder.encode(model1);
+    std::string frame2 = encoder.encode(model2);
+    std::string frame3 = encoder.encode(model1);
+    BOOST_CHECK_GT(frame1.size(), sizeof(uint32_t));
+    BOOST_CHECK_GT(frame2.size(), sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(frame3.size(), sizeof(uint32_t));
+
+    BOOST_CHECK_EQUAL(decoder.decode(frame1).name, "model1");
+    BOOST_CHECK_EQUAL(decoder.decode(frame2).name, "model2");
+    BOOST_CHECK_EQUAL(decoder.decode(frame3).name, "model1");
+    BOOST_CHECK_EQUAL(decoder.decode(frame3).data, Json::Value(1));
+
+    // A decoder that missed the definitions can't resolve the references
+    WinCostModelDecoder decoder2;
+    BOOST_CHECK_THROW(decoder2.decode(frame3), ML::Exception);
+    BOOST_CHECK_THROW(decoder2.decode(frame2), ML::Exception);
+    BOOST_CHECK_THROW(decoder2.decode(""), ML::Exception);
+
+    // Once cleared, the encoder defines the models again
+    encoder.clear();
+    decoder2.clear();
+    std::string frame4 = encoder.encode(model2);
+    BOOST_CHECK_GT(frame4.size(), sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(decoder2.decode(frame4).name, "model2");
+
+    // ... which replaces the models that the decoder already had
+    BOOST_CHECK_EQUAL(decoder.decode(frame4).name, "model2");
+    BOOST_CHECK_EQUAL(decoder.decode(frame4.substr(0, sizeof(uint32_t))).name,
+                      "model2");
+}
+
+BOOST_AUTO_TEST_CASE( test_win_cost_model_identity )
+{
+    WinCostModelEncoder encoder;
+
+    auto makeData = [] (double m, const std::string & b)
+        {
+            Json::Value data;
+            data["m"] = m;
+            data["b"] = b;
+            data["list"][0] = 1;
+            data["list"][1] = "two";
+            return data;
+        };
+
+    // Models are matched on their contents, not on their instance
+    std::string frame1 = encoder.encode(WinCostModel("m", makeData(0.5, "5")));
+    std::string frame2 = encoder.encode(WinCostModel("m", makeData(0.5, "5")));
+    BOOST_CHECK_GT(frame1.size(), sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(frame2, frame1.substr(0, sizeof(uint32_t)));
+
+    // Any difference in the name or the data makes for a different model
+    std::string frame3 = encoder.encode(WinCostModel("m", makeData(0.5, "6")));
+    std::string frame4 = encoder.encode(WinCostModel("n", makeData(0.5, "5")));
+    std::string frame5 = encoder.encode(WinCostModel("m", makeData(0.6, "5")));
+    BOOST_CHECK_GT(frame3.size(), sizeof(uint32_t));
+    BOOST_CHECK_GT(frame4.size(), sizeof(uint32_t));
+    BOOST_CHECK_GT(frame5.size(), sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(encoder.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE( test_win_cost_model_bounded )
+{
+    WinCostModelEncoder encoder(4);
+    WinCostModelDecoder decoder;
+
+    // Per auction models don't make the encoder grow without bound
+    for (int i = 0;  i < 10;  ++i) {
+        WinCostModel model("model", Json::Value(i));
+        encoder.encode(model, [&] (const std::string & frame) {
+                BOOST_CHECK_GT(frame.size(), sizeof(uint32_t));
+                BOOST_CHECK_EQUAL(decoder.decode(frame).data, Json::Value(i));
+            });
+        BOOST_CHECK_LE(encoder.size(), 4);
+    }
+
+    // Ids that were given out again refer to their new model
+    WinCostModel model("model", Json::Value(9));
+    std::string frame = encoder.encode(model);
+    BOOST_CHECK_EQUAL(frame.size(), sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(decoder.decode(frame).data, Json::Value(9));
+}
@@ -0,0 +1,110 @@
+/* bid_request_projection_test.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Tests for the projection of the fields of a bid request.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "rtbkit/common/bid_request_projection.h"
+#include "jml/arch/exception.h"
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+namespace {
+
+BidRequest makeRequest()
+{
+    BidRequest request;
+    request.auctionId = Id("auction");
+    request.exchange = "exchange";
+    request.ipAddress = "10.0.0.1";
+    request.userAgent = "Mozilla/5.0";
+    request.userIds.add(Id("provider"), ID_PROVIDER);
+    request.userIds.add(Id("exchange"), ID_EXCHANGE);
+
+    request.device.reset(new OpenRTB::Device());
+    request.device->ip = "10.0.0.2";
+    request.device->ua = "Mozilla/5.0 (device)";
+
+    request.site.reset(new OpenRTB::Site());
+    request.site->domain = "example.com";
+    request.site->name = "Example";
+
+    return request;
+}
+
+std::unique_ptr<BidRequest> parseProjected(const std::string & projected)
+{
+    return std::unique_ptr<BidRequest>(
+            BidRequest::parse("datacratic-bin", projected));
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_projection_fields )
+{
+    BidRequest request = makeRequest();
+
+    BidRequestProjection projection(
+            { "userIds", "device.ip", "site.domain" });
+    std::string projected = projection.project(request);
+
+    BOOST_CHECK_LT(projected.size(), request.toBinaryStr().size());
+
+    auto result = parseProjected(projected);
+    BOOST_CHECK_EQUAL(result->userIds.toJsonStr(), request.userIds.toJsonStr());
+    BOOST_CHECK_EQUAL(result->userIds.providerId, Id("provider"));
+
+    BOOST_REQUIRE(result->device);
+    BOOST_CHECK_EQUAL(result->device->ip, "10.0.0.2");
+    BOOST_CHECK(result->device->ua.empty());
+
+    BOOST_REQUIRE(result->site);
+    BOOST_CHECK_EQUAL(result->site->domain.rawString(), "example.com");
+    BOOST_CHECK(result->site->name.empty());
+
+    // Everything else is left out
+    BOOST_CHECK_EQUAL(result->ipAddress, "");
+    BOOST_CHECK_EQUAL(result->exchange, "");
+    BOOST_CHECK(!result->auctionId);
+    BOOST_CHECK(!result->app);
+}
+
+BOOST_AUTO_TEST_CASE( test_projection_whole_field )
+{
+    BidRequest request = makeRequest();
+
+    // Naming the structure takes all of it, in any order
+    BidRequestProjection projection({ "device.ip", "device", "ipAddress" });
+    auto result = parseProjected(projection.project(request));
+
+    BOOST_REQUIRE(result->device);
+    BOOST_CHECK_EQUAL(result->device->ip, "10.0.0.2");
+    BOOST_CHECK_EQUAL(result->device->ua.rawString(), "Mozilla/5.0 (device)");
+    BOOST_CHECK_EQUAL(result->ipAddress, "10.0.0.1");
+
+    // Absent fields are skipped
+    request.device.reset();
+    result = parseProjected(projection.project(request));
+    BOOST_CHECK(!result->device);
+
+    auto projection2 = BidRequestProjection::fromJson(projection.toJson());
+    BOOST_CHECK(projection2.fields() == projection.fields());
+}
+
+BOOST_AUTO_TEST_CASE( test_projection_bad_fields )
+{
+    BOOST_CHECK_THROW(BidRequestProjection({ "noSuchField" }), ML::Exception);
+    BOOST_CHECK_THROW(BidRequestProjection({ "device.noSuchField" }),
+                      ML::Exception);
+    BOOST_CHECK_THROW(BidRequestProjection({ "ipAddress.length" }),
+                      ML::Exception);
+}
@@ -0,0 +1,167 @@
+/** config_set_bench.cc                                           -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Micro-benchmark of the ConfigSet operations for each set of kernels.
+
+    Simulates the bitfield work done by the filters on a single request: the
+    set of configs is intersected with the result of each filter, a couple of
+    sets are unioned for the include/exclude filters and the survivors are
+    counted and iterated over.
+
+*/
+
+#include "rtbkit/common/filter.h"
+#include "soa/utils/print_utils.h"
+#include "jml/arch/timers.h"
+#include "jml/arch/format.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <random>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+/******************************************************************************/
+/* CONFIG                                                                     */
+/******************************************************************************/
+
+struct Config
+{
+    Config() :
+        configs({ 512, 4096, 16384 }),
+        filters(12),
+        requests(100000)
+    {}
+
+    std::vector<size_t> configs;
+    size_t filters;
+    size_t requests;
+};
+
+Config getConfig(int argc, char** argv)
+{
+    using namespace boost::program_options;
+
+    Config config;
+    std::vector<size_t> configs;
+
+    options_description opt;
+    opt.add_options()
+        ("configs,c", value< std::vector<size_t> >(&configs),
+         "number of agent configs to filter; can be repeated")
+        ("filters,f", value<size_t>(&config.filters),
+         "number of filters applied per request")
+        ("requests,r", value<size_t>(&config.requests),
+         "number of simulated requests")
+        ("help,h","print this message");
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opt).run(), vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        cerr << opt << endl;
+        exit(1);
+    }
+
+    if (!configs.empty()) config.configs = configs;
+    return config;
+}
+
+
+/******************************************************************************/
+/* BENCH                                                                      */
+/******************************************************************************/
+
+/** Most filters let through the vast majority of the configs so the sets are
+    generated dense with a few holes punched in them.
+ */
+ConfigSet makeSet(std::mt19937& rng, size_t configs, unsigned holeRatio)
+{
+    ConfigSet set(true);
+    set.expand(configs);
+
+    for (size_t i = 0; i < configs; ++i) {
+        if (rng() % holeRatio == 0) set.reset(i);
+    }
+
+    return set;
+}
+
+double bench(const Config& config, size_t configs, size_t& matched)
+{
+    std::mt19937 rng(configs);
+
+    std::vector<ConfigSet> filters;
+    for (size_t i = 0; i < config.filters * 4; ++i)
+        filters.push_back(makeSet(rng, configs, 16));
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < config.requests; ++i)
+        order.push_back(rng() % (filters.size() - 1));
+
+    Timer timer;
+
+    for (size_t i = 0; i < config.requests; ++i) {
+        ConfigSet matching(true);
+        matching.expand(configs);
+
+        for (size_t j = 0; j < config.filters; ++j) {
+            const ConfigSet& filter = filters[(order[i] + j) % filters.size()];
+
+            // Roughly one in four filters is an include/exclude filter which
+            // unions the result of its sub-filters before intersecting.
+            if (j % 4 == 0) {
+                ConfigSet include = filter | filters[order[i] + 1];
+                matching &= include;
+            }
+            else matching &= filter;
+
+            if (matching.empty()) break;
+        }
+
+        matched += matching.count();
+        for (size_t id = matching.next(); id < matching.size(); id = matching.next(id + 1))
+            matched ^= id & 1;
+    }
+
+    return timer.elapsed_wall();
+}
+
+
+/******************************************************************************/
+/* MAIN                                                                       */
+/******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    auto config = getConfig(argc, argv);
+
+    const ConfigSetKernels* kernels[] = {
+        &scalarConfigSetKernels, &sse2ConfigSetKernels, &avx2ConfigSetKernels
+    };
+
+    cerr << "default kernels: " << configSetKernels().name << endl;
+
+    for (size_t configs : config.configs) {
+        for (const ConfigSetKernels* k : kernels) {
+            if (!isSupported(*k)) continue;
+            setConfigSetKernels(*k);
+
+            size_t matched = 0;
+            double elapsed = bench(config, configs, matched);
+            double requests = config.requests;
+
+            cerr << ML::format("%6lld configs  %-6s  ", (long long) configs, k->name)
+                << printValue(requests / elapsed) << " Requests/sec  "
+                << printValue(elapsed / requests * 1000000.0) << " us/Request"
+                << "  (" << matched << ")"
+                << endl;
+        }
+    }
+}
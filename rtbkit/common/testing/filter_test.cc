@@ -14,6 +14,7 @@
 #include "rtbkit/common/bid_request.h"
 
 #include <boost/test/unit_test.hpp>
+#include <random>
 
 using namespace std;
 using namespace RTBKIT;
@@ -114,6 +115,94 @@ BOOST_AUTO_TEST_CASE(configSetTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(configSetKernelsTest)
+{
+    const ConfigSetKernels* kernels[] = {
+        &scalarConfigSetKernels, &sse2ConfigSetKernels, &avx2ConfigSetKernels
+    };
+
+    // Checks every kernel against the scalar one over sizes that exercise the
+    // vector bodies as well as the scalar tails.
+    auto check = [&] (const ConfigSetKernels& k, size_t n) {
+        mt19937 rng(n);
+        vector<uint64_t> a(n), b(n);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = rng() % 4 ? uint64_t(rng()) << 32 | rng() : 0;
+            b[i] = rng() % 4 ? uint64_t(rng()) << 32 | rng() : 0;
+        }
+
+        vector<uint64_t> exp = a, act = a;
+        scalarConfigSetKernels.andWords(exp.data(), b.data(), n);
+        k.andWords(act.data(), b.data(), n);
+        BOOST_CHECK(exp == act);
+
+        exp = act = a;
+        scalarConfigSetKernels.orWords(exp.data(), b.data(), n);
+        k.orWords(act.data(), b.data(), n);
+        BOOST_CHECK(exp == act);
+
+        exp = act = a;
+        scalarConfigSetKernels.xorWords(exp.data(), b.data(), n);
+        k.xorWords(act.data(), b.data(), n);
+        BOOST_CHECK(exp == act);
+
+        BOOST_CHECK_EQUAL(k.count(a.data(), n), scalarConfigSetKernels.count(a.data(), n));
+
+        vector<uint64_t> zero(n, 0);
+        BOOST_CHECK(k.empty(zero.data(), n));
+        for (size_t i = 0; i < n; ++i) {
+            zero[i] = 1ULL << (i % 64);
+            BOOST_CHECK(!k.empty(zero.data(), n));
+
+            for (size_t start = 0; start <= i; start += 3)
+                BOOST_CHECK_EQUAL(k.nextWord(zero.data(), start, n), i);
+            BOOST_CHECK_EQUAL(k.nextWord(zero.data(), i + 1, n), n);
+
+            zero[i] = 0;
+        }
+    };
+
+    for (const ConfigSetKernels* k : kernels) {
+        if (!isSupported(*k)) {
+            cerr << "skipping unsupported kernels: " << k->name << endl;
+            continue;
+        }
+
+        for (size_t n = 0; n < 40; ++n) check(*k, n);
+        check(*k, 256);
+
+        // Make sure ConfigSet gives the same answers through every kernel.
+        const ConfigSetKernels& old = configSetKernels();
+        setConfigSetKernels(*k);
+
+        ConfigSet a, b(true);
+        for (size_t i = 0; i < 1000; i += 3) a.set(i);
+        for (size_t i = 0; i < 500; i += 5) b.reset(i);
+
+        BOOST_CHECK_EQUAL(a.count(), 334);
+        BOOST_CHECK_EQUAL((a & b).count(), 334 - 34);
+
+        ConfigSet both = a | b;
+        size_t expected = 0;
+        for (size_t i = 0; i < both.size(); ++i)
+            expected += a.test(i) || b.test(i);
+        BOOST_CHECK_EQUAL(both.count(), expected);
+
+        BOOST_CHECK_EQUAL((a ^ a).empty(), true);
+        BOOST_CHECK_EQUAL(a.next(1), 3);
+        BOOST_CHECK_EQUAL(a.next(998), 999);
+        BOOST_CHECK_EQUAL(a.next(1000), a.size());
+
+        ConfigSet sparse;
+        sparse.expand(4096);
+        sparse.set(4000);
+        BOOST_CHECK_EQUAL(sparse.next(), 4000);
+        BOOST_CHECK_EQUAL(sparse.next(4001), sparse.size());
+
+        setConfigSetKernels(old);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(creativeMatrixTest)
 {
     enum { n = 10, m = 100 };
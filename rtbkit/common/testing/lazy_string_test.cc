@@ -0,0 +1,71 @@
+/** lazy_string_test.cc                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Tests for the lazily generated string.
+
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "rtbkit/common/lazy_string.h"
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace RTBKIT;
+
+BOOST_AUTO_TEST_CASE( lazyStringBasics )
+{
+    LazyString empty;
+    BOOST_CHECK(empty.isGenerated());
+    BOOST_CHECK(empty.empty());
+
+    LazyString eager("hello");
+    BOOST_CHECK(eager.isGenerated());
+    BOOST_CHECK_EQUAL(eager.str(), "hello");
+
+    size_t calls = 0;
+    LazyString lazy([&] { calls++; return string("world"); });
+    BOOST_CHECK(!lazy.isGenerated());
+    BOOST_CHECK_EQUAL(calls, 0);
+
+    // Copies share the buffer so the generator only runs once.
+    LazyString copy = lazy;
+    BOOST_CHECK_EQUAL(copy.str(), "world");
+    BOOST_CHECK(lazy.isGenerated());
+    BOOST_CHECK_EQUAL(lazy.str(), "world");
+    BOOST_CHECK_EQUAL(&lazy.str(), &copy.str());
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    const string& ref = lazy;
+    BOOST_CHECK_EQUAL(ref, "world");
+
+    // Assigning detaches the string from the shared buffer.
+    copy = "other";
+    BOOST_CHECK_EQUAL(copy.str(), "other");
+    BOOST_CHECK_EQUAL(lazy.str(), "world");
+}
+
+BOOST_AUTO_TEST_CASE( lazyStringThreads )
+{
+    enum { Threads = 8 };
+
+    for (size_t round = 0; round < 100; ++round) {
+        std::atomic<size_t> calls(0), errors(0);
+        LazyString lazy([&] { calls++; return string(1000, 'x'); });
+
+        vector<thread> threads;
+        for (size_t i = 0; i < Threads; ++i) {
+            threads.emplace_back([&, lazy] {
+                        if (lazy.size() != 1000) errors++;
+                    });
+        }
+        for (auto& th : threads) th.join();
+
+        BOOST_CHECK_EQUAL(calls.load(), 1);
+        BOOST_CHECK_EQUAL(errors.load(), 0);
+    }
+}
@@ -0,0 +1,171 @@
+/** value_encoding_bench.cc                                       -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Micro-benchmark of the JSON and binary encodings of the value
+    descriptions for the messages that go between the router, the post
+    auction loop and the agents.
+
+*/
+
+#include "rtbkit/common/auction_events.h"
+#include "rtbkit/common/bid_request.h"
+#include "soa/types/json_parsing.h"
+#include "soa/types/json_printing.h"
+#include "soa/utils/print_utils.h"
+#include "jml/arch/timers.h"
+#include "jml/arch/format.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <sstream>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+/******************************************************************************/
+/* CONFIG                                                                     */
+/******************************************************************************/
+
+struct Config
+{
+    Config() : iterations(100000) {}
+
+    size_t iterations;
+};
+
+Config getConfig(int argc, char** argv)
+{
+    using namespace boost::program_options;
+
+    Config config;
+
+    options_description opt;
+    opt.add_options()
+        ("iterations,n", value<size_t>(&config.iterations),
+         "number of times each value is encoded and decoded")
+        ("help,h","print this message");
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opt).run(), vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        cerr << opt << endl;
+        exit(1);
+    }
+
+    return config;
+}
+
+
+/******************************************************************************/
+/* SAMPLES                                                                    */
+/******************************************************************************/
+
+const std::string sampleRequest = "{\"!!CV\":\"0.1\",\"exchange\":\"abcd\",\"id\":\"8b703eb9-5ebf-4001-15e8-10d6000003a0\",\"ipAddress\":\"76.aa.xx.yy\",\"language\":\"en\",\"location\":{\"cityName\":\"Grande Prairie\",\"countryCode\":\"CA\",\"dma\":0,\"postalCode\":\"0\",\"regionCode\":\"AB\",\"timezoneOffsetMinutes\":240},\"protocolVersion\":\"0.3\",\"provider\":\"xxx1\",\"segments\":{\"xxx1\":null},\"imp\":[{\"formats\":[\"160x600\"],\"id\":\"22202919\",\"position\":\"NONE\",\"reservePrice\":0},{\"formats\":[\"300x250\",\"728x90\"],\"id\":\"22202920\",\"position\":\"ABOVE_FOLD\",\"reservePrice\":0}],\"timestamp\":1336313462.550589,\"url\":\"http://emedtv.com/search.html?searchString=skin\",\"userAgent\":\"Mozilla/5.0 (compatible; MSIE 9.0; Windows NT 6.1; WOW64; Trident/5.0)\",\"userIds\":{\"ag\":\"7d837be6-94de-11e1-841f-68b599c88614\",\"abcd\":\"PV08FEPS1KQAAGcrbUsAAABY\",\"prov\":\"7d837be6-94de-11e1-841f-68b599c88614\",\"xchg\":\"PV08FEPS1KQAAGcrbUsAAABY\"}}";
+
+PostAuctionEvent makeWin()
+{
+    PostAuctionEvent event;
+    event.type = PAE_WIN;
+    event.auctionId = Id("8b703eb9-5ebf-4001-15e8-10d6000003a0");
+    event.adSpotId = Id("22202919");
+    event.timestamp = Date::fromSecondsSinceEpoch(1336313462.6);
+    event.bidTimestamp = Date::fromSecondsSinceEpoch(1336313462.55);
+    event.account = AccountKey("campaign:strategy");
+    event.winPrice = MicroUSD(1234);
+    event.uids.add(Id("7d837be6-94de-11e1-841f-68b599c88614"), ID_EXCHANGE);
+    event.channels.add("channel1");
+    event.channels.add("channel2");
+    return event;
+}
+
+
+/******************************************************************************/
+/* BENCH                                                                      */
+/******************************************************************************/
+
+template<typename T>
+void bench(const Config& config, const std::string& name, const T& value)
+{
+    static auto desc = getDefaultDescriptionShared<T>();
+
+    auto report = [&] (const char * what, double elapsed, size_t bytes)
+        {
+            double n = config.iterations;
+            cerr << ML::format("%-18s %-12s ", name.c_str(), what)
+                 << printValue(n / elapsed) << " msg/sec  "
+                 << printValue(elapsed / n * 1000000.0) << " us/msg  "
+                 << bytes << " bytes"
+                 << endl;
+        };
+
+    std::string json;
+    {
+        Timer timer;
+        for (size_t i = 0; i < config.iterations; ++i) {
+            std::ostringstream stream;
+            StreamJsonPrintingContext context(stream);
+            desc->printJson(&value, context);
+            json = stream.str();
+        }
+        report("json encode", timer.elapsed_wall(), json.size());
+    }
+
+    {
+        Timer timer;
+        for (size_t i = 0; i < config.iterations; ++i) {
+            T decoded;
+            IndexedJsonParsingContext context(json);
+            desc->parseJson(&decoded, context);
+        }
+        report("json decode", timer.elapsed_wall(), json.size());
+    }
+
+    std::string binary;
+    {
+        Timer timer;
+        for (size_t i = 0; i < config.iterations; ++i) {
+            binary.clear();
+            desc->printBinary(&value, binary);
+        }
+        report("binary encode", timer.elapsed_wall(), binary.size());
+    }
+
+    {
+        Timer timer;
+        for (size_t i = 0; i < config.iterations; ++i) {
+            T decoded;
+            desc->parseBinary(&decoded, binary.c_str(), binary.size());
+        }
+        report("binary decode", timer.elapsed_wall(), binary.size());
+    }
+}
+
+
+/******************************************************************************/
+/* MAIN                                                                       */
+/******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    auto config = getConfig(argc, argv);
+
+    std::unique_ptr<BidRequest> request(
+            BidRequest::parse("datacratic", sampleRequest));
+    bench(config, "BidRequest", *request);
+
+    bench(config, "PostAuctionEvent", makeWin());
+
+    SubmittedAuctionEvent submitted;
+    submitted.auctionId = request->auctionId;
+    submitted.adSpotId = request->imp[0].id;
+    submitted.lossTimeout = Date::fromSecondsSinceEpoch(1336313464.5);
+    submitted.bidRequestStr = sampleRequest;
+    submitted.bidRequestStrFormat = "datacratic";
+    bench(config, "SubmittedAuction", submitted);
+}
@@ -661,6 +661,13 @@ createFromJson(const Json::Value & json)
         }
         else if (it.memberName() == "bidderInterface")
             newConfig.bidderInterface = it->asString();
+        else if (it.memberName() == "bidRequestFormat") {
+            newConfig.bidRequestFormat = it->asString();
+            if (newConfig.bidRequestFormat != "jsonRaw"
+                && newConfig.bidRequestFormat != "binary")
+                throw Exception("bidRequestFormat has invalid value: %s",
+                                newConfig.bidRequestFormat.c_str());
+        }
         else if (it.memberName() == "userPartition") {
             newConfig.userPartition.fromJson(*it);
         }
@@ -836,6 +843,8 @@ toJson(bool includeCreatives) const
 
     if (!bidderInterface.empty())
         result["bidderInterface"] = bidderInterface;
+    if (!bidRequestFormat.empty())
+        result["bidRequestFormat"] = bidRequestFormat;
 
     if (!urlFilter.empty())
         result["urlFilter"] = urlFilter.toJson();
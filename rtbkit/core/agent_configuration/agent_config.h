@@ -314,6 +314,13 @@ struct AgentConfig {
 
     std::string bidderInterface;
 
+    /** Encoding of the bid requests sent to the agent: "jsonRaw" (the
+        default) forwards the JSON request, "binary" sends the canonical
+        request in the binary JSON encoding which is smaller and faster to
+        parse.
+    */
+    std::string bidRequestFormat;
+
     std::vector<std::string> requiredIds;
 
     IncludeExclude<DomainMatcher> hostFilter;
@@ -7,6 +7,7 @@
 
 #include "blacklist.h"
 #include "agent_config.h"
+#include <mutex>
 
 namespace RTBKIT {
 
@@ -99,6 +100,8 @@ void
 Blacklist::
 doExpiries()
 {
+    std::lock_guard<ML::Spinlock> guard(lock);
+
     Date start = Date::now();
 
     auto onBlacklistFinished = [&] (const Id & userId,
@@ -115,10 +118,11 @@ Blacklist::
 matches(const BidRequest & bidRequest, const std::string & agentName,
         const AgentConfig & config) const
 {  
+    std::lock_guard<ML::Spinlock> guard(lock);
+
     bool blocked = false;
     const Id & exchangeId = bidRequest.userIds.exchangeId;
     if (!blocked && exchangeId) {
-        // TODO: read lock
         auto bit = entries.find(exchangeId);
         if (bit != entries.end()) {
             const BlacklistInfo & binfo = bit->second;
@@ -128,7 +132,6 @@ matches(const BidRequest & bidRequest, const std::string & agentName,
     }
     const Id & providerId = bidRequest.userIds.providerId;
     if (!blocked && providerId) {
-        // TODO: read lock
         auto bit = entries.find(providerId);
         if (bit != entries.end()) {
             const BlacklistInfo & binfo = bit->second;
@@ -145,6 +148,8 @@ Blacklist::
 add(const BidRequest & bidRequest, const std::string & agent,
     const AgentConfig & agentConfig)
 {
+    std::lock_guard<ML::Spinlock> guard(lock);
+
     auto addToBlacklist = [&] (const Id & id)
         {
             if (!id) return;
@@ -131,6 +131,44 @@ getNetBudget()
             + adjustmentsIn - adjustmentsOut);
 }
 
+void
+Account::
+serialize(ML::DB::Store_Writer & store) const
+{
+    store << (unsigned char)0 // version
+          << (unsigned char)type << (unsigned char)status
+          << budgetIncreases << budgetDecreases << recycledIn << allocatedIn
+          << commitmentsRetired << adjustmentsIn
+          << recycledOut << allocatedOut << commitmentsMade << adjustmentsOut
+          << spent << balance
+          << lineItems << adjustmentLineItems;
+}
+
+void
+Account::
+reconstitute(ML::DB::Store_Reader & store)
+{
+    unsigned char version;
+    store >> version;
+    if (version != 0)
+        throw ML::Exception("invalid version reconstituting Account");
+
+    unsigned char typeByte, statusByte;
+    store >> typeByte >> statusByte;
+    if (typeByte > AT_SPEND || statusByte > ACTIVE)
+        throw ML::Exception("invalid type or status reconstituting Account");
+    type = (AccountType)typeByte;
+    status = (Status)statusByte;
+
+    store >> budgetIncreases >> budgetDecreases >> recycledIn >> allocatedIn
+          >> commitmentsRetired >> adjustmentsIn
+          >> recycledOut >> allocatedOut >> commitmentsMade >> adjustmentsOut
+          >> spent >> balance
+          >> lineItems >> adjustmentLineItems;
+
+    checkInvariants("reconstitute");
+}
+
 std::ostream & operator << (std::ostream & stream, const Account & account)
 {
     std::set<CurrencyCode> currencies;
@@ -353,17 +391,19 @@ void
 ShadowAccounts::
 logBidEvents(const Datacratic::EventRecorder & eventRecorder)
 {
-    Guard guard(lock);
-
     uint32_t attachedBids(0), detachedBids(0), commitments(0), expired(0);
 
-    for (auto & it: accounts) {
-        ShadowAccount & account = it.second;
-        attachedBids += account.attachedBids;
-        detachedBids += account.detachedBids;
-        commitments += account.commitments.size();
-        account.logBidEvents(eventRecorder, it.first.toString('.'));
-        expired += account.lastExpiredCommitments;
+    for (auto & shard: shards) {
+        Guard guard(shard.lock);
+
+        for (auto & it: shard.accounts) {
+            ShadowAccount & account = it.second;
+            attachedBids += account.attachedBids;
+            detachedBids += account.detachedBids;
+            commitments += account.commitments.size();
+            account.logBidEvents(eventRecorder, it.first.toString('.'));
+            expired += account.lastExpiredCommitments;
+        }
     }
 
     eventRecorder.recordLevel(attachedBids,
@@ -11,9 +11,11 @@
 #include <unordered_map>
 #include <memory>
 #include <unordered_set>
+#include <algorithm>
 #include "rtbkit/common/currency.h"
 #include "rtbkit/common/account_key.h"
 #include "soa/types/date.h"
+#include "soa/types/id.h"
 #include "jml/utils/string_functions.h"
 #include <mutex>
 #include <thread>
@@ -426,8 +428,94 @@ public:
 
         checkInvariants("recuperateTo");
     }
+
+    /** Compact binary form of the account, used by the banker journal.
+        Unlike toJson(), the balance is stored rather than recomputed.
+    */
+    void serialize(ML::DB::Store_Writer & store) const;
+    void reconstitute(ML::DB::Store_Reader & store);
+};
+
+IMPL_SERIALIZE_RECONSTITUTE(Account);
+
+
+/*****************************************************************************/
+/* COMMITMENT KEY                                                            */
+/*****************************************************************************/
+
+/** Identifies the commitment made for a bid: the auction, the spot and the
+    agent that bid on it.  The ids are kept in their binary form so that
+    the hot path of the router and the post auction loop doesn't need to
+    format them into a string for every bid.
+
+    A plain item string (as used by the string based banker interface) is
+    stored in the agent field with null ids; such a key only ever matches a
+    commitment that was made with the same string.
+*/
+
+struct CommitmentKey {
+    CommitmentKey()
+    {
+    }
+
+    CommitmentKey(const Id & auctionId, const Id & spotId,
+                  const std::string & agent)
+        : auctionId(auctionId), spotId(spotId), agent(agent)
+    {
+    }
+
+    CommitmentKey(const std::string & item)
+        : agent(item)
+    {
+    }
+
+    CommitmentKey(const char * item)
+        : agent(item)
+    {
+    }
+
+    Id auctionId;
+    Id spotId;
+    std::string agent;
+
+    /** Item string of the commitment in the format the string based banker
+        interface uses, ie auctionId-spotId-agent.
+    */
+    std::string toString() const
+    {
+        if (!auctionId && !spotId)
+            return agent;
+        return auctionId.toString() + "-" + spotId.toString() + "-" + agent;
+    }
+
+    bool operator == (const CommitmentKey & other) const
+    {
+        return auctionId == other.auctionId
+            && spotId == other.spotId
+            && agent == other.agent;
+    }
+
+    bool operator != (const CommitmentKey & other) const
+    {
+        return !operator == (other);
+    }
+
+    struct Hash {
+        size_t operator () (const CommitmentKey & key) const
+        {
+            size_t h = key.auctionId.hash();
+            h = h * 31 + key.spotId.hash();
+            return h * 31 + std::hash<std::string>()(key.agent);
+        }
+    };
 };
 
+inline std::ostream &
+operator << (std::ostream & stream, const CommitmentKey & key)
+{
+    return stream << key.toString();
+}
+
 
 /*****************************************************************************/
 /* SHADOW ACCOUNT                                                            */
@@ -467,7 +555,8 @@ struct ShadowAccount {
         Date timestamp;  ///< When the commitment was made
     };
 
-    std::unordered_map<std::string, Commitment> commitments; 
+    std::unordered_map<CommitmentKey, Commitment, CommitmentKey::Hash>
+        commitments;
 
     void checkInvariants() const
     {
@@ -576,7 +665,7 @@ struct ShadowAccount {
     /* SPEND AUTHORIZATION                                                   */
     /*************************************************************************/
 
-    bool authorizeBid(const std::string & item,
+    bool authorizeBid(const CommitmentKey & item,
                       Amount amount)
     {
         checkInvariants();
@@ -594,19 +683,19 @@ struct ShadowAccount {
         return true;
     }
     
-    void commitBid(const std::string & item,
+    void commitBid(const CommitmentKey & item,
                    Amount amountPaid,
                    const LineItems & lineItems)
     {
         commitDetachedBid(detachBid(item), amountPaid, lineItems);
     }
 
-    void cancelBid(const std::string & item)
+    void cancelBid(const CommitmentKey & item)
     {
         commitDetachedBid(detachBid(item), Amount(), LineItems());
     }
     
-    Amount detachBid(const std::string & item)
+    Amount detachBid(const CommitmentKey & item)
     {
         checkInvariants();
 
@@ -624,11 +713,11 @@ struct ShadowAccount {
         return amountAuthorized;
     }
 
-    void attachBid(const std::string & item,
+    void attachBid(const CommitmentKey & item,
                    Amount amount)
     {
         Date now = Date::now();
-        auto c = commitments.insert(make_pair(item, Commitment(amount, now)));
+        auto c = commitments.insert(std::make_pair(item, Commitment(amount, now)));
         if (!c.second)
             throw ML::Exception("attempt to re-open commitment");
         attachedBids++;
@@ -884,6 +973,17 @@ struct Accounts {
         newAccount.status = Account::ACTIVE;
     }
 
+    /** Restore the exact state of an account, including its balance and
+        status, as saved by the banker journal.
+    */
+    void restoreAccount(const AccountKey & accountKey,
+                        const Account & account)
+    {
+        Guard guard(lock);
+        AccountInfo & info = ensureAccount(accountKey, account.type);
+        static_cast<Account &>(info) = account;
+    }
+
     void reactivateAccount(const AccountKey & accountKey)
     {
         Guard guard(lock);
@@ -1120,6 +1220,34 @@ struct Accounts {
         return (outOfSyncAccounts.count(account) > 0);
     }
 
+    /** Accounts that were modified since the last call, with their state
+        at the time of the call.  The set of changed accounts is cleared,
+        so that each modification is returned once.
+    */
+    typedef std::vector<std::pair<AccountKey, Account> > AccountChanges;
+
+    AccountChanges takeChangedAccounts()
+    {
+        Guard guard(lock);
+
+        AccountChanges result;
+        result.reserve(changedAccounts.size());
+        for (auto & key: changedAccounts)
+            result.emplace_back(key, accounts.at(key));
+        changedAccounts.clear();
+
+        return result;
+    }
+
+    /** Forget about the modifications made so far, for example once the
+        accounts have just been loaded from storage.
+    */
+    void clearChangedAccounts()
+    {
+        Guard guard(lock);
+        changedAccounts.clear();
+    }
+
 
     /** interaccount consistency */
     /* "Inconsistent" here means that there is a mismatch between the members
@@ -1162,6 +1290,11 @@ private:
     AccountSet outOfSyncAccounts;
     AccountSet inconsistentAccounts;
 
+    /* Accounts obtained through the non-const accessors below since the
+       last takeChangedAccounts().  Every modification goes through one of
+       them. */
+    AccountSet changedAccounts;
+
 public:
     std::vector<AccountKey>
     getAccountKeys(const AccountKey & prefix = AccountKey(),
@@ -1236,6 +1369,8 @@ private:
     {
         ExcAssertGreaterEqual(accountKey.size(), 1);
 
+        changedAccounts.insert(accountKey);
+
         auto it = accounts.find(accountKey);
         if (it != accounts.end()) {
             ExcAssertEqual(it->second.type, type);
@@ -1262,6 +1397,7 @@ private:
         auto it = accounts.find(account);
         if (it == accounts.end())
             throw ML::Exception("couldn't get account: " + account.toString());
+        changedAccounts.insert(account);
         return it->second;
     }
 
@@ -1374,24 +1510,37 @@ private:
 /* SHADOW ACCOUNTS                                                           */
 /*****************************************************************************/
 
+/** Set of shadow accounts of a slave banker.
+
+    The accounts are spread over a fixed number of shards, each one with its
+    own lock and hash table, so that bid operations on different accounts
+    from different threads don't serialize on a single lock.  Operations
+    that look at all the accounts (synchronization, iteration, logging) lock
+    the shards one after the other and so only see a consistent state per
+    account, not across accounts.
+*/
+
 struct ShadowAccounts {
     /** Callback called whenever a new account is created.  This can be
         assigned to in order to add functionality that must be present
-        whenever a new account is created.
+        whenever a new account is created.  It is called with the lock of
+        the account's shard held.
     */
     std::function<void (AccountKey)> onNewAccount;
     
     const ShadowAccount activateAccount(const AccountKey & account)
     {
-        Guard guard(lock);
-        return getAccountImpl(account);
+        Shard & shard = getShard(account);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, account);
     }
 
     const ShadowAccount syncFromMaster(const AccountKey & account,
                                        const Account & master)
     {
-        Guard guard(lock);
-        auto & a = getAccountImpl(account);
+        Shard & shard = getShard(account);
+        Guard guard(shard.lock);
+        auto & a = getAccountImpl(shard, account);
         ExcAssert(!a.uninitialized);
         a.syncFromMaster(master);
         return a;
@@ -1404,8 +1553,9 @@ struct ShadowAccounts {
     initializeAndMergeState(const AccountKey & account,
                             const Account & master)
     {
-        Guard guard(lock);
-        auto & a = getAccountImpl(account);
+        Shard & shard = getShard(account);
+        Guard guard(shard.lock);
+        auto & a = getAccountImpl(shard, account);
         ExcAssert(a.uninitialized);
         a.initializeAndMergeState(master);
         a.uninitialized = false;
@@ -1414,29 +1564,35 @@ struct ShadowAccounts {
 
     void checkInvariants() const
     {
-        Guard guard(lock);
-        for (auto & a: accounts) {
-            a.second.checkInvariants();
+        for (auto & shard: shards) {
+            Guard guard(shard.lock);
+            for (auto & a: shard.accounts) {
+                a.second.checkInvariants();
+            }
         }
     }
 
     const ShadowAccount getAccount(const AccountKey & accountKey) const
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey);
+        const Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey);
     }
 
     bool accountExists(const AccountKey & accountKey) const
     {
-        Guard guard(lock);
-        return accounts.count(accountKey);
+        const Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return shard.accounts.count(accountKey);
     }
 
     bool createAccountAtomic(const AccountKey & accountKey)
     {
-    	Guard guard(lock);
+        Shard & shard = getShard(accountKey);
+    	Guard guard(shard.lock);
 
-    	AccountEntry & account = getAccountImpl(accountKey, false /* call onCreate */);
+    	AccountEntry & account = getAccountImpl(shard, accountKey,
+                                                false /* call onCreate */);
     	bool result = account.first;
 
     	// record that this account creation is requested for the first time
@@ -1451,55 +1607,64 @@ struct ShadowAccounts {
 
     void syncTo(Accounts & master) const
     {
-        Guard guard1(lock);
-        Guard guard2(master.lock);
+        for (auto & shard: shards) {
+            Guard guard1(shard.lock);
+            Guard guard2(master.lock);
 
-        for (auto & a: accounts)
-            a.second.syncToMaster(master.getAccountImpl(a.first));
+            for (auto & a: shard.accounts)
+                a.second.syncToMaster(master.getAccountImpl(a.first));
+        }
     }
 
     void syncFrom(const Accounts & master)
     {
-        Guard guard1(lock);
-        Guard guard2(master.lock);
+        for (auto & shard: shards) {
+            Guard guard1(shard.lock);
+            Guard guard2(master.lock);
 
-        for (auto & a: accounts) {
-            a.second.syncFromMaster(master.getAccountImpl(a.first));
-            if (master.outOfSyncAccounts.count(a.first) > 0) {
-                outOfSyncAccounts.insert(a.first);
+            for (auto & a: shard.accounts) {
+                a.second.syncFromMaster(master.getAccountImpl(a.first));
+                if (master.outOfSyncAccounts.count(a.first) > 0) {
+                    shard.outOfSyncAccounts.insert(a.first);
+                }
             }
         }
     }
 
     void sync(Accounts & master)
     {
-        Guard guard1(lock);
-        Guard guard2(master.lock);
+        for (auto & shard: shards) {
+            Guard guard1(shard.lock);
+            Guard guard2(master.lock);
 
-        for (auto & a: accounts) {
-            a.second.syncToMaster(master.getAccountImpl(a.first));
-            a.second.syncFromMaster(master.getAccountImpl(a.first));
+            for (auto & a: shard.accounts) {
+                a.second.syncToMaster(master.getAccountImpl(a.first));
+                a.second.syncFromMaster(master.getAccountImpl(a.first));
+            }
         }
     }
 
     bool isInitialized(const AccountKey & accountKey) const
     {
-        Guard guard(lock);
-        return !getAccountImpl(accountKey).uninitialized;
+        const Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return !getAccountImpl(shard, accountKey).uninitialized;
     }
 
     bool isStalled(const AccountKey & accountKey) const
     {
-        Guard guard(lock);
-        auto & account = getAccountImpl(accountKey);
+        const Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        auto & account = getAccountImpl(shard, accountKey);
         return account.uninitialized && account.requested.minutesUntil(Date::now()) >= 1.0;
     }
 
     void reinitializeStalledAccount(const AccountKey & accountKey)
     {
         ExcAssert(isStalled(accountKey));
-        Guard guard(lock);
-        auto & account = getAccountImpl(accountKey);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        auto & account = getAccountImpl(shard, accountKey);
         account.first = true;
         account.requested = Date::now();
     }
@@ -1509,36 +1674,42 @@ struct ShadowAccounts {
     /*************************************************************************/
 
     bool authorizeBid(const AccountKey & accountKey,
-                      const std::string & item,
+                      const CommitmentKey & item,
                       Amount amount)
     {
-        Guard guard(lock);
-        return (outOfSyncAccounts.count(accountKey) == 0
-                && getAccountImpl(accountKey).authorizeBid(item, amount));
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return (shard.outOfSyncAccounts.count(accountKey) == 0
+                && getAccountImpl(shard, accountKey).authorizeBid(item, amount));
     }
     
     void commitBid(const AccountKey & accountKey,
-                   const std::string & item,
+                   const CommitmentKey & item,
                    Amount amountPaid,
                    const LineItems & lineItems)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey).commitBid(item, amountPaid, lineItems);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey)
+            .commitBid(item, amountPaid, lineItems);
     }
 
     void cancelBid(const AccountKey & accountKey,
-                   const std::string & item)
+                   const CommitmentKey & item)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey).cancelBid(item);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey).cancelBid(item);
     }
     
     void forceWinBid(const AccountKey & accountKey,
                      Amount amountPaid,
                      const LineItems & lineItems)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey).forceWinBid(amountPaid, lineItems);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey)
+            .forceWinBid(amountPaid, lineItems);
     }
 
     /// Commit a bid that has been detached from its tracking
@@ -1547,31 +1718,35 @@ struct ShadowAccounts {
                            Amount amountPaid,
                            const LineItems & lineItems)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey)
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey)
             .commitDetachedBid(amountAuthorized, amountPaid, lineItems);
     }
 
     /// Commit a specific currency (amountToCommit)
     void commitEvent(const AccountKey & accountKey, const Amount & amountToCommit)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey).commitEvent(amountToCommit);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey).commitEvent(amountToCommit);
     }
 
     Amount detachBid(const AccountKey & accountKey,
-                     const std::string & item)
+                     const CommitmentKey & item)
     {
-        Guard guard(lock);
-        return getAccountImpl(accountKey).detachBid(item);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        return getAccountImpl(shard, accountKey).detachBid(item);
     }
 
     void attachBid(const AccountKey & accountKey,
-                   const std::string & item,
+                   const CommitmentKey & item,
                    Amount amountAuthorized)
     {
-        Guard guard(lock);
-        getAccountImpl(accountKey).attachBid(item, amountAuthorized);
+        Shard & shard = getShard(accountKey);
+        Guard guard(shard.lock);
+        getAccountImpl(shard, accountKey).attachBid(item, amountAuthorized);
     }
 
     void logBidEvents(const Datacratic::EventRecorder & eventRecorder);
@@ -1600,61 +1775,86 @@ private:
         bool first;
     };
 
-    AccountEntry & getAccountImpl(const AccountKey & account,
+    typedef ML::Spinlock Lock;
+    typedef std::unique_lock<Lock> Guard;
+
+    typedef std::unordered_map<AccountKey, AccountEntry> AccountMap;
+    typedef std::unordered_set<AccountKey> AccountSet;
+
+    struct Shard {
+        mutable Lock lock;
+        AccountMap accounts;
+        AccountSet outOfSyncAccounts;
+    };
+
+    enum { NumShards = 32 };
+    Shard shards[NumShards];
+
+    Shard & getShard(const AccountKey & account)
+    {
+        return shards[account.hash() % NumShards];
+    }
+
+    const Shard & getShard(const AccountKey & account) const
+    {
+        return shards[account.hash() % NumShards];
+    }
+
+    AccountEntry & getAccountImpl(Shard & shard,
+                                  const AccountKey & account,
                                   bool callOnNewAccount = true)
     {
-        auto it = accounts.find(account);
-        if (it == accounts.end()) {
+        auto it = shard.accounts.find(account);
+        if (it == shard.accounts.end()) {
             if (callOnNewAccount && onNewAccount)
                 onNewAccount(account);
-            it = accounts.insert(std::make_pair(account, AccountEntry()))
+            it = shard.accounts.insert(std::make_pair(account, AccountEntry()))
                 .first;
         }
         return it->second;
     }
 
-    const AccountEntry & getAccountImpl(const AccountKey & account) const
+    const AccountEntry & getAccountImpl(const Shard & shard,
+                                        const AccountKey & account) const
     {
-        auto it = accounts.find(account);
-        if (it == accounts.end())
+        auto it = shard.accounts.find(account);
+        if (it == shard.accounts.end())
             throw ML::Exception("getting unknown account " + account.toString());
         return it->second;
     }
 
-    typedef ML::Spinlock Lock;
-    typedef std::unique_lock<Lock> Guard;
-    mutable Lock lock;
-
-    typedef std::map<AccountKey, AccountEntry> AccountMap;
-    AccountMap accounts;
-
-    typedef std::unordered_set<AccountKey> AccountSet;
-    AccountSet outOfSyncAccounts;
-
 public:
+    /** Returns the keys of the accounts under the given prefix, sorted. */
     std::vector<AccountKey>
     getAccountKeys(const AccountKey & prefix = AccountKey()) const
     {
-        Guard guard(lock);
-
         std::vector<AccountKey> result;
 
-        for (auto it = accounts.lower_bound(prefix), end = accounts.end();
-             it != accounts.end() && it->first.hasPrefix(prefix);  ++it) {
-            result.push_back(it->first);
+        for (auto & shard: shards) {
+            Guard guard(shard.lock);
+            for (auto & a: shard.accounts) {
+                if (a.first.hasPrefix(prefix))
+                    result.push_back(a.first);
+            }
         }
+
+        std::sort(result.begin(), result.end());
         return result;
     }
 
+    /** Calls onAccount for every account, in no particular order.  The
+        lock of the account's shard is held during the call.
+    */
     void
     forEachAccount(const std::function<void (const AccountKey &,
                                              const ShadowAccount &)> &
                    onAccount) const
     {
-        Guard guard(lock);
-        
-        for (auto & a: accounts) {
-            onAccount(a.first, a.second);
+        for (auto & shard: shards) {
+            Guard guard(shard.lock);
+            for (auto & a: shard.accounts) {
+                onAccount(a.first, a.second);
+            }
         }
     }
 
@@ -1662,25 +1862,29 @@ public:
     forEachInitializedAndActiveAccount(const std::function<void (const AccountKey &,
                                                         const ShadowAccount &)> & onAccount)
     {
-        Guard guard(lock);
-        
-        for (auto & a: accounts) {
-            if (a.second.uninitialized || a.second.status == Account::CLOSED)
-                continue;
-            onAccount(a.first, a.second);
+        for (auto & shard: shards) {
+            Guard guard(shard.lock);
+            for (auto & a: shard.accounts) {
+                if (a.second.uninitialized || a.second.status == Account::CLOSED)
+                    continue;
+                onAccount(a.first, a.second);
+            }
         }
     }
 
     size_t size() const
     {
-        Guard guard(lock);
-        return accounts.size();
+        size_t result = 0;
+        for (auto & shard: shards) {
+            Guard guard(shard.lock);
+            result += shard.accounts.size();
+        }
+        return result;
     }
 
     bool empty() const
     {
-        Guard guard(lock);
-        return accounts.empty();
+        return size() == 0;
     }
 };
 
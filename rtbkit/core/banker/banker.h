@@ -293,7 +293,7 @@ public:
      * extremely fast and synchronous.
      */
     virtual bool authorizeBid(const AccountKey & account,
-                              const std::string & item,
+                              const CommitmentKey & item,
                               Amount amount) = 0;
 
     /*
@@ -305,13 +305,13 @@ public:
      *
      */
     virtual void cancelBid(const AccountKey & account,
-                           const std::string & item)
+                           const CommitmentKey & item)
     {
         return commitBid(account, item, Amount(), LineItems());
     }
 
     virtual void winBid(const AccountKey & account,
-                        const std::string & item,
+                        const CommitmentKey & item,
                         Amount amountPaid,
                         const LineItems & lineItems = LineItems())
     {
@@ -319,17 +319,17 @@ public:
     }
     
     virtual void attachBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountAuthorized) = 0;
 
     virtual Amount detachBid(const AccountKey & account,
-                             const std::string & item) = 0;
+                             const CommitmentKey & item) = 0;
 
     /** Commit a bid.  This is used internally to both cancel and win bids.
         Asynchonous and returns no value.
     */
     virtual void commitBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountPaid,
                            const LineItems & lineItems) = 0;
 
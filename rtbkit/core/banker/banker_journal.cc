@@ -0,0 +1,257 @@
+/* banker_journal.cc
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Local write-ahead log of the master banker's accounts.
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "banker_journal.h"
+#include "jml/arch/exception.h"
+#include "jml/db/persistent.h"
+#include "jml/utils/xxhash.h"
+
+using namespace std;
+using namespace ML;
+
+
+namespace RTBKIT {
+
+namespace {
+
+const char journalMagic[4] = { 'B', 'K', 'J', '1' };
+
+/* Length and hash of the record that follows. */
+struct RecordHeader {
+    uint32_t length;
+    uint32_t hash;
+};
+
+enum { HASH_SEED = 0x42414e4b };
+
+void appendRecord(std::string & output,
+                  const AccountKey & key, const Account & account)
+{
+    std::ostringstream stream;
+    {
+        DB::Store_Writer store(stream);
+        key.serialize(store);
+        account.serialize(store);
+    }
+    std::string payload = stream.str();
+
+    RecordHeader header;
+    header.length = payload.size();
+    header.hash = XXH32(payload.c_str(), payload.size(), HASH_SEED);
+    output.append((const char *)&header, sizeof(header));
+    output.append(payload);
+}
+
+void writeFully(int fd, const std::string & data, const std::string & path)
+{
+    const char * p = data.c_str();
+    size_t remaining = data.size();
+
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, p, remaining);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            throw ML::Exception(errno, "write to banker journal " + path);
+        }
+        p += written;
+        remaining -= written;
+    }
+}
+
+} // file scope
+
+
+/*****************************************************************************/
+/* BANKER JOURNAL                                                            */
+/*****************************************************************************/
+
+BankerJournal::
+BankerJournal(const std::string & path, bool syncWrites)
+    : path_(path), syncWrites(syncWrites), fd(-1), numRecords(0)
+{
+    open();
+}
+
+BankerJournal::
+~BankerJournal()
+{
+    close();
+}
+
+void
+BankerJournal::
+open()
+{
+    fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1)
+        throw ML::Exception(errno, "open banker journal " + path_);
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+        throw ML::Exception(errno, "fstat banker journal " + path_);
+
+    if (st.st_size == 0)
+        writeAll(std::string(journalMagic, sizeof(journalMagic)));
+}
+
+void
+BankerJournal::
+close()
+{
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void
+BankerJournal::
+writeAll(const std::string & data)
+{
+    writeFully(fd, data, path_);
+
+    if (syncWrites && fdatasync(fd) == -1)
+        throw ML::Exception(errno, "fdatasync banker journal " + path_);
+}
+
+void
+BankerJournal::
+append(const Accounts::AccountChanges & changes)
+{
+    if (changes.empty())
+        return;
+
+    // All the records go out in a single write
+    std::string data;
+    for (auto & change: changes)
+        appendRecord(data, change.first, change.second);
+
+    writeAll(data);
+    numRecords += changes.size();
+}
+
+size_t
+BankerJournal::
+recover(Accounts & accounts)
+{
+    int readFd = ::open(path_.c_str(), O_RDONLY);
+    if (readFd == -1)
+        throw ML::Exception(errno, "open banker journal " + path_);
+
+    std::string contents;
+    char buf[65536];
+    for (;;) {
+        ssize_t res = ::read(readFd, buf, sizeof(buf));
+        if (res == -1) {
+            if (errno == EINTR)
+                continue;
+            ::close(readFd);
+            throw ML::Exception(errno, "read banker journal " + path_);
+        }
+        if (res == 0)
+            break;
+        contents.append(buf, res);
+    }
+    ::close(readFd);
+
+    if (contents.size() < sizeof(journalMagic)
+        || memcmp(contents.c_str(), journalMagic, sizeof(journalMagic)) != 0)
+        throw ML::Exception("file " + path_ + " is not a banker journal");
+
+    // The last record of each account is the one that counts.  Going
+    // through a map also restores the parents before their children.
+    std::map<AccountKey, Account> recovered;
+
+    size_t offset = sizeof(journalMagic);
+    numRecords = 0;
+
+    while (offset < contents.size()) {
+        RecordHeader header;
+        if (contents.size() - offset < sizeof(header))
+            break;
+        memcpy(&header, contents.c_str() + offset, sizeof(header));
+
+        const char * payload = contents.c_str() + offset + sizeof(header);
+        if (contents.size() - offset - sizeof(header) < header.length)
+            break;
+        if (XXH32(payload, header.length, HASH_SEED) != header.hash)
+            break;
+
+        DB::Store_Reader store(payload, header.length);
+        AccountKey key;
+        key.reconstitute(store);
+        recovered[key].reconstitute(store);
+
+        offset += sizeof(header) + header.length;
+        ++numRecords;
+    }
+
+    if (offset != contents.size()) {
+        cerr << "banker journal " << path_ << ": dropping "
+             << contents.size() - offset
+             << " bytes of incomplete record at offset " << offset << endl;
+        if (ftruncate(fd, offset) == -1)
+            throw ML::Exception(errno, "truncate banker journal " + path_);
+    }
+
+    for (auto & r: recovered)
+        accounts.restoreAccount(r.first, r.second);
+
+    return recovered.size();
+}
+
+void
+BankerJournal::
+compact(const Accounts & accounts)
+{
+    std::string data(journalMagic, sizeof(journalMagic));
+    size_t records = 0;
+
+    auto onAccount = [&] (const AccountKey & key, const Account & account)
+        {
+            appendRecord(data, key, account);
+            ++records;
+        };
+    accounts.forEachAccount(onAccount);
+
+    // Write the new journal to the side and move it over the old one, so
+    // that a crash while compacting leaves one or the other intact.
+    std::string tmpPath = path_ + ".tmp";
+
+    int tmpFd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (tmpFd == -1)
+        throw ML::Exception(errno, "open banker journal " + tmpPath);
+
+    try {
+        writeFully(tmpFd, data, tmpPath);
+        if (fdatasync(tmpFd) == -1)
+            throw ML::Exception(errno, "fdatasync banker journal " + tmpPath);
+    } catch (...) {
+        ::close(tmpFd);
+        ::unlink(tmpPath.c_str());
+        throw;
+    }
+    ::close(tmpFd);
+
+    if (::rename(tmpPath.c_str(), path_.c_str()) == -1)
+        throw ML::Exception(errno, "rename banker journal " + tmpPath);
+
+    close();
+    open();
+    numRecords = records;
+}
+
+} // namespace RTBKIT
@@ -0,0 +1,89 @@
+/* banker_journal.h                                                -*- C++ -*-
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Local write-ahead log of the master banker's accounts.
+*/
+
+#pragma once
+
+#include <string>
+#include "account.h"
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* BANKER JOURNAL                                                            */
+/*****************************************************************************/
+
+/** Append-only local file holding the state of the banker's accounts.
+
+    Every time accounts are modified, their new state is appended as a
+    binary record.  Replaying the file, with the last record of each account
+    taking precedence, gives back the state of all the accounts, which
+    allows the master banker to restart without reloading everything from
+    its persistence backend.
+
+    Since records hold the complete state of an account rather than a
+    delta, the file can be compacted at any time by rewriting it with a
+    single record per account.
+
+    Each record is made of its length, an xxhash of its content and the
+    account key and account serialized with ML::DB.  A record that was
+    only partially written when the process died is detected on recovery
+    and dropped.
+
+    This class is not thread safe; callers must serialize access to it.
+*/
+
+struct BankerJournal {
+
+    /** Open the journal at the given path, creating it if it doesn't
+        exist.  If syncWrites is true, every append is followed by an
+        fdatasync, which protects against losing the last changes on a
+        machine crash at the cost of a disk flush on every modification.
+    */
+    BankerJournal(const std::string & path, bool syncWrites = false);
+
+    ~BankerJournal();
+
+    /** Append the state of the given accounts to the journal. */
+    void append(const Accounts::AccountChanges & changes);
+
+    /** Read back the journal into the given accounts.  Returns the number
+        of accounts that were recovered, which is zero for an empty
+        journal.  A partially written record at the end of the file is
+        truncated away.
+    */
+    size_t recover(Accounts & accounts);
+
+    /** Rewrite the journal with a single record for each of the given
+        accounts.  The new file replaces the old one atomically.
+    */
+    void compact(const Accounts & accounts);
+
+    /** Returns true when the journal holds enough obsolete records that
+        it is worth compacting for the given number of accounts.
+    */
+    bool needsCompaction(size_t numAccounts) const
+    {
+        return numRecords > 2 * numAccounts + 1000;
+    }
+
+    const std::string & path() const { return path_; }
+
+    /** Number of records in the file, obsolete ones included. */
+    size_t records() const { return numRecords; }
+
+private:
+    void open();
+    void close();
+    void writeAll(const std::string & data);
+
+    std::string path_;
+    bool syncWrites;
+    int fd;
+    size_t numRecords;
+};
+
+} // namespace RTBKIT
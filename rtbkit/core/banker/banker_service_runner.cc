@@ -48,6 +48,10 @@ int main(int argc, char ** argv)
 
     bool debug = false;
 
+    bool incrementalSaves = false;
+    std::string journalPath;
+    bool journalSync = false;
+
     std::vector<std::string> fixedHttpBindAddresses;
 
     configuration_options.add_options()
@@ -63,6 +67,13 @@ int main(int argc, char ** argv)
          "Periodic delay at which state will be saved")
         ("fixed-http-bind-address,a", value(&fixedHttpBindAddresses),
          "Fixed address (host:port or *:port) at which we will always listen")
+        ("incremental-saves", bool_switch(&incrementalSaves),
+         "Only save the accounts that changed since the last save")
+        ("journal", value<string>(&journalPath),
+         "Local file to which every account change is logged, and from "
+         "which the accounts are recovered on restart")
+        ("journal-sync", bool_switch(&journalSync),
+         "Flush the journal to disk after every change")
         ("debug", bool_switch(&debug),
          "Debug mode enabled");
 
@@ -95,6 +106,10 @@ int main(int argc, char ** argv)
     if (debug)
         banker.debug.activate();
 
+    banker.incrementalSaves = incrementalSaves;
+    if (!journalPath.empty())
+        banker.journal = std::make_shared<BankerJournal>(journalPath, journalSync);
+
     if (redisUri != "nopersistence") {
         std::cout << " redisUri=" << redisUri << std::endl;
         auto address = Redis::Address(redisUri);
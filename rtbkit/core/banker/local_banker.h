@@ -46,7 +46,7 @@ struct LocalBanker : public Banker, Datacratic::MessageLoop, Datacratic::Service
 
     virtual bool
     authorizeBid(const AccountKey & account,
-                 const std::string & item,
+                 const CommitmentKey & item,
                  Amount amount)
     {
         return bid(account, amount);
@@ -54,13 +54,13 @@ struct LocalBanker : public Banker, Datacratic::MessageLoop, Datacratic::Service
 
     virtual void
     cancelBid(const AccountKey & account,
-              const std::string & item)
+              const CommitmentKey & item)
     {
     }
 
     virtual void
     winBid(const AccountKey & account,
-           const std::string & item,
+           const CommitmentKey & item,
            Amount amountPaid,
            const LineItems & lineItems = LineItems())
     {
@@ -69,21 +69,21 @@ struct LocalBanker : public Banker, Datacratic::MessageLoop, Datacratic::Service
 
     virtual void
     attachBid(const AccountKey & account,
-              const std::string & item,
+              const CommitmentKey & item,
               Amount amountAuthorized)
     {
     }
 
     virtual Amount
     detachBid(const AccountKey & account,
-              const std::string & item)
+              const CommitmentKey & item)
     {
         return MicroUSD(0);
     }
 
     virtual void
     commitBid(const AccountKey & account,
-              const std::string & item,
+              const CommitmentKey & item,
               Amount amountPaid,
               const LineItems & lineItems)
     {
@@ -132,12 +132,43 @@ saveAll(const Accounts & toSave, OnSavedCallback onSaved)
     /* TODO: we need to check the content of the "banker:accounts" set for
      * "extra" account keys */
 
+    vector<string> keys;
+
+    /* fetch all account keys and values from storage */
+    auto onAccount = [&] (const AccountKey & key,
+                          const Account & account)
+        {
+            keys.push_back(key.toString());
+        };
+    toSave.forEachAccount(onAccount);
+
+    saveKeys(toSave, std::move(keys), onSaved);
+}
+
+void
+RedisBankerPersistence::
+saveChanged(const Accounts & toSave, const vector<AccountKey> & changed,
+            OnSavedCallback onSaved)
+{
+    /* Same as saveAll, but only the accounts that changed since the last
+       save are fetched, checked and written. */
+    vector<string> keys;
+    keys.reserve(changed.size());
+    for (auto & key: changed)
+        keys.push_back(key.toString());
+
+    saveKeys(toSave, std::move(keys), onSaved);
+}
+
+void
+RedisBankerPersistence::
+saveKeys(const Accounts & toSave, vector<string> keys, OnSavedCallback onSaved)
+{
     // Phase 1: we load all of the keys.  This way we can know what is
     // present and deal with keys that should be zeroed out.  We can also
     // detect if we have a synchronization error and bail out.
 
     const Date begin = Date::now();
-    vector<string> keys;
 
     Redis::Command fetchCommand(MGET);
 
@@ -145,15 +176,8 @@ saveAll(const Accounts & toSave, OnSavedCallback onSaved)
         return rhs.secondsSince(lhs) * 1000;
     };
 
-    /* fetch all account keys and values from storage */
-    auto onAccount = [&] (const AccountKey & key,
-                          const Account & account)
-        {
-            string keyStr = key.toString();
-            keys.push_back(keyStr);
-            fetchCommand.addArg(PREFIX + keyStr);
-        };
-    toSave.forEachAccount(onAccount);
+    for (auto & key: keys)
+        fetchCommand.addArg(PREFIX + key);
 
     const Date beforePhase1Time = Date::now();
     auto onPhase1Result = [=] (const Redis::Result & result)
@@ -585,7 +609,8 @@ MasterBanker(std::shared_ptr<ServiceProxies> proxies,
              const string & serviceName)
     : ServiceBase(serviceName, proxies),
       RestServiceEndpoint(proxies->zmqContext),
-      saving(false)
+      saving(false),
+      incrementalSaves(false)
 {
     /* Set the Access-Control-Allow-Origins: * header to allow browser-based
        REST calls directly to the endpoint.
@@ -881,6 +906,7 @@ createAccount(const AccountKey & key, AccountType type)
     reactivatePresentAccounts(key);
 
     Account account = accounts.createAccount(key, type);
+    journalChanges();
     return account.toJson();
 
     if (type == AT_BUDGET)
@@ -947,6 +973,19 @@ onStateSaved(const BankerPersistence::Result& result,
     lastSaveLatency = std::move(result.latencies);
 
     reportLatencies("save state", result.latencies);
+
+    {
+        // Accounts that didn't make it are tried again on the next save,
+        // including those that the storage skipped for being out of sync
+        std::lock_guard<std::mutex> journalGuard(journalLock);
+        for (auto & key: savingAccounts) {
+            if (result.status != BankerPersistence::SUCCESS
+                || accounts.isAccountOutOfSync(key))
+                unsavedAccounts.insert(key);
+        }
+        savingAccounts.clear();
+    }
+
     saving = false;
     ML::futex_wake(saving);
 }
@@ -959,13 +998,54 @@ saveState()
 
     Guard guard(saveLock);
 
+    journalChanges();
+
+    if (journal) {
+        std::lock_guard<std::mutex> journalGuard(journalLock);
+        if (journal->needsCompaction(accounts.size())) {
+            journal->compact(accounts);
+            recordHit("journal.compactions");
+        }
+    }
+
     if (!storage_ || saving)
         return;
 
+    {
+        std::lock_guard<std::mutex> journalGuard(journalLock);
+        savingAccounts.assign(unsavedAccounts.begin(), unsavedAccounts.end());
+        unsavedAccounts.clear();
+    }
+
     saving = true;
-    storage_->saveAll(accounts, bind(&MasterBanker::onStateSaved, this,
-                                          placeholders::_1,
-                                          placeholders::_2));
+    auto onSaved = bind(&MasterBanker::onStateSaved, this,
+                        placeholders::_1,
+                        placeholders::_2);
+    if (incrementalSaves) {
+        recordLevel(savingAccounts.size(), "save.accounts");
+        // Nothing changed since the last save: there's nothing to send
+        if (savingAccounts.empty())
+            onSaved(BankerPersistence::SUCCESS, "");
+        else storage_->saveChanged(accounts, savingAccounts, onSaved);
+    }
+    else storage_->saveAll(accounts, onSaved);
+}
+
+void
+MasterBanker::
+journalChanges()
+{
+    std::lock_guard<std::mutex> guard(journalLock);
+
+    auto changes = accounts.takeChangedAccounts();
+    if (changes.empty())
+        return;
+
+    if (journal)
+        journal->append(changes);
+
+    for (auto & change: changes)
+        unsavedAccounts.insert(change.first);
 }
 
 void
@@ -978,6 +1058,7 @@ onStateLoaded(shared_ptr<Accounts> newAccounts,
         recordHit("load.success");
         newAccounts->ensureInterAccountConsistency();
         accounts = *newAccounts;
+        accounts.clearChangedAccounts();
         LOG(print) << "successfully loaded accounts" << endl;
     }
     else if (result.status == BankerPersistence::DATA_INCONSISTENCY) {
@@ -1002,6 +1083,29 @@ loadStateSync()
 {
     recordHit("load.attempts");
 
+    if (journal) {
+        Accounts recovered;
+        size_t numRecovered = journal->recover(recovered);
+        if (numRecovered > 0) {
+            recordHit("load.journal");
+            recovered.ensureInterAccountConsistency();
+            accounts = recovered;
+
+            // The persistence may be behind the journal, so all of the
+            // recovered accounts go out with the next save.
+            {
+                std::lock_guard<std::mutex> journalGuard(journalLock);
+                for (auto & change: accounts.takeChangedAccounts())
+                    unsavedAccounts.insert(change.first);
+                journal->compact(accounts);
+            }
+
+            LOG(print) << "recovered " << numRecovered
+                       << " accounts from journal " << journal->path() << endl;
+            return;
+        }
+    }
+
     if (!storage_)
         return;
 
@@ -1020,6 +1124,12 @@ loadStateSync()
     while (!done) {
         ML::futex_wait(done, 0);
     }
+
+    // Start the journal from the state that was loaded
+    if (journal) {
+        std::lock_guard<std::mutex> journalGuard(journalLock);
+        journal->compact(accounts);
+    }
 }
 
 void
@@ -1151,7 +1261,9 @@ setBudget(const AccountKey &key, const CurrencyPool &newBudget)
     checkPersistence();
 
     reactivatePresentAccounts(key); 
-    return accounts.setBudget(key, newBudget);
+    auto result = accounts.setBudget(key, newBudget);
+    journalChanges();
+    return result;
 }
 
 const Account
@@ -1162,7 +1274,9 @@ onCreateAccount(const AccountKey &key, AccountType type)
     checkPersistence();
  
     reactivatePresentAccounts(key);
-    return accounts.createAccount(key, type);
+    auto result = accounts.createAccount(key, type);
+    journalChanges();
+    return result;
 }
 
 bool
@@ -1174,6 +1288,7 @@ closeAccount(const AccountKey &key)
  
     reactivatePresentAccounts(key);
     auto account = accounts.closeAccount(key);
+    journalChanges();
     if (account.status == Account::CLOSED)
         return true;
     else
@@ -1201,7 +1316,9 @@ setBalance(const AccountKey &key, CurrencyPool amount, AccountType type)
     checkPersistence();
 
     reactivatePresentAccounts(key);
-    return accounts.setBalance(key, amount, type);
+    auto result = accounts.setBalance(key, amount, type);
+    journalChanges();
+    return result;
 }
 
 std::map<std::string, Account>
@@ -1227,6 +1344,7 @@ setBalanceBatched(const Json::Value &transfers)
         result[key] = accounts.setBalance(account, amount, type);
     }
 
+    journalChanges();
     return std::move(result);
 }
 
@@ -1238,7 +1356,9 @@ addAdjustment(const AccountKey &key, CurrencyPool amount)
     checkPersistence();
 
     reactivatePresentAccounts(key);
-    return accounts.addAdjustment(key, amount);
+    auto result = accounts.addAdjustment(key, amount);
+    journalChanges();
+    return result;
 }
 
 const Account
@@ -1253,7 +1373,9 @@ syncFromShadow(const AccountKey &key, const ShadowAccount &shadow)
     if (presentActive.first && !presentActive.second)
         return accounts.getAccount(key);
 
-    return accounts.syncFromShadow(key, shadow);
+    auto result = accounts.syncFromShadow(key, shadow);
+    journalChanges();
+    return result;
 }
 
 
@@ -1282,6 +1404,7 @@ syncFromShadowBatched(const Json::Value &transfers)
         }
     }
 
+    journalChanges();
     return result;
 }
 
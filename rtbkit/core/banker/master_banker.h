@@ -9,6 +9,7 @@
 #define __banker__master_banker_h__
 
 #include "banker.h"
+#include "banker_journal.h"
 #include "soa/service/named_endpoint.h"
 #include "soa/service/message_loop.h"
 #include "soa/service/redis.h"
@@ -197,6 +198,18 @@ struct BankerPersistence {
                          OnLoadedCallback onLoaded) = 0;
     virtual void saveAll(const Accounts & toSave,
                          OnSavedCallback onDone) = 0;
+
+    /** Save the accounts of toSave whose keys are in changed, which are the
+        accounts modified since the last successful save.  Backends that
+        can't save a subset of the accounts save all of them.
+    */
+    virtual void saveChanged(const Accounts & toSave,
+                             const std::vector<AccountKey> & changed,
+                             OnSavedCallback onDone)
+    {
+        saveAll(toSave, onDone);
+    }
+
     virtual void restoreFromArchive(const AccountKey & accountName,
                          OnRestoredCallback onRestored) = 0;
 };
@@ -251,8 +264,13 @@ struct RedisBankerPersistence : public BankerPersistence {
 
     void loadAll(const std::string & topLevelKey, OnLoadedCallback onLoaded);
     void saveAll(const Accounts & toSave, OnSavedCallback onDone);
+    void saveChanged(const Accounts & toSave,
+                     const std::vector<AccountKey> & changed,
+                     OnSavedCallback onDone);
     void restoreFromArchive(const AccountKey & key, OnRestoredCallback onRestored);
 private:
+    void saveKeys(const Accounts & toSave, std::vector<std::string> keys,
+                  OnSavedCallback onDone);
     void moveToActive(const std::vector<AccountKey> & archivedAccountKeys,
                                 OnRestoredCallback onRestored);
 };
@@ -321,6 +339,19 @@ struct MasterBanker
     mutable Lock saveLock;
     int saving;
 
+    /** If true, each save only gives the persistence the accounts that
+        changed since the last successful save, instead of all of them.
+        Must be set before init().
+    */
+    bool incrementalSaves;
+
+    /** Local journal to which every modification of the accounts is
+        appended.  When it is set and not empty, init() recovers the
+        accounts from it rather than loading them from the persistence.
+        Must be set before init().
+    */
+    std::shared_ptr<BankerJournal> journal;
+
     Json::Value createAccount(const AccountKey & key, AccountType type);
     Json::Value getAccountsSimpleSummaries(int depth);
 
@@ -361,6 +392,16 @@ private:
     void reportLatencies(const std::string& category,
                          const BankerPersistence::LatencyMap& latencies) const;
 
+    /** Append the accounts modified since the last call to the journal,
+        and remember them for the next incremental save.  Called after
+        every operation that modifies the accounts.
+    */
+    void journalChanges();
+
+    std::mutex journalLock;
+    std::unordered_set<AccountKey> unsavedAccounts; ///< changed since last save
+    std::vector<AccountKey> savingAccounts;         ///< in the current save
+
     bool closeAccount(const AccountKey &key);
     const std::vector<AccountKey> getActiveAccounts();
     void restoreAccount(const AccountKey & key);
@@ -63,7 +63,7 @@ NullBanker::NullBanker(bool authorize, const std::string & serviceName)
 bool
 NullBanker::
 authorizeBid(const AccountKey & account,
-             const std::string & item,
+             const CommitmentKey & item,
              Amount amountToAuthorize)
 {
     return authorize_;
@@ -72,7 +72,7 @@ authorizeBid(const AccountKey & account,
 void
 NullBanker::
 commitBid(const AccountKey & account,
-          const std::string & item,
+          const CommitmentKey & item,
           Amount amountPaid,
           const LineItems & lineItems)
 {
@@ -47,14 +47,14 @@ public:
     NullBanker(bool authorize = false, const std::string & servicName = "");
 
     virtual bool authorizeBid(const AccountKey & account,
-                              const std::string & item,
+                              const CommitmentKey & item,
                               Amount amount);
 
     /** Commit a bid.  This is used internally to both cancel and win bids.
         Asynchonous and returns no value.
     */
     virtual void commitBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountPaid,
                            const LineItems & lineItems);
 
@@ -63,13 +63,13 @@ public:
                              const LineItems & lineItems);
     
     virtual void attachBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountAuthorized)
     {
     }
 
     virtual Amount detachBid(const AccountKey & account,
-                             const std::string & item)
+                             const CommitmentKey & item)
     {
         return Amount();
     }
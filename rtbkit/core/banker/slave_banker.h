@@ -138,14 +138,14 @@ struct SlaveBanker : public Banker, public MessageLoop {
     }
 
     virtual bool authorizeBid(const AccountKey & account,
-                              const std::string & item,
+                              const CommitmentKey & item,
                               Amount amount)
     {
         return accounts.authorizeBid(account, item, amount);
     }
 
     virtual void commitBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountPaid,
                            const LineItems & lineItems)
     {
@@ -153,13 +153,13 @@ struct SlaveBanker : public Banker, public MessageLoop {
     }
 
     virtual Amount detachBid(const AccountKey & account,
-                             const std::string & item)
+                             const CommitmentKey & item)
     {
         return accounts.detachBid(account, item);
     }
 
     virtual void attachBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountAuthorized)
     {
         accounts.attachBid(account, item, amountAuthorized);
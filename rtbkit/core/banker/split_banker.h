@@ -48,7 +48,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual bool authorizeBid(const AccountKey & account,
-                              const std::string & item,
+                              const CommitmentKey & item,
                               Amount amount)
     {
         if (isLocal(account)) {
@@ -59,7 +59,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual void cancelBid(const AccountKey & account,
-                           const std::string & item)
+                           const CommitmentKey & item)
     {
         if (!isLocal(account)) {
             masterBanker->commitBid(account, item, Amount(), LineItems());
@@ -67,7 +67,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual void winBid(const AccountKey & account,
-                        const std::string & item,
+                        const CommitmentKey & item,
                         Amount amountPaid,
                         const LineItems & lineItems = LineItems())
     {
@@ -79,7 +79,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual void attachBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountAuthorized)
     {
         if (!isLocal(account)) {
@@ -88,7 +88,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual Amount detachBid(const AccountKey & account,
-                             const std::string & item)
+                             const CommitmentKey & item)
     {
         if (isLocal(account)) {
             return MicroUSD(0);
@@ -98,7 +98,7 @@ struct SplitBanker : public Banker {
     }
 
     virtual void commitBid(const AccountKey & account,
-                           const std::string & item,
+                           const CommitmentKey & item,
                            Amount amountPaid,
                            const LineItems & lineItems)
     {
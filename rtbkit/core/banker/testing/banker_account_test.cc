@@ -19,6 +19,8 @@
 #include "jml/arch/atomic_ops.h"
 #include "jml/arch/timers.h"
 #include "jml/utils/ring_buffer.h"
+#include <atomic>
+#include <algorithm>
 
 
 using namespace std;
@@ -473,6 +475,91 @@ BOOST_AUTO_TEST_CASE( test_accounts )
     cerr << accounts.getAccountSummary(budget) << endl;
 }
 
+BOOST_AUTO_TEST_CASE( test_shadow_accounts_shared_between_threads )
+{
+    Accounts master;
+
+    AccountKey budget("budget");
+    master.createBudgetAccount(budget);
+    master.setBudget(budget, USD(1000));
+
+    int nThreads = 8;
+    int nBids = 20000;
+
+    ShadowAccounts shadow;
+
+    std::vector<AccountKey> spendAccounts;
+    for (unsigned i = 0;  i < nThreads;  ++i) {
+        AccountKey account = budget.childKey("spend" + to_string(i));
+        master.createSpendAccount(account);
+        master.setBalance(account, USD(1), AT_SPEND);
+        shadow.activateAccount(account);
+        spendAccounts.push_back(account);
+    }
+
+    shadow.syncFrom(master);
+
+    // Keys come back sorted whichever shard they live in
+    auto keys = shadow.getAccountKeys(budget);
+    BOOST_CHECK_EQUAL(keys.size(), nThreads);
+    BOOST_CHECK(std::is_sorted(keys.begin(), keys.end()));
+
+    std::atomic<int> errors(0);
+    std::vector<int> numCommitted(nThreads);
+
+    // Every thread bids on its own account through the same ShadowAccounts,
+    // and two threads bid on each account so that the shards are exercised
+    // both with and without contention.
+    auto runBidThread = [&] (int threadNum)
+        {
+            const AccountKey & account = spendAccounts[threadNum / 2 * 2];
+            std::string agent = "agent" + to_string(threadNum);
+
+            for (int i = 0;  i < nBids;  ++i) {
+                CommitmentKey key(Id(i), Id(threadNum), agent);
+
+                if (!shadow.authorizeBid(account, key, MicroUSD(1))) {
+                    errors++;
+                    continue;
+                }
+
+                if (i % 2 == 0) {
+                    shadow.commitBid(account, key, MicroUSD(1), LineItems());
+                    numCommitted[threadNum]++;
+                }
+                else shadow.cancelBid(account, key);
+            }
+        };
+
+    boost::thread_group threads;
+    for (unsigned i = 0;  i < nThreads;  ++i)
+        threads.create_thread(std::bind(runBidThread, i));
+    threads.join_all();
+
+    BOOST_CHECK_EQUAL(errors, 0);
+
+    shadow.checkInvariants();
+    shadow.syncTo(master);
+    master.checkInvariants();
+
+    for (unsigned i = 0;  i < nThreads;  i += 2) {
+        int committed = numCommitted[i] + numCommitted[i + 1];
+        Account account = master.getAccount(spendAccounts[i]);
+        BOOST_CHECK_EQUAL(account.spent.getAvailable(CurrencyCode::CC_USD),
+                          MicroUSD(committed));
+    }
+
+    // A binary key and its string form are different commitments
+    AccountKey account = spendAccounts[0];
+    CommitmentKey key(Id("auction"), Id("spot"), "agent");
+    BOOST_CHECK(shadow.authorizeBid(account, key, MicroUSD(1)));
+    BOOST_CHECK(shadow.authorizeBid(account, key.toString(), MicroUSD(1)));
+    BOOST_CHECK_THROW(shadow.authorizeBid(account, key, MicroUSD(1)),
+                      ML::Exception);
+    BOOST_CHECK_EQUAL(shadow.detachBid(account, key), MicroUSD(1));
+    BOOST_CHECK_EQUAL(shadow.detachBid(account, key.toString()), MicroUSD(1));
+}
+
 BOOST_AUTO_TEST_CASE( test_multiple_bidder_threads )
 {
     Accounts master;
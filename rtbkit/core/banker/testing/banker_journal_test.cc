@@ -0,0 +1,214 @@
+/* banker_journal_test.cc
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Tests for the change tracking of the banker accounts and the local
+   journal in which the changes are logged.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rtbkit/core/banker/banker_journal.h"
+
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+namespace {
+
+std::set<AccountKey> changedKeys(Accounts & accounts)
+{
+    std::set<AccountKey> result;
+    for (auto & change: accounts.takeChangedAccounts())
+        result.insert(change.first);
+    return result;
+}
+
+void checkSameAccounts(const Accounts & a1, const Accounts & a2)
+{
+    BOOST_CHECK_EQUAL(a1.size(), a2.size());
+    a1.forEachAccount([&] (const AccountKey & key, const Account & account)
+        {
+            Account other = a2.getAccount(key);
+            BOOST_CHECK_EQUAL(account.toJson(), other.toJson());
+            BOOST_CHECK_EQUAL(account.balance, other.balance);
+            BOOST_CHECK_EQUAL(account.status, other.status);
+        });
+}
+
+struct TempFile {
+    TempFile()
+        : path(ML::format("/tmp/banker_journal_test.%d", getpid()))
+    {
+        unlink(path.c_str());
+    }
+
+    ~TempFile()
+    {
+        unlink(path.c_str());
+        unlink((path + ".tmp").c_str());
+    }
+
+    std::string path;
+};
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_account_serialize )
+{
+    Accounts accounts;
+    accounts.setBudget({"top"}, USD(100));
+    accounts.setBalance({"top", "spend"}, USD(10), AT_SPEND);
+    accounts.importSpend({"top", "spend"}, USD(3));
+
+    Account account = accounts.getAccount({"top", "spend"});
+    account.lineItems["line"] = USD(3);
+
+    std::ostringstream stream;
+    {
+        ML::DB::Store_Writer store(stream);
+        store << account;
+    }
+
+    std::string data = stream.str();
+    ML::DB::Store_Reader store(data.c_str(), data.size());
+    Account reconstituted;
+    store >> reconstituted;
+
+    BOOST_CHECK_EQUAL(reconstituted.toJson(), account.toJson());
+    BOOST_CHECK_EQUAL(reconstituted.balance, account.balance);
+
+    // Much more compact than the JSON that goes to redis
+    BOOST_CHECK_LT(data.size(), account.toJson().toString().size() / 4);
+}
+
+BOOST_AUTO_TEST_CASE( test_changed_accounts )
+{
+    Accounts accounts;
+    BOOST_CHECK(changedKeys(accounts).empty());
+
+    accounts.setBudget({"top"}, USD(100));
+    accounts.setBalance({"top", "spend1"}, USD(10), AT_SPEND);
+    accounts.setBalance({"top", "spend2"}, USD(10), AT_SPEND);
+    BOOST_CHECK_EQUAL(changedKeys(accounts).size(), 3);
+    BOOST_CHECK(changedKeys(accounts).empty());
+
+    // Reading doesn't count as a change
+    accounts.getAccount({"top", "spend1"});
+    accounts.getAccountSummary({"top"});
+    accounts.getBalance({"top", "spend2"});
+    BOOST_CHECK(changedKeys(accounts).empty());
+
+    // Moving money around changes the parent as well
+    accounts.setBalance({"top", "spend1"}, USD(5), AT_NONE);
+    std::set<AccountKey> expected = { {"top"}, {"top", "spend1"} };
+    BOOST_CHECK(changedKeys(accounts) == expected);
+
+    // The state returned is the one at the time of the call
+    accounts.addAdjustment({"top", "spend2"}, USD(1));
+    auto changes = accounts.takeChangedAccounts();
+    BOOST_REQUIRE_EQUAL(changes.size(), 1);
+    BOOST_CHECK_EQUAL(changes[0].second.balance, USD(11));
+
+    accounts.closeAccount({"top", "spend2"});
+    accounts.clearChangedAccounts();
+    BOOST_CHECK(changedKeys(accounts).empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_journal_recover )
+{
+    TempFile file;
+
+    Accounts accounts;
+    accounts.setBudget({"top"}, USD(100));
+    accounts.setBalance({"top", "spend1"}, USD(10), AT_SPEND);
+    accounts.setBalance({"top", "spend2"}, USD(20), AT_SPEND);
+
+    {
+        BankerJournal journal(file.path);
+        journal.append(accounts.takeChangedAccounts());
+
+        accounts.importSpend({"top", "spend1"}, USD(2));
+        accounts.setBalance({"top", "spend2"}, USD(15), AT_NONE);
+        journal.append(accounts.takeChangedAccounts());
+
+        accounts.closeAccount({"top", "spend1"});
+        journal.append(accounts.takeChangedAccounts());
+
+        BOOST_CHECK_EQUAL(journal.records(), 8);
+    }
+
+    // The last record of each account wins
+    BankerJournal journal(file.path);
+    Accounts recovered;
+    BOOST_CHECK_EQUAL(journal.recover(recovered), 3);
+    BOOST_CHECK_EQUAL(journal.records(), 8);
+    checkSameAccounts(accounts, recovered);
+    BOOST_CHECK_EQUAL(recovered.getAccount({"top", "spend1"}).status,
+                      Account::CLOSED);
+
+    // Compaction keeps a single record per account
+    journal.compact(recovered);
+    BOOST_CHECK_EQUAL(journal.records(), 3);
+
+    Accounts compacted;
+    BOOST_CHECK_EQUAL(BankerJournal(file.path).recover(compacted), 3);
+    checkSameAccounts(accounts, compacted);
+}
+
+BOOST_AUTO_TEST_CASE( test_journal_incomplete_record )
+{
+    TempFile file;
+
+    Accounts accounts;
+    accounts.setBudget({"top"}, USD(100));
+    accounts.setBalance({"top", "spend"}, USD(10), AT_SPEND);
+
+    off_t goodSize;
+    {
+        BankerJournal journal(file.path);
+        journal.append(accounts.takeChangedAccounts());
+        struct stat st;
+        BOOST_REQUIRE_EQUAL(stat(file.path.c_str(), &st), 0);
+        goodSize = st.st_size;
+
+        accounts.setBalance({"top", "spend"}, USD(5), AT_NONE);
+        journal.append(accounts.takeChangedAccounts());
+    }
+
+    // Simulate a crash in the middle of writing the last records
+    BOOST_REQUIRE_EQUAL(truncate(file.path.c_str(), goodSize + 10), 0);
+
+    Accounts recovered;
+    {
+        BankerJournal journal(file.path);
+        BOOST_CHECK_EQUAL(journal.recover(recovered), 2);
+        BOOST_CHECK_EQUAL(journal.records(), 2);
+        BOOST_CHECK_EQUAL(recovered.getBalance({"top", "spend"}), USD(10));
+
+        // The partial record is gone, so appending works again
+        accounts.setBalance({"top", "spend"}, USD(7), AT_NONE);
+        journal.append(accounts.takeChangedAccounts());
+    }
+
+    Accounts again;
+    BOOST_CHECK_EQUAL(BankerJournal(file.path).recover(again), 2);
+    checkSameAccounts(accounts, again);
+
+    // Not a journal at all
+    {
+        int fd = open(file.path.c_str(), O_WRONLY | O_TRUNC);
+        BOOST_REQUIRE_EQUAL(write(fd, "garbage", 7), 7);
+        close(fd);
+    }
+    Accounts garbage;
+    BOOST_CHECK_THROW(BankerJournal(file.path).recover(garbage),
+                      ML::Exception);
+}
@@ -0,0 +1,190 @@
+/** banker_persistence_bench.cc                                   -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Benchmark of the full and incremental saves of the master banker's
+    accounts, and of the local journal, against the mock persistence.
+
+*/
+
+#include "rtbkit/core/banker/testing/mock_banker_persistence.h"
+#include "rtbkit/core/banker/banker_journal.h"
+#include "soa/utils/print_utils.h"
+#include "jml/arch/timers.h"
+#include "jml/arch/format.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <unistd.h>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+/******************************************************************************/
+/* CONFIG                                                                     */
+/******************************************************************************/
+
+struct Config
+{
+    Config() :
+        accounts({ 10000, 100000, 1000000 }),
+        changed(0.01),
+        rounds(5),
+        journal("/tmp/banker_persistence_bench.journal")
+    {}
+
+    std::vector<size_t> accounts;
+    double changed;
+    size_t rounds;
+    std::string journal;
+};
+
+Config getConfig(int argc, char** argv)
+{
+    using namespace boost::program_options;
+
+    Config config;
+
+    options_description opt;
+    opt.add_options()
+        ("accounts,n", value<vector<size_t> >(&config.accounts)->multitoken(),
+         "number of spend accounts in each run")
+        ("changed,c", value<double>(&config.changed),
+         "fraction of the spend accounts modified between two saves")
+        ("rounds,r", value<size_t>(&config.rounds),
+         "number of saves in each run")
+        ("journal,j", value<string>(&config.journal),
+         "path of the temporary journal file")
+        ("help,h","print this message");
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opt).run(), vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        cerr << opt << endl;
+        exit(1);
+    }
+
+    return config;
+}
+
+
+/******************************************************************************/
+/* BENCH                                                                      */
+/******************************************************************************/
+
+AccountKey spendAccount(size_t i)
+{
+    return AccountKey({ ML::format("campaign%zd", i / 100),
+                        ML::format("strategy%zd", i % 100) });
+}
+
+void bench(const Config& config, size_t numAccounts)
+{
+    auto report = [&] (const char * what, double elapsed, size_t count)
+        {
+            cerr << ML::format("%8zd accounts  %-20s ", numAccounts, what)
+                 << printValue(elapsed * 1000.0) << " ms  "
+                 << count << " accounts"
+                 << endl;
+        };
+
+    Accounts accounts;
+    for (size_t i = 0; i < numAccounts; ++i) {
+        AccountKey key = spendAccount(i);
+        if (i % 100 == 0)
+            accounts.setBudget(key.parent(), USD(1000000));
+        accounts.setBalance(key, USD(10), AT_SPEND);
+    }
+    accounts.takeChangedAccounts();
+
+    MockBankerPersistence persistence;
+    persistence.storeAccounts = true;
+    auto onSaved = [] (const BankerPersistence::Result & result,
+                       const std::string & info)
+        {
+            ExcAssertEqual(result.status, BankerPersistence::SUCCESS);
+        };
+
+    unlink(config.journal.c_str());
+    BankerJournal journal(config.journal);
+    journal.compact(accounts);
+
+    size_t numChanged = numAccounts * config.changed;
+    double takeTime = 0, journalTime = 0, incrementalTime = 0, fullTime = 0;
+    size_t takeCount = 0, incrementalCount = 0, fullCount = 0;
+
+    for (size_t round = 0; round < config.rounds; ++round) {
+        // What the banker sees between two saves: spend accounts topped up
+        // by the slave bankers.
+        for (size_t i = 0; i < numChanged; ++i) {
+            size_t account = random() % numAccounts;
+            accounts.setBalance(spendAccount(account), USD(10 + round % 2),
+                                AT_NONE);
+        }
+
+        Timer timer;
+        auto changes = accounts.takeChangedAccounts();
+        takeTime += timer.elapsed_wall();
+        takeCount += changes.size();
+
+        timer.restart();
+        journal.append(changes);
+        journalTime += timer.elapsed_wall();
+
+        std::vector<AccountKey> keys;
+        for (auto & change: changes)
+            keys.push_back(change.first);
+
+        size_t before = persistence.accountsWritten;
+        timer.restart();
+        persistence.saveChanged(accounts, keys, onSaved);
+        incrementalTime += timer.elapsed_wall();
+        incrementalCount += persistence.accountsWritten - before;
+
+        before = persistence.accountsWritten;
+        timer.restart();
+        persistence.saveAll(accounts, onSaved);
+        fullTime += timer.elapsed_wall();
+        fullCount += persistence.accountsWritten - before;
+    }
+
+    double rounds = config.rounds;
+    report("take changed", takeTime / rounds, takeCount / rounds);
+    report("journal append", journalTime / rounds, takeCount / rounds);
+    report("incremental save", incrementalTime / rounds,
+           incrementalCount / rounds);
+    report("full save", fullTime / rounds, fullCount / rounds);
+
+    {
+        Timer timer;
+        Accounts recovered;
+        size_t count = journal.recover(recovered);
+        report("journal recover", timer.elapsed_wall(), count);
+    }
+
+    {
+        Timer timer;
+        journal.compact(accounts);
+        report("journal compact", timer.elapsed_wall(), accounts.size());
+    }
+
+    unlink(config.journal.c_str());
+}
+
+
+/******************************************************************************/
+/* MAIN                                                                       */
+/******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    auto config = getConfig(argc, argv);
+
+    for (size_t numAccounts: config.accounts)
+        bench(config, numAccounts);
+}
@@ -14,6 +14,7 @@
 #include "soa/service/service_base.h" // NullEventService, ServiceProxies
 
 #include "rtbkit/core/banker/master_banker.h"
+#include "rtbkit/core/banker/testing/mock_banker_persistence.h"
 
 using namespace std;
 using namespace Datacratic;
@@ -91,6 +92,66 @@ BOOST_AUTO_TEST_CASE( test_master_banker_onstatesaved )
                       ML::Exception);
 }
 
+BOOST_AUTO_TEST_CASE( test_master_banker_idle_incremental_save )
+{
+    auto serviceProxies = std::make_shared<ServiceProxies>();
+
+    MasterBanker testBanker(serviceProxies);
+    testBanker.incrementalSaves = true;
+    testBanker.accounts.createAccount(AccountKey("account1"), AT_BUDGET);
+    testBanker.accounts.clearChangedAccounts();
+
+    /* a save that reaches the storage fails, as redis does for an MGET
+     * without keys */
+    auto storage = make_shared<MockBankerPersistence>();
+    storage->prepareSave(BankerPersistence::PERSISTENCE_ERROR,
+                         "wrong number of arguments for 'mget' command");
+    testBanker.storage_ = storage;
+
+    /* nothing changed, so the storage must not be asked to save anything */
+    testBanker.saveState();
+    BOOST_CHECK_EQUAL(testBanker.lastSaveStatus, BankerPersistence::SUCCESS);
+    BOOST_CHECK_EQUAL(storage->statusQ.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_master_banker_out_of_sync_incremental_save )
+{
+    auto serviceProxies = std::make_shared<ServiceProxies>();
+
+    MasterBanker testBanker(serviceProxies);
+    testBanker.incrementalSaves = true;
+
+    auto storage = make_shared<MockBankerPersistence>();
+    storage->storeAccounts = true;
+    testBanker.storage_ = storage;
+
+    testBanker.accounts.createAccount(AccountKey("account1"), AT_BUDGET);
+    testBanker.accounts.createAccount(AccountKey("account2:spend"), AT_SPEND);
+    testBanker.accounts.markAccountOutOfSync({"account2", "spend"});
+
+    /* the account that is out of sync is skipped by the storage... */
+    testBanker.saveState();
+    BOOST_CHECK_EQUAL(testBanker.lastSaveStatus, BankerPersistence::SUCCESS);
+    BOOST_CHECK(storage->stored.count("account1"));
+    BOOST_CHECK(!storage->stored.count("account2:spend"));
+
+    /* ... and stays pending until it can be saved, even though it doesn't
+     * change in the meantime */
+    testBanker.saveState();
+    BOOST_CHECK(!storage->stored.count("account2:spend"));
+
+    auto reloaded = make_shared<Accounts>();
+    reloaded->createAccount(AccountKey("account1"), AT_BUDGET);
+    reloaded->createAccount(AccountKey("account2:spend"), AT_SPEND);
+    testBanker.onStateLoaded(reloaded, BankerPersistence::SUCCESS, "");
+    BOOST_CHECK(!testBanker.accounts.isAccountOutOfSync({"account2", "spend"}));
+
+    storage->stored.clear();
+    testBanker.saveState();
+    BOOST_CHECK(storage->stored.count("account2:spend"));
+    BOOST_CHECK(!storage->stored.count("account1"));
+}
+
 BOOST_AUTO_TEST_CASE( test_master_banker_http_headers )
 {
     auto serviceProxies = std::make_shared<ServiceProxies>();
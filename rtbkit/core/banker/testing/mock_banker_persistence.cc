@@ -17,7 +17,7 @@ namespace RTBKIT {
 
 MockBankerPersistence::
 MockBankerPersistence()
-    : disableSaves(false)
+    : disableSaves(false), storeAccounts(false), accountsWritten(0)
 {
 }
 
@@ -70,6 +70,16 @@ saveAll(const Accounts & toSave, OnSavedCallback onSaved)
         cerr << __FUNCTION__ << ": invocation ignored" << endl;
         return;
     }
+    if (storeAccounts) {
+        toSave.forEachAccount([&] (const AccountKey & key,
+                                   const Account & account)
+                              {
+                                  if (!toSave.isAccountOutOfSync(key))
+                                      store(key, account);
+                              });
+        onSaved(BankerPersistence::SUCCESS, "");
+        return;
+    }
     int op = opsQ.front();
     if (op == 1) {
         opsQ.pop_front();
@@ -82,4 +92,36 @@ saveAll(const Accounts & toSave, OnSavedCallback onSaved)
     }
 }
 
+void
+MockBankerPersistence::
+saveChanged(const Accounts & toSave, const vector<AccountKey> & changed,
+            OnSavedCallback onSaved)
+{
+    if (!storeAccounts) {
+        saveAll(toSave, onSaved);
+        return;
+    }
+
+    for (auto & key: changed) {
+        if (!toSave.isAccountOutOfSync(key))
+            store(key, toSave.getAccount(key));
+    }
+    onSaved(BankerPersistence::SUCCESS, "");
+}
+
+void
+MockBankerPersistence::
+restoreFromArchive(const AccountKey & key, OnRestoredCallback onRestored)
+{
+    onRestored(make_shared<Accounts>(), BankerPersistence::SUCCESS, "");
+}
+
+void
+MockBankerPersistence::
+store(const AccountKey & key, const Account & account)
+{
+    stored[key.toString()] = account.toJson().toStringNoNewLine();
+    ++accountsWritten;
+}
+
 } // namespace RTBKIT
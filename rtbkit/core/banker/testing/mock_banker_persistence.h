@@ -12,6 +12,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "rtbkit/core/banker/master_banker.h"
 
@@ -22,6 +23,14 @@ struct MockBankerPersistence : public BankerPersistence {
 
     bool disableSaves; /* make "saveAll" void */
 
+    /* When set, saves don't use the prepared results but behave like an
+       in-memory store: the JSON of each account that is given to a save is
+       written into "stored" and the save succeeds.  As with redis, the
+       accounts that are out of sync are skipped. */
+    bool storeAccounts;
+    std::unordered_map<std::string, std::string> stored;
+    size_t accountsWritten; /* number of accounts written by all saves */
+
     std::deque<BankerPersistence::PersistenceCallbackStatus> statusQ;
     std::deque<std::string> infoQ;
     std::deque<std::shared_ptr<Accounts>> accountsQ;
@@ -34,9 +43,16 @@ struct MockBankerPersistence : public BankerPersistence {
 
     void loadAll(const std::string & topLevelKey, OnLoadedCallback onLoaded);
     void saveAll(const Accounts & toSave, OnSavedCallback onSaved);
+    void saveChanged(const Accounts & toSave,
+                     const std::vector<AccountKey> & changed,
+                     OnSavedCallback onSaved);
+    void restoreFromArchive(const AccountKey & key,
+                            OnRestoredCallback onRestored);
 
 private:
     std::deque<int> opsQ; // 1 = save; 2 = load
+
+    void store(const AccountKey & key, const Account & account);
 };
 
 } // namespace RTBKIT
@@ -12,6 +12,7 @@
 #include "soa/service/service_base.h"
 #include "soa/service/http_client.h"
 #include "soa/service/typed_message_channel.h"
+#include "soa/types/binary_json.h"
 #include "rtbkit/common/auction_events.h"
 
 namespace RTBKIT {
@@ -20,6 +21,11 @@ namespace RTBKIT {
 /* EVENT FORWARDER                                                            */
 /******************************************************************************/
 
+/** Forwards the auctions and events to the REST interface of a post auction
+    service.  They're sent as JSON or, if binary is set, in the binary
+    encoding of their value description, which is cheaper to produce and to
+    parse; only post auction services that know about it can receive it.
+*/
 struct EventForwarder :
         public Datacratic::ServiceBase,
         public Datacratic::MessageLoop
@@ -32,8 +38,9 @@ struct EventForwarder :
 
     EventForwarder(
             Datacratic::ServiceBase & parent,
-            std::string uri, std::string name) :
+            std::string uri, std::string name, bool binary = false) :
         ServiceBase(std::move(name), parent),
+        binary(binary),
         client(std::move(uri), ConnectionCount),
         auctionQueue(AuctionQueueSize),
         eventQueue(EventQueueSize)
@@ -43,8 +50,9 @@ struct EventForwarder :
 
     EventForwarder(
             std::shared_ptr<Datacratic::ServiceProxies>& proxies,
-            std::string uri, std::string name) :
+            std::string uri, std::string name, bool binary = false) :
         ServiceBase(std::move(name), proxies),
+        binary(binary),
         client(std::move(uri), ConnectionCount),
         auctionQueue(AuctionQueueSize),
         eventQueue(EventQueueSize)
@@ -100,11 +108,18 @@ private:
 
         static auto desc = getDefaultDescriptionShared((T*) 0);
 
-        std::stringstream stream;
-        Datacratic::StreamJsonPrintingContext ctx(stream);
-        desc->printJson(&obj, ctx);
-
-        HttpRequest::Content body(stream.str(), "application/json");
+        HttpRequest::Content body;
+        if (binary) {
+            std::string str;
+            desc->printBinary(&obj, str);
+            body = HttpRequest::Content(str, BinaryJson::ContentType);
+        }
+        else {
+            std::stringstream stream;
+            Datacratic::StreamJsonPrintingContext ctx(stream);
+            desc->printJson(&obj, ctx);
+            body = HttpRequest::Content(stream.str(), "application/json");
+        }
 
         auto onDone = [=] (const HttpRequest&, HttpClientError err) {
             if (err != HttpClientError::None) {
@@ -131,6 +146,7 @@ private:
         send("events", *event);
     }
 
+    bool binary;
     HttpClient client;
     TypedMessageSink< std::shared_ptr< SubmittedAuctionEvent> > auctionQueue;
     TypedMessageSink< std::shared_ptr< PostAuctionEvent> > eventQueue;
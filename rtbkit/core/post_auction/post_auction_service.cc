@@ -292,7 +292,7 @@ initRestEndpoint()
             "Submit and auction to the PAL",
             &PostAuctionService::doAuction,
             this,
-            JsonParam< std::shared_ptr< SubmittedAuctionEvent> >("", "auction to submit"));
+            JsonOrBinaryParam< std::shared_ptr< SubmittedAuctionEvent> >("auction to submit"));
 
     addRouteSync(
             versionNode,
@@ -301,7 +301,7 @@ initRestEndpoint()
             "Submit and auction to the PAL",
             &PostAuctionService::doEvent,
             this,
-            JsonParam< std::shared_ptr< PostAuctionEvent> >("", "event to submit"));
+            JsonOrBinaryParam< std::shared_ptr< PostAuctionEvent> >("event to submit"));
 
     addSource("PostAuctionService::restEndpoint", *restEndpoint);
 }
@@ -59,9 +59,9 @@ bool findAuction(
     return true;
 }
 
-std::string makeBidId(Id auctionId, Id spotId, const std::string & agent)
+CommitmentKey makeBidId(Id auctionId, Id spotId, const std::string & agent)
 {
-    return auctionId.toString() + "-" + spotId.toString() + "-" + agent;
+    return CommitmentKey(auctionId, spotId, agent);
 }
 
 
@@ -222,7 +222,7 @@ doAuction(std::shared_ptr<SubmittedAuctionEvent> event)
         submitted.emplace(key, submission, lossTimeout);
         spotIdMap[key.first] = key.second;
 
-        string transId =
+        auto transId =
             makeBidId(auctionId, event->adSpotId, submission.bid.agent);
 
         banker->attachBid(
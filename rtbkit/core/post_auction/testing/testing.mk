@@ -1,2 +1,3 @@
 $(eval $(call program,post_auction_redis_bench,post_auction redis))
 $(eval $(call program,post_auction_sharding_bench,post_auction boost_program_options))
+$(eval $(call test,timeout_map_test,types,boost))
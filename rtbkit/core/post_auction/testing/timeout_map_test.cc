@@ -0,0 +1,206 @@
+/* timeout_map_test.cc
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Tests for the post auction timeout map.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "rtbkit/core/post_auction/timeout_map.h"
+#include "soa/types/id.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+
+
+using namespace std;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+BOOST_AUTO_TEST_CASE( test_basics )
+{
+    TimeoutMap<string, int> map;
+    Date start = Date::fromSecondsSinceEpoch(1000);
+
+    BOOST_CHECK(map.emplace("a", 1, start.plusSeconds(1)));
+    BOOST_CHECK(map.emplace("b", 2, start.plusSeconds(2)));
+    BOOST_CHECK(!map.emplace("a", 3, start.plusSeconds(3)));
+
+    BOOST_CHECK_EQUAL(map.size(), 2);
+    BOOST_CHECK(map.count("a"));
+    BOOST_CHECK(!map.count("c"));
+    BOOST_CHECK_EQUAL(map.get("a"), 1);
+    BOOST_CHECK_THROW(map.get("c"), ML::Exception);
+
+    map.get("b") = 4;
+    BOOST_CHECK_EQUAL(map.pop("b"), 4);
+    BOOST_CHECK(!map.count("b"));
+    BOOST_CHECK(!map.erase("b"));
+    BOOST_CHECK(map.erase("a"));
+    BOOST_CHECK_EQUAL(map.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( test_expire )
+{
+    TimeoutMap<string, int> map;
+    Date start = Date::fromSecondsSinceEpoch(1000);
+
+    map.emplace("a", 1, start.plusSeconds(1.0));
+    map.emplace("b", 2, start.plusSeconds(1.0005));
+    map.emplace("c", 3, start.plusSeconds(2.0));
+    map.emplace("d", 4, start.plusSeconds(1000.0));
+    map.emplace("e", 5, Date::positiveInfinity());
+
+    map.update("c", start.plusSeconds(0.5));
+
+    vector<string> expired;
+    auto onExpire = [&] (string key, int) { expired.push_back(key); };
+
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start), 0);
+
+    // Entries that share a tick with now must not be expired early.
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(1.0002)), 2);
+    sort(expired.begin(), expired.end());
+    BOOST_CHECK_EQUAL(expired.size(), 2);
+    BOOST_CHECK_EQUAL(expired[0], "a");
+    BOOST_CHECK_EQUAL(expired[1], "c");
+
+    expired.clear();
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(999)), 1);
+    BOOST_CHECK_EQUAL(expired.at(0), "b");
+
+    expired.clear();
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(1000)), 1);
+    BOOST_CHECK_EQUAL(expired.at(0), "d");
+
+    // Entries in the past are expired on the next call.
+    map.emplace("f", 6, start);
+    expired.clear();
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(1000)), 1);
+    BOOST_CHECK_EQUAL(expired.at(0), "f");
+
+    BOOST_CHECK_EQUAL(map.size(), 1);
+    BOOST_CHECK(map.count("e"));
+}
+
+BOOST_AUTO_TEST_CASE( test_expire_reentrant )
+{
+    TimeoutMap<int, int> map;
+    Date start = Date::fromSecondsSinceEpoch(1000);
+
+    for (int i = 0; i < 10; ++i)
+        map.emplace(i, i, start.plusSeconds(i));
+
+    // The callback may modify the map.
+    size_t expired = map.expire([&] (int key, int) {
+                map.erase(key + 1);
+                map.emplace(key + 100, key, start.plusSeconds(100));
+            }, start.plusSeconds(0.5));
+
+    BOOST_CHECK_EQUAL(expired, 1);
+    BOOST_CHECK(!map.count(1));
+    BOOST_CHECK(map.count(100));
+    BOOST_CHECK_EQUAL(map.size(), 9);
+}
+
+BOOST_AUTO_TEST_CASE( test_far_future_first )
+{
+    TimeoutMap<int, int> map;
+    Date start = Date::now();
+
+    // A far future first entry must not position the wheel in the future.
+    map.emplace(0, 0, Date::positiveInfinity());
+    for (int i = 1; i <= 1000; ++i)
+        map.emplace(i, i, start.plusSeconds(i * 0.01));
+
+    vector<int> expired;
+    auto onExpire = [&] (int key, int) { expired.push_back(key); };
+
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start), 0);
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(0.005)), 0);
+
+    for (int i = 1; i <= 10; ++i) {
+        expired.clear();
+        BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(i * 0.01)), 1);
+        BOOST_CHECK_EQUAL(expired.at(0), i);
+    }
+
+    BOOST_CHECK_EQUAL(map.expire(onExpire, start.plusSeconds(10)), 990);
+    BOOST_CHECK_EQUAL(map.size(), 1);
+    BOOST_CHECK(map.count(0));
+}
+
+/** Compares against a reference implementation with random operations over
+    timeouts that span all the levels of the wheel.
+ */
+BOOST_AUTO_TEST_CASE( test_random )
+{
+    typedef pair<Id, Id> Key;
+
+    TimeoutMap<Key, uint64_t> timeouts;
+    std::map<Key, pair<uint64_t, Date> > ref;
+
+    mt19937 rng(0);
+    Date now = Date::fromSecondsSinceEpoch(1000);
+
+    auto randomTimeout = [&] {
+        static const double spans[] = { 0.01, 1, 60, 3600, 86400, 1e7 };
+        double span = spans[rng() % 6];
+        return now.plusSeconds(span * (rng() % 1000) / 1000.0);
+    };
+
+    for (size_t i = 0; i < 200000; ++i) {
+        Key key(Id(rng() % 5000), Id(rng() % 2));
+
+        switch (rng() % 5) {
+        case 0:
+        case 1: {
+            Date timeout = randomTimeout();
+            bool inserted = timeouts.emplace(key, i, timeout);
+            BOOST_REQUIRE_EQUAL(inserted, !ref.count(key));
+            if (inserted) ref[key] = make_pair(i, timeout);
+            break;
+        }
+
+        case 2:
+            if (!ref.count(key)) break;
+            ref[key].second = randomTimeout();
+            timeouts.update(key, ref[key].second);
+            break;
+
+        case 3:
+            BOOST_REQUIRE_EQUAL(timeouts.erase(key), ref.erase(key));
+            break;
+
+        case 4: {
+            now = now.plusSeconds((rng() % 100) / 10.0);
+
+            size_t expected = 0;
+            timeouts.expire([&] (Key key, uint64_t value) {
+                        auto it = ref.find(key);
+                        BOOST_REQUIRE(it != ref.end());
+                        BOOST_REQUIRE_EQUAL(it->second.first, value);
+                        BOOST_REQUIRE(it->second.second <= now);
+                        ref.erase(it);
+                    }, now);
+
+            for (const auto& entry : ref)
+                if (entry.second.second <= now) expected++;
+            BOOST_REQUIRE_EQUAL(expected, 0);
+            break;
+        }
+        }
+
+        BOOST_REQUIRE_EQUAL(timeouts.size(), ref.size());
+    }
+
+    for (const auto& entry : ref) {
+        BOOST_REQUIRE(timeouts.count(entry.first));
+        BOOST_REQUIRE_EQUAL(timeouts.get(entry.first), entry.second.first);
+    }
+}
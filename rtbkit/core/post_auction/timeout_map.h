@@ -12,131 +12,483 @@
 #pragma once
 
 #include "soa/types/date.h"
+#include "jml/utils/exc_check.h"
 
-#include <set>
-#include <queue>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+#include <utility>
 
 namespace RTBKIT {
 
+/******************************************************************************/
+/* TIMEOUT MAP HASH                                                           */
+/******************************************************************************/
+
+/** Defaults to std::hash but also handles the (auction id, spot id) pairs
+    that the event matchers use as keys.
+ */
+template<typename Key>
+struct TimeoutMapHash : public std::hash<Key> {};
+
+template<typename X, typename Y>
+struct TimeoutMapHash< std::pair<X, Y> >
+{
+    size_t operator() (const std::pair<X, Y>& key) const
+    {
+        size_t h = TimeoutMapHash<X>()(key.first);
+        return h ^ (TimeoutMapHash<Y>()(key.second) + 0x9E3779B9 + (h << 6) + (h >> 2));
+    }
+};
+
+
 /******************************************************************************/
 /* TIMEOUT MAP                                                                */
 /******************************************************************************/
 
-template<typename Key, typename Value>
+/** Map of key to value where each entry expires at a given date.
+
+    Entries live in pooled nodes which are allocated in chunks and recycled so
+    that inserting and removing entries doesn't hit the allocator. The nodes
+    are indexed by an open addressing hash table (linear probing with backward
+    shift deletion) and are linked into a hierarchical timing wheel: 4 levels
+    of 256 slots where a level 0 slot covers one tick (resolution) and each
+    level covers 256 times the span of the one below. Inserting, updating and
+    removing an entry are O(1) and expiring only touches the slots that have
+    come due plus an occasional cascade of a higher level slot.
+
+    Entries are never expired early: the last slot is scanned and only entries
+    whose timeout is <= now are expired.
+
+    References returned by get() stay valid until the entry is removed.
+
+    Key and Value must be default constructible and Key must be comparable
+    with ==.
+ */
+template<typename Key, typename Value, typename Hash = TimeoutMapHash<Key> >
 struct TimeoutMap
 {
+    /** resolution is the duration of a tick of the timing wheel in seconds.
+        The default of 1ms gives 4.6 hours before entries need to be re-filed
+        from the top level of the wheel.
+     */
+    explicit TimeoutMap(double resolution = 0.001) :
+        resolution(resolution),
+        entries(0),
+        freeList(NoNode),
+        numNodes(0),
+        currentTick(0),
+        started(false)
+    {
+        ExcCheckGreater(resolution, 0.0, "invalid timeout map resolution");
+        for (auto& level : wheel) {
+            for (auto& slot : level) slot = NoNode;
+        }
+        for (auto& count : levelCount) count = 0;
+    }
+
+    TimeoutMap(const TimeoutMap&) = delete;
+    TimeoutMap& operator=(const TimeoutMap&) = delete;
 
     size_t size() const
     {
-        return map.size();
+        return entries;
     }
 
     bool count(const Key& key) const
     {
-        return map.count(key);
+        return findSlot(key, hashOf(key)) != NoNode;
     }
 
     Value& get(const Key& key)
     {
-        auto it = map.find(key);
-        ExcCheck(it != map.end(), "key not present in the timeout map.");
-        return it->second.value;
+        uint32_t slot = findSlot(key, hashOf(key));
+        ExcCheck(slot != NoNode, "key not present in the timeout map.");
+        return node(table[slot]).value;
     }
 
     const Value& get(const Key& key) const
     {
-        auto it = map.find(key);
-        ExcCheck(it != map.end(), "key not present in the timeout map.");
-        return it->second.value;
+        uint32_t slot = findSlot(key, hashOf(key));
+        ExcCheck(slot != NoNode, "key not present in the timeout map.");
+        return node(table[slot]).value;
     }
 
     bool emplace(Key key, Value value, Datacratic::Date timeout)
     {
-        auto ret = map.insert(std::make_pair(
-                        std::move(key), Entry(std::move(value), timeout)));
-        if (!ret.second) return false;
+        size_t hash = hashOf(key);
+        if (findSlot(key, hash) != NoNode) return false;
+
+        if ((entries + 1) * 2 > table.size())
+            rehash(std::max<size_t>(table.size() * 2, 16));
+
+        uint32_t index = allocNode();
+        Node& n = node(index);
+        n.key = std::move(key);
+        n.value = std::move(value);
+        n.hash = hash;
+        n.timeout = timeout;
 
-        queue.emplace(ret.first->first, timeout);
+        insertSlot(index);
+        entries++;
+
+        schedule(index);
         return true;
     }
 
     void update(const Key& key, Datacratic::Date timeout)
     {
-        auto it = map.find(key);
-        ExcCheck(it != map.end(), "key not present in the timeout map.");
+        uint32_t slot = findSlot(key, hashOf(key));
+        ExcCheck(slot != NoNode, "key not present in the timeout map.");
 
-        it->second.timeout = timeout;
-        queue.emplace(key, timeout);
+        uint32_t index = table[slot];
+        unschedule(index);
+        node(index).timeout = timeout;
+        schedule(index);
     }
 
     Value pop(const Key& key)
     {
-        auto it = map.find(key);
-        ExcCheck(it != map.end(), "key not present in the timeout map.");
+        uint32_t slot = findSlot(key, hashOf(key));
+        ExcCheck(slot != NoNode, "key not present in the timeout map.");
 
-        Value value = std::move(it->second.value);
-        map.erase(it);
+        uint32_t index = table[slot];
+        Value value = std::move(node(index).value);
+        remove(slot);
         return value;
     }
 
     bool erase(const Key& key)
     {
-        return map.erase(key);
+        uint32_t slot = findSlot(key, hashOf(key));
+        if (slot == NoNode) return false;
+        remove(slot);
+        return true;
     }
 
+    /** Removes every entry whose timeout is <= now and then calls fn with the
+        key and value of each of them. The callback is free to modify the map.
+     */
     template<typename Fn>
     size_t expire(const Fn& fn, Datacratic::Date now = Datacratic::Date::now())
     {
-        std::vector< std::pair<Key, Entry> > toExpire;
-        toExpire.reserve(1 << 4);
-
-        while (!queue.empty() && queue.top().timeout <= now) {
-            TimeoutEntry entry = std::move(queue.top());
-            queue.pop();
-
-            auto it = map.find(entry.key);
-            if (it == map.end()) continue;
-            if (it->second.timeout > now) continue;
-
-            toExpire.emplace_back(std::move(*it));
-            map.erase(it);
+        std::vector< std::pair<Key, Value> > toExpire;
+
+        int64_t nowTick = tickOf(now);
+        if (!started) start(nowTick);
+
+        while (currentTick < nowTick) {
+            if (!entries) {
+                currentTick = nowTick;
+                break;
+            }
+
+            // Nothing can be due in level 0 so jump to the next cascade.
+            if (!levelCount[0]) {
+                int64_t next = (currentTick | SlotMask) + 1;
+                if (next > nowTick) {
+                    currentTick = nowTick;
+                    break;
+                }
+                currentTick = next;
+                cascade();
+                continue;
+            }
+
+            // Everything filed in a tick prior to now is due.
+            expireSlot(0, currentTick & SlotMask, toExpire);
+
+            currentTick++;
+            if (!(currentTick & SlotMask)) cascade();
         }
 
+        // The current tick is only partially elapsed.
+        expireSlot(0, currentTick & SlotMask, toExpire, now);
+
         for (auto& entry : toExpire)
-            fn(std::move(entry.first), std::move(entry.second.value));
+            fn(std::move(entry.first), std::move(entry.second));
 
         return toExpire.size();
     }
 
 private:
 
-    struct Entry
+    enum {
+        Levels = 4,
+        SlotBits = 8,
+        Slots = 1 << SlotBits,
+        SlotMask = Slots - 1,
+        ChunkBits = 10,
+        ChunkSize = 1 << ChunkBits
+    };
+
+    static constexpr uint32_t NoNode = uint32_t(-1);
+
+    struct Node
     {
+        Node() : hash(0), next(NoNode), prev(NoNode), level(0), slot(0) {}
+
+        Key key;
         Value value;
+        size_t hash;
         Datacratic::Date timeout;
 
-        Entry(Value value, Datacratic::Date timeout) :
-            value(std::move(value)), timeout(timeout)
-        {}
+        // Links in the list of the wheel slot or in the free list.
+        uint32_t next;
+        uint32_t prev;
+        uint16_t level;
+        uint16_t slot;
     };
 
-    struct TimeoutEntry
+
+    /* NODE POOL */
+
+    Node& node(uint32_t index)
     {
-        Key key;
-        Datacratic::Date timeout;
+        return chunks[index >> ChunkBits][index & (ChunkSize - 1)];
+    }
 
-        TimeoutEntry(Key key, Datacratic::Date timeout) :
-            key(std::move(key)), timeout(timeout)
-        {}
+    const Node& node(uint32_t index) const
+    {
+        return chunks[index >> ChunkBits][index & (ChunkSize - 1)];
+    }
 
-        bool operator<(const TimeoutEntry& other) const
-        {
-            return timeout > other.timeout;
+    uint32_t allocNode()
+    {
+        if (freeList != NoNode) {
+            uint32_t index = freeList;
+            freeList = node(index).next;
+            return index;
         }
-    };
 
-    std::unordered_map<Key, Entry> map;
-    std::priority_queue<TimeoutEntry> queue;
+        if (numNodes % ChunkSize == 0)
+            chunks.emplace_back(new Node[ChunkSize]);
+        return numNodes++;
+    }
+
+    void freeNode(uint32_t index)
+    {
+        Node& n = node(index);
+        n.key = Key();
+        n.value = Value();
+        n.next = freeList;
+        freeList = index;
+    }
+
+
+    /* HASH TABLE */
+
+    size_t hashOf(const Key& key) const
+    {
+        // Fibonacci hashing spreads weak hashes over the high bits which we
+        // fold back down as the table is indexed with the low bits.
+        uint64_t h = Hash()(key) * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    uint32_t findSlot(const Key& key, size_t hash) const
+    {
+        if (table.empty()) return NoNode;
+
+        size_t mask = table.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            uint32_t index = table[i];
+            if (index == NoNode) return NoNode;
+
+            const Node& n = node(index);
+            if (n.hash == hash && n.key == key) return i;
+        }
+    }
+
+    void insertSlot(uint32_t index)
+    {
+        size_t mask = table.size() - 1;
+        size_t i = node(index).hash & mask;
+        while (table[i] != NoNode) i = (i + 1) & mask;
+        table[i] = index;
+    }
+
+    void eraseSlot(size_t i)
+    {
+        size_t mask = table.size() - 1;
+
+        // Shift back the entries of the probe sequence so that lookups never
+        // need tombstones.
+        for (size_t j = (i + 1) & mask; table[j] != NoNode; j = (j + 1) & mask) {
+            size_t ideal = node(table[j]).hash & mask;
+
+            bool movable = i <= j
+                ? (ideal <= i || ideal > j)
+                : (ideal <= i && ideal > j);
+            if (!movable) continue;
+
+            table[i] = table[j];
+            i = j;
+        }
+
+        table[i] = NoNode;
+    }
+
+    void rehash(size_t newSize)
+    {
+        std::vector<uint32_t> old(newSize, NoNode);
+        table.swap(old);
+
+        for (uint32_t index : old) {
+            if (index != NoNode) insertSlot(index);
+        }
+    }
+
+    void remove(uint32_t slot)
+    {
+        uint32_t index = table[slot];
+        eraseSlot(slot);
+        entries--;
+
+        unschedule(index);
+        freeNode(index);
+    }
+
+
+    /* TIMING WHEEL */
+
+    int64_t tickOf(Datacratic::Date date) const
+    {
+        double tick = std::floor(date.secondsSinceEpoch() / resolution);
+
+        // Keeps infinite dates and the like representable.
+        const double limit = 1ULL << 62;
+        if (tick > limit) return limit;
+        if (tick < -limit) return -limit;
+        return tick;
+    }
+
+    void start(int64_t tick)
+    {
+        currentTick = tick;
+        started = true;
+    }
+
+    void schedule(uint32_t index)
+    {
+        Node& n = node(index);
+        int64_t tick = tickOf(n.timeout);
+
+        // The wheel starts at the earliest of now and the first timeout so
+        // that a far future first entry doesn't push everything that follows
+        // into the overdue slot.
+        if (!started) start(std::min(tick, tickOf(Datacratic::Date::now())));
+
+        // Overdue entries go in the current slot which gets scanned on every
+        // call to expire.
+        if (tick < currentTick) tick = currentTick;
+
+        uint64_t delta = tick - currentTick;
+
+        unsigned level = 0;
+        while (level < Levels - 1 && delta >= (1ULL << (SlotBits * (level + 1))))
+            level++;
+
+        // Too far in the future for the wheel: file it in the furthest slot
+        // and it'll be re-filed when that slot cascades.
+        if (level == Levels - 1 && delta >= (1ULL << (SlotBits * Levels)))
+            tick = currentTick + (1ULL << (SlotBits * Levels)) - 1;
+
+        unsigned slot = (uint64_t(tick) >> (SlotBits * level)) & SlotMask;
+        link(index, level, slot);
+    }
+
+    void link(uint32_t index, unsigned level, unsigned slot)
+    {
+        Node& n = node(index);
+        uint32_t& head = wheel[level][slot];
+
+        n.level = level;
+        n.slot = slot;
+        n.prev = NoNode;
+        n.next = head;
+        if (head != NoNode) node(head).prev = index;
+        head = index;
+
+        levelCount[level]++;
+    }
+
+    void unschedule(uint32_t index)
+    {
+        Node& n = node(index);
+
+        if (n.prev != NoNode) node(n.prev).next = n.next;
+        else wheel[n.level][n.slot] = n.next;
+        if (n.next != NoNode) node(n.next).prev = n.prev;
+
+        levelCount[n.level]--;
+    }
+
+    /** Re-files the entries of the higher level slots which are now within
+        the span of the level below.
+     */
+    void cascade()
+    {
+        for (unsigned level = 1; level < Levels; ++level) {
+            unsigned slot = (uint64_t(currentTick) >> (SlotBits * level)) & SlotMask;
+
+            uint32_t index = wheel[level][slot];
+            wheel[level][slot] = NoNode;
+
+            while (index != NoNode) {
+                uint32_t next = node(index).next;
+                levelCount[level]--;
+                schedule(index);
+                index = next;
+            }
+
+            if (slot) break;
+        }
+    }
+
+    void expireSlot(
+            unsigned level, unsigned slot,
+            std::vector< std::pair<Key, Value> >& toExpire,
+            Datacratic::Date now = Datacratic::Date::positiveInfinity())
+    {
+        uint32_t index = wheel[level][slot];
+
+        while (index != NoNode) {
+            Node& n = node(index);
+            uint32_t next = n.next;
+
+            if (n.timeout <= now) {
+                eraseSlot(findSlot(n.key, n.hash));
+                toExpire.emplace_back(std::move(n.key), std::move(n.value));
+                entries--;
+                unschedule(index);
+                freeNode(index);
+            }
+
+            index = next;
+        }
+    }
+
+
+    double resolution;
+    size_t entries;
+
+    std::vector< std::unique_ptr<Node[]> > chunks;
+    uint32_t freeList;
+    uint32_t numNodes;
+
+    std::vector<uint32_t> table;
+
+    uint32_t wheel[Levels][Slots];
+    size_t levelCount[Levels];
+    int64_t currentTick;
+    bool started;
 };
 
+template<typename Key, typename Value, typename Hash>
+constexpr uint32_t TimeoutMap<Key, Value, Hash>::NoNode;
+
 } // namespace RTBKIT
@@ -0,0 +1,108 @@
+/* augmentation_cache.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Router-side cache of augmentation responses.
+*/
+
+#include "augmentation_cache.h"
+
+
+using namespace std;
+using namespace ML;
+
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* AUGMENTATION CACHE                                                        */
+/*****************************************************************************/
+
+AugmentationCache::
+AugmentationCache(size_t maxEntries)
+    : maxEntries(maxEntries)
+{
+}
+
+std::string
+AugmentationCache::
+key(const AugmentationCacheConfig & config,
+    const UserIds & userIds,
+    const std::set<std::string> & agents)
+{
+    std::string result;
+
+    for (const auto & domain: config.keyDomains) {
+        auto it = userIds.find(domain);
+        if (it == userIds.end() || !it->second)
+            return "";
+
+        result += it->second.toString();
+        result += '\0';
+    }
+
+    result += '\1';
+
+    for (const auto & agent: agents) {
+        result += agent;
+        result += '\0';
+    }
+
+    return result;
+}
+
+const AugmentationList *
+AugmentationCache::
+find(const std::string & augmentor,
+     const std::string & key,
+     Date now) const
+{
+    auto it = entries.find(augmentor + '\0' + key);
+    if (it == entries.end() || it->second.timeout <= now)
+        return nullptr;
+    return &it->second;
+}
+
+void
+AugmentationCache::
+insert(const std::string & augmentor,
+       const std::string & key,
+       const AugmentationList & response,
+       Date expiry)
+{
+    std::string fullKey = augmentor + '\0' + key;
+
+    // Re-inserted rather than updated so that the timeout of the node
+    // follows the new expiry.
+    entries.erase(fullKey);
+
+    while (!entries.empty() && entries.size() >= maxEntries)
+        entries.erase(entries.timeouts.begin()->second);
+
+    entries.insert(fullKey, response, expiry);
+}
+
+void
+AugmentationCache::
+erase(const std::string & augmentor)
+{
+    std::string prefix = augmentor + '\0';
+
+    auto it = entries.nodes.lower_bound(prefix);
+    while (it != entries.end()
+           && it->first.compare(0, prefix.size(), prefix) == 0)
+    {
+        auto toErase = it++;
+        entries.erase(toErase);
+    }
+}
+
+void
+AugmentationCache::
+expire(Date now)
+{
+    if (entries.earliest <= now)
+        entries.expire(now);
+}
+
+} // namespace RTBKIT
@@ -0,0 +1,82 @@
+/* augmentation_cache.h                                            -*- C++ -*-
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Router-side cache of augmentation responses.
+*/
+
+#ifndef __rtb_router__augmentation_cache_h__
+#define __rtb_router__augmentation_cache_h__
+
+#include "rtbkit/common/augmentation.h"
+#include "rtbkit/common/bid_request.h"
+#include "soa/service/timeout_map.h"
+#include <set>
+#include <string>
+
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* AUGMENTATION CACHE                                                        */
+/*****************************************************************************/
+
+/** Keeps the responses of the augmentors that asked for it in their
+    AugmentationCacheConfig, so that an auction for a user that was recently
+    augmented can skip the round-trip to the augmentor.
+
+    Entries are keyed by the augmentor name, the user ids in the configured
+    domains and the agents that the augmentation was requested for, since an
+    augmentor only answers for the agents it was given.  They expire after the
+    ttl of the augmentor and, once maxEntries is reached, the entry closest to
+    expiry is dropped to make room for a new one.
+
+    This class is not thread safe; the AugmentationLoop only uses it from its
+    message loop thread.
+*/
+
+struct AugmentationCache {
+
+    AugmentationCache(size_t maxEntries = 1 << 20);
+
+    /** Returns the key under which the response for the given user ids and
+        agents is cached, or an empty string if the user ids don't contain
+        every key domain of the config.
+    */
+    static std::string key(const AugmentationCacheConfig & config,
+                           const UserIds & userIds,
+                           const std::set<std::string> & agents);
+
+    /** Returns the cached response for the augmentor and key or null if
+        there is none or if it has expired.
+    */
+    const AugmentationList * find(const std::string & augmentor,
+                                  const std::string & key,
+                                  Date now = Date::now()) const;
+
+    /** Cache the response of an augmentor until the given date, replacing
+        any previous response under the same key.
+    */
+    void insert(const std::string & augmentor,
+                const std::string & key,
+                const AugmentationList & response,
+                Date expiry);
+
+    /** Drop every response of the given augmentor. */
+    void erase(const std::string & augmentor);
+
+    /** Drop the expired responses. */
+    void expire(Date now = Date::now());
+
+    size_t size() const { return entries.size(); }
+
+    size_t maxEntries;
+
+private:
+    typedef TimeoutMap<std::string, AugmentationList> Entries;
+    Entries entries;
+};
+
+} // namespace RTBKIT
+
+#endif /* __rtb_router__augmentation_cache_h__ */
@@ -68,8 +68,8 @@ init()
 
     toAugmentors.init(getServices()->config, serviceName() + "/augmentors");
 
-    toAugmentors.clientMessageHandler
-        = [&] (const std::vector<std::string> & message)
+    toAugmentors.clientMessageViewHandler
+        = [&] (const ZmqMessageView & message)
         {
             //cerr << "got augmentor message " << message << endl;
             handleAugmentorMessage(message);
@@ -156,20 +156,18 @@ bindAugmentors(const std::string & uri)
 
 void
 AugmentationLoop::
-handleAugmentorMessage(const std::vector<std::string> & message)
+handleAugmentorMessage(const ZmqMessageView & message)
 {
-    Date now = Date::now();
-
-    const std::string & type = message.at(1); 
-    if (type == "CONFIG") {
-        doConfig(message);
-    }
-    else if (type == "RESPONSE") {
+    ZmqFrameView type = message.at(1);
+    if (type == "RESPONSE") {
         doResponse(message);
     }
+    else if (type == "CONFIG") {
+        doConfig(message.toStrings());
+    }
     else throw ML::Exception("error handling unknown "
                              "augmentor message of type "
-                             + type);
+                             + type.toString());
 }
 
 void
@@ -185,6 +183,8 @@ recordStats()
 
         recordLevel(inFlights, "augmentor.%s.numInFlight", it->first);
     }
+
+    recordLevel(cache.size(), "cache.entries");
 }
 
 
@@ -211,6 +211,8 @@ checkExpiries()
     if (augmenting.earliest <= now)
         augmenting.expire(onExpired, now);
 
+    cache.expire(now);
+
     if (augmenting.empty() && !idle_) {
         idle_ = 1;
         futex_wake(idle_);
@@ -384,12 +386,27 @@ doAugmentation(std::shared_ptr<Entry>&& entry)
     }
 
     bool sentToAugmentor = false;
+    std::vector<std::string> cached;
 
     for (auto it = entry->outstanding.begin(), end = entry->outstanding.end();
          it != end;  ++it)
     {
         auto & aug = *augmentors[*it];
 
+        // A response cached for the same user and agents completes the
+        // augmentation without going to the augmentor.
+        std::string key = cacheKey(aug, *entry);
+        if (!key.empty()) {
+            const AugmentationList * response = cache.find(*it, key, now);
+            if (response) {
+                recordHit("augmentor.%s.cacheHit", *it);
+                entry->info->auction->augmentations[*it].mergeWith(*response);
+                cached.push_back(*it);
+                continue;
+            }
+            recordHit("augmentor.%s.cacheMiss", *it);
+        }
+
         auto instance = pickInstance(aug);
         if (!instance) {
             recordHit("augmentor.%s.skippedTooManyInFlight", *it);
@@ -400,24 +417,41 @@ doAugmentation(std::shared_ptr<Entry>&& entry)
         set<string> agents = entry->augmentorAgents[*it];
 
         entry->instances[*it] = instance;
-        
-        std::ostringstream availableAgentsStr;
-        ML::DB::Store_Writer writer(availableAgentsStr);
-        writer.save(agents);
-
-        // Send the message to the augmentor
-        toAugmentors.sendMessage(
-                instance->addr,
-                "AUGMENT", "1.0", *it,
-                entry->info->auction->id.toString(),
-                entry->info->auction->requestStrFormat,
-                entry->info->auction->requestStr,
-                availableAgentsStr.str(),
-                Date::now());
+
+        // Send the message to the augmentor.  Version 1.1 carries only the
+        // fields of the request it asked for and the indexes of the agents.
+        if (instance->projection) {
+            toAugmentors.sendMessage(
+                    instance->addr,
+                    "AUGMENT", "1.1", *it,
+                    entry->info->auction->id.toString(),
+                    "datacratic-bin",
+                    instance->projection->project(
+                            *entry->info->auction->request),
+                    agentIndexes(*instance, agents),
+                    Date::now());
+        }
+        else {
+            std::ostringstream availableAgentsStr;
+            ML::DB::Store_Writer writer(availableAgentsStr);
+            writer.save(agents);
+
+            toAugmentors.sendMessage(
+                    instance->addr,
+                    "AUGMENT", "1.0", *it,
+                    entry->info->auction->id.toString(),
+                    entry->info->auction->requestStrFormat,
+                    entry->info->auction->requestStr.str(),
+                    availableAgentsStr.str(),
+                    Date::now());
+        }
 
         sentToAugmentor = true;
     }
 
+    for (const auto & name : cached)
+        entry->outstanding.erase(name);
+
     if (sentToAugmentor)
         augmenting.insert(entry->info->auction->id, std::move(entry), entry->timeout);
     else entry->onFinished(entry->info);
@@ -432,7 +466,7 @@ AugmentationLoop::
 doConfig(const std::vector<std::string> & message)
 {
     ExcCheckGreaterEqual(message.size(), 4, "config message has wrong size");
-    ExcCheckLessEqual(message.size(), 5, "config message has wrong size");
+    ExcCheckLessEqual(message.size(), 7, "config message has wrong size");
 
     const string & addr = message[0];
     const string & version = message[2];
@@ -443,6 +477,16 @@ doConfig(const std::vector<std::string> & message)
         maxInFlight = std::stoi(message[4]);
     if (maxInFlight < 0) maxInFlight = 3000;
 
+    AugmentationCacheConfig cacheConfig;
+    if (message.size() >= 6 && !message[5].empty())
+        cacheConfig = AugmentationCacheConfig::fromJson(Json::parse(message[5]));
+
+    std::shared_ptr<const BidRequestProjection> projection;
+    if (message.size() >= 7 && !message[6].empty()) {
+        projection = std::make_shared<BidRequestProjection>(
+                BidRequestProjection::fromJson(Json::parse(message[6])));
+    }
+
     ExcCheckEqual(version, "1.0", "unknown version for config message");
     ExcCheck(!name.empty(), "no augmentor name specified");
 
@@ -457,13 +501,22 @@ doConfig(const std::vector<std::string> & message)
         recordHit("augmentor.%s.configured", name);
     }
 
-    info->instances.push_back(std::make_shared<AugmentorInstanceInfo>(addr, maxInFlight));
+    auto instance = std::make_shared<AugmentorInstanceInfo>(addr, maxInFlight);
+    instance->projection = projection;
+    info->instances.push_back(instance);
+
+    // The last instance to configure decides how the augmentor is cached.
+    if (cacheConfig.toJson() != info->cacheConfig.toJson()) {
+        cache.erase(name);
+        info->cacheConfig = cacheConfig;
+    }
     recordHit("augmentor.%s.instances.%s.configured", name, addr);
 
 
     updateAllAugmentors();
 
-    toAugmentors.sendMessage(addr, "CONFIGOK");
+    // The version tells the augmentor that binary responses are understood
+    toAugmentors.sendMessage(addr, "CONFIGOK", "1.1");
 }
 
 
@@ -503,8 +556,10 @@ doDisconnection(const std::string & addr, const std::string & aug)
     }
 
     // We let the inFlight auctions expire naturally.
-    for (const auto& name : toErase)
+    for (const auto& name : toErase) {
         augmentors.erase(name);
+        cache.erase(name);
+    }
 
     if (!toErase.empty())
         updateAllAugmentors();
@@ -513,32 +568,48 @@ doDisconnection(const std::string & addr, const std::string & aug)
 
 void
 AugmentationLoop::
-doResponse(const std::vector<std::string> & message)
+doResponse(const ZmqMessageView & message)
 {
     recordEvent("augmentation.response");
     //cerr << "doResponse " << message << endl;
 
     ExcCheckEqual(message.size(), 7, "response message has wrong size");
 
-    const string & version = message[2];
-    ExcCheckEqual(version, "1.0", "unknown response version");
+    ZmqFrameView version = message[2];
+
+    Date startTime;
+    Id id;
+    if (version == "1.1") {
+        startTime = message[3].binary<Date>();
+        id = message[4].binary<Id>();
+    }
+    else if (version == "1.0") {
+        startTime = Date::parseSecondsSinceEpoch(message[3].toString());
+        id = Id(message[4].toString());
+    }
+    else throw ML::Exception("unknown response version "
+                             + version.toString());
 
-    const std::string & addr = message[0];
-    Date startTime = Date::parseSecondsSinceEpoch(message[3]);
-    Id id(message[4]);
-    const std::string & augmentor = message[5];
-    const std::string & augmentation = message[6];
+    const std::string addr = message[0].toString();
+    const std::string augmentor = message[5].toString();
+    ZmqFrameView augmentation = message[6];
 
     ML::Timer timer;
 
     AugmentationList augmentationList;
-    if (augmentation != "" && augmentation != "null") {
+    bool validResponse = false;
+    if (!augmentation.empty() && augmentation != "null") {
         try {
             Json::Value augmentationJson;
 
             JML_TRACE_EXCEPTIONS(false);
-            augmentationJson = Json::parse(augmentation);
+            Json::Reader reader;
+            if (!reader.parse(augmentation.data(),
+                              augmentation.data() + augmentation.size(),
+                              augmentationJson))
+                throw ML::Exception("invalid augmentation json");
             augmentationList = AugmentationList::fromJson(augmentationJson);
+            validResponse = true;
         } catch (const std::exception & exc) {
             string eventName = "augmentor." + augmentor
                 + ".responseParsingExceptions";
@@ -577,11 +648,22 @@ doResponse(const std::vector<std::string> & message)
     auto& entry = *augmentingIt;
 
     const char* eventType =
-        (augmentation == "" || augmentation == "null") ?
+        (augmentation.empty() || augmentation == "null") ?
         "nullResponse" : "validResponse";
     recordHit("augmentor.%s.%s", augmentor, eventType);
     recordHit("augmentor.%s.instances.%s.%s", augmentor, addr, eventType);
 
+    // Null responses are what shedding augmentors send so they're never
+    // cached.
+    if (validResponse && augmentorIt != augmentors.end()) {
+        const AugmentorInfo & aug = *augmentorIt->second;
+        std::string key = cacheKey(aug, *entry.second);
+        if (!key.empty()) {
+            cache.insert(augmentor, key, augmentationList,
+                         Date::now().plusSeconds(aug.cacheConfig.ttl));
+        }
+    }
+
     auto& auctionAugs = entry.second->info->auction->augmentations;
     auctionAugs[augmentor].mergeWith(augmentationList);
 
@@ -606,4 +688,52 @@ augmentationExpired(const Id & id, const Entry & entry)
     entry.onFinished(entry.info);
 }                     
 
+std::string
+AugmentationLoop::
+cacheKey(const AugmentorInfo & aug, Entry & entry)
+{
+    if (!aug.cacheConfig.enabled()) return "";
+
+    const auto & request = entry.info->auction->request;
+    if (!request) return "";
+
+    return AugmentationCache::key(aug.cacheConfig, request->userIds,
+                                  entry.augmentorAgents[aug.name]);
+}
+
+std::string
+AugmentationLoop::
+agentIndexes(AugmentorInstanceInfo & instance,
+             const std::set<std::string> & agents)
+{
+    size_t first = instance.agentIndexes.size();
+    std::vector<std::string> newAgents;
+
+    std::string result;
+    result.reserve(agents.size() * sizeof(uint32_t));
+
+    for (const auto & agent : agents) {
+        uint32_t index = instance.agentIndexes.size();
+        auto res = instance.agentIndexes.insert(make_pair(agent, index));
+        if (res.second)
+            newAgents.push_back(agent);
+        else index = res.first->second;
+
+        result.append((const char *)&index, sizeof(index));
+    }
+
+    // Messages to an instance are delivered in order so it gets the names
+    // before the request that uses them.
+    if (!newAgents.empty()) {
+        std::ostringstream agentsStr;
+        ML::DB::Store_Writer writer(agentsStr);
+        writer.save(newAgents);
+
+        toAugmentors.sendMessage(instance.addr, "AGENTS", "1.0",
+                                 std::to_string(first), agentsStr.str());
+    }
+
+    return result;
+}
+
 } // namespace RTBKIT
@@ -13,7 +13,10 @@
 #include "soa/service/zmq_endpoint.h"
 #include "soa/service/typed_message_channel.h"
 #include "router_types.h"
+#include "augmentation_cache.h"
+#include "rtbkit/common/bid_request_projection.h"
 #include <boost/scoped_ptr.hpp>
+#include <unordered_map>
 #include <boost/thread/thread.hpp>
 #include "soa/service/zmq.hpp"
 #include "soa/service/socket_per_thread.h"
@@ -40,6 +43,18 @@ struct AugmentorInstanceInfo {
     std::string addr;
     int numInFlight;
     int maxInFlight;
+
+    /** Fields of the bid request that the instance reads.  When null, the
+        whole request is sent.  It's per instance as instances running
+        different versions of an augmentor can coexist during a deploy, and
+        only those that ask for a projection understand AUGMENT 1.1.
+    */
+    std::shared_ptr<const BidRequestProjection> projection;
+
+    /** Index of the agents sent to the instance in AGENTS messages, which
+        projected AUGMENT messages refer to instead of the agent names.
+    */
+    std::unordered_map<std::string, uint32_t> agentIndexes;
 };
 
 /** Information about a given class of augmentor. */
@@ -48,6 +63,7 @@ struct AugmentorInfo {
 
     std::string name;                   ///< What the augmentation is called
     std::vector<std::shared_ptr<AugmentorInstanceInfo>> instances;
+    AugmentationCacheConfig cacheConfig; ///< How to cache its responses
 
     std::shared_ptr<AugmentorInstanceInfo> findInstance(const std::string& addr)
     {
@@ -135,6 +151,9 @@ private:
     /** Currently configured augmentors.  Indexed by the augmentor name. */
     std::map<std::string, std::shared_ptr<AugmentorInfo> > augmentors;
 
+    /** Responses of the augmentors which enabled caching in their config. */
+    AugmentationCache cache;
+
     /** A single entry in the augmentor info structure. */
     struct AugmentorInfoEntry {
         std::string name;
@@ -165,7 +184,7 @@ private:
     void updateAllAugmentors();
 
 
-    void handleAugmentorMessage(const std::vector<std::string> & message);
+    void handleAugmentorMessage(const ZmqMessageView & message);
 
     std::shared_ptr<AugmentorInstanceInfo> pickInstance(AugmentorInfo& aug);
     void doAugmentation(std::shared_ptr<Entry>&& entry);
@@ -180,13 +199,26 @@ private:
     /** Disconnect the instance at addr for type aug. */
     void doDisconnection(const std::string & addr, const std::string & aug = "");
 
-    /** Handle a response from an augmentation. */
-    void doResponse(const std::vector<std::string> & message);
+    /** Handle a response from an augmentation.  Version 1.1 of the response
+        has its start time and auction id in binary frames.
+    */
+    void doResponse(const ZmqMessageView & message);
 
     /** Handle a message asking for augmentation. */
     void doAugment(const std::vector<std::string> & message);
 
     void augmentationExpired(const Id & id, const Entry & entry);
+
+    /** Returns the key under which the response of the augmentor for the
+        entry is cached or an empty string if it can't be cached.
+    */
+    std::string cacheKey(const AugmentorInfo & aug, Entry & entry);
+
+    /** Returns the packed indexes of the agents for the instance, first
+        sending it an AGENTS message for the agents it doesn't know yet.
+    */
+    std::string agentIndexes(AugmentorInstanceInfo & instance,
+                             const std::set<std::string> & agents);
 };
 
 } // namespace RTBKIT
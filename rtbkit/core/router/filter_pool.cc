@@ -7,6 +7,7 @@
 */
 
 #include "filter_pool.h"
+#include "filters/priority.h"
 #include "rtbkit/common/bid_request.h"
 #include "rtbkit/common/exchange_connector.h"
 #include "rtbkit/core/agent_configuration/agent_config.h"
@@ -14,6 +15,8 @@
 #include "jml/utils/exc_check.h"
 #include "jml/arch/tick_counter.h"
 
+#include <mutex>
+
 
 using namespace std;
 using namespace ML;
@@ -26,6 +29,14 @@ namespace RTBKIT {
 /* FILTER POOL                                                                */
 /******************************************************************************/
 
+struct FilterPool::StageEvents
+{
+    EventHandle timing;
+    EventHandle breakLoop;
+    std::vector<EventHandle> filtered; // indexed by config.
+};
+
+
 FilterPool::
 FilterPool() : data(new Data()), events(nullptr) {}
 
@@ -42,6 +53,8 @@ bool
 FilterPool::
 setData(Data*& oldData, unique_ptr<Data>& newData)
 {
+    if (newData) newData->compile(*this);
+
     if (!data.compare_exchange_strong(oldData, newData.get()))
         return false;
 
@@ -69,16 +82,57 @@ FilterPool::
 
 void
 FilterPool::
-recordDiff(const Data* data, const FilterBase* filter, const ConfigSet& diff)
+recordDiff(const Data::Stage& stage, const ConfigSet& diff)
 {
+    if (!stage.events) return;
+    const auto& filtered = stage.events->filtered;
+
     for (size_t cfg = diff.next(); cfg < diff.size(); cfg = diff.next(cfg+1)) {
-        const AgentConfig& config = *data->configs[cfg].config;
+        if (cfg < filtered.size()) filtered[cfg].record();
+    }
+}
 
-        events->recordHit("accounts.%s.filter.static.%s",
-                config.account.toString('.'), filter->name());
+/** Attributes the configs removed by the fused stage to the fused filters as
+    if they had been executed one after the other.
+ */
+void
+FilterPool::
+recordFused(const Data* data, const Data::FusedResult& result, const ConfigSet& configs)
+{
+    ConfigSet remaining = configs;
+
+    for (size_t i = 0; i < data->fused.size(); ++i) {
+        const Data::Stage& stage = data->fused[i];
+
+        ConfigSet diff = remaining & result.removed[i];
+        recordDiff(stage, diff);
+        remaining ^= diff;
+
+        if (remaining.empty()) {
+            recordBreak(stage);
+            return;
+        }
     }
 }
 
+void
+FilterPool::
+recordStage(
+        const Data* data, const Data::Stage& stage,
+        const ConfigSet& configs, FilterState& state)
+{
+    recordDiff(stage, configs ^ state.configs());
+    if (!state.getFilterReasons().empty())
+        recordReason(data, stage.filter, state);
+}
+
+void
+FilterPool::
+recordBreak(const Data::Stage& stage)
+{
+    if (stage.events) stage.events->breakLoop.record();
+}
+
 void
 FilterPool::
 recordReason(const Data* data, const FilterBase* f, FilterState & state){
@@ -101,16 +155,14 @@ recordReason(const Data* data, const FilterBase* f, FilterState & state){
 
 }
 
-uint64_t
+void
 FilterPool::
-recordTime(uint64_t start, const FilterBase* filter)
+recordTime(uint64_t elapsed, const Data::Stage& stage)
 {
-    uint64_t now = ticks();
-    double us = ((now - start) / ticks_per_second) * 1000000.0;
+    if (!stage.events) return;
 
-    events->recordLevel(us, "filters.timingUs.%s", filter->name());
-
-    return now;
+    double us = (elapsed / ticks_per_second) * 1000000.0;
+    stage.events->timing.record(us);
 }
 
 
@@ -126,44 +178,89 @@ filter(const BidRequest& br, const ExchangeConnector* conn, const ConfigSet& mas
     FilterState state(br, conn, current->activeConfigs);
     state.narrowConfigs(mask);
 
-    ConfigSet configs = state.configs();
+    if (random() % 10 == 0)
+        filterSampled(current, state);
+    else filterCompiled(current, state);
 
-    bool sampleStats = events && (random() % 10 == 0);
-    uint64_t ticksStart = sampleStats ? ticks() : 0;
+    auto biddableSpots = state.biddableSpots();
+    const ConfigSet& configs = state.configs();
 
-    for (FilterBase* filter : current->filters) {
-        filter->filter(state);
+    ConfigList result;
+    for (size_t i = configs.next(); i < configs.size(); i = configs.next(i + 1)) {
+        ConfigEntry entry = current->configs[i];
+        entry.biddableSpots = std::move(biddableSpots[i]);
+        result.emplace_back(std::move(entry));
+    }
 
-        const ConfigSet& filtered = state.configs();
+    return result;
+}
+
+
+void
+FilterPool::
+filterCompiled(const Data* current, FilterState& state)
+{
+    if (!current->fused.empty()) {
+        auto result = current->lookupFused(state);
+        if (events) recordFused(current, *result, state.configs());
+
+        state.narrowConfigs(result->configs);
+        if (state.configs().empty()) return;
+    }
 
-        if (sampleStats) {
-            ticksStart = recordTime(ticksStart, filter);
-            recordDiff(current, filter, configs ^ filtered);
-            if (!state.getFilterReasons().empty()) {
-                recordReason(current, filter, state);
-            }
-            configs = filtered;
+    for (const Data::Stage& stage : current->stages) {
+        if (events) {
+            ConfigSet configs = state.configs();
+            stage.filter->filter(state);
+            recordStage(current, stage, configs, state);
         }
+        else stage.filter->filter(state);
+
         state.resetFilterReasons();
 
-        if (filtered.empty()) {
-            if (sampleStats) 
-                events->recordHit("filters.breakLoop.%s", filter->name());
-            break;
+        if (state.configs().empty()) {
+            if (events) recordBreak(stage);
+            return;
         }
     }
+}
 
-    auto biddableSpots = state.biddableSpots();
-    configs = state.configs();
 
-    ConfigList result;
-    for (size_t i = configs.next(); i < configs.size(); i = configs.next(i + 1)) {
-        ConfigEntry entry = current->configs[i];
-        entry.biddableSpots = std::move(biddableSpots[i]);
-        result.emplace_back(std::move(entry));
-    }
+/** Runs every filter individually, fused ones included, so that we can measure
+    the cost and the selectivity of each of them.
+ */
+void
+FilterPool::
+filterSampled(const Data* current, FilterState& state)
+{
+    ConfigSet configs = state.configs();
 
-    return result;
+    auto runStage = [&] (const Data::Stage& stage) {
+        uint64_t start = ticks();
+        stage.filter->filter(state);
+        uint64_t elapsed = ticks() - start;
+
+        const ConfigSet& filtered = state.configs();
+        stage.cost->record(elapsed, configs.count(), filtered.count());
+
+        if (events) {
+            recordTime(elapsed, stage);
+            recordStage(current, stage, configs, state);
+        }
+        state.resetFilterReasons();
+        configs = filtered;
+
+        if (!filtered.empty()) return true;
+
+        if (events) recordBreak(stage);
+        return false;
+    };
+
+    for (const Data::Stage& stage : current->fused)
+        if (!runStage(stage)) return;
+
+    for (const Data::Stage& stage : current->stages)
+        if (!runStage(stage)) return;
 }
 
 
@@ -303,6 +400,45 @@ getFilterNames() const
 }
 
 
+/******************************************************************************/
+/* FILTER POOL - FILTER COST                                                  */
+/******************************************************************************/
+
+void
+FilterPool::FilterCost::
+record(uint64_t ticks, size_t configsIn, size_t configsOut)
+{
+    this->samples++;
+    this->ticks += ticks;
+    this->configsIn += configsIn;
+    this->configsOut += configsOut;
+}
+
+double
+FilterPool::FilterCost::
+rank() const
+{
+    double n = samples;
+    double in = configsIn;
+    if (!n || !in) return 0.0;
+
+    double cost = ticks / n;
+    double removed = 1.0 - configsOut / in;
+    return cost / std::max(removed, 0.001);
+}
+
+shared_ptr<FilterPool::FilterCost>
+FilterPool::
+getCost(const string& filter)
+{
+    lock_guard<Spinlock> guard(costsLock);
+
+    auto& cost = costs[filter];
+    if (!cost) cost = make_shared<FilterCost>();
+    return cost;
+}
+
+
 /******************************************************************************/
 /* FILTER POOL - DATA                                                         */
 /******************************************************************************/
@@ -310,7 +446,8 @@ getFilterNames() const
 FilterPool::Data::
 Data(const Data& other) :
     configs(other.configs),
-    activeConfigs(other.activeConfigs)
+    activeConfigs(other.activeConfigs),
+    events(other.events)
 {
     filters.reserve(other.filters.size());
     for (FilterBase* filter : other.filters)
@@ -324,6 +461,170 @@ FilterPool::Data::
     for (FilterBase* filter : filters) delete filter;
 }
 
+
+namespace {
+
+// Number of samples required for each filter before we trust the measurements
+// enough to reorder the filters.
+constexpr uint64_t MinSamples = 1000;
+
+// Upper bound on the number of results memoized by the fused stage.
+constexpr size_t MaxFusedEntries = 4096;
+
+} // namespace anonymous
+
+void
+FilterPool::Data::
+compile(FilterPool& pool)
+{
+    fused.clear();
+    stages.clear();
+    fusedCache.clear();
+
+    // Filters at or above ExchangePre asked to be executed as late as
+    // possible (they usually call back into the exchange connector) so they
+    // keep their position at the end.
+    size_t reorderable = 0;
+    bool measured = true;
+
+    unordered_map<string, shared_ptr<const StageEvents> > newEvents;
+
+    for (FilterBase* filter : filters) {
+        filter->compile();
+
+        auto& interned = newEvents[filter->name()];
+        auto it = events.find(filter->name());
+        interned = internEvents(
+                pool, filter, it != events.end() ? it->second : nullptr);
+
+        Stage stage = { filter, pool.getCost(filter->name()), interned };
+
+        if (filter->isExactMatch()) {
+            fused.push_back(stage);
+            continue;
+        }
+
+        if (filter->priority() < Priority::ExchangePre) {
+            measured = measured && stage.cost->samples >= MinSamples;
+            reorderable++;
+        }
+
+        stages.push_back(stage);
+    }
+
+    events.swap(newEvents);
+    changedConfigs.clear();
+
+    // filters is sorted by priority so the reorderable stages are all at the
+    // front. Until every one of them has been measured we stick to the
+    // priority order.
+    if (!measured) return;
+
+    // The measurements keep changing under our feet so snapshot the ranks
+    // before sorting.
+    vector< pair<double, Stage> > ranked;
+    for (size_t i = 0; i < reorderable; ++i)
+        ranked.emplace_back(stages[i].cost->rank(), stages[i]);
+
+    stable_sort(ranked.begin(), ranked.end(),
+            [] (const pair<double, Stage>& lhs, const pair<double, Stage>& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+    for (size_t i = 0; i < reorderable; ++i)
+        stages[i] = ranked[i].second;
+}
+
+shared_ptr<const FilterPool::StageEvents>
+FilterPool::Data::
+internEvents(
+        const FilterPool& pool, const FilterBase* filter,
+        const shared_ptr<const StageEvents>& previous) const
+{
+    if (!pool.events) return nullptr;
+
+    // The previous generation may still be recording through its events so
+    // they're copied rather than updated in place. Only the events of the
+    // configs that changed since need to be interned again.
+    if (previous) {
+        if (changedConfigs.empty() && previous->filtered.size() == configs.size())
+            return previous;
+
+        auto result = make_shared<StageEvents>(*previous);
+        result->filtered.resize(configs.size());
+        for (size_t cfgId : changedConfigs)
+            internConfigEvents(pool, filter, cfgId, *result);
+        return result;
+    }
+
+    EventRecorder& events = *pool.events;
+    string name = filter->name();
+
+    auto result = make_shared<StageEvents>();
+    result->timing = events.internEvent("filters.timingUs." + name, ET_LEVEL);
+    result->breakLoop = events.internEvent("filters.breakLoop." + name);
+
+    result->filtered.resize(configs.size());
+    for (size_t i = 0; i < configs.size(); ++i)
+        internConfigEvents(pool, filter, i, *result);
+
+    return result;
+}
+
+void
+FilterPool::Data::
+internConfigEvents(
+        const FilterPool& pool, const FilterBase* filter,
+        size_t cfgId, StageEvents& result) const
+{
+    if (!configs[cfgId].config) {
+        result.filtered[cfgId] = EventHandle();
+        return;
+    }
+
+    result.filtered[cfgId] = pool.events->internEvent(ML::format(
+                    "accounts.%s.filter.static.%s",
+                    configs[cfgId].config->account.toString('.').c_str(),
+                    filter->name().c_str()));
+}
+
+shared_ptr<const FilterPool::Data::FusedResult>
+FilterPool::Data::
+lookupFused(const FilterState& state) const
+{
+    string key;
+    for (const Stage& stage : fused)
+        stage.filter->exactMatchKey(state.request, key);
+
+    {
+        lock_guard<Spinlock> guard(fusedLock);
+        auto it = fusedCache.find(key);
+        if (it != fusedCache.end()) return it->second;
+    }
+
+    // The fused filters only narrow the configs so we can evaluate them
+    // against all the active configs and apply the result as a mask.
+    auto result = make_shared<FusedResult>();
+    result->removed.resize(fused.size());
+
+    FilterState fullState(state.request, state.exchange, activeConfigs);
+    for (size_t i = 0; i < fused.size(); ++i) {
+        ConfigSet configs = fullState.configs();
+        fused[i].filter->filter(fullState);
+
+        result->removed[i] = configs ^ fullState.configs();
+        if (fullState.configs().empty()) break;
+    }
+
+    result->configs = fullState.configs();
+
+    lock_guard<Spinlock> guard(fusedLock);
+    if (fusedCache.size() >= MaxFusedEntries) fusedCache.clear();
+    fusedCache.emplace(move(key), result);
+
+    return result;
+}
+
 ssize_t
 FilterPool::Data::
 findConfig(const string& name) const
@@ -351,6 +652,7 @@ addConfig(const string& name, const AgentInfo& info)
     }
 
     activeConfigs.setConfig(index, info.config->creatives.size());
+    changedConfigs.push_back(index);
 
     for (FilterBase* filter : filters)
         filter->addConfig(index, info.config);
@@ -371,6 +673,7 @@ removeConfig(const string& name)
         filter->removeConfig(index, configs[index].config);
 
     configs[index].reset();
+    changedConfigs.push_back(index);
 }
 
 
@@ -10,11 +10,13 @@
 
 #include "rtbkit/common/filter.h"
 #include "soa/gc/gc_lock.h"
+#include "jml/arch/spinlock.h"
 
 #include <atomic>
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 
 namespace Datacratic {
@@ -37,6 +39,19 @@ struct AgentConfig;
 /* FILTER POOL                                                                */
 /******************************************************************************/
 
+/** Holds the filters and the agent configs they operate on.
+
+    Every time a new generation of the data is published, the filters are
+    compiled into their execution order: the exact-match filters (see
+    FilterBase::isExactMatch) are fused into a single memoized lookup stage
+    and the remaining filters are ordered by their measured cost and
+    selectivity. A sample of the requests are run through each filter
+    individually to gather those measurements.
+
+    The per filter events are interned when the data is compiled, only for
+    the filters and configs that changed since the previous generation, and
+    are recorded for every request, whichever of the two paths it takes.
+ */
 struct FilterPool
 {
     FilterPool();
@@ -92,6 +107,31 @@ struct FilterPool
 
 private:
 
+    /** Cost and selectivity measurements of a filter. These are kept across
+        generations of the data so that each new generation can be ordered
+        according to what was measured on the previous ones.
+     */
+    struct FilterCost
+    {
+        FilterCost() : samples(0), ticks(0), configsIn(0), configsOut(0) {}
+
+        void record(uint64_t ticks, size_t configsIn, size_t configsOut);
+
+        // Expected cost of the filter per config it removes. Filters with a
+        // lower rank should be executed first.
+        double rank() const;
+
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> ticks;
+        std::atomic<uint64_t> configsIn;
+        std::atomic<uint64_t> configsOut;
+    };
+
+    std::shared_ptr<FilterCost> getCost(const std::string& filter);
+
+    /** Interned events of a filter for a generation of the data. */
+    struct StageEvents;
+
     struct Data
     {
         Data() {}
@@ -106,22 +146,78 @@ private:
         void addFilter(FilterBase* filter);
         void removeFilter(const std::string& name);
 
+        /** Outcome of the fused stage for an exact-match key: the configs
+            that made it through and the configs removed by each fused filter
+            so that the removals can still be attributed to the filters.
+         */
+        struct FusedResult
+        {
+            ConfigSet configs;
+            std::vector<ConfigSet> removed;
+        };
+
+        void compile(FilterPool& pool);
+        std::shared_ptr<const StageEvents>
+        internEvents(
+                const FilterPool& pool, const FilterBase* filter,
+                const std::shared_ptr<const StageEvents>& previous) const;
+        void internConfigEvents(
+                const FilterPool& pool, const FilterBase* filter,
+                size_t cfgId, StageEvents& result) const;
+        std::shared_ptr<const FusedResult> lookupFused(const FilterState& state) const;
+
         // \todo Use unique_ptr when moving to gcc 4.7
         std::vector<FilterBase*> filters;
 
         std::vector<ConfigEntry> configs;
         CreativeMatrix activeConfigs;
+
+        // Interned events of each filter, carried from one generation to the
+        // next so that compile() only interns the events of the configs that
+        // changed in between.
+        std::unordered_map<
+            std::string, std::shared_ptr<const StageEvents> > events;
+        std::vector<size_t> changedConfigs;
+
+        struct Stage
+        {
+            FilterBase* filter;
+            std::shared_ptr<FilterCost> cost;
+            std::shared_ptr<const StageEvents> events; // null without events.
+        };
+
+        // Compiled form of the filters; rebuilt by compile() whenever a new
+        // generation is published.
+        std::vector<Stage> fused;
+        std::vector<Stage> stages;
+
+        // Result of the fused stage for each exact-match key seen so far.
+        mutable ML::Spinlock fusedLock;
+        mutable std::unordered_map<
+            std::string, std::shared_ptr<const FusedResult> > fusedCache;
     };
 
     bool setData(Data*&, std::unique_ptr<Data>&);
-    void recordDiff(const Data* data, const FilterBase* f, const ConfigSet& diff);
+    void filterCompiled(const Data* data, FilterState& state);
+    void filterSampled(const Data* data, FilterState& state);
+    void recordFused(
+            const Data* data, const Data::FusedResult& result,
+            const ConfigSet& configs);
+    void recordStage(
+            const Data* data, const Data::Stage& stage,
+            const ConfigSet& configs, FilterState& state);
+    void recordDiff(const Data::Stage& stage, const ConfigSet& diff);
     void recordReason(const Data* data, const FilterBase* f, FilterState & state);
-    uint64_t recordTime(uint64_t ticks, const FilterBase* filter);
+    void recordTime(uint64_t elapsed, const Data::Stage& stage);
+    void recordBreak(const Data::Stage& stage);
 
     std::atomic<Data*> data;
     std::vector< std::shared_ptr<AgentConfig> > configs;
     mutable Datacratic::GcLock gc;
 
+    ML::Spinlock costsLock;
+    std::unordered_map<std::string, std::shared_ptr<FilterCost> > costs;
+
     EventRecorder* events;
 };
 
@@ -11,6 +11,8 @@
 
 LIB_FILTERS_SOURCES := \
 	static_filters.cc \
+	pattern_matcher.cc \
+	geo_index.cc \
         creative_filters.cc
 
 LIB_FILTERS_LINK := \
@@ -11,6 +11,9 @@
 #include "rtbkit/core/agent_configuration/agent_config.h"
 #include "rtbkit/core/agent_configuration/include_exclude.h"
 #include "rtbkit/common/filter.h"
+#include "pattern_matcher.h"
+
+#include <algorithm>
 
 
 namespace RTBKIT {
@@ -322,12 +325,29 @@ private:
 
 /** Generic include filter for regexes.
 
+    Once compiled, the literal and near-literal regexes are matched in a single
+    pass over the string by a PatternMatcher and only the irregular ones are
+    evaluated one by one. Until compile() is called (it's called by the
+    FilterPool on every new generation) every regex is evaluated.
+
     \todo We could add a TLS cache of all seen values such that we can avoid the
     regex entirely.
  */
 template<typename Regex, typename Str>
 struct RegexFilter
 {
+    RegexFilter() : compiled(false) {}
+
+    // The compiled form points into data so it isn't copied.
+    RegexFilter(const RegexFilter& other) : data(other.data), compiled(false) {}
+
+    RegexFilter& operator=(const RegexFilter& other)
+    {
+        data = other.data;
+        compiled = false;
+        return *this;
+    }
+
     template<typename List>
     bool isEmpty(const List& list) const
     {
@@ -352,16 +372,48 @@ struct RegexFilter
     {
         ConfigSet matches;
 
-        for (const auto& entry : data)
-            matches |= entry.second.filter(str);
+        if (!compiled) {
+            for (const auto& entry : data)
+                matches |= entry.second.filter(str);
+            return matches;
+        }
+
+        matchLiterals(str, matches);
+
+        for (const RegexData* entry : irregular)
+            matches |= entry->filter(str);
 
         return matches;
     }
 
+    void compile()
+    {
+        if (compiled) return;
+
+        literals.clear();
+        literalData.clear();
+        irregular.clear();
+
+        for (const auto& entry : data) {
+            RegexLiteral literal;
+
+            if (analyze(entry.second.regex, literal)) {
+                literals.add(literal.literal);
+                literalData.push_back(std::make_pair(&entry.second, literal));
+            }
+            else irregular.push_back(&entry.second);
+        }
+
+        literals.build();
+        compiled = true;
+    }
+
 private:
 
     void addConfig(unsigned cfgIndex, const Regex& regex)
     {
+        compiled = false;
+
         auto& entry = data[regex.str()];
         if (entry.regex.empty()) entry.regex = regex;
         entry.configs.set(cfgIndex);
@@ -375,6 +427,8 @@ private:
 
     void removeConfig(unsigned cfgIndex, const Regex& regex)
     {
+        compiled = false;
+
         auto it = data.find(regex.str());
         if (it == data.end()) return;
 
@@ -407,6 +461,70 @@ private:
        own because, you guessed it, gcc already defines it. Glorious is it not?
     */
     std::map<KeyT, RegexData> data;
+
+
+    // Only case sensitive perl regexes are analyzed; the others are always
+    // evaluated.
+    static bool analyze(const boost::regex& regex, RegexLiteral& literal)
+    {
+        if (regex.flags() & (boost::regex::icase | boost::regex::literal))
+            return false;
+        return analyzeRegex(regex.str(), literal);
+    }
+
+    template<typename R>
+    static bool analyze(const R&, RegexLiteral&) { return false; }
+
+
+    // Only std::string values are ever matched against the literals.
+    template<typename S>
+    void matchLiterals(const S&, ConfigSet&) const {}
+
+    void matchLiterals(const std::string& str, ConfigSet& matches) const
+    {
+        // Anchors also match around newlines so we can only trust them for
+        // single line strings.
+        bool singleLine = str.find('\n') == std::string::npos;
+
+        std::vector<unsigned> found, candidates;
+
+        literals.search(str, [&] (unsigned pattern, size_t end) {
+                    const RegexLiteral& literal = literalData[pattern].second;
+
+                    if (!literal.exact || !singleLine) {
+                        candidates.push_back(pattern);
+                        return;
+                    }
+
+                    if (literal.anchorBegin && end != literals.length(pattern))
+                        return;
+                    if (literal.anchorEnd && end != str.size())
+                        return;
+
+                    found.push_back(pattern);
+                });
+
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+
+        for (unsigned pattern : found)
+            matches |= literalData[pattern].first->configs;
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(
+                std::unique(candidates.begin(), candidates.end()),
+                candidates.end());
+
+        for (unsigned pattern : candidates)
+            matches |= literalData[pattern].first->filter(str);
+    }
+
+
+    // Compiled form of data; see compile().
+    bool compiled;
+    PatternMatcher literals;
+    std::vector< std::pair<const RegexData*, RegexLiteral> > literalData;
+    std::vector<const RegexData*> irregular;
 };
 
 
@@ -613,6 +731,13 @@ struct IncludeExcludeFilter
     }
 
 
+    // Only available if the underlying filter can be compiled.
+    void compile()
+    {
+        includes.compile();
+        excludes.compile();
+    }
+
     template<typename... Args>
     ConfigSet filter(Args&&... args) const
     {
@@ -0,0 +1,175 @@
+/** geo_index.cc                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Implementation of the geo-fencing index.
+
+*/
+
+#include "geo_index.h"
+#include "jml/utils/exc_check.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* GEO INDEX                                                                  */
+/******************************************************************************/
+
+namespace {
+
+float cosInDegrees(float degrees)
+{
+    static const double degToRad = 3.14159265 / 180.0;
+    return cos(degrees * degToRad);
+}
+
+float wrapLongitude(float lon)
+{
+    if (lon >= 180.0) return lon - 360.0;
+    if (lon < -180.0) return lon + 360.0;
+    return lon;
+}
+
+} // namespace anonymous
+
+constexpr GeoIndex::Key GeoIndex::WideKey;
+
+GeoIndex::
+GeoIndex(float cellDegrees) :
+    cellDegrees(cellDegrees),
+    latCells(ceil(180.0 / cellDegrees)),
+    lonCells(ceil(360.0 / cellDegrees)),
+    entries(0)
+{
+    ExcCheckGreater(cellDegrees, 0.0, "invalid cell size");
+}
+
+bool
+GeoIndex::Circle::
+contains(float lat, float lon) const
+{
+    float dy = (lat - this->lat) * LATITUDE_1DEGREE_KMS;
+    float dx = wrapLongitude(lon - this->lon) * kmPerLon;
+    return dx * dx + dy * dy <= radiusSqr;
+}
+
+GeoIndex::Key
+GeoIndex::
+key(int64_t latCell, int64_t lonCell) const
+{
+    lonCell %= lonCells;
+    if (lonCell < 0) lonCell += lonCells;
+    return Key(latCell) << 32 | Key(lonCell);
+}
+
+int64_t
+GeoIndex::
+latCell(float lat) const
+{
+    int64_t cell = floor((lat + 90.0) / cellDegrees);
+    return std::min(std::max<int64_t>(cell, 0), latCells - 1);
+}
+
+int64_t
+GeoIndex::
+lonCell(float lon) const
+{
+    return floor((lon + 180.0) / cellDegrees);
+}
+
+void
+GeoIndex::
+add(unsigned cfgIndex, float lat, float lon, float radius)
+{
+    Circle circle;
+    circle.lat = lat;
+    circle.lon = lon;
+    circle.kmPerLon = LONGITUDE_1DEGREE_KMS * cosInDegrees(lat);
+    circle.radiusSqr = radius * radius;
+    circle.cfgIndex = cfgIndex;
+
+    auto& keys = configs[cfgIndex];
+
+    float dLat = radius / LATITUDE_1DEGREE_KMS;
+    float dLon = circle.kmPerLon > 0 ? radius / circle.kmPerLon : 360.0;
+
+    int64_t latBegin = latCell(lat - dLat), latEnd = latCell(lat + dLat) + 1;
+    int64_t lonBegin = lonCell(lon - dLon), lonEnd = lonCell(lon + dLon) + 1;
+
+    size_t numCells = (latEnd - latBegin) * (lonEnd - lonBegin);
+    if (dLon >= 180.0 || numCells > MaxCellsPerCircle) {
+        wide.push_back(circle);
+        keys.push_back(WideKey);
+        return;
+    }
+
+    for (int64_t i = latBegin; i < latEnd; ++i) {
+        for (int64_t j = lonBegin; j < lonEnd; ++j) {
+            Key k = key(i, j);
+            cells[k].push_back(circle);
+            keys.push_back(k);
+            entries++;
+        }
+    }
+}
+
+void
+GeoIndex::
+remove(unsigned cfgIndex)
+{
+    auto it = configs.find(cfgIndex);
+    if (it == configs.end()) return;
+
+    auto isConfig = [=] (const Circle& circle) {
+        return circle.cfgIndex == cfgIndex;
+    };
+
+    for (Key k : it->second) {
+        if (k == WideKey) {
+            wide.erase(remove_if(wide.begin(), wide.end(), isConfig), wide.end());
+            continue;
+        }
+
+        auto cell = cells.find(k);
+        if (cell == cells.end()) continue;
+
+        auto& list = cell->second;
+        auto last = remove_if(list.begin(), list.end(), isConfig);
+        entries -= list.end() - last;
+        list.erase(last, list.end());
+
+        if (list.empty()) cells.erase(cell);
+    }
+
+    configs.erase(it);
+}
+
+void
+GeoIndex::
+match(float lat, float lon, ConfigSet& result) const
+{
+    if (configs.empty()) return;
+
+    for (const Circle& circle : wide) {
+        if (circle.contains(lat, lon)) result.set(circle.cfgIndex);
+    }
+
+    if (cells.empty()) return;
+
+    auto it = cells.find(key(latCell(lat), lonCell(lon)));
+    if (it == cells.end()) return;
+
+    for (const Circle& circle : it->second) {
+        if (result.test(circle.cfgIndex)) continue;
+        if (circle.contains(lat, lon)) result.set(circle.cfgIndex);
+    }
+}
+
+} // namespace RTBKIT
@@ -0,0 +1,96 @@
+/** geo_index.h                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Spatial index of the geo-fencing areas of the agent configs.
+
+*/
+
+#pragma once
+
+#include "rtbkit/common/filter.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* GEO INDEX                                                                  */
+/******************************************************************************/
+
+/** Uniform grid over latitude and longitude where each cell lists the circles
+    that overlap it. Looking up a point only has to check the circles of its
+    cell instead of every circle of every config.
+
+    Circles that would span too many cells (very large radius or close to the
+    poles) are kept in a separate list which is always checked.
+
+    Distances are computed with an equirectangular projection centered on each
+    circle which is accurate well within a percent for the radius we see in
+    geo-fencing campaigns.
+ */
+struct GeoIndex
+{
+    static constexpr float DefaultCellDegrees = 0.1;
+    static constexpr size_t MaxCellsPerCircle = 1024;
+
+    static constexpr float LATITUDE_1DEGREE_KMS = 111.0;
+    static constexpr float LONGITUDE_1DEGREE_KMS = 111.321;
+
+    explicit GeoIndex(float cellDegrees = DefaultCellDegrees);
+
+    /** Adds a circle centered on (lat, lon) with the given radius in km. */
+    void add(unsigned cfgIndex, float lat, float lon, float radius);
+
+    /** Removes all the circles associated with the config. */
+    void remove(unsigned cfgIndex);
+
+    /** Sets the bits of the configs which have at least one circle containing
+        the point.
+     */
+    void match(float lat, float lon, ConfigSet& result) const;
+
+    bool empty() const { return configs.empty(); }
+
+    /** Number of circles stored in the cells; a circle is counted once for
+        every cell it overlaps.
+     */
+    size_t cellEntries() const { return entries; }
+
+private:
+
+    struct Circle
+    {
+        float lat;
+        float lon;
+        float kmPerLon;
+        float radiusSqr;
+        unsigned cfgIndex;
+
+        bool contains(float lat, float lon) const;
+    };
+
+    typedef uint64_t Key;
+    static constexpr Key WideKey = ~Key(0);
+
+    Key key(int64_t latCell, int64_t lonCell) const;
+    int64_t latCell(float lat) const;
+    int64_t lonCell(float lon) const;
+
+    float cellDegrees;
+    int64_t latCells;
+    int64_t lonCells;
+
+    std::unordered_map<Key, std::vector<Circle> > cells;
+    std::vector<Circle> wide;
+    size_t entries;
+
+    // Keys of the cells that hold a circle of each config; WideKey stands for
+    // the wide list.
+    std::unordered_map<unsigned, std::vector<Key> > configs;
+};
+
+} // namespace RTBKIT
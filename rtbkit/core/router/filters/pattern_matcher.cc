@@ -0,0 +1,194 @@
+/** pattern_matcher.cc                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Implementation of the multi-pattern literal matcher.
+
+*/
+
+#include "pattern_matcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+
+
+using namespace std;
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* REGEX LITERAL                                                              */
+/******************************************************************************/
+
+namespace {
+
+// Factors shorter than this match too often to be worth indexing.
+constexpr size_t MinFactorLength = 3;
+
+bool isEscaped(const string& pattern, size_t pos)
+{
+    size_t slashes = 0;
+    while (pos > slashes && pattern[pos - slashes - 1] == '\\') slashes++;
+    return slashes % 2;
+}
+
+} // namespace anonymous
+
+bool
+analyzeRegex(const string& pattern, RegexLiteral& result)
+{
+    result = RegexLiteral();
+
+    size_t i = 0;
+    size_t end = pattern.size();
+
+    if (i < end && pattern[i] == '^') {
+        result.anchorBegin = true;
+        ++i;
+    }
+
+    if (end > i && pattern[end - 1] == '$' && !isEscaped(pattern, end - 1)) {
+        result.anchorEnd = true;
+        --end;
+    }
+
+    string run, best;
+    bool exact = true;
+
+    for (; i < end; ++i) {
+        char c = pattern[i];
+
+        if (c == '\\') {
+            if (++i == end) return false;
+
+            // Escaped letters and digits are character classes (\d, \w, ...)
+            // or assertions (\b, ...) which we don't handle.
+            char escaped = pattern[i];
+            if (isalnum(escaped) || escaped == '_') return false;
+
+            run += escaped;
+            continue;
+        }
+
+        if (c == '.') {
+            exact = false;
+            if (run.size() > best.size()) best = run;
+            run.clear();
+            continue;
+        }
+
+        if (strchr("[](){}*+?|^$", c)) return false;
+
+        run += c;
+    }
+
+    if (exact) {
+        if (run.empty()) return false;
+
+        result.exact = true;
+        result.literal = run;
+        return true;
+    }
+
+    if (run.size() > best.size()) best = run;
+    if (best.size() < MinFactorLength) return false;
+
+    result.literal = best;
+    return true;
+}
+
+
+/******************************************************************************/
+/* PATTERN MATCHER                                                            */
+/******************************************************************************/
+
+void
+PatternMatcher::
+clear()
+{
+    nodes.clear();
+    nodes.emplace_back();
+    root.fill(0);
+    lengths.clear();
+}
+
+uint32_t
+PatternMatcher::
+insertChild(uint32_t node, uint8_t c)
+{
+    uint32_t existing = child(node, c);
+    if (existing) return existing;
+
+    uint32_t index = nodes.size();
+    nodes.emplace_back();
+
+    if (!node) root[c] = index;
+    else {
+        auto& next = nodes[node].next;
+        auto it = lower_bound(next.begin(), next.end(), make_pair(c, uint32_t(0)));
+        next.insert(it, make_pair(c, index));
+    }
+
+    return index;
+}
+
+unsigned
+PatternMatcher::
+add(const string& pattern)
+{
+    uint32_t node = 0;
+    for (char c : pattern)
+        node = insertChild(node, c);
+
+    unsigned id = lengths.size();
+    nodes[node].outputs.push_back(id);
+    lengths.push_back(pattern.size());
+
+    return id;
+}
+
+void
+PatternMatcher::
+build()
+{
+    deque<uint32_t> queue;
+
+    auto visit = [&] (uint32_t parent, uint8_t c, uint32_t node) {
+        uint32_t fail = 0;
+
+        if (parent) {
+            fail = nodes[parent].fail;
+            while (true) {
+                uint32_t next = child(fail, c);
+                if (next) {
+                    fail = next;
+                    break;
+                }
+                if (!fail) break;
+                fail = nodes[fail].fail;
+            }
+        }
+
+        nodes[node].fail = fail;
+        nodes[node].dict = nodes[fail].outputs.empty() ? nodes[fail].dict : fail;
+
+        queue.push_back(node);
+    };
+
+    for (unsigned c = 0; c < root.size(); ++c) {
+        if (root[c]) visit(0, c, root[c]);
+    }
+
+    while (!queue.empty()) {
+        uint32_t node = queue.front();
+        queue.pop_front();
+
+        for (const auto& edge : nodes[node].next)
+            visit(node, edge.first, edge.second);
+    }
+}
+
+} // namespace RTBKIT
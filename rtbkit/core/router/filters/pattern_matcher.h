@@ -0,0 +1,144 @@
+/** pattern_matcher.h                                 -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Multi-pattern literal matching used to speed up the regex filters.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace RTBKIT {
+
+
+/******************************************************************************/
+/* REGEX LITERAL                                                              */
+/******************************************************************************/
+
+/** Literal extracted from a regex by analyzeRegex.
+
+    If exact is true then searching for the regex is equivalent to searching
+    for the literal, subject to the anchors. Otherwise the literal is a factor
+    which must appear in any string matched by the regex; finding the literal
+    is then only a hint that the regex needs to be checked.
+ */
+struct RegexLiteral
+{
+    RegexLiteral() : exact(false), anchorBegin(false), anchorEnd(false) {}
+
+    std::string literal;
+    bool exact;
+    bool anchorBegin;
+    bool anchorEnd;
+};
+
+/** Extracts a literal out of a perl-style regex. Returns false if the regex is
+    too irregular for any useful literal to be extracted in which case the
+    regex has to be evaluated on every string.
+
+    Only simple concatenations of characters, escaped punctuation and '.'
+    wildcards, optionally anchored by '^' and '$', are understood.
+ */
+bool analyzeRegex(const std::string& pattern, RegexLiteral& result);
+
+
+/******************************************************************************/
+/* PATTERN MATCHER                                                            */
+/******************************************************************************/
+
+/** Aho-Corasick automaton which finds every occurrence of a set of literal
+    patterns in a single pass over a string.
+
+    Patterns are identified by the order in which they were added. The
+    automaton must be rebuilt via build() after patterns are added.
+ */
+struct PatternMatcher
+{
+    PatternMatcher() { clear(); }
+
+    void clear();
+
+    /** Adds a pattern and returns its id. */
+    unsigned add(const std::string& pattern);
+
+    /** Computes the failure links of the automaton. */
+    void build();
+
+    size_t size() const { return lengths.size(); }
+    size_t length(unsigned pattern) const { return lengths[pattern]; }
+
+    /** Calls onMatch(pattern, end) for every occurrence of a pattern in str
+        where end is the offset one past the last character of the match.
+     */
+    template<typename Fn>
+    void search(const std::string& str, const Fn& onMatch) const
+    {
+        if (lengths.empty()) return;
+
+        uint32_t state = 0;
+
+        for (size_t i = 0; i < str.size(); ++i) {
+            uint8_t c = str[i];
+
+            while (true) {
+                uint32_t next = child(state, c);
+                if (next || !state) {
+                    state = next;
+                    break;
+                }
+                state = nodes[state].fail;
+            }
+
+            uint32_t out = nodes[state].outputs.empty() ? nodes[state].dict : state;
+            for (; out; out = nodes[out].dict) {
+                for (unsigned pattern : nodes[out].outputs)
+                    onMatch(pattern, i + 1);
+            }
+        }
+    }
+
+private:
+
+    struct Node
+    {
+        Node() : fail(0), dict(0) {}
+
+        // Sorted by character.
+        std::vector< std::pair<uint8_t, uint32_t> > next;
+
+        uint32_t fail;
+
+        // Closest node on the failure chain which has outputs.
+        uint32_t dict;
+
+        std::vector<unsigned> outputs;
+    };
+
+    uint32_t child(uint32_t node, uint8_t c) const
+    {
+        if (!node) return root[c];
+
+        const auto& next = nodes[node].next;
+        for (const auto& edge : next) {
+            if (edge.first == c) return edge.second;
+            if (edge.first > c) break;
+        }
+        return 0;
+    }
+
+    uint32_t insertChild(uint32_t node, uint8_t c);
+
+    std::vector<Node> nodes;
+
+    // Dense transition table for the root since every search goes through it.
+    std::array<uint32_t, 256> root;
+
+    std::vector<size_t> lengths;
+};
+
+} // namespace RTBKIT
@@ -222,89 +222,50 @@ getValue(const BidRequest& br, const FilterEntry& entry) const
 }
 
 
-LatLongDevFilter::Square
-LatLongDevFilter::squareFromLatLongRadius(float lat, float lon, float radius)
-{
-    Square sq;
-    sq.y_max = (lat * LATITUDE_1DEGREE_KMS) + radius;
-    sq.y_min = (lat * LATITUDE_1DEGREE_KMS) - radius;
-
-    sq.x_max = ( lon * LONGITUDE_1DEGREE_KMS * cosInDegrees(lat) ) + radius;
-    sq.x_min = ( lon * LONGITUDE_1DEGREE_KMS * cosInDegrees(lat) ) - radius;
-
-    return sq;
-}
-
 void LatLongDevFilter::addConfig(unsigned cfgIndex,
         const std::shared_ptr<RTBKIT::AgentConfig>& config)
 {
-    SquareList squares;
-    for ( const RTBKIT::LatLonRad & llr : config->latLongDevFilter.latlonrads){
-        auto sq = squareFromLatLongRadius(llr.lat, llr.lon, llr.radius);
-        squares.push_back(sq);
-    }
-    if ( ! squares.empty()){
-        squares_by_confindx[cfgIndex] = squares;
-        configs_with_filt.set(cfgIndex);
-    }
+    const auto& latlonrads = config->latLongDevFilter.latlonrads;
+    if (latlonrads.empty()) return;
+
+    for ( const RTBKIT::LatLonRad & llr : latlonrads)
+        index.add(cfgIndex, llr.lat, llr.lon, llr.radius);
+
+    configs_with_filt.set(cfgIndex);
 }
 
 void LatLongDevFilter::removeConfig(unsigned cfgIndex,
         const std::shared_ptr<RTBKIT::AgentConfig>& config)
 {
-    if ( squares_by_confindx.count(cfgIndex) > 0){
-        squares_by_confindx.erase(cfgIndex);
-        configs_with_filt.reset(cfgIndex);
-    }
+    index.remove(cfgIndex);
+    configs_with_filt.reset(cfgIndex);
 }
 
 void LatLongDevFilter::filter(RTBKIT::FilterState& state) const
- {
-    RTBKIT::ConfigSet matches = state.configs();
-
-    auto it = squares_by_confindx.begin();
-    if ( ! checkLatLongPresent(state.request)){
-        // If there is no geo info the filter, then filter out all the
-        // agent configs that has this filter present.
-        state.narrowConfigs(configs_with_filt.negate());
-    } else {
-        // Filter using the lat long of the request and from the configs
-        // of the agents.
-        for ( ; it != squares_by_confindx.end(); ++it ){
-            if (pointInsideAnySquare(state.request.device->geo->lat.val,
-                    state.request.device->geo->lon.val, it->second)) {
-                continue;
-            }
-            matches.reset(it->first);
-        }
-        state.narrowConfigs(matches);
+{
+    // If there is no geo info in the request then only the agent configs
+    // without the filter go through.
+    RTBKIT::ConfigSet matches = configs_with_filt.negate();
+
+    if (checkLatLongPresent(state.request)) {
+        const auto& geo = *state.request.device->geo;
+        index.match(geo.lat.val, geo.lon.val, matches);
     }
 
- }
+    state.narrowConfigs(matches);
+}
 
 bool LatLongDevFilter::checkLatLongPresent(
         const RTBKIT::BidRequest & req) const
 {
     if ( ! req.device) return false;
     if ( ! req.device->geo) return false;
-    if ( req.device->geo->lat.val == std::numeric_limits<float>::quiet_NaN() ||
-         req.device->geo->lon.val == std::numeric_limits<float>::quiet_NaN() )
+    if ( std::isnan(req.device->geo->lat.val) ||
+         std::isnan(req.device->geo->lon.val) )
         return false;
     return true;
 }
 
-bool
-LatLongDevFilter::pointInsideAnySquare(float lat, float lon,
-        const SquareList & squares)
-{
-    const float y = lat * LATITUDE_1DEGREE_KMS;
-    const float x = lon * LONGITUDE_1DEGREE_KMS * cosInDegrees(lat);
-    for ( auto & sq : squares){
-        if (insideSquare(x, y , sq)) return true;
-    }
-    return false;
-}
-
 } // namespace RTBKIT
 
 /******************************************************************************/
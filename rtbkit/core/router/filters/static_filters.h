@@ -10,6 +10,7 @@
 
 #include "generic_filters.h"
 #include "priority.h"
+#include "geo_index.h"
 #include "rtbkit/common/exchange_connector.h"
 #include "jml/utils/compact_vector.h"
 
@@ -121,6 +122,14 @@ struct HourOfWeekFilter : public FilterBaseT<HourOfWeekFilter>
         state.narrowConfigs(data[state.request.timestamp.hourOfWeek()]);
     }
 
+    bool isExactMatch() const { return true; }
+
+    void exactMatchKey(const BidRequest& br, std::string& key) const
+    {
+        ExcCheckNotEqual(br.timestamp, Date(), "Null auction date");
+        key += char(br.timestamp.hourOfWeek());
+    }
+
 private:
 
     std::array<ConfigSet, 24 * 7> data;
@@ -146,6 +155,8 @@ struct UrlFilter : public FilterBaseT<UrlFilter>
         state.narrowConfigs(impl.filter(state.request.url.toString()));
     }
 
+    void compile() { impl.compile(); }
+
 private:
     typedef RegexFilter<boost::regex, std::string> BaseFilter;
     IncludeExcludeFilter<BaseFilter> impl;
@@ -195,6 +206,16 @@ struct LanguageFilter : public FilterBaseT<LanguageFilter>
         state.narrowConfigs(impl.filter(state.request.language.utf8String()));
     }
 
+    void compile() { impl.compile(); }
+
+    bool isExactMatch() const { return true; }
+
+    void exactMatchKey(const BidRequest& br, std::string& key) const
+    {
+        key += br.language.utf8String();
+        key += '\0';
+    }
+
 private:
     typedef RegexFilter<boost::regex, std::string> BaseFilter;
     IncludeExcludeFilter<BaseFilter> impl;
@@ -287,6 +308,14 @@ struct ExchangeNameFilter : public FilterBaseT<ExchangeNameFilter>
         state.narrowConfigs(data.filter(state.request.exchange));
     }
 
+    bool isExactMatch() const { return true; }
+
+    void exactMatchKey(const BidRequest& br, std::string& key) const
+    {
+        key += br.exchange;
+        key += '\0';
+    }
+
 private:
     IncludeExcludeFilter< ListFilter<std::string> > data;
 };
@@ -314,6 +343,17 @@ struct FoldPositionFilter : public FilterBaseT<FoldPositionFilter>
         }
     }
 
+    bool isExactMatch() const { return true; }
+
+    void exactMatchKey(const BidRequest& br, std::string& key) const
+    {
+        for (const auto& imp : br.imp) {
+            key += std::to_string(imp.position.val);
+            key += ',';
+        }
+        key += '\0';
+    }
+
 private:
     IncludeExcludeFilter< ListFilter<OpenRTB::AdPosition> > impl;
 };
@@ -364,50 +404,24 @@ struct LatLongDevFilter : public RTBKIT::FilterBaseT<LatLongDevFilter>
 {
     static constexpr const char* name = "latLongDevFilter";
 
-    /**
-     * To see if a point is inside a required area we aproximate that area (
-     * circular) with a square, and check that the point is within the
-     * boundaries.
-     */
-    struct Square{
-        float x_max;
-        float x_min;
-        float y_max;
-        float y_min;
-    };
-
-    typedef std::vector<Square> SquareList;
-    std::unordered_map<unsigned, SquareList> squares_by_confindx;
-    ConfigSet configs_with_filt;
-
     unsigned priority() const { return Priority::LatLong; } //low priority
 
-    static constexpr float LONGITUDE_1DEGREE_KMS = 111.321;
-    static constexpr float LATITUDE_1DEGREE_KMS = 111.0;
-
     /**
-     * Convert the lat long in a 2D square of side radius.
-     * Make it with the following approximations:
-     * 1 degree of latitude = 111 kms
-     * 1 degre of longitude = 111.321 * cos(latitude) kms
-     */
-    static Square squareFromLatLongRadius(float lat, float lon, float radius);
-
-    /**
-     * Save the squares for each config index.
-     * Important: We only filter by those who has the filter.
+     * Index the circles of the config. Only the configs which have the
+     * filter are filtered.
      */
     virtual void addConfig(unsigned cfgIndex,
             const std::shared_ptr<RTBKIT::AgentConfig>& config);
 
     /**
-     * Remove the square list for the given config index.
+     * Remove the circles of the given config index from the index.
      */
     virtual void removeConfig(unsigned cfgIndex,
             const std::shared_ptr<RTBKIT::AgentConfig>& config);
 
     /**
-     * Particular implementation of virtual method for this filter type.
+     * Lets through the configs without the filter and the configs with at
+     * least one circle that contains the device's location.
      */
     virtual void filter(RTBKIT::FilterState& state) const ;
 
@@ -420,28 +434,10 @@ struct LatLongDevFilter : public RTBKIT::FilterBaseT<LatLongDevFilter>
      */
     bool checkLatLongPresent(const RTBKIT::BidRequest & req) const ;
 
-    /**
-     * Return true is the point is inside in at least one of the given
-     * square of the list given. Otherwise false.
-     */
-    static bool pointInsideAnySquare(float lat, float lon,
-            const SquareList & squares);
-
-    /**
-     * Check if the given point defined by (x, y) is inside of the square
-     * defined by the two edges (x_max,y_max) and (x_min, y_min).
-     */
-    inline static bool insideSquare(float x, float y, const Square & sq )
-    {
-        return x < sq.x_max && x > sq.x_min && y < sq.y_max && y > sq.y_min;
-    }
-
-    inline static float cosInDegrees(float degrees)
-    {
-        static const double deeToGrad = 3.14159265 / 180.0;
-        return cos(degrees * deeToGrad);
-    }
+private:
 
+    GeoIndex index;
+    ConfigSet configs_with_filt;
 };
 
 
@@ -219,6 +219,57 @@ BOOST_AUTO_TEST_CASE(regexFilterTest)
     check(filter.filter("d"),   { });
 }
 
+BOOST_AUTO_TEST_CASE(regexFilterCompiledTest)
+{
+    using boost::regex;
+
+    vector<regex> regexes = {
+        regex("cnn"),               // literal
+        regex("^http://news"),      // anchored literal
+        regex("\\.com$"),           // escaped anchored literal
+        regex("^http://bob\\.org/$"), // exact literal
+        regex("sport.\\.html"),     // literal factor
+        regex("a|b"),               // irregular
+        regex("[0-9]+"),            // irregular
+        regex("CNN", regex::icase), // case insensitive
+    };
+
+    RegexFilter<regex, string> expected;
+    RegexFilter<regex, string> filter;
+
+    for (size_t i = 0; i < regexes.size(); ++i) {
+        expected.addConfig(i, makeList({ regexes[i] }));
+        filter.addConfig(i, makeList({ regexes[i] }));
+    }
+    filter.compile();
+
+    vector<string> strs = {
+        "", "cnn", "http://news.cnn.com", "http://www.cnn.com/news",
+        "http://bob.org/", "http://bob.org/x", "http://x.com/sports.html",
+        "http://x.com/sport.html", "www.CNN.ca", "news\nhttp://news.ca",
+        "zzz", "x.com\n"
+    };
+
+    title("regex-compiled-1");
+    for (const string& str : strs) {
+        cerr << "str=" << str << endl;
+        BOOST_CHECK_EQUAL(filter.filter(str).print(), expected.filter(str).print());
+    }
+
+    title("regex-compiled-2");
+    filter.removeConfig(0, makeList({ regexes[0] }));
+    expected.removeConfig(0, makeList({ regexes[0] }));
+    filter.compile();
+
+    for (const string& str : strs)
+        BOOST_CHECK_EQUAL(filter.filter(str).print(), expected.filter(str).print());
+
+    title("regex-compiled-copy");
+    RegexFilter<regex, string> copy(filter);
+    for (const string& str : strs)
+        BOOST_CHECK_EQUAL(copy.filter(str).print(), expected.filter(str).print());
+}
+
 BOOST_AUTO_TEST_CASE(segmentListTest)
 {
     SegmentListFilter filter;
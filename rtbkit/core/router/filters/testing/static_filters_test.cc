@@ -23,6 +23,7 @@
 #include "jml/utils/vector_utils.h"
 
 #include <boost/test/unit_test.hpp>
+#include <random>
 
 using namespace std;
 using namespace ML;
@@ -698,3 +699,79 @@ BOOST_AUTO_TEST_CASE( LatLongDevFilterTest)
     doCheck(br9, { 2, 3});
 
 }
+
+/** Compares the grid index against a brute force scan over many random circles,
+    including some that wrap around the date line or are too large to be
+    stored in the grid.
+ */
+BOOST_AUTO_TEST_CASE( geoIndexTest )
+{
+    GeoIndex index;
+
+    struct Circle { unsigned cfg; float lat, lon, radius; };
+    vector<Circle> circles;
+
+    mt19937 rng(0);
+    auto uniform = [&] (float min, float max) {
+        return uniform_real_distribution<float>(min, max)(rng);
+    };
+
+    auto addCircle = [&] (unsigned cfg, float lat, float lon, float radius) {
+        index.add(cfg, lat, lon, radius);
+        circles.push_back({ cfg, lat, lon, radius });
+    };
+
+    for (unsigned cfg = 0; cfg < 200; ++cfg) {
+        for (size_t i = 0; i < 20; ++i)
+            addCircle(cfg, uniform(40, 42), uniform(-75, -73), uniform(0.1, 20));
+    }
+    addCircle(200, 10, 179.95, 15);
+    addCircle(201, 0, 0, 2000);
+    addCircle(202, 89.9, 0, 5);
+
+    auto expected = [&] (float lat, float lon) {
+        ConfigSet result;
+        for (const Circle& c : circles) {
+            float dy = (lat - c.lat) * GeoIndex::LATITUDE_1DEGREE_KMS;
+            float dLon = lon - c.lon;
+            if (dLon >= 180) dLon -= 360;
+            if (dLon < -180) dLon += 360;
+            float kmPerLon = GeoIndex::LONGITUDE_1DEGREE_KMS
+                * cos(c.lat * (3.14159265 / 180.0));
+            float dx = dLon * kmPerLon;
+            if (dx * dx + dy * dy <= c.radius * c.radius) result.set(c.cfg);
+        }
+        return result;
+    };
+
+    auto doCheck = [&] (float lat, float lon) {
+        ConfigSet result;
+        index.match(lat, lon, result);
+
+        ConfigSet diff = result ^ expected(lat, lon);
+        BOOST_CHECK_MESSAGE(diff.empty(),
+                "lat=" << lat << " lon=" << lon << " diff=" << diff.print());
+    };
+
+    for (size_t i = 0; i < 10000; ++i)
+        doCheck(uniform(39.5, 42.5), uniform(-75.5, -72.5));
+
+    doCheck(10, -179.99);
+    doCheck(10, 179.99);
+    doCheck(3, 3);
+    doCheck(89.95, 120);
+
+    for (unsigned cfg = 0; cfg < 200; cfg += 2) {
+        index.remove(cfg);
+        circles.erase(remove_if(circles.begin(), circles.end(),
+                        [=] (const Circle& c) { return c.cfg == cfg; }),
+                circles.end());
+    }
+
+    for (size_t i = 0; i < 10000; ++i)
+        doCheck(uniform(39.5, 42.5), uniform(-75.5, -72.5));
+
+    for (unsigned cfg = 0; cfg < 203; ++cfg) index.remove(cfg);
+    BOOST_CHECK(index.empty());
+    BOOST_CHECK_EQUAL(index.cellEntries(), 0);
+}
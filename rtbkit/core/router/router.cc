@@ -32,6 +32,7 @@
 #include "rtbkit/common/auction_events.h"
 #include "rtbkit/common/messages.h"
 #include "rtbkit/common/win_cost_model.h"
+#include "soa/types/binary_json.h"
 #include "rtbkit/common/bidder_interface.h"
 #include "rtbkit/common/analytics.h"
 
@@ -124,10 +125,7 @@ Router(ServiceBase & parent,
       postAuctionEndpoint(*this),
       configBuffer(1024),
       exchangeBuffer(64),
-      startBiddingBuffer(65536),
-      submittedBuffer(65536),
       auctionGraveyard(65536),
-      doBidBuffer(65536),
       augmentationLoop(*this),
       loopMonitor(*this),
       loadStabilizer(loopMonitor),
@@ -157,6 +155,7 @@ Router(ServiceBase & parent,
       slowModeTolerance(MonitorClient::DefaultTolerance),
       augmentationWindow(augmentationWindow)
 {
+    shards.emplace_back(new RouterShard(0));
     monitorProviderClient.addProvider(this);
 }
 
@@ -177,10 +176,7 @@ Router(std::shared_ptr<ServiceProxies> services,
       postAuctionEndpoint(*this),
       configBuffer(1024),
       exchangeBuffer(64),
-      startBiddingBuffer(65536),
-      submittedBuffer(65536),
       auctionGraveyard(65536),
-      doBidBuffer(65536),
       augmentationLoop(*this),
       loopMonitor(*this),
       loadStabilizer(loopMonitor),
@@ -211,6 +207,7 @@ Router(std::shared_ptr<ServiceProxies> services,
       augmentationWindow(augmentationWindow)
 
 {
+    shards.emplace_back(new RouterShard(0));
     monitorProviderClient.addProvider(this);
 }
 
@@ -390,11 +387,13 @@ init()
     bridge.agents.onConnection = [=] (const std::string & agent)
         {
             cerr << "agent " << agent << " connected to router" << endl;
+            resetWinCostModels(agent);
         };
 
     bridge.agents.onDisconnection = [=] (const std::string & agent)
         {
             cerr << "agent " << agent << " disconnected from router" << endl;
+            resetWinCostModels(agent);
         };
 
     configListener.onConfigChange = [=] (const std::string & agent,
@@ -513,6 +512,41 @@ unsafeDisableAuctionProbability()
     disableAuctionProb = true;
 }
 
+void
+Router::
+setNumAuctionShards(unsigned numShards)
+{
+    if (numShards == 0)
+        throw ML::Exception("router needs at least one auction shard");
+    if (runThread)
+        throw ML::Exception("can't change the number of shards of a "
+                            "running router");
+
+    shards.clear();
+    for (unsigned i = 0;  i < numShards;  ++i)
+        shards.emplace_back(new RouterShard(i));
+}
+
+void
+Router::
+wakeupShard(RouterShard & shard)
+{
+    if (hasShardThreads())
+        shard.wakeup.signal();
+    else wakeupMainLoop.signal();
+}
+
+bool
+Router::
+injectBid(BidMessage message)
+{
+    RouterShard & shard = shardFor(message.auctionId);
+    if (!shard.doBidBuffer.tryPush(std::move(message)))
+        return false;
+    wakeupShard(shard);
+    return true;
+}
+
 void
 Router::
 start(boost::function<void ()> onStop)
@@ -540,6 +574,24 @@ start(boost::function<void ()> onStop)
     if (analytics) analytics->start();
     analyticsPublisher.start();
     augmentationLoop.start();
+
+    if (hasShardThreads()) {
+        for (auto & shard : shards) {
+            RouterShard * sh = shard.get();
+            uint64_t lastActive = 0;
+            loopMonitor.addCallback(
+                    ML::format("routerShard%d", sh->index),
+                    [=] (double elapsed) mutable {
+                        uint64_t active = sh->usActive;
+                        double delta = active - lastActive;
+                        lastActive = active;
+                        return delta / 1000000.0 / elapsed;
+                    });
+
+            sh->thread.reset(new boost::thread([=] () { this->runShard(*sh); }));
+        }
+    }
+
     runThread.reset(new boost::thread(runfn));
 
     if (connectPostAuctionLoop) {
@@ -582,7 +634,7 @@ numNonIdle() const
     size_t numInFlight, numAwaitingAugmentation;
     {
         Guard guard(lock);
-        numInFlight = inFlight.size();
+        numInFlight = numAuctionsInProgress();
         numAwaitingAugmentation = augmentationLoop.numAugmenting();
     }
 
@@ -628,6 +680,14 @@ run()
         { 0, wakeupMainLoop.fd(), ZMQ_POLLIN, 0 }
     };
 
+    // When the shards run in their own threads they also send on the
+    // agents socket, so we can't poll it directly.  Instead we wait on its
+    // notification fd and receive under the socket's lock.
+    if (hasShardThreads()) {
+        items[0].socket = 0;
+        items[0].fd = bridge.agents.getNotificationFd();
+    }
+
     double last_check = ML::wall_time(), last_check_pace = last_check,
         lastPings = last_check;
 
@@ -720,8 +780,10 @@ run()
                 recordTime("sleep", atStart);
             }
 
+            // The notification fd is edge triggered and a send from a
+            // shard can swallow the edge, so don't sleep for long on it.
             double pollStart = getTime();
-            rc = zmq_poll(items, 2, 50 /* milliseconds */);
+            rc = zmq_poll(items, 2, hasShardThreads() ? 1 : 50 /* milliseconds */);
             recordTime("sleepPoll", pollStart);
         }
 
@@ -734,26 +796,8 @@ run()
             cerr << "zeromq error: " << zmq_strerror(zmq_errno()) << endl;
         }
 
-        {
-            double atStart = getTime();
-            std::shared_ptr<AugmentationInfo> info;
-            while (startBiddingBuffer.tryPop(info)) {
-                doStartBidding(info);
-            }
-
-            recordTime("doStartBidding", atStart);
-        }
-
-        {
-            double atStart = getTime();
-
-            BidMessage message;
-            while (doBidBuffer.tryPop(message)) {
-                doBidImpl(message);
-            }
-
-            recordTime("doBid", atStart);
-        }
+        if (!hasShardThreads())
+            drainShard(*shards[0], recordTime);
 
         {
             double atStart = getTime();
@@ -781,17 +825,30 @@ run()
             recordTime("doConfig", atStart);
         }
 
-        {
+        if (hasShardThreads()) {
             double atStart = getTime();
 
-            std::shared_ptr<Auction> auction;
-            while (submittedBuffer.tryPop(auction))
-                doSubmitted(auction);
+            for (;;) {
+                vector<string> message;
+                try {
+                    message = bridge.agents.recvMessageNonBlocking();
+                    if (message.empty())
+                        break;
+                    bridge.agents.handleMessage(std::move(message));
+
+                } catch (const std::exception & exc) {
+                    cerr << "error handling agent message " << message
+                         << ": " << exc.what() << endl;
+                    logRouterError("handleAgentMessage", exc.what(),
+                                   message);
 
-            recordTime("doSubmitted", atStart);
-        }
+                    if (analytics) analytics->logRouterErrorMessage("handleAgentMessage", exc.what(), message);
+                }
+            }
 
-        if (items[0].revents & ZMQ_POLLIN) {
+            recordTime("agentMessages", atStart);
+        }
+        else if (items[0].revents & ZMQ_POLLIN) {
             double atStart = getTime();
             // Agent message
             vector<string> message;
@@ -843,6 +900,11 @@ run()
             logUsageMetrics(10.0);
             if (analytics) analytics->logUsageMessage(*this, 10.0);
             if (analytics) analytics->logMarkMessage(*this,last_check);
+            for (auto & shard : shards) {
+                std::lock_guard<std::mutex> guard(shard->lock);
+                dutyCycleCurrent += shard->dutyCycle;
+                shard->dutyCycle.clear();
+            }
             dutyCycleCurrent.ending = Date::now();
             dutyCycleHistory.push_back(dutyCycleCurrent);
             dutyCycleCurrent.clear();
@@ -899,6 +961,121 @@ run()
     //cerr << "server shutdown" << endl;
 }
 
+namespace {
+
+/** Held while a shard works on one of its auctions, so that the version
+    of the agents it looks at stays alive and other threads can look at its
+    in-flight auctions safely.
+
+    The critical section is speculative so that it's only entered once for
+    a batch of work items; whoever uses the guard must call forceUnlock()
+    on allAgentsGc once it's done with the batch.
+*/
+struct ShardWorkGuard {
+    ShardWorkGuard(GcLock & allAgentsGc, RouterShard & shard)
+        : agentsGuard(allAgentsGc, GcLock::RD_NO), shardGuard(shard.lock)
+    {
+    }
+
+    GcLock::SpeculativeGuard agentsGuard;
+    std::lock_guard<std::mutex> shardGuard;
+};
+
+} // file scope
+
+void
+Router::
+drainShard(RouterShard & shard, const RecordTimeFn & recordTime)
+{
+    auto getTime = [&] () { return Date::now().secondsSinceEpoch(); };
+
+    {
+        double atStart = getTime();
+
+        std::shared_ptr<AugmentationInfo> info;
+        while (shard.startBiddingBuffer.tryPop(info)) {
+            ShardWorkGuard guard(allAgentsGc, shard);
+            doStartBidding(info);
+        }
+
+        recordTime("doStartBidding", atStart);
+    }
+
+    {
+        double atStart = getTime();
+
+        BidMessage message;
+        while (shard.doBidBuffer.tryPop(message)) {
+            ShardWorkGuard guard(allAgentsGc, shard);
+            doBidImpl(message);
+        }
+
+        std::vector<std::string> rawMessage;
+        while (shard.bidMessageBuffer.tryPop(rawMessage)) {
+            ShardWorkGuard guard(allAgentsGc, shard);
+            try {
+                doBid(rawMessage);
+            } catch (const std::exception & exc) {
+                returnErrorResponse(rawMessage,
+                                    "threw exception: " + string(exc.what()));
+            }
+        }
+
+        recordTime("doBid", atStart);
+    }
+
+    {
+        double atStart = getTime();
+
+        std::shared_ptr<Auction> auction;
+        while (shard.submittedBuffer.tryPop(auction)) {
+            ShardWorkGuard guard(allAgentsGc, shard);
+            doSubmitted(auction);
+        }
+
+        recordTime("doSubmitted", atStart);
+    }
+
+    allAgentsGc.forceUnlock(0, GcLock::RD_NO);
+}
+
+void
+Router::
+runShard(RouterShard & shard)
+{
+    zmq_pollitem_t items [] = {
+        { 0, shard.wakeup.fd(), ZMQ_POLLIN, 0 }
+    };
+
+    auto noRecordTime = [] (const char *, double) {};
+
+    Date lastExpiry = Date::now();
+
+    while (!shutdown_) {
+        int rc = zmq_poll(items, 1, 1 /* milliseconds */);
+        if (rc == -1 && zmq_errno() != EINTR) {
+            cerr << "zeromq error: " << zmq_strerror(zmq_errno()) << endl;
+        }
+
+        if (items[0].revents & ZMQ_POLLIN)
+            shard.wakeup.read();
+
+        RouterProfiler profiler(shard.usActive);
+
+        drainShard(shard, noRecordTime);
+
+        Date now = Date::now();
+        if (lastExpiry.secondsUntil(now) >= 0.001) {
+            {
+                ShardWorkGuard guard(allAgentsGc, shard);
+                expireInFlight(shard, now);
+            }
+            allAgentsGc.forceUnlock(0, GcLock::RD_NO);
+            lastExpiry = now;
+        }
+    }
+}
+
 void
 Router::
 shutdown()
@@ -916,6 +1093,11 @@ shutdown()
     if (runThread)
         runThread->join();
     runThread.reset();
+    for (auto & shard : shards) {
+        if (shard->thread)
+            shard->thread->join();
+        shard->thread.reset();
+    }
     if (cleanupThread)
         cleanupThread->join();
     cleanupThread.reset();
@@ -991,7 +1173,12 @@ int
 Router::
 numAuctionsInProgress() const
 {
-    return -1;//inFlight.size();
+    int result = 0;
+    for (auto & shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        result += shard->inFlight.size();
+    }
+    return result;
 }
 
 void
@@ -1022,7 +1209,13 @@ handleAgentMessage(const std::vector<std::string> & message)
                 bidder->sendMessage(nullptr, address, "NEEDCONFIG");
                 return;
             }
-            agents[configName].address = address;
+            AgentInfo & info = agents[configName];
+            info.address = address;
+            info.binaryAuctions = message.size() > 3 && message[3] == "1.1";
+            info.winCostModels->clear();
+
+            // Let the shards see the new address
+            updateAllAgents();
             return;
         }
 
@@ -1039,7 +1232,21 @@ handleAgentMessage(const std::vector<std::string> & message)
         }
 
         if (request[0] == 'B' && request == "BID") {
-            doBid(message);
+            if (!hasShardThreads()) {
+                {
+                    ShardWorkGuard guard(allAgentsGc, *shards[0]);
+                    doBid(message);
+                }
+                allAgentsGc.forceUnlock(0, GcLock::RD_NO);
+                return;
+            }
+
+            // Parsing the bid is left to the shard that owns the auction
+            RouterShard & shard = shardFor(Id(message.at(2)));
+            if (!shard.bidMessageBuffer.tryPush(message))
+                throw ML::Exception("auction shard %d can't keep up with bids",
+                                    shard.index);
+            shard.wakeup.signal();
             return;
         }
 
@@ -1167,7 +1374,17 @@ checkDeadAgents()
 
                     this->recordHit("accounts.%s.lostBids", account);
 
-                    bidder->sendBidLostMessage(info.config, it->first, inFlight[id].auction);
+                    std::shared_ptr<Auction> auction;
+                    {
+                        RouterShard & shard = shardFor(id);
+                        std::lock_guard<std::mutex> guard(shard.lock);
+                        auto auctionIt = shard.inFlight.find(id);
+                        if (auctionIt != shard.inFlight.end())
+                            auction = auctionIt->second.auction;
+                    }
+
+                    if (auction)
+                        bidder->sendBidLostMessage(info.config, it->first, auction);
 
                     toExpire.push_back(id);
                 }
@@ -1192,7 +1409,7 @@ checkDeadAgents()
         }
 
         double timeSinceHeartbeat
-            = now.secondsSince(info.status->lastHeartbeat);
+            = now.secondsSince(info.status->lastHeartbeat.load());
 
         this->recordLevel(timeSinceHeartbeat,
                           "accounts.%s.timeSinceHeartbeat", account);
@@ -1248,8 +1465,33 @@ checkExpiredAuctions()
 
     Date start = Date::now();
 
+    // With shard threads, each shard expires its own auctions
+    if (!hasShardThreads()) {
+        RouterShard & shard = *shards[0];
+        {
+            ShardWorkGuard guard(allAgentsGc, shard);
+            expireInFlight(shard, start);
+        }
+        allAgentsGc.forceUnlock(0, GcLock::RD_NO);
+    }
+
     {
-        RouterProfiler profiler(dutyCycleCurrent.nsExpireInFlight);
+        RouterProfiler profiler(dutyCycleCurrent.nsExpireBlacklist);
+        blacklist.doExpiries();
+    }
+
+    if (doDebug) {
+        RouterProfiler profiler(dutyCycleCurrent.nsExpireDebug);
+        expireDebugInfo();
+    }
+}
+
+void
+Router::
+expireInFlight(RouterShard & shard, Date now)
+{
+    {
+        RouterProfiler profiler(shard.dutyCycle.nsExpireInFlight);
 
         // Look for in flight timeout expiries
         auto onExpiredInFlight = [&] (const Id & auctionId,
@@ -1262,11 +1504,12 @@ checkExpiredAuctions()
                          end = auctionInfo.bidders.end();
                      it != end;  ++it) {
                     string agent = it->first;
-                    if (!agents.count(agent)) continue;
+                    const AgentInfo * agentInfo = findAgentInfo(agent);
+                    if (!agentInfo) continue;
 
-                    if (agents[agent].expireBidInFlight(auctionId)) {
-                        AgentInfo & info = this->agents[agent];
-                        ++info.stats->tooLate;
+                    const AgentInfo & info = *agentInfo;
+                    if (info.expireBidInFlight(auctionId)) {
+                        ML::atomic_inc(info.stats->tooLate);
 
                         this->recordHit("accounts.%s.EXPIRED",
                                         info.config->account.toString('.'));
@@ -1302,17 +1545,7 @@ checkExpiredAuctions()
                 return Date();
             };
 
-        inFlight.expire(onExpiredInFlight, start);
-    }
-
-    {
-        RouterProfiler profiler(dutyCycleCurrent.nsExpireBlacklist);
-        blacklist.doExpiries();
-    }
-
-    if (doDebug) {
-        RouterProfiler profiler(dutyCycleCurrent.nsExpireDebug);
-        expireDebugInfo();
+        shard.inFlight.expire(onExpiredInFlight, now);
     }
 }
 
@@ -1326,8 +1559,15 @@ returnErrorResponse(const std::vector<std::string> & message,
     if (analytics) analytics->logErrorMessage(error,message);
     logMessageToAnalytics("ERROR", error, message);
     const auto& agent = message[0];
-    AgentInfo & info = this->agents[agent];
-    bidder->sendErrorMessage(info.config, agent, error, message);
+
+    // May be called from a shard, so use the published agents
+    std::shared_ptr<const AgentConfig> config;
+    {
+        GcLock::SharedGuard guard(allAgentsGc, GcLock::RD_NO);
+        if (const AgentInfo * info = findAgentInfo(agent))
+            config = info->config;
+    }
+    bidder->sendErrorMessage(config, agent, error, message);
 }
 
 void
@@ -1337,7 +1577,16 @@ returnInvalidBid(
         const std::shared_ptr<Auction> &auction,
         const char *reason, const char *message, ...) {
 
-    auto& agentInfo = agents[agent];
+    // May be called from a shard, so use the published agents
+    GcLock::SharedGuard guard(allAgentsGc, GcLock::RD_NO);
+    const AgentInfo * info = findAgentInfo(agent);
+    if (!info) {
+        this->recordHit("bidErrors.%s", reason);
+        this->recordHit("bidErrors.unknownAgent");
+        return;
+    }
+
+    const auto& agentInfo = *info;
     const auto& agentConfig = agentInfo.config;
     this->recordHit("bidErrors.%s", reason);
     this->recordHit("accounts.%s.bidErrors.total",
@@ -1346,7 +1595,7 @@ returnInvalidBid(
                     agentConfig->account.toString('.'),
                     reason);
 
-    ++agentInfo.stats->invalid;
+    ML::atomic_inc(agentInfo.stats->invalid);
 
     va_list ap;
     va_start(ap, message);
@@ -1374,7 +1623,16 @@ returnInvalidBid(
         const std::shared_ptr<Auction> &auction,
         const std::string &reason, const char *message, ...) {
 
-    auto& agentInfo = agents[agent];
+    // May be called from a shard, so use the published agents
+    GcLock::SharedGuard guard(allAgentsGc, GcLock::RD_NO);
+    const AgentInfo * info = findAgentInfo(agent);
+    if (!info) {
+        this->recordHit("bidErrors.%s", reason);
+        this->recordHit("bidErrors.unknownAgent");
+        return;
+    }
+
+    const auto& agentInfo = *info;
     const auto& agentConfig = agentInfo.config;
     this->recordHit("bidErrors.%s", reason);
     this->recordHit("accounts.%s.bidErrors.total",
@@ -1383,7 +1641,7 @@ returnInvalidBid(
                     agentConfig->account.toString('.'),
                     reason);
 
-    ++agentInfo.stats->invalid;
+    ML::atomic_inc(agentInfo.stats->invalid);
 
     va_list ap;
     va_start(ap, message);
@@ -1411,7 +1669,7 @@ doStats(const std::vector<std::string> & message)
     Json::Value result(Json::objectValue);
 
     result["numAugmenting"] = augmentationLoop.numAugmenting();
-    result["numInFlight"] = inFlight.size();
+    result["numInFlight"] = numAuctionsInProgress();
     result["blacklistUsers"] = blacklist.size();
 
     result["numAgents"] = agents.size();
@@ -1422,7 +1680,7 @@ doStats(const std::vector<std::string> & message)
 
     int totalAgentInFlight = 0;
 
-    BOOST_FOREACH(auto agent, agents) {
+    BOOST_FOREACH(const auto & agent, agents) {
         agentsVal[agent.first] = agent.second.toJson(false, false);
         totalAgentInFlight += agent.second.numBidsInFlight();
     }
@@ -1478,9 +1736,11 @@ augmentAuction(const std::shared_ptr<AugmentationInfo> & info)
                 return;
             }
 
-            // Send it off to be farmed out to the bidders
-            startBiddingBuffer.push(info);
-            wakeupMainLoop.signal();
+            // Send it off to be farmed out to the bidders by the shard
+            // that owns the auction
+            RouterShard & shard = this->shardFor(info->auction->id);
+            shard.startBiddingBuffer.push(info);
+            this->wakeupShard(shard);
         };
 
     augmentationLoop.augment(info, Date::now().plusSeconds(augmentationWindow.count()),
@@ -1552,7 +1812,8 @@ preprocessAuction(const std::shared_ptr<Auction> & auction)
             const AgentStatus & status,
             AgentStats & stats)
         {
-            if (status.dead || status.lastHeartbeat.secondsSince(now) > 2.0) {
+            if (status.dead
+                || status.lastHeartbeat.load().secondsSince(now) > 2.0) {
                 doFilterStat(config, "static.agentAppearsDead");
                 return false;
             }
@@ -1658,11 +1919,13 @@ Router::
 doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
 {
     //static const char *fName = "Router::doStartBidding:";
-    RouterProfiler profiler(dutyCycleCurrent.nsStartBidding);
+    RouterProfiler profiler(
+            shardFor(augInfo->auction->id).dutyCycle.nsStartBidding);
 
     try {
         Id auctionId = augInfo->auction->id;
-        if (inFlight.count(auctionId)) {
+        RouterShard & shard = shardFor(auctionId);
+        if (shard.inFlight.count(auctionId)) {
             throwException("doStartBidding.alreadyInFlight",
                            "auction with ID %s already in progress",
                            auctionId.toString().c_str());
@@ -1703,8 +1966,9 @@ doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
 
             for (unsigned i = 0;  i < bidders.size();  ++i) {
                 PotentialBidder & bidder = bidders[i];
-                if (!agents.count(bidder.agent)) continue;
-                AgentInfo & info = agents[bidder.agent];
+                const AgentInfo * agentInfo = findAgentInfo(bidder.agent);
+                if (!agentInfo) continue;
+                const AgentInfo & info = *agentInfo;
                 const AgentConfig & config = *bidder.config;
 
                 auto doFilterStat = [&] (const char * reason)
@@ -1730,7 +1994,7 @@ doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
 
                 /* Check if we have too many in flight. */
                 if (info.numBidsInFlight() >= info.config->maxInFlight) {
-                    ++info.stats->tooManyInFlight;
+                    ML::atomic_inc(info.stats->tooManyInFlight);
                     bidder.inFlightProp = PotentialBidder::NULL_PROP;
                     doFilterStat("dynamic.tooManyInFlight");
                     continue;
@@ -1858,13 +2122,14 @@ doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
             PotentialBidder & winner = bidders[best];
             string agent = winner.agent;
 
-            if (!agents.count(agent)) {
+            const AgentInfo * agentInfo = findAgentInfo(agent);
+            if (!agentInfo) {
                 //cerr << "!!!AGENT IS GONE" << endl;
                 continue;  // agent is gone
             }
-            AgentInfo & info = agents[agent];
+            const AgentInfo & info = *agentInfo;
 
-            ++info.stats->auctions;
+            ML::atomic_inc(info.stats->auctions);
 
             Json::Value aggregatedAug;
             for (const auto& aug : augList) {
@@ -1872,6 +2137,12 @@ doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
                     aug.second.filterForAccount(winner.config->account).toJson();
             }
             auction->agentAugmentations[agent] = chomp(aggregatedAug.toString());
+            if (info.binaryAuctions) {
+                std::string & binaryAug
+                    = auction->agentAugmentationsBinary[agent];
+                BinaryJsonPrintingContext context(binaryAug);
+                context.writeJson(aggregatedAug);
+            }
 
             //auctionInfo.activities.push_back("sent to " + agent);
 
@@ -1907,7 +2178,7 @@ doStartBidding(const std::shared_ptr<AugmentationInfo> & augInfo)
         else {
             /* No bidders; don't bother with the bid */
             ML::atomic_inc(numNoBidders);
-            inFlight.erase(auctionId);
+            shard.inFlight.erase(auctionId);
             //cerr << fName << "About to call finish " << endl;
             if (!auction->finish()) {
                 recordHit("tooLateToFinish");
@@ -1933,8 +2204,8 @@ addAuction(std::shared_ptr<Auction> auction, Date lossTimeout)
 
     try {
         AuctionInfo & result
-            = inFlight.insert(id, AuctionInfo(auction, lossTimeout),
-                              getCurrentTime().plusSeconds(bidMemoryWindow));
+            = shardFor(id).inFlight.insert(id, AuctionInfo(auction, lossTimeout),
+                                           getCurrentTime().plusSeconds(bidMemoryWindow));
         return result;
     } catch (const std::exception & exc) {
         //cerr << "====================================" << endl;
@@ -1985,6 +2256,7 @@ doBid(const std::vector<std::string> & message)
         bids = Bids::fromJson(biddata);
     }
     catch (const std::exception & exc) {
+        auto & inFlight = shardFor(auctionId).inFlight;
         auto it = inFlight.find(auctionId);
         if (it == inFlight.end()) {
             recordHit("bidError.unknownAuction");
@@ -2017,6 +2289,8 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
     ExcAssert(!message.agents.empty());
 
     const auto& auctionId = message.auctionId;
+    RouterShard & shard = shardFor(auctionId);
+    auto & inFlight = shard.inFlight;
     auto it = inFlight.find(auctionId);
     if (it == inFlight.end()) {
         recordHit("bidError.unknownAuction");
@@ -2026,11 +2300,16 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
 
     AuctionInfo & auctionInfo = it->second;
 
+    const AgentInfo * firstAgentInfo = nullptr;
+
     for (const auto &agent: message.agents) {
-        if (!agents.count(agent)) {
+        const AgentInfo * agentInfo = findAgentInfo(agent);
+        if (!agentInfo) {
             returnErrorResponse(originalMessage, "unknown agent");
             return;
         }
+        if (!firstAgentInfo)
+            firstAgentInfo = agentInfo;
 
         auto biddersIt = auctionInfo.bidders.find(agent);
         if (biddersIt == auctionInfo.bidders.end()) {
@@ -2040,7 +2319,7 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
             return;
         }
 
-        AgentInfo & info = agents[agent];
+        const AgentInfo & info = *agentInfo;
         /* One less in flight. */
         if (!info.expireBidInFlight(auctionId)) {
             recordHit("bidError.agentNotBidding");
@@ -2061,7 +2340,8 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
     const auto& agent = message.agents[0];
     auto biddersIt = auctionInfo.bidders.find(agent);
     auto & config = *biddersIt->second.agentConfig;
-    AgentInfo & info = agents[agent];
+    // Looked up above, and valid for as long as we hold allAgentsGc
+    const AgentInfo & info = *firstAgentInfo;
     const auto& agentConfig = info.config;
 
     const auto& bids = message.bids;
@@ -2069,7 +2349,7 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
 
     BidInfo bidInfo(std::move(biddersIt->second));
 
-    RouterProfiler profiler(dutyCycleCurrent.nsBid);
+    RouterProfiler profiler(shard.dutyCycle.nsBid);
 
     ML::atomic_inc(numBids);
 
@@ -2166,10 +2446,7 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
             continue;
         }
 
-        string auctionKey
-            = auctionId.toString() + "-"
-            + imp[spotIndex].id.toString() + "-"
-            + agent;
+        CommitmentKey auctionKey(auctionId, imp[spotIndex].id, agent);
 
         // authorize an amount of money computed from the win cost model.
         Amount price = message.wcm.evaluate(bid, bid.price);
@@ -2208,7 +2485,7 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
 
         if (!banker->authorizeBid(config.account, auctionKey, price) || failBid(budgetErrorRate))
         {
-            ++info.stats->noBudget;
+            ML::atomic_inc(info.stats->noBudget);
 
             bidder->sendNoBudgetMessage(agentConfig, agent, auctionInfo.auction);
 
@@ -2225,7 +2502,7 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
         if (doDebug)
             this->debugSpot(auctionId, imp[spotIndex].id,
                     ML::format("BID %s %s %f",
-                            auctionKey.c_str(),
+                            auctionKey.toString().c_str(),
                             bid.price.toString().c_str(),
                             (double)bid.priority));
 
@@ -2264,25 +2541,25 @@ doBidImpl(const BidMessage &message, const std::vector<std::string> &originalMes
         if (doDebug)
             this->debugSpot(auctionId, imp[spotIndex].id,
                     ML::format("BID %s %s",
-                            auctionKey.c_str(), msg.c_str()));
+                            auctionKey.toString().c_str(), msg.c_str()));
 
 
         switch (localResult.val) {
         case Auction::WinLoss::PENDING: {
-            ++info.stats->bids;
-            info.stats->totalBid += price;
+            ML::atomic_inc(info.stats->bids);
+            info.addTotalBid(price);
             break; // response will be sent later once local winning bid known
         }
         case Auction::WinLoss::LOSS:
-            ++info.stats->bids;
-            info.stats->totalBid += price;
+            ML::atomic_inc(info.stats->bids);
+            info.addTotalBid(price);
             // fall through
         case Auction::WinLoss::TOOLATE:
         case Auction::WinLoss::INVALID: {
             if (localResult.val == Auction::WinLoss::TOOLATE)
-                ++info.stats->tooLate;
+                ML::atomic_inc(info.stats->tooLate);
             else if (localResult.val == Auction::WinLoss::INVALID)
-                ++info.stats->invalid;
+                ML::atomic_inc(info.stats->invalid);
 
             banker->cancelBid(config.account, auctionKey);
 
@@ -2376,7 +2653,7 @@ doSubmitted(std::shared_ptr<Auction> auction)
     // Either a) move it across to the win queue, or b) drop it if we
     // didn't bid anything
 
-    RouterProfiler profiler(dutyCycleCurrent.nsSubmitted);
+    RouterProfiler profiler(shardFor(auction->id).dutyCycle.nsSubmitted);
 
     const Id & auctionId = auction->id;
 
@@ -2432,17 +2709,15 @@ doSubmitted(std::shared_ptr<Auction> auction)
 
             //cerr << "doing response " << i << endl;
 
-            if (!agents.count(response.agent)) continue;
+            const AgentInfo * agentInfo = findAgentInfo(response.agent);
+            if (!agentInfo) continue;
 
-            AgentInfo & info = agents[response.agent];
+            const AgentInfo & info = *agentInfo;
             const auto& agentConfig = info.config;
 
             Amount bid_price = response.price.maxPrice;
 
-            string auctionKey
-                = auctionId.toString() + "-"
-                + spotId.toString() + "-"
-                + response.agent;
+            CommitmentKey auctionKey(auctionId, spotId, response.agent);
 
             // Make sure we account for the bid no matter what
             ML::Call_Guard guard
@@ -2473,14 +2748,14 @@ doSubmitted(std::shared_ptr<Auction> auction)
                                "auction should not be invalid");
             case Auction::WinLoss::LOSS:
                 bidStatus = BS_LOSS;
-                ++info.stats->losses;
+                ML::atomic_inc(info.stats->losses);
                 msg = "LOSS";
                 bidder->sendLossMessage(agentConfig, response.agent, auctionId.toString());
                 recordHit("accounts.%s.LOCAL_LOSS", agentConfig->account.toString('.'));
                 break;
             case Auction::WinLoss::TOOLATE:
                 bidStatus = BS_TOOLATE;
-                ++info.stats->tooLate;
+                ML::atomic_inc(info.stats->tooLate);
                 msg = "TOOLATE";
                 bidder->sendTooLateMessage(agentConfig, response.agent, auction);
                 recordHit("accounts.%s.TOOLATE", agentConfig->account.toString('.'));
@@ -2494,7 +2769,7 @@ doSubmitted(std::shared_ptr<Auction> auction)
                 debugSpot(auctionId, spotId,
                           ML::format("%s %s",
                                      msg.c_str(),
-                                     auctionKey.c_str()));
+                                     auctionKey.toString().c_str()));
         }
 
         // If we didn't actually submit a bid then nothing else to do
@@ -2594,7 +2869,13 @@ onAuctionDone(std::shared_ptr<Auction> auction)
 #endif
 
     debugAuction(auction->id, "SENT SUBMITTED");
-    submittedBuffer.push(auction);
+    RouterShard & shard = shardFor(auction->id);
+    shard.submittedBuffer.push(auction);
+
+    // The main loop polls often enough to pick this up without being
+    // woken, but shard threads wait on their wakeup fd.
+    if (hasShardThreads())
+        shard.wakeup.signal();
 }
 
 void
@@ -2613,6 +2894,16 @@ onAuctionError(const std::string & channel,
     }
 }
 
+void
+Router::
+resetWinCostModels(const std::string & address)
+{
+    for (auto & agent: agents) {
+        if (agent.second.address == address)
+            agent.second.winCostModels->clear();
+    }
+}
+
 void
 Router::
 updateAllAgents()
@@ -2624,6 +2915,9 @@ updateAllAgents()
         AllAgentInfo * current = allAgents;
 
         for (auto it = agents.begin(), end = agents.end();  it != end;  ++it) {
+            newInfo->agents[it->first]
+                = std::make_shared<AgentInfo>(it->second);
+
             if (!it->second.configured) continue;
             if (!it->second.config) continue;
             if (!it->second.stats) continue;
@@ -2690,8 +2984,7 @@ doConfig(const std::string & agent,
         //cerr << "configured " << agent << " strategy : " << info.config->strategy << " campaign "
         //     <<  info.config->campaign << endl;
 
-        string bidRequestFormat = "jsonRaw";
-        info.setBidRequestFormat(bidRequestFormat);
+        info.setBidRequestFormat(newConfig->bidRequestFormat);
 
         configure(agent, *newConfig);
         info.configured = true;
@@ -2902,6 +3195,19 @@ forEachAccountAgent(const AccountKey & account,
         onAgent(ac->at(*jt));
 }
 
+const AgentInfo *
+Router::
+findAgentInfo(const std::string & agent) const
+{
+    const AllAgentInfo * ac = allAgents;
+    if (!ac) return nullptr;
+
+    auto it = ac->agents.find(agent);
+    if (it == ac->agents.end())
+        return nullptr;
+    return it->second.get();
+}
+
 AgentInfoEntry
 Router::
 getAgentEntry(const std::string & agent) const
@@ -2932,9 +3238,7 @@ submitToPostAuctionService(std::shared_ptr<Auction> auction,
 
     backtrace();
 #endif
-    string auctionKey = auction->id.toString()
-                        + "-" + adSpotId.toString()
-                        + "-" + bid.agent;
+    CommitmentKey auctionKey(auction->id, adSpotId, bid.agent);
 
     banker->detachBid(bid.account, auctionKey);
 
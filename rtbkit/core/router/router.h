@@ -71,6 +71,13 @@ struct AgentInfoEntry {
 struct AllAgentInfo : public std::vector<AgentInfoEntry> {
     std::unordered_map<std::string, int> agentIndex;
     std::unordered_map<AccountKey, std::vector<int> > accountIndex;
+
+    /** Copy of every agent in the router's agents map, including the ones
+        that aren't configured or are dead, for the auction shards to look
+        up without locking.  The copies share their status and stats with
+        the router's entries.
+    */
+    std::unordered_map<std::string, std::shared_ptr<const AgentInfo> > agents;
 };
 
 /*****************************************************************************/
@@ -95,6 +102,64 @@ struct AuctionDebugInfo {
     std::vector<Message> messages;
 };
 
+/*****************************************************************************/
+/* ROUTER SHARD                                                              */
+/*****************************************************************************/
+
+/** Slice of the auction pipeline.  Each auction belongs to exactly one
+    shard, chosen from the hash of its id, and everything that happens to
+    it between the end of augmentation and its submission (start of
+    bidding, bids, expiry) is done by that shard.
+
+    By default the router has a single shard which is serviced by the main
+    router loop.  When more than one shard is configured each of them gets
+    its own thread, and the main loop only deals with agent messages,
+    configuration and housekeeping.
+*/
+struct RouterShard {
+    RouterShard(unsigned index)
+        : index(index),
+          startBiddingBuffer(65536),
+          submittedBuffer(65536),
+          doBidBuffer(65536),
+          bidMessageBuffer(65536),
+          usActive(0)
+    {
+    }
+
+    unsigned index;
+
+    ML::RingBufferSRMW<std::shared_ptr<AugmentationInfo> > startBiddingBuffer;
+    ML::RingBufferSRMW<std::shared_ptr<Auction> > submittedBuffer;
+    ML::RingBufferSRMW<BidMessage> doBidBuffer;
+
+    /// Unparsed BID messages from agents, forwarded by the main loop
+    ML::RingBufferSRMW<std::vector<std::string> > bidMessageBuffer;
+
+    ML::Wakeup_Fd wakeup;
+
+    /** List of auctions owned by this shard that we're currently tracking
+        as active. */
+    TimeoutMap<Id, AuctionInfo> inFlight;
+
+    /** Held by the shard while it works on one of its auctions, and by
+        anyone else who wants to look at inFlight.  It's a mutex as the
+        work includes sending messages and talking to the banker.
+    */
+    mutable std::mutex lock;
+
+    /// Microseconds spent processing; used for the loop monitor
+    uint64_t usActive;
+
+    /** Time spent in each part of the shard's pipeline, protected by lock.
+        The main loop merges it into the router's duty cycle.
+    */
+    DutyCycleEntry dutyCycle;
+
+    std::unique_ptr<boost::thread> thread;
+};
+
+
 /*****************************************************************************/
 /* ROUTER                                                                    */
 /*****************************************************************************/
@@ -183,6 +248,14 @@ struct Router : public ServiceBase,
     */
     void unsafeDisableSlowMode();
 
+    /** Set the number of shards that auctions are spread over.  With more
+        than one shard, each shard runs its own thread.  Must be called
+        before start().
+    */
+    void setNumAuctionShards(unsigned numShards);
+
+    unsigned numAuctionShards() const { return shards.size(); }
+
     /** Start the router running in a separate thread.  The given function
         will be called when the thread is stopped. */
     virtual void
@@ -428,19 +501,46 @@ public:
 
     void updateAllAgents();
 
-    /** Map from the configured name of the agent to the agent info. */
+    /** Forget the win cost models sent to the agent at the given address so
+        that they get defined again; called when it connects or disconnects.
+    */
+    void resetWinCostModels(const std::string & address);
+
+    /** Map from the configured name of the agent to the agent info.  Only
+        used by the main loop; the auction shards see the copies published
+        in allAgents by updateAllAgents().
+    */
     typedef std::map<std::string, AgentInfo> Agents;
     Agents agents;
 
     ML::RingBufferSRMW<std::pair<std::string, std::shared_ptr<const AgentConfig> > > configBuffer;
     ML::RingBufferSRMW<std::shared_ptr<ExchangeConnector> > exchangeBuffer;
-    ML::RingBufferSRMW<std::shared_ptr<AugmentationInfo> > startBiddingBuffer;
-    ML::RingBufferSRMW<std::shared_ptr<Auction> > submittedBuffer;
-    ML::RingBufferSWMR<std::shared_ptr<Auction> > auctionGraveyard;
-    ML::RingBufferSRMW<BidMessage> doBidBuffer;
+    ML::RingBufferSRMW<std::shared_ptr<Auction> > auctionGraveyard;
 
     ML::Wakeup_Fd wakeupMainLoop;
 
+    /** Shards over which the auctions are spread. */
+    std::vector<std::unique_ptr<RouterShard> > shards;
+
+    /** Return the shard that owns the given auction. */
+    RouterShard & shardFor(const Id & auctionId) const
+    {
+        return *shards[auctionId.hash() % shards.size()];
+    }
+
+    /** Do the shards run in their own threads?  If not, the only shard is
+        serviced by the main loop. */
+    bool hasShardThreads() const { return shards.size() > 1; }
+
+    /** Wake up whichever loop services the given shard. */
+    void wakeupShard(RouterShard & shard);
+
+    /** Queue a bid to be processed by the shard that owns its auction.
+        Can be called from any thread.  Returns false if the queue is
+        full.
+    */
+    bool injectBid(BidMessage message);
+
     FilterPool filters;
 
     AugmentationLoop augmentationLoop;
@@ -449,9 +549,7 @@ public:
     LoopMonitor loopMonitor;
     LoadStabilizer loadStabilizer;
 
-    /** List of auctions we're currently tracking as active. */
     typedef TimeoutMap<Id, AuctionInfo> InFlight;
-    InFlight inFlight;
 
     /** Add the given auction to our data structures. */
     AuctionInfo &
@@ -462,12 +560,24 @@ public:
 
     void run();
 
+    /** Event loop for a shard that runs in its own thread. */
+    void runShard(RouterShard & shard);
+
+    typedef std::function<void (const char * what, double start)>
+        RecordTimeFn;
+
+    /** Process everything that is waiting in the shard's queues. */
+    void drainShard(RouterShard & shard, const RecordTimeFn & recordTime);
+
     void handleAgentMessage(const std::vector<std::string> & message);
 
     void checkDeadAgents();
 
     void checkExpiredAuctions();
 
+    /** Expire the in-flight auctions of the given shard. */
+    void expireInFlight(RouterShard & shard, Date now);
+
     void returnErrorResponse(const std::vector<std::string> & message,
                              const std::string & error);
 
@@ -593,6 +703,13 @@ public:
     */
     AgentInfoEntry getAgentEntry(const std::string & agent) const;
 
+    /** Find the given agent in the current version of allAgents, or null
+        if it isn't known.  This is how the auction shards get at the
+        agents; the caller must hold allAgentsGc, until when the result
+        stays valid.
+    */
+    const AgentInfo * findAgentInfo(const std::string & agent) const;
+
     /** Listen for changes in configuration and let the router know about
         them.
     */
@@ -64,7 +64,8 @@ RouterRunner() :
     analyticsPublisherOn(false),
     analyticsPublisherConnections(1),
     augmentationWindowms(5),
-    dableSlowMode(false)
+    dableSlowMode(false),
+    auctionShards(1)
 {
 }
 
@@ -118,7 +119,10 @@ doOptions(int argc, char ** argv,
          ("augmenter-timeout",value<int>(&augmentationWindowms),
          "configure the augmenter  timeout (in milliseconds)")
         ("no slow mode", value<bool>(&dableSlowMode)->zero_tokens(),
-         "disable the slow mode.");
+         "disable the slow mode.")
+        ("auction-shards", value<int>(&auctionShards),
+         "number of threads over which auctions are sharded (default 1, "
+         "which runs them in the main router loop)");
 
     options_description all_opt = opts;
     all_opt
@@ -183,6 +187,7 @@ init()
                                       USD_CPM(maxBidPrice),
                                       slowModeTimeout, amountSlowModeMoneyLimit, augmentationWindow);
     router->slowModeTolerance = slowModeTolerance;
+    router->setNumAuctionShards(auctionShards);
     router->initBidderInterface(bidderConfig);
     if (dableSlowMode) {
        router->unsafeDisableSlowMode();
@@ -56,6 +56,7 @@ struct RouterRunner {
     int analyticsPublisherConnections;
     int augmentationWindowms;
     bool dableSlowMode;
+    int auctionShards;
 
     void doOptions(int argc, char ** argv,
                    const boost::program_options::options_description & opts
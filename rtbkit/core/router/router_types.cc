@@ -105,8 +105,8 @@ toJson(bool includeConfig, bool includeStats) const
     Json::Value result;
     result["configured"] = configured;
     result["lastHeartbeat"]
-        = status->lastHeartbeat.print(4);
-    result["numInFlight"] = status->numBidsInFlight;
+        = status->lastHeartbeat.load().print(4);
+    result["numInFlight"] = status->numBidsInFlight.load();
     if (config && includeConfig) result["config"] = config->toJson(false);
     if (stats && includeStats) result["stats"] = stats->toJson();
     
@@ -124,13 +124,19 @@ const std::string &
 AgentInfo::
 encodeBidRequest(const Auction & auction) const
 {
-    return auction.requestStr;
+    if (bidRequestFormat == BRF_BINARY_V1)
+        return auction.requestBinary.str();
+    return auction.requestStr.str();
 }
 
 const std::string &
 AgentInfo::
 getBidRequestEncoding(const Auction & auction) const
 {
+    static const std::string binaryEncoding = "datacratic-bin";
+
+    if (bidRequestFormat == BRF_BINARY_V1)
+        return binaryEncoding;
     return auction.requestStrFormat;
 }
 
@@ -138,7 +144,11 @@ void
 AgentInfo::
 setBidRequestFormat(const std::string & val)
 {
-    // TODO
+    if (val.empty() || val == "jsonRaw")
+        bidRequestFormat = BRF_JSON_RAW;
+    else if (val == "binary")
+        bidRequestFormat = BRF_BINARY_V1;
+    else throw ML::Exception("unknown bid request format " + val);
 }
 
 AgentStats::
@@ -11,9 +11,14 @@
 #include "rtbkit/common/bid_request.h"
 #include "rtbkit/common/auction.h"
 #include "jml/stats/distribution.h"
+#include "jml/arch/spinlock.h"
 #include <set>
+#include <map>
+#include <mutex>
+#include <atomic>
 #include "rtbkit/common/currency.h"
 #include "rtbkit/common/bids.h"
+#include "rtbkit/common/auction_message.h"
 
 
 namespace RTBKIT {
@@ -89,19 +94,33 @@ struct AgentStats {
 
     uint64_t requiredAugmentorIsMissing;
     uint64_t augmentorValueIsNull;
+
+    /** Protects the CurrencyPool members, which can't be updated atomically
+        and are written to by every auction shard the agent bids in.
+    */
+    ML::Spinlock lock;
 };
 
 
 struct AgentStatus {
     AgentStatus()
-        : dead(false), numBidsInFlight(0)
+        : dead(false), lastHeartbeat(Date::now()), numBidsInFlight(0)
     {
-        lastHeartbeat = Date::now();
     }
 
-    bool dead;
-    Date lastHeartbeat;
-    size_t numBidsInFlight;
+    /** Written by the main loop and read by the auction shards through
+        their copy of the AgentInfo, so they're atomic.
+    */
+    std::atomic<bool> dead;
+    std::atomic<Date> lastHeartbeat;
+    std::atomic<size_t> numBidsInFlight;
+
+    /** Auctions in which the agent is participating.  These are tracked
+        here rather than in AgentInfo so that every auction shard can
+        update them under inFlightLock.
+    */
+    std::map<Id, Date> bidsInFlight;
+    ML::Spinlock inFlightLock;
 };
 
 /// Information about a agent
@@ -111,7 +130,9 @@ struct AgentInfo {
           configured(false),
           status(new AgentStatus()),
           stats(new AgentStats()),
-          throttleProbability(1.0)
+          throttleProbability(1.0),
+          binaryAuctions(false),
+          winCostModels(new WinCostModelEncoder())
     {
     }
 
@@ -130,6 +151,16 @@ struct AgentInfo {
 
     /** Address of the zeromq socket for this agent. */
     std::string address;
+
+    /** Does the agent understand AUCTION_BINARY messages?  Agents say so
+        by sending version 1.1 with their CONFIG message.
+    */
+    bool binaryAuctions;
+
+    /** Win cost models sent to the agent in binary auction messages.  It's
+        cleared when the agent (re)connects as it starts with no models.
+    */
+    std::shared_ptr<WinCostModelEncoder> winCostModels;
     
     /** Encode the given bid request ready to be sent to the given
         agent in its configured format.
@@ -195,10 +226,21 @@ struct AgentInfo {
         status->dead = false;
     }
 
+    /** Call the given function for each auction that the agent is
+        bidding in.  The function is called on a snapshot, so it may
+        itself expire the bids.
+    */
     template<typename Fn>
     void forEachInFlight(const Fn & fn) const
     {
-        for (auto it = bidsInFlight.begin(), end = bidsInFlight.end();
+        std::vector<std::pair<Id, Date> > inFlight;
+        {
+            std::lock_guard<ML::Spinlock> guard(status->inFlightLock);
+            inFlight.assign(status->bidsInFlight.begin(),
+                            status->bidsInFlight.end());
+        }
+
+        for (auto it = inFlight.begin(), end = inFlight.end();
              it != end;  ++it) {
             fn(it->first, it->second);
         }
@@ -206,30 +248,39 @@ struct AgentInfo {
 
     size_t numBidsInFlight() const
     {
+        std::lock_guard<ML::Spinlock> guard(status->inFlightLock);
         // DEBUG
-        if (status->numBidsInFlight != bidsInFlight.size())
+        if (status->numBidsInFlight != status->bidsInFlight.size())
             throw ML::Exception("numBidsInFlight is wrong");
         return status->numBidsInFlight;
     }
     
-    bool expireBidInFlight(const Id & id)
+    bool expireBidInFlight(const Id & id) const
     {
-        bool result = bidsInFlight.erase(id);
-        status->numBidsInFlight = bidsInFlight.size();
+        std::lock_guard<ML::Spinlock> guard(status->inFlightLock);
+        bool result = status->bidsInFlight.erase(id);
+        status->numBidsInFlight = status->bidsInFlight.size();
         return result;
     }
 
     // Returns true if it was successfully inserted
-    bool trackBidInFlight(const Id & id, Date date = Date::now())
+    bool trackBidInFlight(const Id & id, Date date = Date::now()) const
     {
-        bool result = bidsInFlight.insert(std::make_pair(id, date)).second;
-        status->numBidsInFlight = bidsInFlight.size();
+        std::lock_guard<ML::Spinlock> guard(status->inFlightLock);
+        bool result
+            = status->bidsInFlight.insert(std::make_pair(id, date)).second;
+        status->numBidsInFlight = status->bidsInFlight.size();
         return result;
     }
 
-private:
-    std::map<Id, Date> bidsInFlight;  /// Auctions in which we're participating
-    //std::set<std::pair<Id, Id> > awaitingResult;  ///< Auctions which are awaiting a win/loss result
+    /** Add to the total bid by the agent.  Safe to call from any auction
+        shard.
+    */
+    void addTotalBid(const Amount & amount) const
+    {
+        std::lock_guard<ML::Spinlock> guard(stats->lock);
+        stats->totalBid += amount;
+    }
 };
 
 /** Information about one of the agents in a round robin group. */
@@ -6,6 +6,8 @@
 
 LIB_FILTERS_SOURCES := \
 	filters/static_filters.cc \
+	filters/pattern_matcher.cc \
+	filters/geo_index.cc \
         filters/creative_filters.cc
 
 LIB_FILTERS_LINK := \
@@ -15,6 +17,7 @@ $(eval $(call library,static_filters,$(LIB_FILTERS_SOURCES),$(LIB_FILTERS_LINK))
 
 LIBRTB_ROUTER_SOURCES := \
 	augmentation_loop.cc \
+	augmentation_cache.cc \
 	router.cc \
 	router_types.cc \
 	router_stack.cc \
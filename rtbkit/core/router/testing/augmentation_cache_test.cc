@@ -0,0 +1,108 @@
+/* augmentation_cache_test.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Tests for the router-side cache of augmentation responses.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "rtbkit/core/router/augmentation_cache.h"
+
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+namespace {
+
+AugmentationList response(const std::string & value)
+{
+    AugmentationList result;
+    result[AccountKey()].data = value;
+    return result;
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_cache_config )
+{
+    AugmentationCacheConfig config;
+    BOOST_CHECK(!config.enabled());
+    BOOST_CHECK(!AugmentationCacheConfig(5.0, {}).enabled());
+
+    config = AugmentationCacheConfig(2.5, { "prov", "xchg" });
+    BOOST_CHECK(config.enabled());
+
+    auto config2 = AugmentationCacheConfig::fromJson(config.toJson());
+    BOOST_CHECK_EQUAL(config2.ttl, 2.5);
+    BOOST_CHECK(config2.keyDomains == config.keyDomains);
+}
+
+BOOST_AUTO_TEST_CASE( test_cache_key )
+{
+    AugmentationCacheConfig config(1.0, { "prov" });
+    std::set<std::string> agents = { "agent1", "agent2" };
+
+    UserIds ids;
+    BOOST_CHECK_EQUAL(AugmentationCache::key(config, ids, agents), "");
+
+    ids.add(Id("user1"), ID_PROVIDER);
+    ids.add(Id("other"), ID_EXCHANGE);
+    std::string key = AugmentationCache::key(config, ids, agents);
+    BOOST_CHECK_NE(key, "");
+
+    // Only the configured domains are part of the key
+    UserIds ids2;
+    ids2.add(Id("user1"), ID_PROVIDER);
+    BOOST_CHECK_EQUAL(AugmentationCache::key(config, ids2, agents), key);
+
+    // but the agents are
+    BOOST_CHECK_NE(AugmentationCache::key(config, ids2, { "agent1" }), key);
+
+    config.keyDomains.push_back("xchg");
+    BOOST_CHECK_EQUAL(AugmentationCache::key(config, ids2, agents), "");
+    BOOST_CHECK_NE(AugmentationCache::key(config, ids, agents), key);
+}
+
+BOOST_AUTO_TEST_CASE( test_cache_expiry )
+{
+    Date now = Date::fromSecondsSinceEpoch(1000);
+
+    AugmentationCache cache(2);
+    BOOST_CHECK(!cache.find("aug", "key1", now));
+
+    cache.insert("aug", "key1", response("a"), now.plusSeconds(1));
+    cache.insert("other", "key1", response("b"), now.plusSeconds(3));
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+
+    auto found = cache.find("aug", "key1", now);
+    BOOST_REQUIRE(found);
+    BOOST_CHECK_EQUAL(found->at(AccountKey()).data.asString(), "a");
+    BOOST_CHECK_EQUAL(cache.find("other", "key1", now)
+                      ->at(AccountKey()).data.asString(), "b");
+    BOOST_CHECK(!cache.find("aug", "key2", now));
+
+    // Expired entries are never returned, even before they're removed
+    BOOST_CHECK(!cache.find("aug", "key1", now.plusSeconds(1)));
+    cache.expire(now.plusSeconds(2));
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+
+    // Replacing an entry updates its response and expiry
+    cache.insert("other", "key1", response("c"), now.plusSeconds(10));
+    cache.expire(now.plusSeconds(5));
+    BOOST_CHECK_EQUAL(cache.find("other", "key1", now.plusSeconds(5))
+                      ->at(AccountKey()).data.asString(), "c");
+
+    // Once full, the entry closest to expiry makes room
+    cache.insert("aug", "key2", response("d"), now.plusSeconds(20));
+    cache.insert("aug", "key3", response("e"), now.plusSeconds(15));
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(!cache.find("other", "key1", now));
+    BOOST_CHECK(cache.find("aug", "key2", now));
+
+    cache.erase("aug");
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
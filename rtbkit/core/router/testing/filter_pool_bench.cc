@@ -0,0 +1,192 @@
+/** filter_pool_bench.cc                                           -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Micro-benchmark of the static filtering over recorded bid requests.
+
+    Registers a large number of randomly generated agent configs in a
+    FilterPool and then times FilterPool::filter over the recorded auctions
+    in 20000-datacratic-auctions.xz.
+
+*/
+
+#include "rtbkit/core/router/filter_pool.h"
+#include "rtbkit/core/router/router_types.h"
+#include "rtbkit/core/agent_configuration/agent_config.h"
+#include "rtbkit/common/bid_request.h"
+#include "soa/utils/print_utils.h"
+#include "jml/utils/filter_streams.h"
+#include "jml/arch/timers.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <random>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+/******************************************************************************/
+/* CONFIG                                                                     */
+/******************************************************************************/
+
+struct Config
+{
+    Config() :
+        configs(2000),
+        passes(10),
+        requests(20000),
+        file("rtbkit/core/router/testing/20000-datacratic-auctions.xz")
+    {}
+
+    size_t configs;
+    size_t passes;
+    size_t requests;
+    std::string file;
+};
+
+Config getConfig(int argc, char** argv)
+{
+    using namespace boost::program_options;
+
+    Config config;
+
+    options_description opt;
+    opt.add_options()
+        ("configs,c", value<size_t>(&config.configs),
+         "number of agent configs to filter")
+        ("passes,p", value<size_t>(&config.passes),
+         "number of passes over the recorded requests")
+        ("requests,r", value<size_t>(&config.requests),
+         "maximum number of recorded requests to load")
+        ("file,f", value<std::string>(&config.file),
+         "file containing the recorded requests")
+        ("help,h","print this message");
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opt).run(), vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        cerr << opt << endl;
+        exit(1);
+    }
+
+    return config;
+}
+
+
+/******************************************************************************/
+/* SETUP                                                                      */
+/******************************************************************************/
+
+std::vector< std::shared_ptr<BidRequest> >
+loadRequests(const Config& config)
+{
+    std::vector< std::shared_ptr<BidRequest> > requests;
+
+    filter_istream stream(config.file);
+    while (stream && requests.size() < config.requests) {
+        string line;
+        getline(stream, line);
+        if (line.empty()) continue;
+
+        requests.emplace_back(BidRequest::parse("datacratic", line));
+    }
+
+    return requests;
+}
+
+/** Generates a config that looks like what we see in production: most of the
+    configs target a subset of the exchanges, languages and hours.
+ */
+AgentInfo makeAgent(std::mt19937& rng, size_t index)
+{
+    static const std::vector<std::string> exchanges = {
+        "dblclk_adx", "rubicon", "appnexus", "openx", "mopub"
+    };
+    static const std::vector<std::string> languages = {
+        "en", "fr", "es", "de"
+    };
+
+    auto pick = [&] (size_t n) { return rng() % n; };
+
+    auto config = std::make_shared<AgentConfig>();
+    config->account = AccountKey({"bench", std::to_string(index)});
+    config->creatives.push_back(Creative::sampleLB);
+    config->creatives.push_back(Creative::sampleWS);
+    config->creatives.push_back(Creative::sampleBB);
+
+    if (pick(4) != 0)
+        config->exchangeFilter.include.push_back(exchanges[pick(exchanges.size())]);
+
+    if (pick(2) != 0) {
+        Json::Value filter;
+        filter["include"].append(languages[pick(languages.size())]);
+        config->languageFilter.fromJson(filter, "languageFilter");
+    }
+
+    for (size_t hour = 0; hour < config->hourOfWeekFilter.hourBitmap.size(); ++hour)
+        config->hourOfWeekFilter.hourBitmap[hour] = pick(8) != 0;
+
+    if (pick(8) == 0) {
+        OpenRTB::AdPosition position;
+        position.val = OpenRTB::AdPosition::ABOVE;
+        config->foldPositionFilter.include.push_back(position);
+    }
+
+    AgentInfo info;
+    info.config = config;
+    return info;
+}
+
+
+/******************************************************************************/
+/* MAIN                                                                       */
+/******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    auto config = getConfig(argc, argv);
+
+    auto requests = loadRequests(config);
+    cerr << "loaded " << requests.size() << " requests" << endl;
+
+    FilterPool pool;
+    pool.initWithFiltersFromJson(Json::parse(
+                    "[ \"ExchangeName\", \"Language\", \"HourOfWeek\","
+                    "  \"FoldPosition\", \"Location\", \"Host\", \"Url\","
+                    "  \"Segments\", \"CreativeFormat\", \"CreativeLanguage\","
+                    "  \"CreativeLocation\", \"CreativeExchangeName\" ]"));
+
+    std::mt19937 rng(0);
+    for (size_t i = 0; i < config.configs; ++i)
+        pool.addConfig("agent-" + std::to_string(i), makeAgent(rng, i));
+
+    // The first pass warms up the fused stage and gathers the measurements
+    // used to order the filters; the re-add then publishes a generation
+    // compiled from those measurements.
+    for (const auto& br : requests) pool.filter(*br, nullptr);
+    pool.addConfig("agent-0", makeAgent(rng, 0));
+
+    size_t matched = 0;
+    Timer timer;
+
+    for (size_t pass = 0; pass < config.passes; ++pass) {
+        for (const auto& br : requests)
+            matched += pool.filter(*br, nullptr).size();
+    }
+
+    double elapsed = timer.elapsed_wall();
+    double filtered = requests.size() * config.passes;
+
+    cerr << "\n"
+        << printValue(config.configs) << " Configs\n"
+        << printValue(filtered) << " Requests\n"
+        << printValue(filtered / elapsed) << " Requests/sec\n"
+        << printValue(elapsed / filtered * 1000000.0) << " us/Request\n"
+        << printValue(matched / filtered) << " Configs/Request\n"
+        << endl;
+}
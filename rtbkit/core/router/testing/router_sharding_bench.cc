@@ -0,0 +1,288 @@
+/** router_sharding_bench.cc                                       -*- C++ -*-
+    Copyright (c) 2014 Datacratic.  All rights reserved.
+
+    Router bench for auction sharding.  Injects auctions as fast as the
+    router will take them into a router with a given number of auction
+    shards and a handful of fixed price bidding agents, and reports the
+    number of auctions which were completed per second.
+
+    Run it with --shards 1, 2, 4 and 8 to see how the auction pipeline
+    scales.
+
+*/
+
+#include "rtbkit/core/router/router.h"
+#include "rtbkit/core/agent_configuration/agent_configuration_service.h"
+#include "rtbkit/core/banker/null_banker.h"
+#include "rtbkit/testing/test_agent.h"
+#include "soa/utils/print_utils.h"
+#include "jml/arch/timers.h"
+
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+
+/******************************************************************************/
+/* CONFIG                                                                     */
+/******************************************************************************/
+
+struct Config
+{
+    Config() :
+        shards(1), feeders(2), agents(4), maxInFlight(4096), durationSec(10)
+    {}
+
+    size_t shards;
+    size_t feeders;
+    size_t agents;
+    size_t maxInFlight;
+    size_t durationSec;
+};
+
+Config getConfig(int argc, char** argv)
+{
+    using namespace boost::program_options;
+
+    Config config;
+
+    options_description opt;
+    opt.add_options()
+        ("shards,s", value<size_t>(&config.shards),
+         "number of auction shards in the router")
+        ("feeders,f", value<size_t>(&config.feeders),
+         "number of threads injecting auctions")
+        ("agents,a", value<size_t>(&config.agents),
+         "number of bidding agents")
+        ("maxInFlight,m", value<size_t>(&config.maxInFlight),
+         "maximum number of auctions in the router at any time")
+        ("durationSec,d", value<size_t>(&config.durationSec))
+        ("help,h","print this message");
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opt).run(), vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        cerr << opt << endl;
+        exit(1);
+    }
+
+    return config;
+}
+
+
+/******************************************************************************/
+/* FEEDER                                                                     */
+/******************************************************************************/
+
+std::atomic<size_t> injected(0);
+std::atomic<size_t> finished(0);
+
+struct Feeder
+{
+    Feeder(std::shared_ptr<Router> router, size_t index, Config config) :
+        done(false), index(index), router(std::move(router)),
+        config(std::move(config))
+    {
+    }
+
+    void start()
+    {
+        runThread = std::thread([=] { run(); });
+    }
+
+    void join()
+    {
+        done = true;
+        runThread.join();
+    }
+
+private:
+
+    void run()
+    {
+        auto onFinished = [] (std::shared_ptr<Auction> auction) {
+            finished.fetch_add(1);
+        };
+
+        size_t counter = 0;
+        size_t maxInFlight = config.maxInFlight;
+
+        while (!done) {
+            if (injected.load() - finished.load() >= maxInFlight) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            Id auctionId((index << 40) + counter++);
+            std::string requestStr = makeBidRequest(auctionId);
+            std::shared_ptr<BidRequest> request(
+                    BidRequest::parse("datacratic", requestStr));
+
+            double now = Date::now().secondsSinceEpoch();
+            router->injectAuction(onFinished, request, requestStr,
+                                  "datacratic", now, now + 0.03);
+            injected.fetch_add(1);
+        }
+    }
+
+    std::string makeBidRequest(Id auctionId) const
+    {
+        BidRequest bidRequest;
+
+        AdSpot spot;
+        spot.id = Id(1);
+        spot.formats.push_back(Format(300,250));
+        bidRequest.imp.push_back(spot);
+
+        bidRequest.location.countryCode = "CA";
+        bidRequest.location.regionCode = "QC";
+        bidRequest.location.cityName = "Montreal";
+        bidRequest.auctionId = auctionId;
+        bidRequest.exchange = "mock";
+        bidRequest.language = "en";
+        bidRequest.url = Url("http://datacratic.com");
+        bidRequest.timestamp = Date::now();
+
+        return bidRequest.toJsonStr();
+    }
+
+    std::atomic<bool> done;
+    std::thread runThread;
+
+    size_t index;
+    std::shared_ptr<Router> router;
+    Config config;
+};
+
+
+/******************************************************************************/
+/* INIT                                                                       */
+/******************************************************************************/
+
+std::shared_ptr<AgentConfigurationService>
+initAgentConfiguration(std::shared_ptr<ServiceProxies> proxies)
+{
+    auto acs = std::make_shared<AgentConfigurationService>(
+            proxies, "AgentConfigurationService");
+    acs->unsafeDisableMonitor();
+    acs->init();
+    acs->bindTcp();
+    acs->start();
+    return acs;
+}
+
+std::shared_ptr<Router>
+initRouter(std::shared_ptr<ServiceProxies> proxies, const Config& config)
+{
+    auto router = std::make_shared<Router>(proxies, "router");
+    router->unsafeDisableMonitor();
+    router->unsafeDisableSlowMode();
+    router->unsafeDisableAuctionProbability();
+    router->setNumAuctionShards(config.shards);
+    router->initBidderInterface(Json::parse("{\"type\":\"agents\"}"));
+    router->init();
+    router->setBanker(std::make_shared<NullBanker>(true));
+    router->initFilters();
+    router->bindTcp();
+    router->start();
+    return router;
+}
+
+std::vector<std::shared_ptr<TestAgent> >
+initAgents(std::shared_ptr<ServiceProxies> proxies, const Config& config)
+{
+    std::vector<std::shared_ptr<TestAgent> > agents;
+
+    for (size_t i = 0; i < config.agents; ++i) {
+        std::string name = "agent-" + std::to_string(i);
+        auto agent = std::make_shared<TestAgent>(
+                proxies, name, AccountKey({"bench", name}));
+        agent->config.maxInFlight = config.maxInFlight;
+        agent->bidWithFixedAmount(USD_CPM(1));
+        agent->init();
+        agent->start();
+        agent->strictMode(false);
+        agents.push_back(agent);
+    }
+
+    return agents;
+}
+
+
+/******************************************************************************/
+/* REPORT                                                                     */
+/******************************************************************************/
+
+size_t report(std::shared_ptr<Router> router, double delta, size_t last = 0)
+{
+    size_t current = finished.load();
+    double throughput = (current - last) / delta;
+
+    std::stringstream ss;
+    ss << "\r"
+        << "auctions/sec=" << printValue(throughput)
+        << ", inFlight=" << printValue(router->numAuctionsInProgress())
+        << ", injected=" << printValue(injected.load());
+    std::cerr << ss.str();
+
+    return current;
+}
+
+
+/******************************************************************************/
+/* MAIN                                                                       */
+/******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    ZmqLogs::print.deactivate();
+    MessageLoopLogs::print.deactivate();
+
+    auto config = getConfig(argc, argv);
+
+    auto proxies = std::make_shared<ServiceProxies>();
+    auto acs = initAgentConfiguration(proxies);
+    auto router = initRouter(proxies, config);
+    auto agents = initAgents(proxies, config);
+
+    // Wait a little for the agents to be configured...
+    ML::sleep(1.0);
+
+    std::vector<Feeder*> feeders;
+    for (size_t i = 0; i < config.feeders; ++i) {
+        feeders.emplace_back(new Feeder(router, i, config));
+        feeders.back()->start();
+    }
+
+    auto now = Date::now();
+    auto stop = now.plusSeconds(config.durationSec);
+
+    size_t start = finished.load();
+    size_t last = report(router, 0.1);
+
+    while ((now = Date::now()) < stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        last = report(router, 0.1, last);
+    }
+
+    size_t total = finished.load() - start;
+
+    std::cerr << "\n\n"
+        << printValue(config.durationSec) << " Duration\n"
+        << printValue(config.shards) << " Shards\n"
+        << printValue(config.agents) << " Agents\n"
+        << printValue(total / double(config.durationSec)) << " Auctions/sec\n"
+        << std::endl;
+
+    // No worth trying to figure out the various shutdown issues.
+    _exit(0);
+}
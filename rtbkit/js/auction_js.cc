@@ -129,7 +129,7 @@ struct AuctionJS
                   const v8::AccessorInfo & info)
     {
         try {
-            return JS::toJS(getShared(info.This())->requestStr);
+            return JS::toJS(getShared(info.This())->requestStr.str());
         } HANDLE_JS_EXCEPTIONS;
     }
 
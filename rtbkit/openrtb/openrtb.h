@@ -835,7 +835,7 @@ struct Context {
     Datacratic::List<ContentCategory> pagecat;    ///< IAB content categories for page/view
     Datacratic::TaggedBool privacypolicy;           ///< Has a privacy policy
     Datacratic::Optional<Publisher> publisher;    ///< Publisher of the site or app
-    Datacratic::Optional<Content> content;        ///< Content of the site or app
+    Datacratic::Lazy<Datacratic::Optional<Content> > content; ///< Content of the site or app, decoded on first access
     Datacratic::CSList keywords;                    ///< Keywords describing app
     Json::Value ext;
 };
@@ -1065,7 +1065,7 @@ struct User {
     Datacratic::CSList keywords;           ///< List of keywords of consumer intent
     Datacratic::UnicodeString customdata;         ///< Custom data from exchange
     Datacratic::Optional<Geo> geo;                   ///< Geolocation of user at registration
-    std::vector<Data> data;         ///< User data segments
+    Datacratic::Lazy<std::vector<Data> > data; ///< User data segments, decoded on first access
     Json::Value ext;           ///< Extensions go here, new in OpenRTB 2.1
 
     /// Rubicon extensions
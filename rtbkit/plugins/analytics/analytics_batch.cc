@@ -0,0 +1,269 @@
+/** analytics_batch.cc
+    Copyright (c) 2016 Datacratic.  All rights reserved.
+
+    Binary frame holding a batch of analytics events.
+*/
+
+#include <cstring>
+
+#include "analytics_batch.h"
+#include "jml/arch/exception.h"
+#include "jml/arch/format.h"
+
+using namespace std;
+using namespace Datacratic;
+
+
+namespace RTBKIT {
+
+namespace {
+
+const char batchMagic[4] = { 'R', 'A', 'B', '1' };
+
+enum FieldType : uint8_t {
+    FT_STRING = 1,
+    FT_SIGNED = 2,
+    FT_UNSIGNED = 3,
+    FT_DOUBLE = 4,
+    FT_TIMESTAMP = 5
+};
+
+struct FrameReader {
+    FrameReader(const char * data, size_t size)
+        : p(data), end(data + size)
+    {
+    }
+
+    template<typename T>
+    T read()
+    {
+        T result;
+        need(sizeof(result));
+        memcpy(&result, p, sizeof(result));
+        p += sizeof(result);
+        return result;
+    }
+
+    std::string readString()
+    {
+        uint32_t length = read<uint32_t>();
+        need(length);
+        std::string result(p, length);
+        p += length;
+        return result;
+    }
+
+    void need(size_t bytes) const
+    {
+        if (size_t(end - p) < bytes)
+            throw ML::Exception("truncated analytics batch");
+    }
+
+    const char * p;
+    const char * end;
+};
+
+} // file scope
+
+
+/*****************************************************************************/
+/* ANALYTICS BATCH WRITER                                                    */
+/*****************************************************************************/
+
+AnalyticsBatchWriter::
+AnalyticsBatchWriter()
+    : numEvents(0), fieldsInEvent(0)
+{
+    frame.append(batchMagic, sizeof(batchMagic));
+    write<uint32_t>(0);
+}
+
+std::string
+AnalyticsBatchWriter::
+take()
+{
+    uint32_t count = numEvents;
+    memcpy(&frame[sizeof(batchMagic)], &count, sizeof(count));
+
+    std::string result;
+    result.swap(frame);
+
+    frame.reserve(result.size());
+    frame.append(batchMagic, sizeof(batchMagic));
+    write<uint32_t>(0);
+    numEvents = 0;
+
+    return result;
+}
+
+size_t
+AnalyticsBatchWriter::
+beginEvent()
+{
+    size_t start = frame.size();
+    write<uint32_t>(0);
+    fieldsInEvent = 0;
+    return start;
+}
+
+void
+AnalyticsBatchWriter::
+endEvent(size_t start)
+{
+    memcpy(&frame[start], &fieldsInEvent, sizeof(fieldsInEvent));
+    ++numEvents;
+}
+
+void
+AnalyticsBatchWriter::
+addField(const std::string & value)
+{
+    write<uint8_t>(FT_STRING);
+    write<uint32_t>(value.size());
+    frame.append(value);
+    ++fieldsInEvent;
+}
+
+void
+AnalyticsBatchWriter::
+addField(const char * value)
+{
+    size_t length = strlen(value);
+    write<uint8_t>(FT_STRING);
+    write<uint32_t>(length);
+    frame.append(value, length);
+    ++fieldsInEvent;
+}
+
+void
+AnalyticsBatchWriter::
+addField(const std::vector<std::string> & values)
+{
+    for (auto & value: values)
+        addField(value);
+}
+
+void
+AnalyticsBatchWriter::
+addField(const Json::Value & value)
+{
+    // Same as the zmq encoding, which removes the trailing newline
+    std::string str = value.toString();
+    while (!str.empty() && str[str.size() - 1] == '\n')
+        str.resize(str.size() - 1);
+    addField(str);
+}
+
+void
+AnalyticsBatchWriter::
+addField(const AnalyticsTimestamp & value)
+{
+    write<uint8_t>(FT_TIMESTAMP);
+    write<double>(value.date.secondsSinceEpoch());
+    write<uint8_t>(value.precision);
+    ++fieldsInEvent;
+}
+
+void
+AnalyticsBatchWriter::
+addField(double value)
+{
+    write<uint8_t>(FT_DOUBLE);
+    write<double>(value);
+    ++fieldsInEvent;
+}
+
+void
+AnalyticsBatchWriter::
+addSigned(int64_t value)
+{
+    write<uint8_t>(FT_SIGNED);
+    write<int64_t>(value);
+    ++fieldsInEvent;
+}
+
+void
+AnalyticsBatchWriter::
+addUnsigned(uint64_t value)
+{
+    write<uint8_t>(FT_UNSIGNED);
+    write<uint64_t>(value);
+    ++fieldsInEvent;
+}
+
+
+/*****************************************************************************/
+/* DECODING                                                                  */
+/*****************************************************************************/
+
+const std::string AnalyticsBatchChannel = "ANALYTICS_BATCH";
+
+bool
+isAnalyticsBatch(const char * data, size_t size)
+{
+    return size >= sizeof(batchMagic) + sizeof(uint32_t)
+        && memcmp(data, batchMagic, sizeof(batchMagic)) == 0;
+}
+
+size_t
+decodeAnalyticsBatch(
+        const char * data, size_t size,
+        const std::function<void (std::vector<std::string> & event)> & onEvent)
+{
+    if (!isAnalyticsBatch(data, size))
+        throw ML::Exception("not an analytics batch");
+
+    FrameReader reader(data + sizeof(batchMagic), size - sizeof(batchMagic));
+    uint32_t numEvents = reader.read<uint32_t>();
+
+    std::vector<std::string> event;
+
+    for (uint32_t i = 0;  i < numEvents;  ++i) {
+        uint32_t numFields = reader.read<uint32_t>();
+
+        // Every field takes at least a type byte and a string length
+        reader.need(size_t(numFields) * (sizeof(uint8_t) + sizeof(uint32_t)));
+
+        event.clear();
+        event.reserve(numFields);
+
+        for (uint32_t j = 0;  j < numFields;  ++j) {
+            uint8_t type = reader.read<uint8_t>();
+            switch (type) {
+            case FT_STRING:
+                event.emplace_back(reader.readString());
+                break;
+            case FT_SIGNED:
+                event.emplace_back(ML::format("%lld",
+                                              (long long)reader.read<int64_t>()));
+                break;
+            case FT_UNSIGNED:
+                event.emplace_back(ML::format("%llu",
+                                              (unsigned long long)reader.read<uint64_t>()));
+                break;
+            case FT_DOUBLE:
+                event.emplace_back(ML::format("%f", reader.read<double>()));
+                break;
+            case FT_TIMESTAMP: {
+                double seconds = reader.read<double>();
+                int precision = reader.read<uint8_t>();
+                event.emplace_back(Date::fromSecondsSinceEpoch(seconds)
+                                   .print(precision));
+                break;
+            }
+            default:
+                throw ML::Exception("unknown field type %d in analytics batch",
+                                    (int)type);
+            }
+        }
+
+        onEvent(event);
+    }
+
+    if (reader.p != reader.end)
+        throw ML::Exception("trailing data in analytics batch");
+
+    return numEvents;
+}
+
+} // namespace RTBKIT
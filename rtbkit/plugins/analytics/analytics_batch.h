@@ -0,0 +1,162 @@
+/** analytics_batch.h                                              -*- C++ -*-
+    Copyright (c) 2016 Datacratic.  All rights reserved.
+
+    Binary frame holding a batch of analytics events.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "soa/types/date.h"
+#include "soa/jsoncpp/value.h"
+
+namespace RTBKIT {
+
+
+/*****************************************************************************/
+/* ANALYTICS TIMESTAMP                                                       */
+/*****************************************************************************/
+
+/** Timestamp of an analytics event.  It is carried as a number in the batch
+    frames and only printed, with the given number of digits for the
+    seconds, when the frame is decoded.
+*/
+
+struct AnalyticsTimestamp {
+    AnalyticsTimestamp(Datacratic::Date date = Datacratic::Date::now(),
+                       int precision = 5)
+        : date(date), precision(precision)
+    {
+    }
+
+    std::string print() const { return date.print(precision); }
+
+    Datacratic::Date date;
+    int precision;
+};
+
+
+/*****************************************************************************/
+/* ANALYTICS BATCH WRITER                                                    */
+/*****************************************************************************/
+
+/** Accumulates analytics events into a single binary frame.
+
+    An event is a channel followed by a list of fields, which is what the
+    zmq analytics publishes as a multipart message.  Rather than being
+    formatted as text when the event happens, every field is written with
+    its type: strings, integers, doubles and timestamps.  The text is only
+    produced by decodeAnalyticsBatch(), on the other end, and is identical
+    to what the zmq encoding of the same fields gives.
+
+    The frame is made of a four byte magic number, the number of events and
+    then, for each event, its number of fields followed by the fields, each
+    one being a type byte and its value.  Numbers are written in the byte
+    order of the host.
+
+    This class is not thread safe.
+*/
+
+struct AnalyticsBatchWriter {
+
+    AnalyticsBatchWriter();
+
+    /** Add an event with the given channel and fields.  A vector of
+        strings is expanded into one field per element, as it is when
+        publishing over zmq.
+    */
+    template<typename... Args>
+    void add(const std::string & channel, Args &&... args)
+    {
+        size_t start = beginEvent();
+        addField(channel);
+        addFields(std::forward<Args>(args)...);
+        endEvent(start);
+    }
+
+    /** Number of events in the frame. */
+    size_t events() const { return numEvents; }
+
+    bool empty() const { return numEvents == 0; }
+
+    /** Size in bytes of the frame so far. */
+    size_t bytes() const { return frame.size(); }
+
+    /** Return the frame and start a new, empty one. */
+    std::string take();
+
+private:
+    size_t beginEvent();
+    void endEvent(size_t start);
+
+    void addFields()
+    {
+    }
+
+    template<typename Head, typename... Tail>
+    void addFields(Head && head, Tail &&... tail)
+    {
+        addField(head);
+        addFields(std::forward<Tail>(tail)...);
+    }
+
+    void addField(const std::string & value);
+    void addField(const char * value);
+    void addField(const std::vector<std::string> & values);
+    void addField(const Json::Value & value);
+    void addField(const AnalyticsTimestamp & value);
+    void addField(int value) { addSigned(value); }
+    void addField(long value) { addSigned(value); }
+    void addField(long long value) { addSigned(value); }
+    void addField(unsigned int value) { addUnsigned(value); }
+    void addField(unsigned long value) { addUnsigned(value); }
+    void addField(unsigned long long value) { addUnsigned(value); }
+    void addField(double value);
+
+    void addSigned(int64_t value);
+    void addUnsigned(uint64_t value);
+
+    template<typename T>
+    void write(const T & value)
+    {
+        frame.append((const char *)&value, sizeof(value));
+    }
+
+    std::string frame;
+    size_t numEvents;
+    uint32_t fieldsInEvent;
+};
+
+
+/*****************************************************************************/
+/* DECODING                                                                  */
+/*****************************************************************************/
+
+/** Name of the zmq channel on which the batch frames are published. */
+extern const std::string AnalyticsBatchChannel;
+
+/** Returns true if the data starts with the magic number of a batch frame. */
+bool isAnalyticsBatch(const char * data, size_t size);
+
+/** Decode a frame produced by AnalyticsBatchWriter, calling onEvent with
+    the channel and the fields of each event as strings, in order.  Returns
+    the number of events.  Throws an ML::Exception if the frame is
+    truncated or corrupt; the events before the problem will already have
+    been passed to onEvent.
+*/
+size_t decodeAnalyticsBatch(
+        const char * data, size_t size,
+        const std::function<void (std::vector<std::string> & event)> & onEvent);
+
+inline size_t decodeAnalyticsBatch(
+        const std::string & frame,
+        const std::function<void (std::vector<std::string> & event)> & onEvent)
+{
+    return decodeAnalyticsBatch(frame.c_str(), frame.size(), onEvent);
+}
+
+} // namespace RTBKIT
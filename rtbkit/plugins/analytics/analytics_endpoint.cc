@@ -9,14 +9,17 @@
 #include <functional>
 
 #include "analytics_endpoint.h"
+#include "analytics_batch.h"
 #include "soa/service/message_loop.h"
 #include "soa/service/http_client.h"
 #include "soa/service/rest_request_binding.h"
 #include "soa/jsoncpp/reader.h"
 #include "jml/arch/timers.h"
+#include "jml/arch/format.h"
 
 using namespace std;
 using namespace Datacratic;
+using namespace RTBKIT;
 
 /********************************************************************************/
 /* ANALYTICS REST ENDPOINT                                                      */
@@ -80,6 +83,21 @@ init()
                     JsonParam<string>("event", "event to publish")
             );
 
+    addRouteSyncReturn(versionNode,
+                    "/batch",
+                    {"POST","PUT"},
+                    "Add a binary batch of events to the logs.",
+                    "Returns the number of events that were logged.",
+                    [] (const string & r) {
+                        Json::Value response(Json::stringValue);
+                        response = r;
+                        return response;
+                    },
+                    &AnalyticsRestEndpoint::addBatch,
+                    this,
+                    StringPayload("frame produced by an AnalyticsBatchWriter")
+            );
+
     addRouteSyncReturn(versionNode,
                     "/channels",
                     {"GET"},
@@ -165,6 +183,33 @@ addEvent(const string & channel, const string & event) const
     return print(channel, event);
 }
 
+string
+AnalyticsRestEndpoint::
+addBatch(const string & frame) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(access);
+
+    size_t logged = 0;
+    auto onEvent = [&] (vector<string> & event)
+        {
+            auto it = channelFilter.find(event[0]);
+            if (it == channelFilter.end() || !it->second)
+                return;
+
+            string fields;
+            for (size_t i = 1;  i < event.size();  ++i) {
+                if (i > 1)
+                    fields += ' ';
+                fields += event[i];
+            }
+            print(event[0], fields);
+            ++logged;
+        };
+    decodeAnalyticsBatch(frame, onEvent);
+
+    return ML::format("%zd events logged", logged);
+}
+
 Json::Value
 AnalyticsRestEndpoint::
 listChannels() const
@@ -54,6 +54,8 @@ private:
     std::string addEvent(const std::string & channel,
                          const std::string & event) const;
 
+    std::string addBatch(const std::string & frame) const;
+
     std::string print(const std::string & channel,
                       const std::string & event) const;
 
@@ -0,0 +1,107 @@
+/* analytics_batch_test.cc
+   Copyright (c) 2016 Datacratic.  All rights reserved.
+
+   Tests for the binary frames of batched analytics events.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "rtbkit/plugins/analytics/analytics_batch.h"
+#include "jml/arch/exception.h"
+#include "jml/arch/format.h"
+
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+using namespace RTBKIT;
+
+namespace {
+
+std::vector<std::vector<std::string> > decode(const std::string & frame)
+{
+    std::vector<std::vector<std::string> > result;
+    size_t n = decodeAnalyticsBatch(frame,
+                                    [&] (std::vector<std::string> & event)
+                                    {
+                                        result.push_back(event);
+                                    });
+    BOOST_CHECK_EQUAL(n, result.size());
+    return result;
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_batch_round_trip )
+{
+    Date date = Date::fromSecondsSinceEpoch(1457366400.123456);
+    std::vector<std::string> message = { "first", "second" };
+    uint64_t bids = 12345678901234ULL;
+    float probability = 0.25;
+
+    AnalyticsBatchWriter writer;
+    BOOST_CHECK(writer.empty());
+
+    writer.add("BID", AnalyticsTimestamp(date), "agent", std::string("id"),
+               bids, -3, probability);
+    writer.add("ERROR", AnalyticsTimestamp(date, 3), message);
+    writer.add("EMPTY");
+    writer.add("JSON", Json::Value(12));
+    BOOST_CHECK_EQUAL(writer.events(), 4);
+
+    std::string frame = writer.take();
+    BOOST_CHECK(writer.empty());
+    BOOST_CHECK(isAnalyticsBatch(frame.c_str(), frame.size()));
+
+    auto events = decode(frame);
+    BOOST_REQUIRE_EQUAL(events.size(), 4);
+
+    // Same text as the zmq encoding of each field
+    std::vector<std::string> expected
+        = { "BID", date.print(5), "agent", "id", "12345678901234", "-3",
+            ML::format("%f", probability) };
+    BOOST_CHECK(events[0] == expected);
+
+    expected = { "ERROR", date.print(3), "first", "second" };
+    BOOST_CHECK(events[1] == expected);
+
+    expected = { "EMPTY" };
+    BOOST_CHECK(events[2] == expected);
+
+    expected = { "JSON", "12" };
+    BOOST_CHECK(events[3] == expected);
+
+    // The writer can be reused after a take
+    writer.add("WIN", "price");
+    events = decode(writer.take());
+    BOOST_REQUIRE_EQUAL(events.size(), 1);
+    BOOST_CHECK_EQUAL(events[0][1], "price");
+
+    BOOST_CHECK(decode(writer.take()).empty());
+}
+
+BOOST_AUTO_TEST_CASE( test_batch_corrupt )
+{
+    AnalyticsBatchWriter writer;
+    writer.add("BID", "agent", 12, 1.5);
+    std::string frame = writer.take();
+
+    BOOST_CHECK(!isAnalyticsBatch("BID", 3));
+    BOOST_CHECK_THROW(decode("not a batch frame"), ML::Exception);
+
+    // Every truncation of the frame is detected
+    for (size_t i = 8;  i < frame.size();  ++i)
+        BOOST_CHECK_THROW(decode(frame.substr(0, i)), ML::Exception);
+
+    BOOST_CHECK_THROW(decode(frame + "x"), ML::Exception);
+
+    // A field count that the frame can't hold is rejected before anything
+    // gets allocated for it
+    std::string corrupt = frame;
+    uint32_t numFields = -1;
+    corrupt.replace(8, sizeof(numFields), (const char *)&numFields,
+                    sizeof(numFields));
+    BOOST_CHECK_THROW(decode(corrupt), ML::Exception);
+}
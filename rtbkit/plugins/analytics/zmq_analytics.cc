@@ -10,6 +10,7 @@
 
 #include "soa/types/date.h"
 #include "jml/arch/format.h"
+#include "jml/utils/exc_assert.h"
 #include "rtbkit/core/router/router.h"
 #include "soa/types/id.h"
 #include "rtbkit/core/post_auction/events.h"
@@ -22,14 +23,29 @@ namespace RTBKIT {
 
 ZmqAnalytics::ZmqAnalytics(const std::string & service_name, std::shared_ptr<ServiceProxies> proxies)
     : Analytics(service_name+"/logger", proxies),
-      zmq_publisher_(getZmqContext())
+      zmq_publisher_(getZmqContext()),
+      batch_max_events_(0),
+      batch_max_delay_(0.0)
 {}
 
 ZmqAnalytics::~ZmqAnalytics() {}
 
+void ZmqAnalytics::setBatching(size_t maxEvents, double maxDelay)
+{
+    ExcAssertGreater(maxDelay, 0.0);
+    batch_max_events_ = maxEvents;
+    batch_max_delay_ = maxDelay;
+}
+
 void ZmqAnalytics::init()
 {
     zmq_publisher_.init(getServices()->config, serviceName());
+
+    if (batch_max_events_ > 0) {
+        zmq_publisher_.addPeriodic("ZmqAnalytics::flushBatch",
+                                   batch_max_delay_,
+                                   [=] (uint64_t) { flushBatch(); });
+    }
 }
 
 void ZmqAnalytics::bindTcp(const std::string & port_range)
@@ -44,9 +60,22 @@ void ZmqAnalytics::start()
 
 void ZmqAnalytics::shutdown()
 {
+    flushBatch();
     zmq_publisher_.shutdown();
 }
 
+void ZmqAnalytics::flushBatch()
+{
+    std::string frame;
+    {
+        std::lock_guard<std::mutex> guard(batch_lock_);
+        if (batch_.empty())
+            return;
+        frame = batch_.take();
+    }
+    zmq_publisher_.publish(AnalyticsBatchChannel, std::move(frame));
+}
+
 
 /**********************************************************************************************
 * USED IN ROUTER
@@ -55,15 +84,15 @@ void ZmqAnalytics::shutdown()
 void ZmqAnalytics::logMarkMessage(const Router & router,
                                   const double & last_check)
 {
-    zmq_publisher_.publish("MARK",
-                           Date::now().print(5),
-                           Date::fromSecondsSinceEpoch(last_check).print(),
-                           ML::format("active: %zd augmenting, %zd inFlight, "
-                                      "%zd agents",
-                                      router.augmentationLoop.numAugmenting(),
-                                      router.inFlight.size(),                                             
-                                      router.agents.size())
-                           );
+    publish("MARK",
+            AnalyticsTimestamp(),
+            AnalyticsTimestamp(Date::fromSecondsSinceEpoch(last_check), 0),
+            ML::format("active: %zd augmenting, %zd inFlight, "
+                       "%zd agents",
+                       router.augmentationLoop.numAugmenting(),
+                       router.numAuctionsInProgress(),
+                       router.agents.size())
+            );
 }
 
 void ZmqAnalytics::logBidMessage(const std::string & agent,
@@ -71,33 +100,33 @@ void ZmqAnalytics::logBidMessage(const std::string & agent,
                                  const std::string & bids,
                                  const std::string & meta) 
 {
-    zmq_publisher_.publish("BID",
-                           Date::now().print(5),
-                           agent,
-                           auctionId.toString(),
-                           bids,
-                           meta
-                           );
+    publish("BID",
+            AnalyticsTimestamp(),
+            agent,
+            auctionId.toString(),
+            bids,
+            meta
+            );
 }
 
 void ZmqAnalytics::logAuctionMessage(const Id & auctionId,
                                      const std::string & auctionRequest)
 {
-    zmq_publisher_.publish("AUCTION", 
-                           Date::now().print(5),
-                           auctionId.toString(),
-                           auctionRequest
-                           );
+    publish("AUCTION", 
+            AnalyticsTimestamp(),
+            auctionId.toString(),
+            auctionRequest
+            );
 }
 
 void ZmqAnalytics::logConfigMessage(const std::string & agent,
                                     const std::string & config)
 {
-    zmq_publisher_.publish("CONFIG",
-                           Date::now().print(5),
-                           agent,
-                           config
-                          );
+    publish("CONFIG",
+            AnalyticsTimestamp(),
+            agent,
+            config
+           );
 }
 
 void ZmqAnalytics::logNoBudgetMessage(const std::string agent,
@@ -105,13 +134,13 @@ void ZmqAnalytics::logNoBudgetMessage(const std::string agent,
                                       const std::string & bids,
                                       const std::string & meta)
 {
-    zmq_publisher_.publish("NOBUDGET",
-                           Date::now().print(5),
-                           agent,
-                           auctionId.toString(),
-                           bids,
-                           meta
-                          );
+    publish("NOBUDGET",
+            AnalyticsTimestamp(),
+            agent,
+            auctionId.toString(),
+            bids,
+            meta
+           );
 }
 
 void ZmqAnalytics::logMessage(const std::string & msg,
@@ -120,13 +149,13 @@ void ZmqAnalytics::logMessage(const std::string & msg,
                               const std::string & bids,
                               const std::string & meta)
 {
-    zmq_publisher_.publish(msg,
-                           Date::now().print(5),
-                           agent,
-                           auctionId.toString(),
-                           bids,
-                           meta
-                          );
+    publish(msg,
+            AnalyticsTimestamp(),
+            agent,
+            auctionId.toString(),
+            bids,
+            meta
+           );
 
 }
 
@@ -156,18 +185,18 @@ void ZmqAnalytics::logUsageMessage(Router & router,
                                      info.stats->bids);
         Router::AgentUsageMetrics delta = newMetrics - last;
 
-        zmq_publisher_.publish("USAGE",
-                               Date::now().print(5),
-                               "AGENT", 
-                               p, 
-                               item.first,
-                               info.config->account.toString(),
-                               delta.intoFilters,
-                               delta.passedStaticFilters,
-                               delta.passedDynamicFilters,
-                               delta.auctions,
-                               delta.bids,
-                               info.config->bidProbability);
+        publish("USAGE",
+                AnalyticsTimestamp(),
+                "AGENT", 
+                p, 
+                item.first,
+                info.config->account.toString(),
+                delta.intoFilters,
+                delta.passedStaticFilters,
+                delta.passedDynamicFilters,
+                delta.auctions,
+                delta.bids,
+                info.config->bidProbability);
         last = move(newMetrics);
     }
 
@@ -189,16 +218,16 @@ void ZmqAnalytics::logUsageMessage(Router & router,
         Router:: RouterUsageMetrics delta = newMetrics - router.lastRouterUsageMetrics;
 
 
-        zmq_publisher_.publish("USAGE",
-                               Date::now().print(5),
-                               "ROUTER", 
-                               p, 
-                               delta.numRequests,
-                               delta.numAuctions,
-                               delta.numNoPotentialBidders,
-                               delta.numBids,
-                               delta.numAuctionsWithBid,
-                               acceptAuctionProbability / numExchanges);
+        publish("USAGE",
+                AnalyticsTimestamp(),
+                "ROUTER", 
+                p, 
+                delta.numRequests,
+                delta.numAuctions,
+                delta.numNoPotentialBidders,
+                delta.numBids,
+                delta.numAuctionsWithBid,
+                acceptAuctionProbability / numExchanges);
 
         router.lastRouterUsageMetrics = move(newMetrics);
     }
@@ -207,23 +236,23 @@ void ZmqAnalytics::logUsageMessage(Router & router,
 void ZmqAnalytics::logErrorMessage(const std::string & error,
                                    const std::vector<std::string> & message)
 {
-    zmq_publisher_.publish("ERROR",
-                           Date::now().print(5),
-                           error,
-                           message
-                          );
+    publish("ERROR",
+            AnalyticsTimestamp(),
+            error,
+            message
+           );
 }
 
 void ZmqAnalytics::logRouterErrorMessage(const std::string & function,
                                          const std::string & exception, 
                                          const std::vector<std::string> & message)
 {
-    zmq_publisher_.publish("ROUTERERROR",
-                           Date::now().print(5),
-                           function,
-                           exception,
-                           message
-                          );
+    publish("ROUTERERROR",
+            AnalyticsTimestamp(),
+            function,
+            exception,
+            message
+           );
 }
 
 
@@ -233,9 +262,9 @@ void ZmqAnalytics::logRouterErrorMessage(const std::string & function,
 
 void ZmqAnalytics::logMatchedWinLoss(const MatchedWinLoss & matchedWinLoss) 
 {
-    zmq_publisher_.publish(
+    publish(
             "MATCHED" + matchedWinLoss.typeString(),                // 0
-            Date::now().print(5),                                   // 1
+            AnalyticsTimestamp(),                                   // 1
 
             matchedWinLoss.auctionId.toString(),                    // 2
             std::to_string(matchedWinLoss.impIndex),                // 3
@@ -275,9 +304,9 @@ void ZmqAnalytics::logMatchedWinLoss(const MatchedWinLoss & matchedWinLoss)
 
 void ZmqAnalytics::logMatchedCampaignEvent(const MatchedCampaignEvent & matchedCampaignEvent)
 {
-    zmq_publisher_.publish(
+    publish(
             "MATCHED" + matchedCampaignEvent.label,    // 0
-            Date::now().print(5),                      // 1
+            AnalyticsTimestamp(),                      // 1
 
             matchedCampaignEvent.auctionId.toString(), // 2
             matchedCampaignEvent.impId.toString(),     // 3
@@ -298,10 +327,10 @@ void ZmqAnalytics::logMatchedCampaignEvent(const MatchedCampaignEvent & matchedC
 
 void ZmqAnalytics::logUnmatchedEvent(const UnmatchedEvent & unmatchedEvent)
 {
-    zmq_publisher_.publish(
+    publish(
             // Use event type not label since label is only defined for campaign events.
             "UNMATCHED" + string(print(unmatchedEvent.event.type)),             // 0
-            Date::now().print(5),                                               // 1
+            AnalyticsTimestamp(),                                               // 1
 
             unmatchedEvent.reason,                                              // 2
             unmatchedEvent.event.auctionId.toString(),                          // 3
@@ -314,22 +343,22 @@ void ZmqAnalytics::logUnmatchedEvent(const UnmatchedEvent & unmatchedEvent)
 
 void ZmqAnalytics::logPostAuctionErrorEvent(const PostAuctionErrorEvent & postAuctionErrorEvent)
 {
-    zmq_publisher_.publish("PAERROR",
-                           Date::now().print(5),
-                           postAuctionErrorEvent.key,
-                           postAuctionErrorEvent.message);
+    publish("PAERROR",
+            AnalyticsTimestamp(),
+            postAuctionErrorEvent.key,
+            postAuctionErrorEvent.message);
 }
 
 void ZmqAnalytics::logPAErrorMessage(const std::string & function,
                                      const std::string & exception, 
                                      const std::vector<std::string> & message)
 {
-    zmq_publisher_.publish("PAERROR",
-                           Date::now().print(5),
-                           function,
-                           exception,
-                           message
-                          );
+    publish("PAERROR",
+            AnalyticsTimestamp(),
+            function,
+            exception,
+            message
+           );
 }
 
 
@@ -340,11 +369,11 @@ void ZmqAnalytics::logPAErrorMessage(const std::string & function,
 void ZmqAnalytics::logMockWinMessage(const std::string & eventAuctionId,
                                      const std::string & eventWinPrice)
 {
-    zmq_publisher_.publish("WIN",
-                           Date::now().print(3),
-                           eventAuctionId,
-                           eventWinPrice,
-                           "0");
+    publish("WIN",
+            AnalyticsTimestamp(Date::now(), 3),
+            eventAuctionId,
+            eventWinPrice,
+            "0");
 }
 
 /**********************************************************************************************
@@ -356,11 +385,11 @@ void ZmqAnalytics::logStandardWinMessage(const std::string & timestamp,
                                          const std::string & impId,
                                          const std::string & winPrice) 
 {
-    zmq_publisher_.publish("WIN",
-                           timestamp,
-                           bidRequestId,
-                           impId,
-                           winPrice);
+    publish("WIN",
+            timestamp,
+            bidRequestId,
+            impId,
+            winPrice);
 }
 
 void ZmqAnalytics::logStandardEventMessage(const std::string & eventType,
@@ -369,11 +398,11 @@ void ZmqAnalytics::logStandardEventMessage(const std::string & eventType,
                                            const std::string & impId,
                                            const std::string & userIds)
 {
-    zmq_publisher_.publish(eventType,
-                           timestamp,
-                           bidRequestId,
-                           impId,
-                           userIds);
+    publish(eventType,
+            timestamp,
+            bidRequestId,
+            impId,
+            userIds);
 }
 
 /**********************************************************************************************
@@ -384,10 +413,10 @@ void ZmqAnalytics::logAdserverEvent(const std::string & type,
                                     const std::string & bidRequestId,
                                     const std::string & impId)
 {
-    zmq_publisher_.publish(type,
-                           type,
-                           bidRequestId,
-                           impId);
+    publish(type,
+            type,
+            bidRequestId,
+            impId);
 }
 
 void ZmqAnalytics::logAdserverWin(const std::string & timestamp,
@@ -397,13 +426,13 @@ void ZmqAnalytics::logAdserverWin(const std::string & timestamp,
                                   const std::string & winPrice,
                                   const std::string & dataCost)
 {
-    zmq_publisher_.publish("WIN",
-                           timestamp,
-                           auctionId,
-                           adSpotId,
-                           accountKey,
-                           winPrice,
-                           dataCost);
+    publish("WIN",
+            timestamp,
+            auctionId,
+            adSpotId,
+            accountKey,
+            winPrice,
+            dataCost);
 }
 
 void ZmqAnalytics::logAuctionEventMessage(const std::string & event,
@@ -412,20 +441,20 @@ void ZmqAnalytics::logAuctionEventMessage(const std::string & event,
                                           const std::string & adSpotId,
                                           const std::string & userId)
 {
-    zmq_publisher_.publish(event,
-                           timestamp,
-                           auctionId,
-                           adSpotId,
-                           userId);
+    publish(event,
+            timestamp,
+            auctionId,
+            adSpotId,
+            userId);
 }
 
 void ZmqAnalytics::logEventJson(const std::string & event,
                                 const std::string & timestamp,
                                 const std::string & json)
 {
-    zmq_publisher_.publish(event,
-                           timestamp,
-                           json);
+    publish(event,
+            timestamp,
+            json);
 }
 
 void ZmqAnalytics::logDetailedWin(const std::string timestamp,
@@ -438,16 +467,16 @@ void ZmqAnalytics::logDetailedWin(const std::string timestamp,
                                   const std::string & strategy,
                                   const std::string & bidTimeStamp)
 {
-    zmq_publisher_.publish("WIN",
-                           timestamp,
-                           json,
-                           auctionId,
-                           spotId,
-                           price,
-                           userIds,
-                           campaign,
-                           strategy,
-                           bidTimeStamp);
+    publish("WIN",
+            timestamp,
+            json,
+            auctionId,
+            spotId,
+            price,
+            userIds,
+            campaign,
+            strategy,
+            bidTimeStamp);
 }
 
 } // namespace RTBKIT
@@ -463,6 +492,14 @@ struct AtInit {
             {
                 return new RTBKIT::ZmqAnalytics(service_name, std::move(proxies));
             });
+        PluginInterface<Analytics>::registerPlugin(
+            "zmq-batch",
+            [](const std::string & service_name, std::shared_ptr<ServiceProxies> proxies)
+            {
+                auto result = new RTBKIT::ZmqAnalytics(service_name, std::move(proxies));
+                result->setBatching(256, 0.001);
+                return result;
+            });
     }
 } atInit;
     
@@ -10,8 +10,10 @@
 #include <memory>
 #include <functional>
 #include <string>
+#include <mutex>
 
 #include "rtbkit/common/analytics.h"
+#include "rtbkit/plugins/analytics/analytics_batch.h"
 #include "soa/service/zmq_named_pub_sub.h"
 
 namespace RTBKIT {
@@ -28,12 +30,33 @@ namespace Datacratic {
 
 namespace RTBKIT {
 
+/** Timestamps are printed when they are published one event at a time. */
+inline zmq::message_t encodeMessage(const AnalyticsTimestamp & timestamp)
+{
+    return timestamp.print();
+}
+
+/** Publishes every event as a multipart zmq message on its channel.
+
+    When batching is enabled, the events are instead accumulated into an
+    AnalyticsBatchWriter frame which is published as a single message on
+    the AnalyticsBatchChannel once it holds maxEvents events, or after
+    maxDelay seconds, whichever comes first.  This saves a message and the
+    formatting of the numbers and timestamps per event; subscribers decode
+    the frames with decodeAnalyticsBatch().  The "zmq-batch" plugin is the
+    batched version of the "zmq" plugin.
+*/
 class ZmqAnalytics : public Analytics {
 
 public:
     ZmqAnalytics(const std::string & service_name, std::shared_ptr<Datacratic::ServiceProxies> proxies);
     virtual ~ZmqAnalytics(); 
 
+    /** Enable batching of the events.  Must be called before init().  A
+        maxEvents of zero disables batching.
+    */
+    void setBatching(size_t maxEvents, double maxDelay = 0.001);
+
     virtual void init();
     virtual void bindTcp(const std::string & port_range = "logs");
     virtual void start();
@@ -120,8 +143,37 @@ public:
                                 const std::string & bidTimeStamp);
 
 private:
+    template<typename... Args>
+    void publish(const std::string & channel, Args &&... args)
+    {
+        if (batch_max_events_ == 0) {
+            zmq_publisher_.publish(channel, std::forward<Args>(args)...);
+            return;
+        }
+
+        // The full frame is published outside of the lock so that the
+        // other threads can keep adding their events meanwhile.
+        std::string frame;
+        {
+            std::lock_guard<std::mutex> guard(batch_lock_);
+            batch_.add(channel, std::forward<Args>(args)...);
+            if (batch_.events() < batch_max_events_)
+                return;
+            frame = batch_.take();
+        }
+        zmq_publisher_.publish(AnalyticsBatchChannel, std::move(frame));
+    }
+
+    /** Publish the events accumulated so far, if any. */
+    void flushBatch();
+
     Datacratic::ZmqNamedPublisher zmq_publisher_;
 
+    size_t batch_max_events_;
+    double batch_max_delay_;
+    std::mutex batch_lock_;
+    AnalyticsBatchWriter batch_;
+
 }; // class ZmqEventLogger
 
 } // namespace RTBKIT
@@ -12,6 +12,7 @@
 #include "jml/utils/vector_utils.h"
 #include "jml/arch/futex.h"
 #include <memory>
+#include <cstring>
 
 
 using namespace std;
@@ -73,14 +74,32 @@ init(int numThreads)
             const AugmentationRequest& request = resp.first;
             const AugmentationList& response = resp.second;
 
-            toRouters.sendMessage(
-                    request.router,
-                    "RESPONSE",
-                    "1.0",
-                    request.startTime,
-                    request.id.toString(),
-                    request.augmentor,
-                    chomp(response.toJson().toString()));
+            bool binary;
+            {
+                std::lock_guard<std::mutex> guard(agentsLock);
+                binary = binaryRouters.count(request.router);
+            }
+
+            if (binary) {
+                toRouters.sendMessage(
+                        request.router,
+                        "RESPONSE",
+                        "1.1",
+                        binaryFrame(request.startTime),
+                        binaryFrame(request.id),
+                        request.augmentor,
+                        chomp(response.toJson().toString()));
+            }
+            else {
+                toRouters.sendMessage(
+                        request.router,
+                        "RESPONSE",
+                        "1.0",
+                        request.startTime,
+                        request.id.toString(),
+                        request.augmentor,
+                        chomp(response.toJson().toString()));
+            }
 
             recordHit("messages.RESPONSE");
         };
@@ -91,7 +110,27 @@ init(int numThreads)
 
     toRouters.connectHandler = [=] (const std::string & newRouter)
         {
-            toRouters.sendMessage(newRouter, "CONFIG", "1.0", augmentorName);
+            {
+                // The router starts a new agent index for each connection.
+                std::lock_guard<std::mutex> guard(agentsLock);
+                routerAgents.erase(newRouter);
+                binaryRouters.erase(newRouter);
+            }
+
+            if (cacheConfig.enabled() || !requestFields.empty()) {
+                Json::Value fields(Json::arrayValue);
+                for (const auto & field : requestFields)
+                    fields.append(field);
+
+                // -1 keeps the router's default maximum of requests in flight
+                toRouters.sendMessage(
+                        newRouter, "CONFIG", "1.0", augmentorName, "-1",
+                        cacheConfig.enabled() ?
+                            chomp(cacheConfig.toJson().toString()) : "",
+                        requestFields.empty() ?
+                            "" : chomp(fields.toString()));
+            }
+            else toRouters.sendMessage(newRouter, "CONFIG", "1.0", augmentorName);
             recordHit("messages.CONFIG");
         };
 
@@ -156,7 +195,8 @@ Augmentor::
 parseMessage(AugmentationRequest& request, Message& message)
 {
     const string & version = message.second.at(1);
-    ExcCheckEqual(version, "1.0", "unexpected version in augment");
+    ExcCheck(version == "1.0" || version == "1.1",
+             "unexpected version in augment");
 
     request.router = message.first;
     request.timeAvailableMs = 0.05;
@@ -167,14 +207,60 @@ parseMessage(AugmentationRequest& request, Message& message)
     const string & brStr = std::move(message.second.at(5));
     request.bidRequest.reset(BidRequest::parse(brSource, brStr));
 
-    istringstream agentsStr(message.second.at(6));
-    ML::DB::Store_Reader reader(agentsStr);
-    reader.load(request.agents);
+    if (version == "1.1")
+        parseAgentIndexes(request, message.second.at(6));
+    else {
+        istringstream agentsStr(message.second.at(6));
+        ML::DB::Store_Reader reader(agentsStr);
+        reader.load(request.agents);
+    }
 
     const string & startTimeStr = message.second.at(7);
     request.startTime = Date::fromSecondsSinceEpoch(strtod(startTimeStr.c_str(), 0));
 }
 
+void
+Augmentor::
+parseAgentIndexes(AugmentationRequest& request, const std::string& indexes)
+{
+    ExcCheckEqual(indexes.size() % sizeof(uint32_t), 0,
+                  "agent indexes have wrong size");
+
+    request.agents.clear();
+    request.agents.reserve(indexes.size() / sizeof(uint32_t));
+
+    std::lock_guard<std::mutex> guard(agentsLock);
+    const auto & agents = routerAgents[request.router];
+
+    for (size_t i = 0; i < indexes.size(); i += sizeof(uint32_t)) {
+        uint32_t index;
+        memcpy(&index, indexes.data() + i, sizeof(index));
+        ExcCheckLess(index, agents.size(), "unknown agent index");
+        request.agents.push_back(agents[index]);
+    }
+}
+
+void
+Augmentor::
+updateAgents(const std::string & router,
+             const std::vector<std::string> & message)
+{
+    const string & version = message.at(1);
+    ExcCheckEqual(version, "1.0", "unexpected version in agents");
+
+    size_t first = std::stoull(message.at(2));
+
+    std::vector<std::string> newAgents;
+    istringstream agentsStr(message.at(3));
+    ML::DB::Store_Reader reader(agentsStr);
+    reader.load(newAgents);
+
+    std::lock_guard<std::mutex> guard(agentsLock);
+    auto & agents = routerAgents[router];
+    agents.resize(first);
+    agents.insert(agents.end(), newAgents.begin(), newAgents.end());
+}
+
 void
 Augmentor::
 handleRouterMessage(const std::string & router, std::vector<std::string> & message)
@@ -184,7 +270,14 @@ handleRouterMessage(const std::string & router, std::vector<std::string> & messa
     const std::string & type = message.at(0);
     recordHit("messages." + type);
 
-    if (type == "CONFIGOK") {}
+    if (type == "CONFIGOK") {
+        if (message.size() > 1 && message[1] == "1.1") {
+            std::lock_guard<std::mutex> guard(agentsLock);
+            binaryRouters.insert(router);
+        }
+    }
+
+    else if (type == "AGENTS") updateAgents(router, message);
 
     else if (type == "AUGMENT") {
 
@@ -199,7 +292,7 @@ handleRouterMessage(const std::string & router, std::vector<std::string> & messa
             toRouters.sendMessage(
                     router,
                     "RESPONSE",
-                    message.at(1), // version
+                    "1.0",         // version
                     message.at(7), // startTime
                     message.at(3), // auctionId
                     message.at(2), // augmentor
@@ -9,6 +9,8 @@
 #define __rtb__augmentor_base_h__
 
 #include <atomic>
+#include <mutex>
+#include <set>
 
 #include "soa/service/service_base.h"
 #include "soa/service/zmq.hpp"
@@ -80,6 +82,27 @@ struct Augmentor : public ServiceBase, public MessageLoop {
     void respond(const AugmentationRequest & request,
                  const AugmentationList & response);
 
+    /** Lets the routers reuse a response for ttl seconds for any auction
+        with the same user ids in each of the given domains and the same
+        agents, instead of sending it to the augmentor.  Only suitable for
+        augmentors whose response depends on nothing else.  Must be called
+        before init().
+    */
+    void setRouterCache(double ttl, const std::vector<std::string> & keyDomains)
+    {
+        cacheConfig = AugmentationCacheConfig(ttl, keyDomains);
+    }
+
+    /** Asks the routers to only send the given fields of the bid requests,
+        as named by BidRequestProjection, instead of the whole request.  The
+        other fields of request.bidRequest are left to their default.  Must
+        be called before init().
+    */
+    void setRequestFields(const std::vector<std::string> & fields)
+    {
+        requestFields = fields;
+    }
+
     double sampleLoad() { return loopMonitor.sampleLoad().load; }
     double shedProbability() { return loadStabilizer.shedProbability(); }
 
@@ -91,6 +114,19 @@ protected:
 
 private:
     std::string augmentorName; // This can differ from the servicenName!
+    AugmentationCacheConfig cacheConfig;
+    std::vector<std::string> requestFields;
+
+    /** Names of the agents sent by each router in AGENTS messages, by index.
+        Written by the message loop and read by the workers.
+    */
+    std::mutex agentsLock;
+    std::map<std::string, std::vector<std::string> > routerAgents;
+
+    /** Routers that accept responses with binary frames, which they say in
+        their CONFIGOK.  Also guarded by agentsLock.
+    */
+    std::set<std::string> binaryRouters;
 
     ZmqMultipleNamedClientBusProxy toRouters;
 
@@ -111,6 +147,9 @@ private:
                              std::vector<std::string> & message);
 
     void parseMessage(AugmentationRequest& req, Message& msg);
+    void parseAgentIndexes(AugmentationRequest& req, const std::string& indexes);
+    void updateAgents(const std::string & router,
+                      const std::vector<std::string> & message);
 };
 
 
@@ -254,7 +254,7 @@ fromOpenRtb(OpenRTB::BidRequest && req,
 
     if (req.user) {
         result->user.reset(req.user.release());
-        for (auto & d: result->user->data) {
+        for (auto & d: *result->user->data) {
             string key;
             if (d.id)
                 key = d.id.toString();
@@ -415,9 +415,7 @@ OpenRTB::BidRequest
 OpenRtbBidRequestParser::
 parseBidRequest(const std::string & jsonValue)
 {
-    const char * strStart = jsonValue.c_str();
-    StreamingJsonParsingContext jsonContext(jsonValue, strStart,
-                                            strStart + jsonValue.size());
+    IndexedJsonParsingContext jsonContext(jsonValue, "bid request");
 
     OpenRTB::BidRequest req;
     desc.parseJson(&req, jsonContext);
@@ -115,9 +115,14 @@ OpenRTB::BidRequest
 OpenRTBBidRequestParser::
 parseBidRequest(const std::string & jsonValue)
 {
-    const char * strStart = jsonValue.c_str();
-    StreamingJsonParsingContext jsonContext(jsonValue, strStart,
-                                            strStart + jsonValue.size());
+    return parseBidRequest(jsonValue.data(), jsonValue.size());
+}
+
+OpenRTB::BidRequest
+OpenRTBBidRequestParser::
+parseBidRequest(const char * data, size_t size)
+{
+    IndexedJsonParsingContext jsonContext(data, size, "bid request");
 
     OpenRTB::BidRequest req;
     desc.parseJson(&req, jsonContext);
@@ -189,6 +194,18 @@ parseBidRequest(const std::string & json,
                                   exchange);
 }
 
+RTBKIT::BidRequest *
+OpenRTBBidRequestParser::
+parseBidRequest(const char * data, size_t size,
+                const std::string & provider,
+                const std::string & exchange)
+{
+    auto br = parseBidRequest(data, size);
+    return createBidRequestHelper(br,
+                                  provider,
+                                  exchange);
+}
+
 void 
 OpenRTBBidRequestParser::
 onBidRequest(OpenRTB::BidRequest & br) {
@@ -421,9 +438,9 @@ onContext(OpenRTB::Context & context) {
     if(context.publisher)
         this->onPublisher(*context.publisher);
 
-    // Content object
-    if(context.content)
-        this->onContent(*context.content);
+    // Content object.  It is left undecoded unless a subclass asked for it.
+    if(decodeContent && *context.content)
+        this->onContent(**context.content);
 
 }
 
@@ -586,8 +603,8 @@ onUser(OpenRTB::User & user) {
     }
 
     // Data object
-    if(!user.data.empty())
-        for(auto & d : user.data) {
+    if(!user.data->empty())
+        for(auto & d : *user.data) {
             this->onData(d);
         }
 
@@ -32,6 +32,7 @@ struct OpenRTBBidRequestParser
 {
 
     OpenRTB::BidRequest parseBidRequest(const std::string & jsonValue);
+    OpenRTB::BidRequest parseBidRequest(const char * data, size_t size);
     OpenRTB::BidRequest parseBidRequest(ML::Parse_Context & context);
 
     OpenRTB::BidRequest toBidRequest(const RTBKIT::BidRequest & br);
@@ -44,6 +45,12 @@ struct OpenRTBBidRequestParser
                                         const std::string & provider,
                                         const std::string & exchange);
 
+    /** Parses the JSON in the given range, which doesn't need to be null
+        terminated, without copying it. */
+    RTBKIT::BidRequest* parseBidRequest(const char * data, size_t size,
+                                        const std::string & provider,
+                                        const std::string & exchange);
+
     static std::unique_ptr<OpenRTBBidRequestParser>
         openRTBBidRequestParserFactory(const std::string & version);
 
@@ -52,6 +59,11 @@ struct OpenRTBBidRequestParser
         AdSpot spot;
     } ctx;
     
+    OpenRTBBidRequestParser()
+        : decodeContent(false)
+    {
+    }
+
     virtual ~OpenRTBBidRequestParser(){};
 
     protected :
@@ -75,6 +87,14 @@ struct OpenRTBBidRequestParser
 
         std::unordered_map<int, std::string> apiFrameworks;
 
+        /** The content of the site or app is rarely used, so it is only
+            decoded, and passed to onContent(), when this is set.  Otherwise
+            it stays in the bid request as the JSON text it was received as
+            until something accesses it.  Subclasses that override
+            onContent() need to set it.
+        */
+        bool decodeContent;
+
     private:
         RTBKIT::BidRequest * createBidRequestHelper(OpenRTB::BidRequest & br,
                                     const std::string & provider,
@@ -237,6 +237,11 @@ void testBidRequestRoundTrip(const std::string & filename,
     std::unique_ptr<BidRequest> br2(BidRequest::parse("rtbkit", s1));
 
     string s2 = br2->toJsonStr();
+
+    // The binary encoding carries exactly the same canonical request
+    std::unique_ptr<BidRequest> br3(BidRequest::parse("datacratic-bin",
+                                                      br->toBinaryStr()));
+    BOOST_CHECK_EQUAL(br3->toJsonStr(), s1);
     
     if (s1 != s2) {
         return;
@@ -444,6 +449,45 @@ BOOST_AUTO_TEST_CASE( benchmark_canonical_parsing )
          << done / elapsed << "/s" << endl;
 }
 
+BOOST_AUTO_TEST_CASE( benchmark_binary_parsing )
+{
+    cerr << "benchmarking binary parsing of OpenRTB-derived bid requests" << endl;
+
+    vector<string> reqs;
+
+    std::shared_ptr<OpenRTBBidRequestParser> p = OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.1");
+
+    size_t jsonBytes = 0, binaryBytes = 0;
+
+    for (auto s: samples) {
+        StreamingJsonParsingContext context;
+        context.init(s);
+        std::unique_ptr<BidRequest> br(p->parseBidRequest(*context.context, "openrtb", "openrtb"));   
+        reqs.push_back(br->toBinaryStr());
+        jsonBytes += br->toJsonStr().size();
+        binaryBytes += reqs.back().size();
+    }
+
+    cerr << "json " << jsonBytes << " bytes, binary " << binaryBytes
+         << " bytes" << endl;
+
+    int done = 0;
+    
+    Date before = Date::now();
+
+    for (unsigned i = 0;  i < 1000;  ++i) {
+        
+        for (unsigned i = 0;  i < reqs.size();  ++i, ++done) {
+            std::unique_ptr<BidRequest> br2(BidRequest::parse("datacratic-bin", reqs[i]));
+        }
+    }
+
+    double elapsed = Date::now().secondsSince(before);
+    
+    cerr << "did " << done << " in " << elapsed << "s at "
+         << done / elapsed << "/s" << endl;
+}
+
 BOOST_AUTO_TEST_CASE( id_provider ) {
 
     cerr << "id provider test : making sure we parse it correctly and always set it" << endl;
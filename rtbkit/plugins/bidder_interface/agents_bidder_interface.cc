@@ -27,9 +27,32 @@ void AgentsBidderInterface::sendAuctionMessage(std::shared_ptr<Auction> const &
     for(auto & item : bidders) {
         auto & agent = item.first;
         auto & spots = item.second.imp;
-        auto & info = router->agents[agent];
+        // Called from the auction shards, which hold allAgentsGc
+        const AgentInfo * agentInfo = router->findAgentInfo(agent);
+        if (!agentInfo) continue;
+        auto & info = *agentInfo;
         WinCostModel wcm = auction->exchangeConnector->getWinCostModel(*auction, *info.config);
 
+        // Nothing in the binary message needs to be parsed as text
+        if (info.binaryAuctions) {
+            auto send = [&] (const std::string & winCostModel)
+                {
+                    bridge->agents.sendMessage(
+                            agent,
+                            "AUCTION_BINARY",
+                            binaryFrame(auction->start),
+                            binaryFrame(auction->id),
+                            info.getBidRequestEncoding(*auction),
+                            info.encodeBidRequest(*auction),
+                            encodeBinarySpots(spots),
+                            binaryFrame(timeLeftMs),
+                            auction->agentAugmentationsBinary[agent],
+                            winCostModel);
+                };
+            info.winCostModels->encode(wcm, send);
+            continue;
+        }
+
         bridge->sendAgentMessage(agent,
                                  "AUCTION",
                                  auction->start,
@@ -16,6 +16,7 @@
 #include "jml/arch/futex.h"
 #include "soa/service/zmq_utils.h"
 #include "soa/service/process_stats.h"
+#include "soa/types/binary_json.h"
 
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
@@ -159,7 +160,10 @@ init()
             ss << "BiddingAgent is connected to router "
                  << connectedTo << endl;
             cerr << ss.str() ;
-            toRouters.sendMessage(connectedTo, "CONFIG", agentName);
+            // The router forgets the win cost models it sent us when we
+            // (re)connect and defines them again, replacing those we have.
+            // Version 1.1 asks for AUCTION_BINARY messages
+            toRouters.sendMessage(connectedTo, "CONFIG", agentName, "1.1");
         };
     toRouters.connectAllServiceProviders("rtbRequestRouter", "agents");
     toRouterChannel.onEvent = [=] (const RouterMessage & msg)
@@ -221,6 +225,7 @@ handleRouterMessage(const std::string & fromRouter,
     
     switch (hash(message[0])) {
         case hash_compile_time("AUCTION") : handleBidRequest(fromRouter, message, onBidRequest); break;
+        case hash_compile_time("AUCTION_BINARY") : handleBinaryBidRequest(fromRouter, message, onBidRequest); break;
         case hash_compile_time("WIN") :     handleResult(message, onWin); break;
         case hash_compile_time("LOSS") :    handleResult(message, onLoss); break;
         case hash_compile_time("LATEWIN") : handleResult(message, onLateWin ); break;
@@ -397,19 +402,62 @@ handleBidRequest(const std::string & fromRouter,
         bids.push_back(bid);
     }
 
-    recordHit("requests");
+    recordRequest(fromRouter, id);
 
-    {
-        lock_guard<mutex> guard (requestsLock);
-        ExcCheck(!requests.count(id), "seen multiple requests with same ID");
+    callback(timestamp, id, br, bids, timeLeftMs, augmentations, wcm);
+}
+
+void
+BiddingAgent::
+handleBinaryBidRequest(const std::string & fromRouter,
+                       const std::vector<std::string>& msg,
+                       BidRequestCbFn& callback)
+{
+    ExcCheck(!requiresAllCB || callback, "Null callback for " + msg[0]);
+    if (!callback) return;
+
+    checkMessageSize(msg, 9);
+
+    // See auction_message.h for the layout of the message
+    double timestamp
+        = ZmqFrameView(msg[1]).binary<Date>().secondsSinceEpoch();
+    Id id = ZmqFrameView(msg[2]).binary<Id>();
 
-        requests[id].timestamp = Date::now();
-        requests[id].fromRouter = fromRouter;
+    std::shared_ptr<BidRequest> br(BidRequest::parse(msg[3], msg[4]));
+
+    Bids bids = decodeBinarySpots(msg[5]);
+    double timeLeftMs = ZmqFrameView(msg[6]).binary<double>();
+
+    Json::Value augmentations;
+    if (!msg[7].empty()) {
+        BinaryJsonParsingContext context(msg[7].data(), msg[7].size());
+        augmentations = context.expectJson();
     }
 
+    WinCostModel wcm;
+    {
+        lock_guard<mutex> guard(winCostModelsLock);
+        wcm = winCostModels[fromRouter].decode(msg[8]);
+    }
+
+    recordRequest(fromRouter, id);
+
     callback(timestamp, id, br, bids, timeLeftMs, augmentations, wcm);
 }
 
+void
+BiddingAgent::
+recordRequest(const std::string & fromRouter, const Id & id)
+{
+    recordHit("requests");
+
+    lock_guard<mutex> guard (requestsLock);
+    ExcCheck(!requests.count(id), "seen multiple requests with same ID");
+
+    requests[id].timestamp = Date::now();
+    requests[id].fromRouter = fromRouter;
+}
+
 void
 BiddingAgent::
 handleResult(const std::vector<std::string>& msg, ResultCbFn& callback)
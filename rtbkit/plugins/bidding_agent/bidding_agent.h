@@ -14,6 +14,7 @@
 #include "rtbkit/common/bids.h"
 #include "rtbkit/common/auction_events.h"
 #include "rtbkit/common/win_cost_model.h"
+#include "rtbkit/common/auction_message.h"
 #include "soa/service/zmq.hpp"
 #include "soa/service/carbon_connector.h"
 #include "soa/jsoncpp/json.h"
@@ -276,6 +277,12 @@ private:
     std::map<Id, RequestStatus> requests;
     std::mutex requestsLock; // Protects concurrent writes to requests
 
+    /** Win cost models referenced by the binary auction messages of each
+        router.  They're forgotten when we (re)connect to the router.
+    */
+    std::map<std::string, WinCostModelDecoder> winCostModels;
+    std::mutex winCostModelsLock;
+
     bool requiresAllCB;
 
 
@@ -299,6 +306,9 @@ private:
     void handleError(const std::vector<std::string>& msg, ErrorCbFn& callback);
     void handleBidRequest(const std::string & fromRouter,
             const std::vector<std::string>& msg, BidRequestCbFn& callback);
+    void handleBinaryBidRequest(const std::string & fromRouter,
+            const std::vector<std::string>& msg, BidRequestCbFn& callback);
+    void recordRequest(const std::string & fromRouter, const Id & id);
     void handleWin(
             const std::vector<std::string>& msg, ResultCbFn& callback);
     void handleResult(
@@ -8,6 +8,7 @@
 
 
 #include "data_logger.h"
+#include "rtbkit/plugins/analytics/analytics_batch.h"
 
 
 using namespace std;
@@ -44,6 +45,17 @@ init()
     multipleSubscriber.init(getServices()->config);
     multipleSubscriber.messageHandler
         = [&] (vector<zmq::message_t> && msg) {
+        // Frames of batched analytics events are unpacked into the events
+        // they contain
+        if (msg.size() == 2 && msg[0].toString() == AnalyticsBatchChannel) {
+            decodeAnalyticsBatch((const char *)msg[1].data(), msg[1].size(),
+                                 [&] (vector<string> & event)
+                                 {
+                                     this->logMessageNoTimestamp(event);
+                                 });
+            return;
+        }
+
         // forward to logger class
         vector<string> s;
         s.reserve(msg.size());
@@ -347,20 +347,18 @@ parseAdtruthObject(const Json::Value& adt) {
 
 std::shared_ptr<BidRequest>
 BidSwitchExchangeConnector::
-parseBidRequest(HttpAuctionHandler & connection,
-                const HttpHeader & header,
-                const std::string & payload) {
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request) {
     std::shared_ptr<BidRequest> res;
     //
     // Check for JSON content-type
-    if (header.contentType != "application/json") {
+    if (request.contentType != "application/json") {
         connection.sendErrorResponse("non-JSON request");
         return res;
     }
 
     // Parse the bid request
-    ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.2")->parseBidRequest(context, exchangeName(), exchangeName()));
+    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.2")->parseBidRequest(request.body.data, request.body.size, exchangeName(), exchangeName()));
 
     //Parsing "ssp" filed
     if (res!=nullptr){
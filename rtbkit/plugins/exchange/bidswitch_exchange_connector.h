@@ -35,22 +35,14 @@ struct BidSwitchExchangeConnector: public OpenRTBExchangeConnector {
     }
 
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler & connection,
-                    const HttpHeader & header,
-                    const std::string & payload);
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
 
     virtual double
-    getTimeAvailableMs(HttpAuctionHandler & connection,
-                       const HttpHeader & header,
-                       const std::string & payload) {
-        // Scan the payload quickly for the tmax parameter.
-        static const std::string toFind = "\"tmax\":";
-        std::string::size_type pos = payload.find(toFind);
-        if (pos == std::string::npos)
-            return 30.0; //ms as specified by the SLA 
-    
-        int tmax = atoi(payload.c_str() + pos + toFind.length());
-        return (absoluteTimeMax < tmax) ? absoluteTimeMax : tmax;
+    getTimeAvailableMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request) {
+        return scanTimeAvailableMs(request.body,
+                                   30.0); //ms as specified by the SLA
     }
 
     /** This is the information that the BidSwitch exchange needs to keep
@@ -68,10 +68,9 @@ void CasaleExchangeConnector::init()
 }
 
 double
-CasaleExchangeConnector::getTimeAvailableMs(
+CasaleExchangeConnector::getTimeAvailableMsView(
         HttpAuctionHandler &handler,
-        const HttpHeader& header,
-        const std::string& payload) {
+        const HttpRequestView& request) {
 
     return Default::MaximumResponseTime;
 }
@@ -131,10 +130,9 @@ CasaleExchangeConnector::getCreativeCompatibility(
 }
 
 std::shared_ptr<BidRequest>
-CasaleExchangeConnector::parseBidRequest(
+CasaleExchangeConnector::parseBidRequestView(
         HttpAuctionHandler& handler,
-        const HttpHeader& header,
-        const std::string& payload)
+        const HttpRequestView& request)
 {
     /* According to the documentation:
      *
@@ -144,15 +142,16 @@ CasaleExchangeConnector::parseBidRequest(
      * 2.1 should be backward-compatible, we "fake" the version and patch it to 2.1 so that
      * we do not throw
      */
-    HttpHeader patchedHeaders(header);
-    auto it = patchedHeaders.headers.find("x-openrtb-version");
-    if (it != std::end(patchedHeaders.headers) && it->second == "2.0") {
-        it->second = "2.1";
+    auto version = request.findHeader("x-openrtb-version");
+    if (version == "2.0") {
+        version = HttpStringView("2.1", 3);
     }
 
-    auto request = OpenRTBExchangeConnector::parseBidRequest(handler, patchedHeaders, payload);
-
-    return request;
+    return parseOpenRTBBidRequest(handler,
+                                  request.contentType,
+                                  version,
+                                  request.findHeader("x-openrtb-verbose"),
+                                  request.body);
 
 }
 
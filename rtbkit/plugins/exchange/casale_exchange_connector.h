@@ -45,13 +45,11 @@ struct CasaleExchangeConnector : public OpenRTBExchangeConnector {
             bool includeReasons) const;
 
     std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler& handler,
-                    const HttpHeader& header,
-                    const std::string& payload);
+    parseBidRequestView(HttpAuctionHandler& handler,
+                        const HttpRequestView& request);
 
-    double getTimeAvailableMs(HttpAuctionHandler& handler,
-                              const HttpHeader& header,
-                              const std::string& payload);
+    double getTimeAvailableMsView(HttpAuctionHandler& handler,
+                                  const HttpRequestView& request);
 
     struct CreativeInfo {
         std::string adm;
@@ -142,11 +142,11 @@ getResponse(const HttpAuctionHandler & connection,
     }
 
     static Datacratic::DefaultDescription<FBX::BidResponse> desc;
-    std::ostringstream stream;
-    StreamJsonPrintingContext context(stream);
+    std::string body;
+    StringJsonPrintingContext context(body);
     desc.printJsonTyped(&response, context);
 
-    return HttpResponse(200, "application/json", stream.str());
+    return HttpResponse(200, "application/json", std::move(body));
 }
 
 } // namespace RTBKIT
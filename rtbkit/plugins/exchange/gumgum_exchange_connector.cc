@@ -136,8 +136,7 @@ parseBidRequest(HttpAuctionHandler & connection,
     cerr << "got request" << endl << header << endl << payload << endl;
 
     // Parse the bid request
-    ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(context, exchangeName(), exchangeName()));
+    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(payload, exchangeName(), exchangeName()));
         
     cerr << res->toJson() << endl;
 
@@ -256,13 +255,13 @@ getResponse(const HttpAuctionHandler & connection,
         return HttpResponse(204, "none", "");
 
     static Datacratic::DefaultDescription<OpenRTB::BidResponse> desc;
-    std::ostringstream stream;
-    StreamJsonPrintingContext context(stream);
+    std::string body;
+    StringJsonPrintingContext context(body);
     desc.printJsonTyped(&response, context);
 
-    cerr << Json::parse(stream.str());
+    cerr << Json::parse(body);
 
-    return HttpResponse(200, "application/json", stream.str());
+    return HttpResponse(200, "application/json", std::move(body));
 }
 
 HttpResponse
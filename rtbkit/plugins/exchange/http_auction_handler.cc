@@ -178,7 +178,7 @@ void
 HttpAuctionHandler::
 handleDisconnect()
 {
-    doEvent("auctionDisconnection");
+    endpoint->auctionEvents.disconnection.record();
 
     disconnected = true;
 
@@ -206,7 +206,7 @@ handleTimeout(Date date, size_t cookie)
     }
 
     if (auction_->finish()) {
-        doEvent("auctionTimeout");
+        endpoint->auctionEvents.timeout.record();
         if (this->endpoint->onTimeout)
             this->endpoint->onTimeout(auction, date);
     }
@@ -237,7 +237,7 @@ onDisassociate()
        anything. */
     if (auction && !auction->tooLate()) {
         auction->isZombie = true;
-        doEvent("disconnectWithActiveAuction");
+        endpoint->auctionEvents.disconnectWithActiveAuction.record();
         //transport().activities.dump();
         //cerr << "disassociation of HttpAuctionHandler " << this
         //     << " when auction not finished"
@@ -276,6 +276,64 @@ incNumServingRequest()
     ML::atomic_add(endpoint->numServingRequest, 1);
 }
 
+namespace {
+
+HttpStringView
+stringView(const std::string & str)
+{
+    return HttpStringView(str.data(), str.size());
+}
+
+/** Views of a request that was accumulated into an HttpHeader and payload.
+    The header doesn't keep the query in its encoded form, so it's written
+    into query, which must outlive the views.
+*/
+HttpRequestView
+requestViewOf(const HttpHeader & header, const std::string & payload,
+              std::string & query)
+{
+    HttpRequestView request;
+
+    request.verb = stringView(header.verb);
+    request.resource = stringView(header.resource);
+    request.version = stringView(header.version);
+
+    query = header.queryParams.uriEscaped();
+    if (!query.empty())
+        request.query = HttpStringView(query.data() + 1, query.size() - 1);
+
+    if (!header.contentType.empty()) {
+        request.contentType = stringView(header.contentType);
+        request.headers.emplace_back(HttpStringView("content-type", 12),
+                                     request.contentType);
+    }
+    for (const auto & field: header.headers)
+        request.headers.emplace_back(stringView(field.first),
+                                     stringView(field.second));
+
+    request.contentLength = payload.size();
+    request.body = stringView(payload);
+
+    return request;
+}
+
+} // file scope
+
+void
+HttpAuctionHandler::
+handleHttpRequest(const HttpRequestView & request)
+{
+    if (request.isChunked || logger
+        || request.resource != endpoint->auctionResource.c_str()
+        || request.verb != endpoint->auctionVerb.c_str()
+        || !request.findHeader("expect").empty()) {
+        HttpConnectionHandler::handleHttpRequest(request);
+        return;
+    }
+
+    handleAuctionRequest(request);
+}
+
 void
 HttpAuctionHandler::
 handleHttpPayload(const HttpHeader & header,
@@ -297,15 +355,44 @@ handleHttpPayload(const HttpHeader & header,
         logger->recordRequest(header, payload);
     }
 
+    std::string query;
+    handleAuctionRequest(requestViewOf(header, payload, query));
+}
+
+const HttpHeader &
+HttpAuctionHandler::
+requestHeader(const HttpRequestView & request)
+{
+    if (!headerDone) {
+        header.parse(request);
+        headerDone = true;
+    }
+    return header;
+}
+
+const std::string &
+HttpAuctionHandler::
+requestPayload(const HttpRequestView & request)
+{
+    if (request.body.data != payload.data())
+        payload.assign(request.body.data, request.body.size);
+    return payload;
+}
+
+void
+HttpAuctionHandler::
+handleAuctionRequest(const HttpRequestView & request)
+{
     ML::atomic_add(endpoint->numRequests, 1);
 
-    doEvent("auctionReceived");
-    doEvent("auctionBodyLength", ET_OUTCOME, payload.size(), "bytes");
+    auto & events = endpoint->auctionEvents;
+    events.received.record();
+    events.bodyLength.record(request.body.size);
 
     incNumServingRequest();
     servingRequest = true;
 
-    addActivityS("handleHttpPayload");
+    addActivityS("handleAuctionRequest");
 
     stopReading();
 
@@ -314,7 +401,7 @@ handleHttpPayload(const HttpHeader & header,
     Date now = Date::now();
 
     if (!endpoint->isEnabled(now)) {
-        doEvent("auctionEarlyDrop.notEnabled");
+        events.earlyDropNotEnabled.record();
         dropAuction("endpoint not enabled");
         return;
     }
@@ -323,32 +410,27 @@ handleHttpPayload(const HttpHeader & header,
     if (acceptProbability < 1.0
         && random() % 1000000 > 1000000 * acceptProbability) {
         // early drop...
-        doEvent("auctionEarlyDrop.randomEarlyDrop");
+        events.earlyDropRandom.record();
         if(!endpoint->disableAcceptProbability) {
             dropAuction("random early drop");
             return;
         }
     }
 
-    double timeAvailableMs = getTimeAvailableMs(header, payload);
-    double networkTimeMs = getRoundTripTimeMs(header);
+    double timeAvailableMs = getTimeAvailableMs(request);
+    double networkTimeMs = getRoundTripTimeMs(request);
 
-    doEvent("auctionStartLatencyMs",
-            ET_OUTCOME,
-            now.secondsSince(endpoint->getStartTime()) * 1000.0, "ms");
+    events.startLatencyMs.record(
+            now.secondsSince(endpoint->getStartTime()) * 1000.0);
 
-    doEvent("auctionTimeAvailableMs",
-            ET_OUTCOME,
-            timeAvailableMs, "ms");
+    events.timeAvailableMs.record(timeAvailableMs);
 
 
     if (timeAvailableMs - networkTimeMs < 5.0) {
         // Do an early drop of the bid request without even creating an
         // auction
 
-        doEvent("auctionEarlyDrop.timeLeftMs",
-                ET_OUTCOME,
-                timeAvailableMs, "ms");
+        events.earlyDropTimeLeftMs.record(timeAvailableMs);
 
         doEvent(ML::format("auctionEarlyDrop.peer.%s",
                                transport().getPeerName().c_str()).c_str());
@@ -388,13 +470,13 @@ handleHttpPayload(const HttpHeader & header,
 
     try {
 
-        auto preStatus = endpoint->preBidRequest(header, payload);
+        auto preStatus = endpoint->preBidRequest(*this, request);
         if (preStatus == PipelineStatus::Stop) {
             dropAuction("pre bid request pipeline");
             return;
         }
 
-        auto bidRequest = parseBidRequest(header, payload);
+        auto bidRequest = parseBidRequest(request);
 
         if (!bidRequest) {
             endpoint->recordHit("error.noBidRequest");
@@ -403,13 +485,17 @@ handleHttpPayload(const HttpHeader & header,
             return;
         }
 
+        // Most requests never make it through the filters so the
+        // stringified request is only generated when something reads it.
+        LazyString requestStr([=] { return bidRequest->toJsonStr(); });
+
         auction.reset(new Auction(endpoint,
                                   handleAuction, bidRequest,
-                                  bidRequest->toJsonStr(),
+                                  std::move(requestStr),
                                   "datacratic",
                                   firstData, expiry));
 
-        auction->requestOriginal = payload;
+        auction->requestOriginal.assign(request.body.data, request.body.size);
         endpoint->adjustAuction(auction);
 
         auto postStatus = endpoint->postBidRequest(auction);
@@ -422,14 +508,14 @@ handleHttpPayload(const HttpHeader & header,
 #if 0
         static std::mutex lock;
         std::unique_lock<std::mutex> guard(lock);
-        cerr << "bytes before = " << payload.size() << " after "
+        cerr << "bytes before = " << request.body.size << " after "
              << auction->requestStr.size() << " ratio "
-             << 100.0 * auction->requestStr.size() / payload.size()
+             << 100.0 * auction->requestStr.size() / request.body.size
              << "%" << endl;
         string s = bidRequest->serializeToString();
-        cerr << "serialized bytes before = " << payload.size() << " after "
+        cerr << "serialized bytes before = " << request.body.size << " after "
              << s.size() << " ratio "
-             << 100.0 * s.size() / payload.size() << "%" << endl;
+             << 100.0 * s.size() / request.body.size << "%" << endl;
 #endif
 
     } catch (const std::exception & exc) {
@@ -440,22 +526,18 @@ handleHttpPayload(const HttpHeader & header,
         return;
     }
 
-    doEvent("auctionNetworkLatencyMs",
-            ET_OUTCOME,
-            (firstData.secondsSince(auction->request->timestamp)) * 1000.0,
-            "ms");
+    events.networkLatencyMs.record(
+            (firstData.secondsSince(auction->request->timestamp)) * 1000.0);
 
-    doEvent("auctionTotalStartLatencyMs",
-            ET_OUTCOME,
-            (now.secondsSince(auction->request->timestamp)) * 1000.0,
-            "ms");
+    events.totalStartLatencyMs.record(
+            (now.secondsSince(auction->request->timestamp)) * 1000.0);
 
-    doEvent("auctionStart");
+    events.start.record();
 
     addActivity("gotAuction %s", auction->id.toString().c_str());
     
     if (now > expiry) {
-        doEvent("auctionAlreadyExpired");
+        events.alreadyExpired.record();
 
         string msg = format("auction started after time already elapsed: "
                             "%s vs %s, available time = %.1fms, "
@@ -547,12 +629,10 @@ sendResponse()
                      << (auction ? auction->id.toString() : "NO AUCTION")
                      << endl;
 
-            this->doEvent("auctionResponseSent");
-            this->doEvent("auctionTotalTimeMs",
-                          ET_OUTCOME,
-                          Date::now().secondsSince(this->firstData) * 1000.0,
-                          "ms",
-                          { 90, 95, 98, 99 });
+            auto & events = this->endpoint->auctionEvents;
+            events.responseSent.record();
+            events.totalTimeMs.record(
+                    Date::now().secondsSince(this->firstData) * 1000.0);
 
             if (random() % 1000 == 0) {
                 this->transport().closeWhenHandlerFinished();
@@ -570,7 +650,7 @@ sendResponse()
     response.extraHeaders
         .push_back({"X-Processing-Time-Ms", to_string(timeTaken)});
 
-    putResponseOnWire(response, onSendFinished);
+    putResponseOnWire(std::move(response), onSendFinished);
 }
 
 void
@@ -625,25 +705,23 @@ getResponse() const
 
 std::shared_ptr<BidRequest>
 HttpAuctionHandler::
-parseBidRequest(const HttpHeader & header,
-                const std::string & payload)
+parseBidRequest(const HttpRequestView & request)
 {
-    return endpoint->parseBidRequest(*this, header, payload);
+    return endpoint->parseBidRequestView(*this, request);
 }
 
 double
 HttpAuctionHandler::
-getTimeAvailableMs(const HttpHeader & header,
-                   const std::string & payload)
+getTimeAvailableMs(const HttpRequestView & request)
 {
-    return endpoint->getTimeAvailableMs(*this, header, payload);
+    return endpoint->getTimeAvailableMsView(*this, request);
 }
 
 double
 HttpAuctionHandler::
-getRoundTripTimeMs(const HttpHeader & header)
+getRoundTripTimeMs(const HttpRequestView & request)
 {
-    return endpoint->getRoundTripTimeMs(*this, header);
+    return endpoint->getRoundTripTimeMsView(*this, request);
 }
 
 } // namespace RTBKIT
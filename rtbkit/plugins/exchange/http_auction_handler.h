@@ -71,9 +71,26 @@ struct HttpAuctionHandler
     bool disconnected;
     bool servingRequest;  ///< Are we currently, actively serving a request?
 
+    /** Handles auctions straight out of the views of the request.  Other
+        requests, chunked ones and the ones that need to be logged go
+        through the HttpHeader and handleHttpPayload().
+    */
+    virtual void handleHttpRequest(const HttpRequestView & request);
+
     virtual void handleHttpPayload(const HttpHeader & header,
                                    const std::string & payload);
 
+    /** Header of the request, which is only parsed out of the views when
+        this is first called.  For the exchange connector methods that
+        still take an HttpHeader.
+    */
+    const HttpHeader & requestHeader(const HttpRequestView & request);
+
+    /** Body of the request, which is only copied out of the views when
+        this is first called.
+    */
+    const std::string & requestPayload(const HttpRequestView & request);
+
     /** Got a disconnection */
     virtual void handleDisconnect();
 
@@ -122,13 +139,12 @@ struct HttpAuctionHandler
     */
     virtual HttpResponse getResponse() const;
 
-    /** Parse the given payload into a bid request.
+    /** Parse the given request into a bid request.
 
         Default implementation forwards to the endpoint.
     */
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(const HttpHeader & header,
-                    const std::string & payload);
+    parseBidRequest(const HttpRequestView & request);
 
 
     /** Return the available time for the bid request in milliseconds.  This
@@ -140,8 +156,7 @@ struct HttpAuctionHandler
         Default implementation forwards to the endpoint.
     */
     virtual double
-    getTimeAvailableMs(const HttpHeader & header,
-                       const std::string & payload);
+    getTimeAvailableMs(const HttpRequestView & request);
 
     /** Return an estimate of how long a round trip with the connected
         server takes, in milliseconds at the exchange's latency percentile.
@@ -149,10 +164,14 @@ struct HttpAuctionHandler
         Default implementation forwards to the endpoint.
     */
     virtual double
-    getRoundTripTimeMs(const HttpHeader & header);
+    getRoundTripTimeMs(const HttpRequestView & request);
 
     static long created;
     static long destroyed;
+
+private:
+    /** Common code for the auctions, whichever way they came in. */
+    void handleAuctionRequest(const HttpRequestView & request);
 };
 
 
@@ -64,6 +64,7 @@ postConstructorInit()
     absoluteTimeMax = 50.0;
     disableAcceptProbability = false;
     disableExceptionPrinting = false;
+    hasPipeline = false;
 
     numServingRequest = 0;
 
@@ -125,8 +126,10 @@ configurePipeline(const Json::Value& config)
         Json::Value nullConfig;
         nullConfig["type"] = "null";
         this->pipeline = BidRequestPipeline::create("", getServices(), nullConfig);
+        this->hasPipeline = false;
     } else {
         this->pipeline = BidRequestPipeline::create("", getServices(), config);
+        this->hasPipeline = true;
     }
 }
 
@@ -161,6 +164,8 @@ void
 HttpExchangeConnector::
 start()
 {
+    internAuctionEvents();
+
     PassiveEndpoint::init(listenPort, bindHost, numThreads, true,
                           performNameLookup, backlog);
     if (realTimePriority > -1) {
@@ -168,6 +173,37 @@ start()
     }
 }
 
+void
+HttpExchangeConnector::
+internAuctionEvents()
+{
+    AuctionEvents & events = auctionEvents;
+
+    events.received = internEvent("auctionReceived", ET_COUNT);
+    events.bodyLength = internEvent("auctionBodyLength", ET_OUTCOME);
+    events.earlyDropNotEnabled
+        = internEvent("auctionEarlyDrop.notEnabled", ET_COUNT);
+    events.earlyDropRandom
+        = internEvent("auctionEarlyDrop.randomEarlyDrop", ET_COUNT);
+    events.earlyDropTimeLeftMs
+        = internEvent("auctionEarlyDrop.timeLeftMs", ET_OUTCOME);
+    events.startLatencyMs = internEvent("auctionStartLatencyMs", ET_OUTCOME);
+    events.timeAvailableMs = internEvent("auctionTimeAvailableMs", ET_OUTCOME);
+    events.networkLatencyMs
+        = internEvent("auctionNetworkLatencyMs", ET_OUTCOME);
+    events.totalStartLatencyMs
+        = internEvent("auctionTotalStartLatencyMs", ET_OUTCOME);
+    events.start = internEvent("auctionStart", ET_COUNT);
+    events.alreadyExpired = internEvent("auctionAlreadyExpired", ET_COUNT);
+    events.timeout = internEvent("auctionTimeout", ET_COUNT);
+    events.responseSent = internEvent("auctionResponseSent", ET_COUNT);
+    events.totalTimeMs
+        = internEvent("auctionTotalTimeMs", ET_OUTCOME, { 90, 95, 98, 99 });
+    events.disconnection = internEvent("auctionDisconnection", ET_COUNT);
+    events.disconnectWithActiveAuction
+        = internEvent("disconnectWithActiveAuction", ET_COUNT);
+}
+
 void
 HttpExchangeConnector::
 shutdown()
@@ -282,6 +318,41 @@ double
 HttpExchangeConnector::
 getRoundTripTimeMs(HttpAuctionHandler & connection,
                    const HttpHeader & header)
+{
+    return getPingTimeMs(connection);
+}
+
+std::shared_ptr<BidRequest>
+HttpExchangeConnector::
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request)
+{
+    return parseBidRequest(connection,
+                           connection.requestHeader(request),
+                           connection.requestPayload(request));
+}
+
+double
+HttpExchangeConnector::
+getTimeAvailableMsView(HttpAuctionHandler & connection,
+                       const HttpRequestView & request)
+{
+    return getTimeAvailableMs(connection,
+                              connection.requestHeader(request),
+                              connection.requestPayload(request));
+}
+
+double
+HttpExchangeConnector::
+getRoundTripTimeMsView(HttpAuctionHandler & connection,
+                       const HttpRequestView & request)
+{
+    return getRoundTripTimeMs(connection, connection.requestHeader(request));
+}
+
+double
+HttpExchangeConnector::
+getPingTimeMs(HttpAuctionHandler & connection) const
 {
     string peerName = connection.transport().getPeerName();
     
@@ -363,6 +434,17 @@ preBidRequest(const HttpHeader& header, const std::string& payload) {
     return pipeline->preBidRequest(this, header, payload);
 }
 
+PipelineStatus
+HttpExchangeConnector::
+preBidRequest(HttpAuctionHandler & connection,
+              const HttpRequestView & request) {
+    if (!hasPipeline)
+        return PipelineStatus::Continue;
+    return pipeline->preBidRequest(this,
+                                   connection.requestHeader(request),
+                                   connection.requestPayload(request));
+}
+
 PipelineStatus
 HttpExchangeConnector::
 postBidRequest(const std::shared_ptr<Auction>& auction) {
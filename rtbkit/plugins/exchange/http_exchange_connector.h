@@ -190,6 +190,28 @@ struct HttpExchangeConnector
     getRoundTripTimeMs(HttpAuctionHandler & connection,
                        const HttpHeader & header);
 
+    /** Versions of parseBidRequest(), getTimeAvailableMs() and
+        getRoundTripTimeMs() that work on the request as it was parsed in
+        the buffer of the connection, without copying its headers and body.
+        The views are only valid during the call.
+
+        These are the methods called for every auction.  The default
+        implementations convert the request into an HttpHeader and a
+        payload, once per request, and call the methods above, so that an
+        exchange only needs to override these to avoid the copies.
+    */
+    virtual std::shared_ptr<BidRequest>
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
+
+    virtual double
+    getTimeAvailableMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request);
+
+    virtual double
+    getRoundTripTimeMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request);
+
     /** Return the HTTP response for our auction.  Default
         implementation calls getResponse() and stringifies the result.
 
@@ -198,6 +220,9 @@ struct HttpExchangeConnector
 
         The first element returned is the HTTP body, the second is the
         content type.
+
+        The request header is empty unless the request had to be converted
+        into an HttpHeader (see parseBidRequestView()).
     */
     virtual HttpResponse
     getResponse(const HttpAuctionHandler & connection,
@@ -270,11 +295,24 @@ struct HttpExchangeConnector
     PipelineStatus
     preBidRequest(const HttpHeader& header, const std::string& payload);
 
+    /** Invokes the pre bid-request pipeline operation on a request that
+        hasn't been converted to an HttpHeader.  Without a configured
+        pipeline, there is nothing to convert it for.
+    */
+    PipelineStatus
+    preBidRequest(HttpAuctionHandler & connection,
+                  const HttpRequestView & request);
+
     /** Invokes the post bid-request pipeline operation */
     PipelineStatus
     postBidRequest(const std::shared_ptr<Auction>& auction);
 
 protected:
+    /** Ping time to the peer of the connection, as used by the default
+        getRoundTripTimeMs().
+    */
+    double getPingTimeMs(HttpAuctionHandler & connection) const;
+
     virtual std::shared_ptr<ConnectionHandler> makeNewHandler();
     virtual std::shared_ptr<HttpAuctionHandler> makeNewHandlerShared();
 
@@ -321,8 +359,34 @@ protected:
 private:
     friend class HttpAuctionHandler;
 
+    /** Events with a fixed name recorded by the auction handlers, interned
+        when the connector is started so that recording them on every
+        auction doesn't need to look them up by name.
+    */
+    struct AuctionEvents {
+        EventHandle received;
+        EventHandle bodyLength;
+        EventHandle earlyDropNotEnabled;
+        EventHandle earlyDropRandom;
+        EventHandle earlyDropTimeLeftMs;
+        EventHandle startLatencyMs;
+        EventHandle timeAvailableMs;
+        EventHandle networkLatencyMs;
+        EventHandle totalStartLatencyMs;
+        EventHandle start;
+        EventHandle alreadyExpired;
+        EventHandle timeout;
+        EventHandle responseSent;
+        EventHandle totalTimeMs;
+        EventHandle disconnection;
+        EventHandle disconnectWithActiveAuction;
+    } auctionEvents;
+
+    void internAuctionEvents();
+
     std::shared_ptr<HttpAuctionLogger> logger;
     std::shared_ptr<BidRequestPipeline> pipeline;
+    bool hasPipeline;     ///< Was a pipeline other than the null one set up?
 
     Lock handlersLock;
     std::set<std::shared_ptr<HttpAuctionHandler> > handlers;
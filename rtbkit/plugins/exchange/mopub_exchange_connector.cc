@@ -218,13 +218,12 @@ getCreativeCompatibility(const Creative & creative,
 }
 std::shared_ptr<BidRequest>
 MoPubExchangeConnector::
-parseBidRequest(HttpAuctionHandler & connection,
-                const HttpHeader & header,
-                const std::string & payload) {
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request) {
     std::shared_ptr<BidRequest> res;
 
     // Check for JSON content-type
-    if (header.contentType != "application/json") {
+    if (request.contentType != "application/json") {
         connection.sendErrorResponse("non-JSON request");
         return res;
     }
@@ -232,8 +231,7 @@ parseBidRequest(HttpAuctionHandler & connection,
     // Parse the bid request
     // TODO Check with MoPub if they send the x-openrtb-version header
     // and if they support 2.2 now.
-    ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.1")->parseBidRequest(context, exchangeName(), exchangeName()));
+    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.1")->parseBidRequest(request.body.data, request.body.size, exchangeName(), exchangeName()));
 
     // get restrictions enforced by MoPub.
     //1) blocked category
@@ -34,9 +34,8 @@ struct MoPubExchangeConnector: public OpenRTBExchangeConnector {
     }
 
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler & connection,
-                    const HttpHeader & header,
-                    const std::string & payload);
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
 
 #if 0
     virtual HttpResponse
@@ -46,9 +45,8 @@ struct MoPubExchangeConnector: public OpenRTBExchangeConnector {
 #endif
 
     virtual double
-    getTimeAvailableMs(HttpAuctionHandler & connection,
-                       const HttpHeader & header,
-                       const std::string & payload) {
+    getTimeAvailableMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request) {
         // TODO: check that is at it seems
         return 200.0;
     }
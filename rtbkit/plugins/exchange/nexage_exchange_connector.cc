@@ -181,13 +181,12 @@ getCreativeCompatibility(const Creative & creative,
 
 std::shared_ptr<BidRequest>
 NexageExchangeConnector::
-parseBidRequest(HttpAuctionHandler & connection,
-                const HttpHeader & header,
-                const std::string & payload) {
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request) {
     std::shared_ptr<BidRequest> res;
 //
     // Check for JSON content-type
-    if (header.contentType != "application/json") {
+    if (request.contentType != "application/json") {
         connection.sendErrorResponse("non-JSON request");
         return res;
     }
@@ -195,8 +194,7 @@ parseBidRequest(HttpAuctionHandler & connection,
     // Parse the bid request
     // Nexage used not to send x-openrtb-version but they're now at 2.2
     // source : http://www.nexage.com/resource-center/openrtb-2-2-technical-reference/
-    ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.2")->parseBidRequest(context, exchangeName(), exchangeName()));
+    res.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory("2.2")->parseBidRequest(request.body.data, request.body.size, exchangeName(), exchangeName()));
 
     return res;
 }
@@ -35,9 +35,8 @@ struct NexageExchangeConnector: public OpenRTBExchangeConnector {
     void init();
 
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler & connection,
-                    const HttpHeader & header,
-                    const std::string & payload);
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
 
 #if 0
     virtual HttpResponse
@@ -47,9 +46,8 @@ struct NexageExchangeConnector: public OpenRTBExchangeConnector {
 #endif
 
     virtual double
-    getTimeAvailableMs(HttpAuctionHandler & connection,
-                       const HttpHeader & header,
-                       const std::string & payload) {
+    getTimeAvailableMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request) {
         return 150.0;
     }
 
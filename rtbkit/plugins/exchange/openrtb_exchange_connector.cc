@@ -14,6 +14,7 @@
 #include "soa/types/json_printing.h"
 #include <boost/any.hpp>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include "jml/utils/file_functions.h"
 #include "jml/arch/info.h"
 #include "jml/utils/rng.h"
@@ -95,29 +96,65 @@ OpenRTBExchangeConnector(const std::string & name,
 {
 }
 
+namespace {
+
+HttpStringView
+findHeader(const HttpHeader & header, const std::string & name)
+{
+    auto it = header.headers.find(name);
+    if (it == header.headers.end())
+        return HttpStringView();
+    return HttpStringView(it->second.data(), it->second.size());
+}
+
+} // file scope
+
 std::shared_ptr<BidRequest>
 OpenRTBExchangeConnector::
 parseBidRequest(HttpAuctionHandler & connection,
                 const HttpHeader & header,
                 const std::string & payload)
+{
+    return parseOpenRTBBidRequest(
+            connection,
+            HttpStringView(header.contentType.data(),
+                           header.contentType.size()),
+            findHeader(header, "x-openrtb-version"),
+            findHeader(header, "x-openrtb-verbose"),
+            HttpStringView(payload.data(), payload.size()));
+}
+
+std::shared_ptr<BidRequest>
+OpenRTBExchangeConnector::
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request)
+{
+    return parseOpenRTBBidRequest(connection,
+                                  request.contentType,
+                                  request.findHeader("x-openrtb-version"),
+                                  request.findHeader("x-openrtb-verbose"),
+                                  request.body);
+}
+
+std::shared_ptr<BidRequest>
+OpenRTBExchangeConnector::
+parseOpenRTBBidRequest(HttpAuctionHandler & connection,
+                       const HttpStringView & contentType,
+                       const HttpStringView & openRtbVersionHeader,
+                       const HttpStringView & verbose,
+                       const HttpStringView & body)
 {
     std::shared_ptr<BidRequest> none;
 
     // Check for JSON content-type
-    if (!header.contentType.empty()) {
-        static const std::string delimiter = ";";
-
-        std::string::size_type posDelim = header.contentType.find(delimiter);
-        std::string content;
-
-        if(posDelim == std::string::npos)
-            content = header.contentType;
-        else {
-            content = header.contentType.substr(0, posDelim);
-            #if 0
-            std::string charset = header.contentType.substr(posDelim, header.contentType.length());
-            #endif
-        }
+    if (!contentType.empty()) {
+        // Ignore the charset that may follow
+        const char * posDelim
+            = (const char *) memchr(contentType.data, ';', contentType.size);
+        HttpStringView content(contentType.data,
+                               posDelim
+                               ? posDelim - contentType.data
+                               : contentType.size);
 
         if(content != "application/json") {
             connection.sendErrorResponse("UNSUPPORTED_CONTENT_TYPE", "The request is required to use the 'Content-Type: application/json' header");
@@ -130,20 +167,19 @@ parseBidRequest(HttpAuctionHandler & connection,
     }
 
     // Check for the x-openrtb-version header
-    auto it = header.headers.find("x-openrtb-version");
-    if (it == header.headers.end()) {
+    if (openRtbVersionHeader.empty()) {
         connection.sendErrorResponse("MISSING_OPENRTB_HEADER", "The request is missing the 'x-openrtb-version' header");
         return none;
     }
 
     // Check that it's version 2.1
-    std::string openRtbVersion = it->second;
+    std::string openRtbVersion = openRtbVersionHeader.str();
     if (openRtbVersion != "2.1" && openRtbVersion != "2.2") {
         connection.sendErrorResponse("UNSUPPORTED_OPENRTB_VERSION", "The request is required to be using version 2.1 or 2.2 of the OpenRTB protocol but requested " + openRtbVersion);
         return none;
     }
 
-    if(payload.empty()) {
+    if(body.empty()) {
         this->recordHit("error.emptyBidRequest");
         connection.sendErrorResponse("EMPTY_BID_REQUEST", "The request is empty");
         return none;
@@ -153,8 +189,7 @@ parseBidRequest(HttpAuctionHandler & connection,
     std::shared_ptr<BidRequest> result;
     try {
         JML_TRACE_EXCEPTIONS(!disableExceptionPrinting);
-        ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-        result.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(context,
+        result.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(body.data, body.size,
                                                                                               exchangeName(),
                                                                                               exchangeName()));
         result->protocolVersion = openRtbVersion;
@@ -168,13 +203,10 @@ parseBidRequest(HttpAuctionHandler & connection,
     }
 
     // Check if we want some reporting
-    auto verbose = header.headers.find("x-openrtb-verbose");
-    if(header.headers.end() != verbose) {
-        if(verbose->second == "1") {
-            if(!result->auctionId.notNull()) {
-                connection.sendErrorResponse("MISSING_ID", "The bid request requires the 'id' field");
-                return none;
-            }
+    if(verbose == "1") {
+        if(!result->auctionId.notNull()) {
+            connection.sendErrorResponse("MISSING_ID", "The bid request requires the 'id' field");
+            return none;
         }
     }
 
@@ -187,13 +219,53 @@ getTimeAvailableMs(HttpAuctionHandler & connection,
                    const HttpHeader & header,
                    const std::string & payload)
 {
-    // Scan the payload quickly for the tmax parameter.
-    static const std::string toFind = "\"tmax\":";
-    std::string::size_type pos = payload.find(toFind);
-    if (pos == std::string::npos)
-        return 30.0;
-    
-    int tmax = atoi(payload.c_str() + pos + toFind.length());
+    return scanTimeAvailableMs(HttpStringView(payload.data(), payload.size()),
+                               30.0);
+}
+
+double
+OpenRTBExchangeConnector::
+getTimeAvailableMsView(HttpAuctionHandler & connection,
+                       const HttpRequestView & request)
+{
+    return scanTimeAvailableMs(request.body, 30.0);
+}
+
+double
+OpenRTBExchangeConnector::
+getRoundTripTimeMsView(HttpAuctionHandler & connection,
+                       const HttpRequestView & request)
+{
+    return getPingTimeMs(connection);
+}
+
+double
+OpenRTBExchangeConnector::
+scanTimeAvailableMs(const HttpStringView & body, double defaultMs) const
+{
+    // Scan the payload quickly for the tmax parameter.  The body isn't null
+    // terminated so the number is read by hand.
+    static const char toFind[] = "\"tmax\":";
+    const char * end = body.data + body.size;
+    const char * pos = std::search(body.data, end,
+                                   toFind, toFind + sizeof(toFind) - 1);
+    if (pos == end)
+        return defaultMs;
+
+    pos += sizeof(toFind) - 1;
+    while (pos != end && isspace(*pos))
+        ++pos;
+
+    bool negative = pos != end && *pos == '-';
+    if (negative)
+        ++pos;
+
+    int tmax = 0;
+    for (;  pos != end && isdigit(*pos);  ++pos)
+        tmax = tmax * 10 + (*pos - '0');
+    if (negative)
+        tmax = -tmax;
+
     return (absoluteTimeMax < tmax) ? absoluteTimeMax : tmax;
 }
 
@@ -225,12 +297,19 @@ getResponse(const HttpAuctionHandler & connection,
     if (response.seatbid.empty())
         return HttpResponse(204, "none", "");
 
+    // The body is printed straight into the string that goes out with the
+    // response.  Reserving the size of the previous response on this thread
+    // means that it is usually printed without any reallocation.
+    static __thread size_t lastResponseSize = 0;
+
     static Datacratic::DefaultDescription<OpenRTB::BidResponse> desc;
-    std::ostringstream stream;
-    StreamJsonPrintingContext context(stream);
+    std::string body;
+    body.reserve(lastResponseSize);
+    StringJsonPrintingContext context(body);
     desc.printJsonTyped(&response, context);
+    lastResponseSize = body.size();
 
-    return HttpResponse(200, "application/json", stream.str());
+    return HttpResponse(200, "application/json", std::move(body));
 }
 
 Json::Value
@@ -43,6 +43,24 @@ struct OpenRTBExchangeConnector : public HttpExchangeConnector {
                        const HttpHeader & header,
                        const std::string & payload);
 
+    /** The OpenRTB exchanges work straight on the views of the request.  A
+        subclass that overrides parseBidRequest(), getTimeAvailableMs() or
+        getRoundTripTimeMs() needs to override the matching view method as
+        well, as the methods that take an HttpHeader aren't called for
+        auctions anymore.
+    */
+    virtual std::shared_ptr<BidRequest>
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
+
+    virtual double
+    getTimeAvailableMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request);
+
+    virtual double
+    getRoundTripTimeMsView(HttpAuctionHandler & connection,
+                           const HttpRequestView & request);
+
     virtual HttpResponse
     getResponse(const HttpAuctionHandler & connection,
                 const HttpHeader & requestHeader,
@@ -65,6 +83,22 @@ private:
                    const Auction & auction) const;
 protected:
 
+    /** Checks the headers and parses the body of an OpenRTB bid request.
+        Empty views stand for missing headers.
+    */
+    std::shared_ptr<BidRequest>
+    parseOpenRTBBidRequest(HttpAuctionHandler & connection,
+                           const HttpStringView & contentType,
+                           const HttpStringView & openRtbVersionHeader,
+                           const HttpStringView & verbose,
+                           const HttpStringView & body);
+
+    /** Scans the body quickly for the tmax parameter, which is capped at
+        absoluteTimeMax.  Returns defaultMs if there is none.
+    */
+    double scanTimeAvailableMs(const HttpStringView & body,
+                               double defaultMs) const;
+
     virtual void setSeatBid(Auction const & auction,
                             int spotNum,
                             OpenRTB::BidResponse & response) const;
@@ -31,12 +31,11 @@ RTBKitExchangeConnector(const std::string &name,
 
 std::shared_ptr<BidRequest>
 RTBKitExchangeConnector::
-parseBidRequest(HttpAuctionHandler &connection,
-                const HttpHeader &header,
-                const std::string &payload)
+parseBidRequestView(HttpAuctionHandler &connection,
+                    const HttpRequestView &httpRequest)
 {
     auto request = 
-        OpenRTBExchangeConnector::parseBidRequest(connection, header, payload);
+        OpenRTBExchangeConnector::parseBidRequestView(connection, httpRequest);
 
 
     if (request != nullptr) {
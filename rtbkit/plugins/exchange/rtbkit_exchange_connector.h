@@ -172,9 +172,8 @@ struct RTBKitExchangeConnector : public OpenRTBExchangeConnector {
     }
 
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler &connection,
-                    const HttpHeader &header,
-                    const std::string &payload);
+    parseBidRequestView(HttpAuctionHandler &connection,
+                        const HttpRequestView &httpRequest);
 
     virtual void
     adjustAuction(std::shared_ptr<Auction>& auction) const;
@@ -13,6 +13,7 @@
 #include "soa/service/logs.h"
 #include <boost/any.hpp>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include "jml/utils/file_functions.h"
  
 using namespace std;
@@ -60,33 +61,28 @@ init()
  
 std::shared_ptr<BidRequest>
 SmaatoExchangeConnector::
-parseBidRequest(HttpAuctionHandler & connection,
-                const HttpHeader & header,
-                const std::string & payload)
+parseBidRequestView(HttpAuctionHandler & connection,
+                    const HttpRequestView & request)
 {
     std::shared_ptr<BidRequest> none;
 
-    size_t found = header.queryParams.uriEscaped().find(SmaatoExchangeConnector::nobid);
-    if (found != string::npos) {
+    const char * queryEnd = request.query.data + request.query.size;
+    if (std::search(request.query.data, queryEnd,
+                    nobid.begin(), nobid.end()) != queryEnd) {
       connection.dropAuction("nobid");
       return none;
     }   
 
     // Check for JSON content-type
-    if (!header.contentType.empty()) {
-        static const std::string delimiter = ";";
-
-        std::string::size_type posDelim = header.contentType.find(delimiter);
-        std::string content;
-
-        if(posDelim == std::string::npos)
-            content = header.contentType;
-        else {
-            content = header.contentType.substr(0, posDelim);
-            #if 0
-            std::string charset = header.contentType.substr(posDelim, header.contentType.length());
-            #endif
-        }
+    if (!request.contentType.empty()) {
+        // Ignore the charset that may follow
+        const char * posDelim
+            = (const char *) memchr(request.contentType.data, ';',
+                                    request.contentType.size);
+        HttpStringView content(request.contentType.data,
+                               posDelim
+                               ? posDelim - request.contentType.data
+                               : request.contentType.size);
 
         if(content != "application/json") {
             connection.sendErrorResponse("UNSUPPORTED_CONTENT_TYPE", "The request is required to use the 'Content-Type: application/json' header");
@@ -99,20 +95,20 @@ parseBidRequest(HttpAuctionHandler & connection,
     }
 
     // Check for the x-openrtb-version header
-    auto it = header.headers.find("x-openrtb-version");
-    if (it == header.headers.end()) {
+    auto version = request.findHeader("x-openrtb-version");
+    if (version.empty()) {
         connection.sendErrorResponse("MISSING_OPENRTB_HEADER", "The request is missing the 'x-openrtb-version' header");
         return none;
     }
 
     // Check that it's version 2.0
-    std::string openRtbVersion = it->second;
+    std::string openRtbVersion = version.str();
     if (openRtbVersion != "2.0") {
         connection.sendErrorResponse("UNSUPPORTED_OPENRTB_VERSION", "The request is required to be using version 2.0 of the OpenRTB protocol but requested " + openRtbVersion);
         return none;
     }
 
-    if(payload.empty()) {
+    if(request.body.empty()) {
         this->recordHit("error.emptyBidRequest");
         connection.sendErrorResponse("EMPTY_BID_REQUEST", "The request is empty");
         return none;
@@ -121,8 +117,7 @@ parseBidRequest(HttpAuctionHandler & connection,
     // Parse the bid request
     std::shared_ptr<BidRequest> result;
     try {
-        ML::Parse_Context context("Bid Request", payload.c_str(), payload.size());
-        result.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(context,
+        result.reset(OpenRTBBidRequestParser::openRTBBidRequestParserFactory(openRtbVersion)->parseBidRequest(request.body.data, request.body.size,
                                                                                               exchangeName(),
                                                                                               exchangeName()));
     }
@@ -135,13 +130,10 @@ parseBidRequest(HttpAuctionHandler & connection,
     }
 
     // Check if we want some reporting
-    auto verbose = header.headers.find("x-openrtb-verbose");
-    if(header.headers.end() != verbose) {
-        if(verbose->second == "1") {
-            if(!result->auctionId.notNull()) {
-                connection.sendErrorResponse("MISSING_ID", "The bid request requires the 'id' field");
-                return none;
-            }
+    if(request.findHeader("x-openrtb-verbose") == "1") {
+        if(!result->auctionId.notNull()) {
+            connection.sendErrorResponse("MISSING_ID", "The bid request requires the 'id' field");
+            return none;
         }
     }
     
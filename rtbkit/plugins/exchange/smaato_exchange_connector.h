@@ -32,19 +32,17 @@ struct SmaatoExchangeConnector: public OpenRTBExchangeConnector {
     }
 
     virtual std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler & connection,
-                    const HttpHeader & header,
-                    const std::string & payload);
+    parseBidRequestView(HttpAuctionHandler & connection,
+                        const HttpRequestView & request);
 
 
-    double getTimeAvailableMs(HttpAuctionHandler & handler,
-			      const HttpHeader & header,
-			      const std::string & payload) {
+    double getTimeAvailableMsView(HttpAuctionHandler & handler,
+				  const HttpRequestView & request) {
       return 100.0;
     }
  
-    double getRoundTripTimeMs(HttpAuctionHandler & handler,
-			      const HttpHeader & header) {
+    double getRoundTripTimeMsView(HttpAuctionHandler & handler,
+				  const HttpRequestView & request) {
       return 35.0;
     }
     
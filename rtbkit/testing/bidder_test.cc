@@ -301,10 +301,9 @@ struct DummyExchangeConnector : public OpenRTBExchangeConnector
     std::string exchangeName() const { return "dummy"; }
 
     std::shared_ptr<BidRequest>
-    parseBidRequest(HttpAuctionHandler& connection,
-                    const HttpHeader& header,
-                    const std::string& payload) {
-        auto request = OpenRTBExchangeConnector::parseBidRequest(connection, header, payload);
+    parseBidRequestView(HttpAuctionHandler& connection,
+                        const HttpRequestView& httpRequest) {
+        auto request = OpenRTBExchangeConnector::parseBidRequestView(connection, httpRequest);
 
         for (const auto& imp: request->imp) {
             BOOST_CHECK(imp.ext.isMember("creative-ids"));
@@ -187,6 +187,7 @@ CompressingOutput::
 CompressingOutput(size_t ringBufferSize,
                   Compressor::FlushLevel flushLevel)
     : WorkerThreadOutput(ringBufferSize),
+      compressionThreads(0),
       compressorFlushLevel(flushLevel)
 {
 }
@@ -205,7 +206,8 @@ open(std::shared_ptr<Sink> sink,
     if (compressor)
         throw ML::Exception("can't open compressor without closing the "
                             "previous one");
-    compressor.reset(Compressor::create(compression, compressionLevel));
+    compressor.reset(Compressor::create(compression, compressionLevel,
+                                        compressionThreads));
 
     this->sink = sink;
 
@@ -245,8 +247,11 @@ implementLogMessage(const std::string & channel,
     compressor->compress(buf, channel.size() + message.size() + 2,
                          onData);
 
-    // This should be done elsewhere or accessed via a flag
-    compressor->flush(compressorFlushLevel, onData);
+    // Only flush once we've caught up with the messages waiting, so that
+    // under load the compressor works on large blocks rather than on one
+    // message at a time.
+    if (!ringBuffer.couldPop())
+        compressor->flush(compressorFlushLevel, onData);
 }
 
 } // namespace Datacratic
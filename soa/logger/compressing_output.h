@@ -132,6 +132,12 @@ struct CompressingOutput : public WorkerThreadOutput {
 
     boost::function<void (std::string, std::size_t)> onFileWrite;
 
+    /** Number of blocks compressed in parallel by the compressors opened
+        from now on, for the schemes that support it (lz4).  Zero
+        compresses in the worker thread.
+    */
+    int compressionThreads;
+
 protected:
     Compressor::FlushLevel compressorFlushLevel;
     std::shared_ptr<Sink> sink;
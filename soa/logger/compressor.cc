@@ -7,7 +7,12 @@
 
 #include "compressor.h"
 #include "jml/utils/exc_assert.h"
+#include "jml/utils/lz4_filter.h"
+#include "jml/utils/worker_task.h"
 #include <zlib.h>
+#include <chrono>
+#include <deque>
+#include <future>
 #include <iostream>
 
 using namespace std;
@@ -45,16 +50,21 @@ filenameToCompression(const std::string & filename)
         return "bzip2";
     if (ends_with(filename, ".xz") || ends_with(filename, ".xz~"))
         return "lzma";
+    if (ends_with(filename, ".lz4") || ends_with(filename, ".lz4~"))
+        return "lz4";
     return "none";
 }
 
 Compressor *
 Compressor::
 create(const std::string & compression,
-       int level)
+       int level,
+       int threads)
 {
     if (compression == "gzip" || compression == "gz")
         return new GzipCompressor(level);
+    else if (compression == "lz4")
+        return new Lz4Compressor(level, threads);
     else if (compression == "" || compression == "none")
         return new NullCompressor();
     else throw ML::Exception("unknown compression %s:%d", compression.c_str(),
@@ -242,6 +252,213 @@ finish(const OnData & onData)
 }
 
 
+/*****************************************************************************/
+/* LZ4 COMPRESSOR                                                            */
+/*****************************************************************************/
+
+struct Lz4Compressor::Itl {
+
+    typedef int (*CompressFn) (const char *, char *, int);
+
+    /** Block of input, and once compressed, the bytes that go in the frame
+        for it.
+    */
+    struct Block {
+        std::string input;
+        std::string output;
+        std::promise<void> done;
+    };
+
+    Itl(int level, int threads, int blockSizeId)
+        : head(blockSizeId, true /* independent blocks */,
+               true /* block checksum */, false /* stream checksum */),
+          headerWritten(false),
+          compressFn(level < 3 ? LZ4_compress : LZ4_compressHC),
+          maxInFlight(threads)
+    {
+        if (blockSizeId < 4 || blockSizeId > 7)
+            throw ML::Exception("invalid lz4 block size id %d", blockSizeId);
+        buffer.reserve(head.blockSize());
+    }
+
+    static void compressBlock(Block & block, CompressFn compressFn)
+    {
+        const std::string & input = block.input;
+        std::string & output = block.output;
+
+        output.resize(sizeof(uint32_t) + LZ4_compressBound(input.size())
+                      + sizeof(uint32_t));
+        char * data = &output[sizeof(uint32_t)];
+
+        int compressedSize = compressFn(input.c_str(), data, input.size());
+
+        uint32_t size;
+        if (compressedSize > 0 && compressedSize < input.size())
+            size = compressedSize;
+        else {
+            // Incompressible; store it as is
+            memcpy(data, input.c_str(), input.size());
+            compressedSize = input.size();
+            size = compressedSize | ML::lz4::NotCompressedMask;
+        }
+
+        uint32_t checksum = XXH32(data, compressedSize, ML::lz4::ChecksumSeed);
+        memcpy(&output[0], &size, sizeof(size));
+        memcpy(data + compressedSize, &checksum, sizeof(checksum));
+        output.resize(sizeof(uint32_t) + compressedSize + sizeof(uint32_t));
+    }
+
+    size_t writeHeader(const OnData & onData)
+    {
+        if (headerWritten)
+            return 0;
+        headerWritten = true;
+        onData((const char *)&head, sizeof(head));
+        return sizeof(head);
+    }
+
+    /** Write out the oldest block in flight, waiting for it if needed. */
+    size_t writeOldest(const OnData & onData)
+    {
+        std::shared_ptr<Block> block = pending.front().first;
+        std::future<void> done = std::move(pending.front().second);
+        pending.pop_front();
+
+        done.get();  // rethrows a failure to compress
+        onData(block->output.c_str(), block->output.size());
+        return block->output.size();
+    }
+
+    size_t endBlock(const OnData & onData)
+    {
+        if (buffer.empty())
+            return 0;
+
+        auto block = std::make_shared<Block>();
+        block->input.swap(buffer);
+        buffer.reserve(head.blockSize());
+
+        if (maxInFlight == 0) {
+            compressBlock(*block, compressFn);
+            onData(block->output.c_str(), block->output.size());
+            return block->output.size();
+        }
+
+        pending.emplace_back(block, block->done.get_future());
+
+        CompressFn fn = compressFn;
+        auto job = [=] ()
+            {
+                try {
+                    compressBlock(*block, fn);
+                    block->done.set_value();
+                } catch (...) {
+                    block->done.set_exception(std::current_exception());
+                }
+            };
+        ML::Worker_Task::instance().add(job, "lz4 compress block");
+
+        // Write out what's done in order, and hold back the writer when
+        // the thread pool falls behind.
+        size_t result = 0;
+        while (!pending.empty()
+               && (pending.size() > maxInFlight
+                   || pending.front().second.wait_for(std::chrono::seconds(0))
+                      == std::future_status::ready))
+            result += writeOldest(onData);
+
+        return result;
+    }
+
+    size_t drain(const OnData & onData)
+    {
+        size_t result = 0;
+        while (!pending.empty())
+            result += writeOldest(onData);
+        return result;
+    }
+
+    size_t compress(const char * data, size_t len, const OnData & onData)
+    {
+        size_t result = writeHeader(onData);
+
+        while (len > 0) {
+            size_t toCopy = std::min(len, head.blockSize() - buffer.size());
+            buffer.append(data, toCopy);
+            data += toCopy;
+            len -= toCopy;
+
+            if (buffer.size() == head.blockSize())
+                result += endBlock(onData);
+        }
+
+        return result;
+    }
+
+    size_t flush(FlushLevel flushLevel, const OnData & onData)
+    {
+        if (flushLevel == FLUSH_NONE)
+            return 0;
+
+        size_t result = writeHeader(onData);
+        result += endBlock(onData);
+        result += drain(onData);
+        return result;
+    }
+
+    size_t finish(const OnData & onData)
+    {
+        size_t result = flush(FLUSH_RESTART, onData);
+
+        const uint32_t endOfStream = 0;
+        onData((const char *)&endOfStream, sizeof(endOfStream));
+        return result + sizeof(endOfStream);
+    }
+
+    ML::lz4::Header head;
+    bool headerWritten;
+    CompressFn compressFn;
+    size_t maxInFlight;
+
+    std::string buffer;  ///< Current block
+
+    /// Blocks being compressed, oldest first
+    std::deque<std::pair<std::shared_ptr<Block>, std::future<void> > > pending;
+};
+
+Lz4Compressor::
+Lz4Compressor(int level, int threads, int blockSizeId)
+    : itl(new Itl(level, threads, blockSizeId))
+{
+}
+
+Lz4Compressor::
+~Lz4Compressor()
+{
+}
+
+size_t
+Lz4Compressor::
+compress(const char * data, size_t len, const OnData & onData)
+{
+    return itl->compress(data, len, onData);
+}
+    
+size_t
+Lz4Compressor::
+flush(FlushLevel flushLevel, const OnData & onData)
+{
+    return itl->flush(flushLevel, onData);
+}
+
+size_t
+Lz4Compressor::
+finish(const OnData & onData)
+{
+    return itl->finish(onData);
+}
+
+
 /*****************************************************************************/
 /* LZMA COMPRESSOR                                                           */
 /*****************************************************************************/
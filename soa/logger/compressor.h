@@ -65,9 +65,13 @@ struct Compressor {
     /** Convert a filename to a compression scheme. */
     static std::string filenameToCompression(const std::string & filename);
 
-    /** Create a compressor with the given scheme. */
+    /** Create a compressor with the given scheme.  For schemes that
+        support it (lz4), a non-zero number of threads compresses blocks
+        in parallel with up to that many in flight.
+    */
     static Compressor * create(const std::string & compression,
-                               int level);
+                               int level,
+                               int threads = 0);
 };
 
 
@@ -135,6 +139,46 @@ private:
     std::unique_ptr<Itl> itl;
 };
 
+
+/*****************************************************************************/
+/* LZ4 COMPRESSOR                                                            */
+/*****************************************************************************/
+
+/** Compressor that writes an lz4 frame, readable by ML::lz4_decompressor
+    and so by filter_istream for files ending in .lz4.
+
+    The data is cut into independent blocks.  When threads is non-zero, full
+    blocks are handed off to the Worker_Task thread pool with up to that
+    many being compressed at once and are written out in order as they
+    complete, which lets a single stream compress faster than one core.
+
+    Flushing at any level other than FLUSH_NONE ends the current block and
+    waits for all the blocks in flight to be written, so it should not be
+    done after every small write.
+*/
+
+struct Lz4Compressor : public Compressor {
+
+    /** Levels under 3 use the fast lz4 compressor, others lz4hc.  The block
+        size is 1 << (8 + 2 * blockSizeId) bytes, with blockSizeId between
+        4 and 7.
+    */
+    Lz4Compressor(int level = 0, int threads = 0, int blockSizeId = 7);
+
+    virtual ~Lz4Compressor();
+
+    virtual size_t compress(const char * data, size_t len,
+                            const OnData & onData);
+    
+    virtual size_t flush(FlushLevel flushLevel, const OnData & onData);
+
+    virtual size_t finish(const OnData & onData);
+
+private:
+    struct Itl;
+    std::unique_ptr<Itl> itl;
+};
+
 } // namespace Datacratic
 
 #endif /* __logger__compressor_h__ */
@@ -291,7 +291,8 @@ RotatingFileOutput::
 RotatingFileOutput()
     : RotatingOutputAdaptor(std::bind(&RotatingFileOutput::createFile,
                                       this,
-                                      std::placeholders::_1))
+                                      std::placeholders::_1)),
+      level(-1), compressionThreads(0)
 {
 }
 
@@ -306,10 +307,12 @@ RotatingFileOutput::
 open(const std::string & filenamePattern,
      const std::string & periodPattern,
      const std::string & compression,
-     int level)
+     int level,
+     int compressionThreads)
 {
     this->compression = compression;
     this->level = level;
+    this->compressionThreads = compressionThreads;
 
     RotatingOutputAdaptor::open(filenamePattern, periodPattern);
 }
@@ -331,6 +334,7 @@ createFile(const std::string & filename)
     result->onFileWrite = [=] (const string& channel, const std::size_t bytes)
 	{ if (this->onFileWrite) this->onFileWrite(channel, bytes); };
 
+    result->compressionThreads = compressionThreads;
     result->open(filename, compression, level);
 
     return result.release();
@@ -131,17 +131,21 @@ struct RotatingFileOutput : public RotatingOutputAdaptor {
 
     virtual ~RotatingFileOutput();
     
-    /** Open the file for rotation. */
+    /** Open the file for rotation.  See CompressingOutput for
+        compressionThreads.
+    */
     void open(const std::string & filenamePattern,
               const std::string & periodPattern,
               const std::string & compression = "",
-              int level = -1);
+              int level = -1,
+              int compressionThreads = 0);
     
 private:
     FileOutput * createFile(const std::string & filename);
 
     std::string compression;
     int level;
+    int compressionThreads;
 };
 
 } // namespace Datacratic
@@ -15,6 +15,8 @@
 #include "publish_output.h"
 #include "callback_output.h"
 #include <boost/make_shared.hpp>
+#include <algorithm>
+#include <unordered_map>
 
 
 using namespace std;
@@ -46,10 +48,23 @@ clearStats()
 /* LOGGER                                                                    */
 /*****************************************************************************/
 
+namespace {
+
+/** Each thread that logs gets its own ring of messages.  A sixteenth of the
+    buffer each keeps the memory used comparable to that of a single shared
+    ring of the full size.
+*/
+size_t threadBufferSize(size_t bufferSize)
+{
+    return std::max<size_t>(1024, bufferSize / 16);
+}
+
+} // file scope
+
 Logger::
 Logger(size_t bufferSize)
     : context(std::make_shared<zmq::context_t>(1)),
-      messages(bufferSize),
+      messages(threadBufferSize(bufferSize)),
       outputs(0),
       messagesSent(0), messagesDone(0)
 {
@@ -59,7 +74,7 @@ Logger(size_t bufferSize)
 Logger::
 Logger(zmq::context_t & contextRef, size_t bufferSize)
     : context(ML::make_unowned_std_sp(contextRef)),
-      messages(bufferSize),
+      messages(threadBufferSize(bufferSize)),
       outputs(0),
       messagesSent(0), messagesDone(0)
 {
@@ -69,7 +84,7 @@ Logger(zmq::context_t & contextRef, size_t bufferSize)
 Logger::
 Logger(std::shared_ptr<zmq::context_t> & context, size_t bufferSize)
     : context(context),
-      messages(bufferSize),
+      messages(threadBufferSize(bufferSize)),
       outputs(0),
       messagesSent(0), messagesDone(0)
 {
@@ -183,38 +198,73 @@ struct Logger::Outputs : public std::vector<Output> {
         if (old) delete old;
     }
     
+    /** Indexes of the outputs whose allow and deny filters accept the
+        channel.  The decisions are cached, as there are only a handful of
+        channels and running the regexes for every message is expensive.
+        Since a new Outputs is created whenever the outputs change, the
+        cache never holds stale decisions.
+    */
+    const std::vector<unsigned> & channelOutputs(const std::string & channel)
+    {
+        auto it = decisions.find(channel);
+        if (it != decisions.end())
+            return it->second;
+
+        std::vector<unsigned> result;
+        for (unsigned i = 0;  i < size();  ++i) {
+            const Output & output = (*this)[i];
+            try {
+                if (!output.allowChannels.empty()
+                    && !boost::regex_match(channel, output.allowChannels))
+                    continue;
+                if (!output.denyChannels.empty()
+                    && boost::regex_match(channel, output.denyChannels))
+                    continue;
+                result.push_back(i);
+            } catch (const std::exception & exc) {
+                cerr << "error: matching channel " << channel
+                     << " for output " << ML::type_name(*output.output)
+                     << ": " << exc.what() << endl;
+            }
+        }
+
+        // Don't let a stream of one-off channel names grow the cache
+        // without bounds.
+        if (decisions.size() >= MaxCachedChannels) {
+            uncached = std::move(result);
+            return uncached;
+        }
+
+        return decisions.insert(make_pair(channel, std::move(result)))
+            .first->second;
+    }
+
     void logMessage(const std::string & channel,
                     const std::string & message)
     {
-        for (auto it = begin(); it != end();  ++it) {
+        for (unsigned i: channelOutputs(channel)) {
+            Output & output = (*this)[i];
             try {
-                //cerr << "channel = " << channel << endl;
-                //cerr << "output = " << ML::type_name(*it->output) << endl;
-                //cerr << "it->allowChannels = " << it->allowChannels.str() << endl;
-                //cerr << "it->denyChannels = " << it->denyChannels.str() << endl;
-                if (it->allowChannels.empty()
-                    || boost::regex_match(channel, it->allowChannels)) {
-                    //cerr << "   allow" << endl;
-                    if (it->denyChannels.empty()
-                        || !boost::regex_match(channel, it->denyChannels)) {
-
-                        if (it->logProbability == 1.0
-                            || ((random() % 100000)
-                                < (it->logProbability * 100000))) {
-                            it->output->logMessage(channel, message);
-                        }
-                        //cerr << "  *** log" << endl;
-                    }
+                if (output.logProbability == 1.0
+                    || ((random() % 100000)
+                        < (output.logProbability * 100000))) {
+                    output.output->logMessage(channel, message);
                 }
             } catch (const std::exception & exc) {
                 cerr << "error: writing message to channel " << channel
-                     << " with output " << ML::type_name(*it->output)
+                     << " with output " << ML::type_name(*output.output)
                      << ": " << exc.what() << "; message = "
                      << message << endl;
             }
         }
     }
     
+    enum { MaxCachedChannels = 10000 };
+
+    /// Outputs for each channel; only touched by the logging thread
+    std::unordered_map<std::string, std::vector<unsigned> > decisions;
+    std::vector<unsigned> uncached;
+
     Outputs * old;   // to allow cleanup
 };
 
@@ -419,9 +469,12 @@ handleListenerMessage(std::vector<std::string> const & message)
     if (message.size() == 1 && message[0] == "SHUTDOWN")
         return;
 
-    atomic_add(messagesDone, 1);
-
-    if (!current) return;
+    // Only count the message as done once the outputs have seen it, so that
+    // waitUntilFinished() really waits for them.
+    if (!current) {
+        atomic_add(messagesDone, 1);
+        return;
+    }
 
     string const & channel = message[0];
 
@@ -440,6 +493,7 @@ handleListenerMessage(std::vector<std::string> const & message)
     }
 
     current->logMessage(channel, toLog);
+    atomic_add(messagesDone, 1);
 }
 
 void
@@ -9,6 +9,7 @@
 #include "soa/service/zmq_named_pub_sub.h"
 #include "soa/service/zmq_utils.h"
 #include "soa/service/socket_per_thread.h"
+#include "soa/service/typed_message_channel.h"
 #include <sstream>
 #include "jml/utils/filter_streams.h"
 #include <boost/thread/thread.hpp>
@@ -76,6 +77,11 @@ struct LogOutput {
     Everything is entirely thread-safe and in normal operation, logging a
     message will not block.  This allows it to be used in contexts where
     logging happens in a time-critical loop, for example.
+
+    Messages logged from within the process go through a lock-free ring per
+    logging thread (see PerThreadMessageSink); the bufferSize is shared out
+    between those rings.  Which outputs a channel goes to is decided once
+    per channel and cached until the outputs change.
 */
 
 struct Logger {
@@ -230,7 +236,7 @@ private:
     std::map<std::string, size_t> stats;
 
 protected:    /// Log entried to add
-    TypedMessageSink<std::vector<std::string>> messages;
+    PerThreadMessageSink<std::vector<std::string>> messages;
 
 private:
 #if 0
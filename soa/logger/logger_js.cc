@@ -388,7 +388,8 @@ struct RotatingFileOutputJS
                 ->open(getArg(args, 0, "filenamePattern"),
                        getArg(args, 1, "period"),
                        getArg(args, 2, "", "compression"),
-                       getArg(args, 3, -1, "compressionLevel"));
+                       getArg(args, 3, -1, "compressionLevel"),
+                       getArg(args, 4, 0, "compressionThreads"));
             return args.This();
         } HANDLE_JS_EXCEPTIONS;
     }
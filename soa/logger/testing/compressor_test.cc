@@ -0,0 +1,127 @@
+/* compressor_test.cc
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Tests for the compressors of the log outputs.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "soa/logger/compressor.h"
+#include "jml/utils/lz4_filter.h"
+#include "jml/arch/format.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+
+
+using namespace Datacratic;
+using namespace ML;
+using namespace std;
+
+
+namespace {
+
+std::string makeLog(size_t numLines)
+{
+    std::string result;
+    for (size_t i = 0;  i < numLines;  ++i) {
+        result += ML::format("AUCTION\t2014-03-01-12:00:%02d.%05d\t"
+                             "{\"id\":\"%016llx\",\"imp\":%d}\n",
+                             i % 60, i, (long long)random(), i % 7);
+    }
+    return result;
+}
+
+/** Feed the data through the compressor in small writes, flushing every
+    now and then, and return the compressed stream.
+*/
+std::string compress(Compressor & compressor, const std::string & data,
+                     size_t flushEvery)
+{
+    std::string result;
+    auto onData = [&] (const char * data, size_t len)
+        {
+            result.append(data, len);
+            return len;
+        };
+
+    size_t done = 0;
+    for (size_t i = 0;  done < data.size();  ++i) {
+        size_t len = std::min<size_t>(data.size() - done, 1000);
+        compressor.compress(data.c_str() + done, len, onData);
+        done += len;
+        if (flushEvery && i % flushEvery == 0)
+            compressor.flush(Compressor::FLUSH_AVAILABLE, onData);
+    }
+    compressor.finish(onData);
+
+    return result;
+}
+
+std::string decompressLz4(const std::string & compressed)
+{
+    boost::iostreams::filtering_istream stream;
+    stream.push(ML::lz4_decompressor());
+    stream.push(boost::iostreams::array_source(compressed.c_str(),
+                                               compressed.size()));
+
+    std::ostringstream result;
+    result << stream.rdbuf();
+    return result.str();
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_lz4_compressor )
+{
+    std::string data = makeLog(100000);
+
+    // Small blocks so that there are lots of them
+    Lz4Compressor compressor(0, 0, 4);
+    std::string compressed = compress(compressor, data, 0);
+
+    BOOST_CHECK_LT(compressed.size(), data.size() / 2);
+    BOOST_CHECK(decompressLz4(compressed) == data);
+
+    // Flushing cuts blocks short but the stream stays the same
+    Lz4Compressor flushed(0, 0, 4);
+    BOOST_CHECK(decompressLz4(compress(flushed, data, 10)) == data);
+
+    // Empty stream
+    Lz4Compressor empty;
+    BOOST_CHECK_EQUAL(decompressLz4(compress(empty, "", 0)), "");
+
+    // Incompressible data is stored as is
+    std::string noise;
+    for (unsigned i = 0;  i < 200000;  ++i)
+        noise += (char)random();
+    Lz4Compressor noisy(0, 0, 4);
+    BOOST_CHECK(decompressLz4(compress(noisy, noise, 0)) == noise);
+}
+
+BOOST_AUTO_TEST_CASE( test_lz4_compressor_parallel )
+{
+    std::string data = makeLog(200000);
+
+    Lz4Compressor serial(0, 0, 4);
+    std::string expected = compress(serial, data, 50);
+
+    // Blocks are cut at the same places whatever the number of threads,
+    // so the output has to be exactly the same.
+    for (int threads: { 1, 2, 8 }) {
+        Lz4Compressor parallel(0, threads, 4);
+        std::string compressed = compress(parallel, data, 50);
+        BOOST_CHECK_EQUAL(compressed.size(), expected.size());
+        BOOST_CHECK(compressed == expected);
+    }
+
+    std::unique_ptr<Compressor> created
+        (Compressor::create(Compressor::filenameToCompression("x.log.lz4"),
+                            -1, 4));
+    BOOST_CHECK(decompressLz4(compress(*created, data, 0)) == data);
+}
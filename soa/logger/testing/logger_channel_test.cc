@@ -0,0 +1,106 @@
+/* logger_channel_test.cc
+   Copyright (c) 2014 Datacratic.  All rights reserved.
+
+   Tests for the routing of the logger's messages to its outputs.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "soa/logger/logger.h"
+#include "jml/utils/testing/watchdog.h"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/regex.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <map>
+#include <string>
+
+
+using namespace Datacratic;
+using namespace ML;
+using namespace std;
+
+
+struct Received {
+    void add(const std::string & output, const std::string & channel)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        counts[output + ":" + channel] += 1;
+    }
+
+    int operator [] (const std::string & key)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return counts[key];
+    }
+
+    std::mutex lock;
+    std::map<std::string, int> counts;
+};
+
+BOOST_AUTO_TEST_CASE( test_channel_routing )
+{
+    ML::Watchdog watchdog(30.0);
+
+    Logger logger;
+    logger.init();
+
+    Received received;
+    auto callback = [&] (const std::string & output)
+        {
+            return [&, output] (std::string channel, std::string message)
+                {
+                    received.add(output, channel);
+                };
+        };
+
+    logger.addCallback(callback("all"));
+    logger.addCallback(callback("auctions"), boost::regex("AUCTION.*"),
+                       boost::regex("AUCTION_DEBUG"));
+    logger.addCallback(callback("never"), boost::regex("NOTHING"));
+
+    logger.start();
+
+    // Several threads log into the same channels; the routing decision is
+    // made once per channel and reused for every message after that.
+    auto logThread = [&] ()
+        {
+            for (unsigned i = 0;  i < 1000;  ++i) {
+                logger.logMessage("AUCTION", "id", "data");
+                logger.logMessage("AUCTION_DEBUG", "id");
+                logger.logMessage("WIN", "id", "price");
+            }
+        };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0;  i < 4;  ++i)
+        threads.emplace_back(logThread);
+    for (auto & thread: threads)
+        thread.join();
+
+    logger.waitUntilFinished();
+
+    BOOST_CHECK_EQUAL(received["all:AUCTION"], 4000);
+    BOOST_CHECK_EQUAL(received["all:AUCTION_DEBUG"], 4000);
+    BOOST_CHECK_EQUAL(received["all:WIN"], 4000);
+    BOOST_CHECK_EQUAL(received["auctions:AUCTION"], 4000);
+    BOOST_CHECK_EQUAL(received["auctions:AUCTION_DEBUG"], 0);
+    BOOST_CHECK_EQUAL(received["auctions:WIN"], 0);
+    BOOST_CHECK_EQUAL(received["never:AUCTION"], 0);
+
+    // Changing the outputs forgets the previous decisions
+    logger.addCallback(callback("wins"), boost::regex("WIN"));
+    logger.logMessage("WIN", "id", "price");
+    logger.logMessage("AUCTION", "id", "data");
+    logger.waitUntilFinished();
+
+    BOOST_CHECK_EQUAL(received["wins:WIN"], 1);
+    BOOST_CHECK_EQUAL(received["wins:AUCTION"], 0);
+    BOOST_CHECK_EQUAL(received["all:WIN"], 4001);
+    BOOST_CHECK_EQUAL(received["auctions:AUCTION"], 4001);
+
+    logger.shutdown();
+}
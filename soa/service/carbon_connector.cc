@@ -149,6 +149,27 @@ record(const std::string & stat,
     }
 }
 
+std::shared_ptr<StatAggregator>
+MultiAggregator::
+intern(const std::string & stat,
+       StatEventType type,
+       const std::vector<int> & extra)
+{
+    switch (type) {
+    case ET_HIT:
+    case ET_COUNT:
+        return getAggregatorPtr(stat, createNewCounter);
+    case ET_STABLE_LEVEL:
+        return getAggregatorPtr(stat, createNewStableLevel);
+    case ET_LEVEL:
+        return getAggregatorPtr(stat, createNewLevel);
+    case ET_OUTCOME:
+        return getAggregatorPtr(stat, createNewOutcome, extra);
+    default:
+        throw ML::Exception("unknown stat type");
+    }
+}
+
 void
 MultiAggregator::
 recordHit(const std::string & stat)
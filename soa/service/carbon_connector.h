@@ -101,6 +101,16 @@ struct MultiAggregator {
     void recordOutcome(const std::string & stat, float value,
             const std::vector<int>& percentiles = DefaultOutcomePercentiles);
 
+    /** Return the aggregator that record() would use for the given stat,
+        creating it if needed.  Recording directly into the aggregator skips
+        the lookup which is what pre-interned events (see EventHandle) rely
+        on.  The aggregator stays valid for the lifetime of this object.
+    */
+    std::shared_ptr<StatAggregator>
+    intern(const std::string & stat,
+           StatEventType type = ET_COUNT,
+           const std::vector<int> & extra = DefaultOutcomePercentiles);
+
     /** Dump synchronously (taking the lock).  This should only be used in
         testing or debugging, not when connected to Carbon.
     */
@@ -153,13 +163,22 @@ private:
     StatAggregator & getAggregator(const std::string & stat,
                                    StatAggregator * (*createFn) (Args...),
                                    Args&&... args)
+    {
+        return *getAggregatorPtr(stat, createFn, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    const std::shared_ptr<StatAggregator> &
+    getAggregatorPtr(const std::string & stat,
+                     StatAggregator * (*createFn) (Args...),
+                     Args&&... args)
     {
         if (!lookupCache.get())
             lookupCache.reset(new LookupCache());
 
         auto found = lookupCache->find(stat);
         if (found != lookupCache->end())
-            return *found->second->second;
+            return found->second->second;
 
         // Get the read lock to look for the aggregator
         std::unique_lock<Lock> guard(lock);
@@ -171,7 +190,7 @@ private:
 
             (*lookupCache)[stat] = found2;
 
-            return *found2->second;
+            return found2->second;
         }
 
         guard.unlock();
@@ -185,7 +204,7 @@ private:
 
         guard2.unlock();
         (*lookupCache)[stat] = found2;
-        return *found2->second;
+        return found2->second;
     }
     
     std::unique_ptr<std::thread> dumpingThread;
@@ -321,11 +321,21 @@ PassiveConnectionHandler::
 send(const std::string & str,
      NextAction next,
      OnWriteFinished onWriteFinished)
+{
+    send(std::string(str), next, std::move(onWriteFinished));
+}
+
+void
+PassiveConnectionHandler::
+send(std::string && str,
+     NextAction next,
+     OnWriteFinished onWriteFinished)
 {
     // If we're not in the right thread, then set the send up to be
     // asynchronous.
     if (!transport().lockedByThisThread()) {
-        doAsync([=] () { this->send(str, next, onWriteFinished); },
+        auto data = std::make_shared<std::string>(std::move(str));
+        doAsync([=] () { this->send(std::move(*data), next, onWriteFinished); },
                 "deferredSend");
         return;
     }
@@ -335,14 +345,14 @@ send(const std::string & str,
 
     WriteEntry entry;
     entry.date = Date::now();
-    entry.data = str;
+    entry.data = std::move(str);
     entry.next = next;
-    entry.onWriteFinished = onWriteFinished;
+    entry.onWriteFinished = std::move(onWriteFinished);
 
     //if (str.find("POST") != 0)
     //    cerr << "SEND " << str << endl;
 
-    toWrite.push_back(entry);
+    toWrite.push_back(std::move(entry));
 
     if (toWrite.size() == 1) {
         done = 0;
@@ -47,6 +47,12 @@ struct ConnectionHandler {
     {
     }
 
+    /** Function called when another handler is about to take over the
+        connection, before onDisassociate(). */
+    virtual void onReplace(ConnectionHandler & newHandler)
+    {
+    }
+
     /** Function called when we're dissociating the connection. */
     virtual void onDisassociate()
     {
@@ -268,6 +274,13 @@ struct PassiveConnectionHandler: public ConnectionHandler {
     void send(const std::string & str,
               NextAction action = NEXT_CONTINUE,
               OnWriteFinished onWriteFinished = OnWriteFinished());
+
+    /** Send some data that is moved into the write queue rather than
+        copied.
+    */
+    void send(std::string && str,
+              NextAction action = NEXT_CONTINUE,
+              OnWriteFinished onWriteFinished = OnWriteFinished());
     
     /** Function called out to when we got some data */
     virtual void handleData(const std::string & data) = 0;
@@ -27,7 +27,7 @@ namespace Datacratic {
 
 HttpConnectionHandler::
 HttpConnectionHandler()
-    : readState(INVALID), httpEndpoint(0)
+    : readState(INVALID), headerDone(false), httpEndpoint(0)
 {
 }
 
@@ -39,6 +39,21 @@ onGotTransport()
     
     readState = HEADER;
     startReading();
+
+    // Requests pipelined behind the previous one on the connection
+    if (!parser.empty()) {
+        firstData = Date::now();
+        parseRequest();
+    }
+}
+
+void
+HttpConnectionHandler::
+onReplace(ConnectionHandler & newHandler)
+{
+    auto next = dynamic_cast<HttpConnectionHandler *>(&newHandler);
+    if (next)
+        parser.swap(next->parser);
 }
 
 std::shared_ptr<ConnectionHandler>
@@ -58,7 +73,7 @@ handleData(const std::string & data)
    //cerr << "HttpConnectionHandler::handleData: got data <" << data << ">" << endl;
     //httpData.write(data.c_str(), data.length());
 
-    if (headerText == "" && readState == HEADER)
+    if (parser.empty() && readState == HEADER)
         firstData = Date::now();
 
     addActivity("handleData with state %d", readState);
@@ -85,52 +100,83 @@ handleData(const std::string & data)
         return;
     }
     
+    // Pipelined request; it will be parsed by the next handler
+    if (readState == DONE) {
+        parser.feed(data);
+        parser.retain();
+        return;
+    }
+
     if (readState != HEADER) {
         throw Exception("invalid read state %d handling data '%s' for %p",
                         readState, data.c_str(), this);
     }
-    
-    headerText += data;
-    // The first time that we see that character sequence, it's the break
-    // between the header and the data.
-    string::size_type breakPos = headerText.find("\r\n\r\n");
-    
 
-    if (breakPos == string::npos)
-    {
-        if (headerText.size() > 16384) {
-            throw ML::Exception("HTTP header exceeds 16kb");
-        }
-        //cerr << "did not find break pos " << endl;
-        return;
-    }
-    // We got a header
+    // The data is parsed in place, and only what's left of it is copied
+    parser.feed(data);
+    parseRequest();
+    parser.retain();
+}
+
+void
+HttpConnectionHandler::
+parseRequest()
+{
+    HttpRequestParser::Result result;
     try {
-        header.parse(headerText);
+        result = parser.next(requestView);
     } catch (...) {
         cerr << "problem parsing in state: " << status() << endl;
         throw;
     }
 
-    //cerr << "content length = " << header.contentLength << endl;
+    if (result == HttpRequestParser::NEED_MORE)
+        return;
+
+    // The body isn't there yet; the client may be waiting for a 100 continue
+    if (result == HttpRequestParser::HEADER) {
+        setHeader(requestView);
+        return;
+    }
+
+    // Anything received from now on belongs to the next request
+    readState = DONE;
+    handleHttpRequest(requestView);
+}
+
+void
+HttpConnectionHandler::
+setHeader(const HttpRequestView & request)
+{
+    header.parse(request);
 
     if (header.contentLength == -1 && !header.isChunked)
         header.contentLength = 0;
     //doError("we need a Content-Length");
-    
-    addActivityS("header parsing OK");
 
-    //cerr << "done header" << endl;
+    addActivityS("header parsing OK");
 
+    headerDone = true;
     handleHttpHeader(header);
+}
 
-    payload = "";
+void
+HttpConnectionHandler::
+handleHttpRequest(const HttpRequestView & request)
+{
+    if (!headerDone)
+        setHeader(request);
 
-    if (header.isChunked)
+    if (header.isChunked) {
         readState = CHUNK_HEADER;
-    else readState = PAYLOAD;
+        handleHttpData(parser.takePending());
+        return;
+    }
+
+    payload.assign(request.body.data, request.body.size);
 
-    handleHttpData(header.knownData);
+    addActivityS("got HTTP payload");
+    handleHttpPayload(header, payload);
 }
 
 void
@@ -383,7 +429,7 @@ putResponseOnWire(HttpResponse response,
 
     //cerr << "sending " << responseStr << endl;
     
-    send(responseStr,
+    send(std::move(responseStr),
          next,
          onSendFinished);
 }
@@ -10,6 +10,7 @@
 #include "soa/service/passive_endpoint.h"
 #include "soa/types/date.h"
 #include "http_header.h"
+#include "http_parsers.h"
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -35,9 +36,9 @@ struct HttpResponse {
                      = std::vector<std::pair<std::string, std::string> >())
         : responseCode(responseCode),
           responseStatus(getResponseReasonPhrase(responseCode)),
-          contentType(contentType),
-          body(body),
-          extraHeaders(extraHeaders),
+          contentType(std::move(contentType)),
+          body(std::move(body)),
+          extraHeaders(std::move(extraHeaders)),
           sendBody(true)
     {
     }
@@ -51,8 +52,8 @@ struct HttpResponse {
                      = std::vector<std::pair<std::string, std::string> >())
         : responseCode(responseCode),
           responseStatus(getResponseReasonPhrase(responseCode)),
-          contentType(contentType),
-          extraHeaders(extraHeaders),
+          contentType(std::move(contentType)),
+          extraHeaders(std::move(extraHeaders)),
           sendBody(false)
     {
     }
@@ -65,7 +66,7 @@ struct HttpResponse {
           responseStatus(getResponseReasonPhrase(responseCode)),
           contentType("application/json"),
           body(boost::trim_copy(body.toString())),
-          extraHeaders(extraHeaders),
+          extraHeaders(std::move(extraHeaders)),
           sendBody(true)
     {
     }
@@ -103,8 +104,17 @@ struct HttpConnectionHandler : public PassiveConnectionHandler {
         DONE
     } readState;
 
-    /** Accumulated text for the header. */
-    std::string headerText;
+    /** Parser for the requests received on the connection.  It keeps the
+        data of pipelined requests, along with its buffer, when the next
+        handler takes over the connection.
+    */
+    HttpRequestParser parser;
+
+    /** Views of the request being parsed, which point into the parser. */
+    HttpRequestView requestView;
+
+    /** Whether the header was already passed to handleHttpHeader. */
+    bool headerDone;
 
     /** The actual header */
     HttpHeader header;
@@ -124,6 +134,11 @@ struct HttpConnectionHandler : public PassiveConnectionHandler {
 
     virtual void onGotTransport();
 
+    /** Hands over the unparsed data of the connection, and the buffer that
+        holds it, to the next HttpConnectionHandler.
+    */
+    virtual void onReplace(ConnectionHandler & newHandler);
+
     /** Create a new connection handler.  Delegates to the endpoint.  This
         is used after a response is sent to set the connection up for a
         new request.
@@ -135,6 +150,14 @@ struct HttpConnectionHandler : public PassiveConnectionHandler {
     virtual void handleError(const std::string & message);
     virtual void onCleanup();
 
+    /** Called once a complete request has been parsed, without any of it
+        having been copied.  Views into the request are only valid during
+        the call.  Default converts it to an HttpHeader and goes through
+        handleHttpHeader and handleHttpPayload, or handleHttpData for
+        chunked requests.
+    */
+    virtual void handleHttpRequest(const HttpRequestView & request);
+
     /** Called when the HTTP header comes through.  Default will pass it
         back to the endpoint to do something with it.
     */
@@ -174,6 +197,11 @@ struct HttpConnectionHandler : public PassiveConnectionHandler {
                                    = std::function<void ()>(),
                                    NextAction next = NEXT_CONTINUE);
 
+private:
+    /** Parse the next request out of the data fed to the parser. */
+    void parseRequest();
+
+    void setHeader(const HttpRequestView & request);
 };
 
 
@@ -5,6 +5,7 @@
 */
 
 #include "http_header.h"
+#include "http_parsers.h"
 #include "jml/utils/parse_context.h"
 #include "jml/utils/string_functions.h"
 #include "jml/db/persistent.h"
@@ -264,6 +265,47 @@ parse(const std::string & headerAndData, bool checkBodyLength)
     }
 }
 
+void
+HttpHeader::
+parse(const HttpRequestView & request)
+{
+    HttpHeader parsed;
+
+    parsed.verb = request.verb.str();
+    parsed.resource = request.resource.str();
+    parsed.version = request.version.str();
+
+    if (!request.query.empty()) {
+        ML::Parse_Context context("request query",
+                                  request.query.data,
+                                  request.query.data + request.query.size);
+        do {
+            string key = expectUrlEncodedString(context, "=&");
+            if (context.match_literal('=')) {
+                string value = expectUrlEncodedString(context, "&");
+                parsed.queryParams.push_back(make_pair(key, value));
+            } else {
+                parsed.queryParams.push_back(make_pair(key, ""));
+            }
+        } while (context.match_literal('&'));
+    }
+
+    parsed.contentType = request.contentType.str();
+    parsed.contentLength = request.contentLength;
+    parsed.isChunked = request.isChunked;
+
+    for (const auto & header: request.headers) {
+        string name = lowercase(header.first.str());
+        if (name == "content-length" || name == "content-type"
+            || name == "transfer-encoding")
+            continue;
+        parsed.headers[name] = header.second.str();
+    }
+
+    swap(parsed);
+    queryParams.swap(parsed.queryParams);
+}
+
 int HttpHeader::responseCode() const
 {
     return boost::lexical_cast<int>(resource);
@@ -16,6 +16,8 @@
 
 namespace Datacratic {
 
+struct HttpRequestView;
+
 /*****************************************************************************/
 /* REST PARAMS                                                               */
 /*****************************************************************************/
@@ -61,6 +63,11 @@ struct HttpHeader {
 
     void parse(const std::string & headerAndData, bool checkBodyLength = true);
 
+    /** Fill in from a request parsed by HttpRequestParser.  The body of the
+        request isn't copied into knownData.
+    */
+    void parse(const HttpRequestView & request);
+
     std::string verb;       // GET, PUT, etc
     std::string resource;   // after the get
     std::string version;    // after the get
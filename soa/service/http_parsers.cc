@@ -395,3 +395,294 @@ finalizeParsing()
     }
     clear();
 }
+
+
+/****************************************************************************/
+/* HTTP STRING VIEW                                                         */
+/****************************************************************************/
+
+std::ostream &
+Datacratic::
+operator << (std::ostream & stream, const HttpStringView & view)
+{
+    return stream.write(view.data, view.size);
+}
+
+
+/****************************************************************************/
+/* HTTP REQUEST VIEW                                                        */
+/****************************************************************************/
+
+HttpStringView
+HttpRequestView::
+findHeader(const char * name)
+    const
+{
+    for (const auto & header: headers) {
+        if (header.first.equalsIgnoreCase(name)) {
+            return header.second;
+        }
+    }
+
+    return HttpStringView();
+}
+
+
+/****************************************************************************/
+/* HTTP REQUEST PARSER                                                      */
+/****************************************************************************/
+
+namespace {
+
+const char * findLineEnd(const char * start, const char * end)
+{
+    const char * cr = (const char *) ::memchr(start, '\r', end - start);
+    if (!cr || cr + 1 == end || cr[1] != '\n') {
+        throw ML::Exception("expected \\r\\n in HTTP header");
+    }
+    return cr;
+}
+
+HttpStringView trimmed(const char * start, const char * end)
+{
+    while (start < end && (*start == ' ' || *start == '\t')) {
+        start++;
+    }
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    return HttpStringView(start, end - start);
+}
+
+int64_t parseContentLength(const HttpStringView & value)
+{
+    if (value.size == 0 || value.size > 18) {
+        throw ML::Exception("invalid content length");
+    }
+
+    int64_t result(0);
+    for (size_t i = 0; i < value.size; i++) {
+        char c = value.data[i];
+        if (c < '0' || c > '9') {
+            throw ML::Exception("invalid content length");
+        }
+        result = result * 10 + (c - '0');
+    }
+
+    return result;
+}
+
+} // file scope
+
+void
+HttpRequestParser::
+clear()
+{
+    buffer_.clear();
+    borrowed_ = nullptr;
+    size_ = 0;
+    start_ = 0;
+    scanned_ = 0;
+    headerSize_ = 0;
+    bodySize_ = 0;
+}
+
+void
+HttpRequestParser::
+feed(const char * data, size_t size)
+{
+    if (empty()) {
+        /* Nothing pending, so the data can be parsed where it is */
+        buffer_.clear();
+        borrowed_ = data;
+        size_ = size;
+        start_ = 0;
+    }
+    else {
+        retain();
+        buffer_.append(data, size);
+        size_ = buffer_.size();
+    }
+}
+
+void
+HttpRequestParser::
+retain()
+{
+    if (borrowed_) {
+        buffer_.assign(borrowed_ + start_, size_ - start_);
+        borrowed_ = nullptr;
+    }
+    else if (start_ > 0) {
+        buffer_.erase(0, start_);
+    }
+    size_ = buffer_.size();
+    start_ = 0;
+}
+
+std::string
+HttpRequestParser::
+takePending()
+{
+    std::string result(data() + start_, pending());
+
+    buffer_.clear();
+    borrowed_ = nullptr;
+    size_ = 0;
+    start_ = 0;
+    scanned_ = 0;
+    headerSize_ = 0;
+    bodySize_ = 0;
+
+    return result;
+}
+
+void
+HttpRequestParser::
+swap(HttpRequestParser & other)
+{
+    retain();
+    other.retain();
+
+    std::swap(maxHeaderSize, other.maxHeaderSize);
+    buffer_.swap(other.buffer_);
+    std::swap(size_, other.size_);
+    std::swap(start_, other.start_);
+    std::swap(scanned_, other.scanned_);
+    std::swap(headerSize_, other.headerSize_);
+    std::swap(bodySize_, other.bodySize_);
+}
+
+HttpRequestParser::Result
+HttpRequestParser::
+next(HttpRequestView & request)
+{
+    /* Empty lines between requests are ignored */
+    while (headerSize_ == 0 && pending() >= 2
+           && ::memcmp(data() + start_, "\r\n", 2) == 0) {
+        start_ += 2;
+    }
+
+    const char * start = data() + start_;
+    size_t available = pending();
+    bool headerWasComplete = (headerSize_ > 0);
+
+    if (!headerWasComplete) {
+        size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+        const char * headerEnd = nullptr;
+        if (available > from) {
+            headerEnd = (const char *) ::memmem(start + from, available - from,
+                                                "\r\n\r\n", 4);
+        }
+
+        if (!headerEnd) {
+            scanned_ = available;
+            if (available > maxHeaderSize) {
+                throw ML::Exception("HTTP header exceeds %zd bytes",
+                                    maxHeaderSize);
+            }
+            return NEED_MORE;
+        }
+
+        headerSize_ = headerEnd + 4 - start;
+        if (headerSize_ > maxHeaderSize) {
+            throw ML::Exception("HTTP header exceeds %zd bytes",
+                                maxHeaderSize);
+        }
+    }
+    else if (available < headerSize_ + bodySize_) {
+        return NEED_MORE;
+    }
+
+    parseHeader(start, start + headerSize_, request);
+
+    if (!headerWasComplete) {
+        bodySize_ = (request.isChunked || request.contentLength < 0
+                     ? 0 : request.contentLength);
+        if (available < headerSize_ + bodySize_) {
+            return HEADER;
+        }
+    }
+
+    request.body = HttpStringView(start + headerSize_, bodySize_);
+
+    start_ += headerSize_ + bodySize_;
+    scanned_ = 0;
+    headerSize_ = 0;
+    bodySize_ = 0;
+
+    return REQUEST;
+}
+
+void
+HttpRequestParser::
+parseHeader(const char * start, const char * end, HttpRequestView & request)
+    const
+{
+    request.headers.clear();
+    request.contentType = HttpStringView();
+    request.contentLength = -1;
+    request.isChunked = false;
+    request.body = HttpStringView();
+
+    /* request line: verb, target and version separated by single spaces */
+    const char * lineEnd = findLineEnd(start, end);
+    const char * verbEnd = (const char *) ::memchr(start, ' ', lineEnd - start);
+    if (!verbEnd || verbEnd == start) {
+        throw ML::Exception("malformed HTTP request line");
+    }
+    const char * target = verbEnd + 1;
+    const char * targetEnd
+        = (const char *) ::memchr(target, ' ', lineEnd - target);
+    if (!targetEnd || targetEnd == target) {
+        throw ML::Exception("malformed HTTP request line");
+    }
+
+    request.verb = HttpStringView(start, verbEnd - start);
+    request.version = HttpStringView(targetEnd + 1, lineEnd - targetEnd - 1);
+
+    const char * query
+        = (const char *) ::memchr(target, '?', targetEnd - target);
+    if (query) {
+        request.resource = HttpStringView(target, query - target);
+        request.query = HttpStringView(query + 1, targetEnd - query - 1);
+    }
+    else {
+        request.resource = HttpStringView(target, targetEnd - target);
+        request.query = HttpStringView();
+    }
+
+    /* header lines, up to the empty line that ends the header */
+    const char * line = lineEnd + 2;
+    while (line < end - 2) {
+        lineEnd = findLineEnd(line, end);
+        if (*line == ' ' || *line == '\t') {
+            throw ML::Exception("folded HTTP header lines are not supported");
+        }
+
+        const char * colon
+            = (const char *) ::memchr(line, ':', lineEnd - line);
+        if (!colon || colon == line) {
+            throw ML::Exception("malformed HTTP header line");
+        }
+
+        HttpStringView name(line, colon - line);
+        HttpStringView value = trimmed(colon + 1, lineEnd);
+        request.headers.emplace_back(name, value);
+
+        if (name.equalsIgnoreCase("content-length")) {
+            request.contentLength = parseContentLength(value);
+        }
+        else if (name.equalsIgnoreCase("transfer-encoding")) {
+            if (!value.equalsIgnoreCase("chunked")) {
+                throw ML::Exception("unknown transfer-encoding");
+            }
+            request.isChunked = true;
+        }
+        else if (name.equalsIgnoreCase("content-type")) {
+            request.contentType = value;
+        }
+
+        line = lineEnd + 2;
+    }
+}
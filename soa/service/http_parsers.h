@@ -7,6 +7,12 @@
 #pragma once
 
 #include <functional>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <strings.h>
 
 
 namespace Datacratic {
@@ -125,4 +131,170 @@ private:
     bool requireClose_;
 };
 
-}
+
+
+/****************************************************************************/
+/* HTTP STRING VIEW                                                         */
+/****************************************************************************/
+
+/* Part of a buffer holding HTTP data, which it references without owning it.
+ */
+
+struct HttpStringView {
+    HttpStringView()
+        : data(nullptr), size(0)
+    {
+    }
+
+    HttpStringView(const char * data, size_t size)
+        : data(data), size(size)
+    {
+    }
+
+    bool empty() const { return size == 0; }
+
+    std::string str() const { return std::string(data, size); }
+
+    bool operator == (const char * other) const
+    {
+        return ::strlen(other) == size && ::memcmp(data, other, size) == 0;
+    }
+
+    bool operator != (const char * other) const
+    {
+        return !operator == (other);
+    }
+
+    /* Compare with a string without regard to the case of ASCII letters, as
+       HTTP does for header names and most tokens. */
+    bool equalsIgnoreCase(const char * other) const
+    {
+        return ::strlen(other) == size && ::strncasecmp(data, other, size) == 0;
+    }
+
+    const char * data;
+    size_t size;
+};
+
+std::ostream & operator << (std::ostream & stream, const HttpStringView & view);
+
+
+/****************************************************************************/
+/* HTTP REQUEST VIEW                                                        */
+/****************************************************************************/
+
+/* Parts of an HTTP request as parsed by HttpRequestParser.  Every view points
+ * into the buffer of the parser. */
+
+struct HttpRequestView {
+    HttpRequestView()
+        : contentLength(-1), isChunked(false)
+    {
+    }
+
+    /* Value of the first header with the given name, compared without regard
+     * to case, or an empty view if there is no such header. */
+    HttpStringView findHeader(const char * name) const;
+
+    HttpStringView verb;
+    HttpStringView resource;            /* path only, without the query */
+    HttpStringView query;               /* after the '?', still url encoded */
+    HttpStringView version;
+
+    /* All of the headers, in the order received and with their names as
+     * sent. */
+    std::vector<std::pair<HttpStringView, HttpStringView> > headers;
+
+    HttpStringView contentType;
+    int64_t contentLength;              /* -1 when not specified */
+    bool isChunked;
+
+    /* Body of the request.  Always empty for chunked requests, which are
+     * reported as soon as their header is complete. */
+    HttpStringView body;
+};
+
+
+/****************************************************************************/
+/* HTTP REQUEST PARSER                                                      */
+/****************************************************************************/
+
+/* HttpRequestParser parses HTTP/1.1 requests in place.  The data of a
+ * connection is fed to it and the requests are pulled one at a time, as
+ * views of the data, which allows for several pipelined requests to be
+ * received at once on a keep-alive connection.
+ *
+ * To avoid copies, fed data is only referenced while nothing is pending in
+ * the parser; whatever hasn't been consumed must then be moved into the
+ * internal buffer with retain() before the fed data goes away.  The buffer
+ * keeps its capacity from one request to the next.
+ */
+
+struct HttpRequestParser {
+    enum Result {
+        NEED_MORE,   /* the next request is incomplete */
+        HEADER,      /* its header is complete but its body isn't */
+        REQUEST      /* it is complete and has been consumed */
+    };
+
+    HttpRequestParser(size_t maxHeaderSize = 16384)
+        : maxHeaderSize(maxHeaderSize)
+    {
+        clear();
+    }
+
+    /* Add data received on the connection. */
+    void feed(const char * data, size_t size);
+
+    void feed(const std::string & data)
+    {
+        feed(data.c_str(), data.size());
+    }
+
+    /* Parse the next request.  HEADER is returned once per request, when its
+     * header is complete before its body, with all but the body of the
+     * request set.  The views are valid until the next call to feed() or
+     * retain().  Throws an ML::Exception if the request is malformed or if
+     * its header is longer than maxHeaderSize. */
+    Result next(HttpRequestView & request);
+
+    /* Copy the data that was fed but not consumed yet into the internal
+     * buffer. */
+    void retain();
+
+    /* Returns and consumes all of the pending data, which is used for the
+     * body of chunked requests. */
+    std::string takePending();
+
+    /* Number of bytes fed but not consumed yet. */
+    size_t pending() const { return size_ - start_; }
+
+    bool empty() const { return pending() == 0; }
+
+    void clear();
+
+    void swap(HttpRequestParser & other);
+
+    size_t maxHeaderSize;
+
+private:
+    void parseHeader(const char * start, const char * end,
+                     HttpRequestView & request) const;
+
+    const char * data() const
+    {
+        return borrowed_ ? borrowed_ : buffer_.data();
+    }
+
+    std::string buffer_;
+    const char * borrowed_; /* data being fed, when not copied to buffer_ */
+    size_t size_;
+    size_t start_;          /* start of the next request in the data */
+
+    /* State of the next request, relative to its start */
+    size_t scanned_;        /* bytes already searched for the header end */
+    size_t headerSize_;     /* size of the header once it is complete */
+    uint64_t bodySize_;
+};
+
+} // namespace Datacratic
@@ -16,6 +16,7 @@
 #include "json_codec.h"
 #include "soa/types/value_description.h"
 #include "soa/types/json_printing.h"
+#include "soa/types/binary_json.h"
 #include "rest_request_params.h"
 #include "rest_request_params_types.h"
 
@@ -231,6 +232,41 @@ createParameterExtractor(Json::Value & argHelp,
         };
 }
 
+/** Free function to be called in order to generate a parameter extractor
+    for the given parameter.  See the CreateRestParameterGenerator class for more
+    details.
+*/
+template<typename T>
+static std::function<T (const RestServiceEndpoint::ConnectionId & connection,
+                        const RestRequest & request,
+                        const RestRequestParsingContext & context)>
+createParameterExtractor(Json::Value & argHelp,
+                         const JsonOrBinaryParam<T> & p, void * = 0)
+{
+    Json::Value & v = argHelp["jsonParams"];
+    Json::Value & v2 = v[v.size()];
+    v2["description"] = p.description;
+    v2["cppType"] = ML::type_name<T>();
+    v2["encoding"] = std::string("JSON or ") + BinaryJson::ContentType;
+    v2["location"] = "Request Body";
+
+    return [=] (const RestServiceEndpoint::ConnectionId & connection,
+                const RestRequest & request,
+                const RestRequestParsingContext & context)
+        {
+            // The binary header can't start a JSON document, so the payload
+            // tells us which one we have even without a content type
+            const std::string & payload = request.payload;
+            if (!BinaryJson::isBinaryJson(payload.c_str(), payload.size()))
+                return JsonCodec<T>::decode(Json::parse(payload));
+
+            static auto desc = getDefaultDescriptionShared((T *)0);
+            T result;
+            desc->parseBinary(&result, payload.c_str(), payload.size());
+            return result;
+        };
+}
+
 /** Free function to be called in order to generate a parameter extractor
     for the given parameter.  See the CreateRestParameterGenerator class for more
     details.
@@ -220,6 +220,26 @@ struct JsonParam {
 };
 
 
+/** This indicates that we get the whole payload as a parameter, decoded
+    with the value description of T.  The payload is JSON, or binary JSON as
+    printed by ValueDescription::printBinary(), which is recognized by its
+    header.
+*/
+template<typename T>
+struct JsonOrBinaryParam {
+    JsonOrBinaryParam()
+    {
+    }
+
+    JsonOrBinaryParam(const std::string & description)
+        : description(description)
+    {
+    }
+
+    std::string description;
+};
+
+
 /** This indicates that we get a parameter from the path of the request. 
     For example, GET /v1/object/3/value, this would be able to bind "3" to
     a parameter of the request.
@@ -60,6 +60,59 @@ get(std::ostream & output) const {
     return result;
 }
 
+namespace {
+
+/** Aggregator that forwards to onEvent() for services that can't intern. */
+struct ForwardingAggregator : public StatAggregator {
+
+    ForwardingAggregator(EventService * service,
+                         const std::string & name,
+                         const char * event,
+                         StatEventType type)
+        : service(service), name(name), event(event), type(type)
+    {
+    }
+
+    virtual void record(float value)
+    {
+        service->onEvent(name, event.c_str(), type, value);
+    }
+
+    virtual std::vector<StatReading> read(const std::string & prefix)
+    {
+        return std::vector<StatReading>();
+    }
+
+    EventService * service;
+    std::string name;
+    std::string event;
+    StatEventType type;
+};
+
+} // namespace anonymous
+
+std::shared_ptr<StatAggregator>
+EventService::
+intern(const std::string & name,
+       const char * event,
+       StatEventType type,
+       const std::vector<int> & extra)
+{
+    return std::make_shared<ForwardingAggregator>(this, name, event, type);
+}
+
+
+/*****************************************************************************/
+/* EVENT HANDLE                                                              */
+/*****************************************************************************/
+
+void
+EventHandle::
+record(float value) const
+{
+    if (stat) stat->record(value);
+}
+
 /*****************************************************************************/
 /* NULL EVENT SERVICE                                                        */
 /*****************************************************************************/
@@ -86,6 +139,16 @@ onEvent(const std::string & name,
     stats->record(name + "." + event, type, value);
 }
 
+std::shared_ptr<StatAggregator>
+NullEventService::
+intern(const std::string & name,
+       const char * event,
+       StatEventType type,
+       const std::vector<int> & extra)
+{
+    return stats->intern(name + "." + event, type, extra);
+}
+
 void
 NullEventService::
 dump(std::ostream & stream) const
@@ -142,6 +205,17 @@ onEvent(const std::string & name,
     connector->record(stat, type, value, extra);
 }
 
+std::shared_ptr<StatAggregator>
+CarbonEventService::
+intern(const std::string & name,
+       const char * event,
+       StatEventType type,
+       const std::vector<int> & extra)
+{
+    return connector->intern(name.empty() ? event : name + "." + event,
+                             type, extra);
+}
+
 
 /*****************************************************************************/
 /* CONFIGURATION SERVICE                                                     */
@@ -711,6 +785,23 @@ recordEventFmt(StatEventType type,
     }
 }
 
+EventHandle
+EventRecorder::
+internEvent(const std::string & event,
+            StatEventType type,
+            const std::vector<int> & extra) const
+{
+    EventService * es = 0;
+    if (events_)
+        es = events_.get();
+    if (!es && services_)
+        es = services_->events.get();
+    if (!es)
+        return EventHandle();
+
+    return EventHandle(es->intern(eventPrefix_, event.c_str(), type, extra));
+}
+
 /*****************************************************************************/
 /* SERVICE BASE                                                              */
 /*****************************************************************************/
@@ -36,6 +36,7 @@ namespace Datacratic {
 
 class MultiAggregator;
 class CarbonConnector;
+struct StatAggregator;
 
 /*****************************************************************************/
 /* EVENT SERVICE                                                             */
@@ -52,6 +53,17 @@ struct EventService {
                          float value,
                          std::initializer_list<int> extra = DefaultOutcomePercentiles) = 0;
 
+    /** Return the aggregator that onEvent() records the given event into so
+        that it can be recorded without building its name or looking it up.
+        The default implementation returns an aggregator that forwards to
+        onEvent(), using the default percentiles for outcomes.
+    */
+    virtual std::shared_ptr<StatAggregator>
+    intern(const std::string & name,
+           const char * event,
+           StatEventType type,
+           const std::vector<int> & extra = DefaultOutcomePercentiles);
+
     virtual void dump(std::ostream & stream) const
     {
     }
@@ -76,6 +88,12 @@ struct NullEventService : public EventService {
                          float value,
                          std::initializer_list<int> extra = DefaultOutcomePercentiles);
 
+    virtual std::shared_ptr<StatAggregator>
+    intern(const std::string & name,
+           const char * event,
+           StatEventType type,
+           const std::vector<int> & extra = DefaultOutcomePercentiles);
+
     virtual void dump(std::ostream & stream) const;
 
     std::unique_ptr<MultiAggregator> stats;
@@ -102,6 +120,12 @@ struct CarbonEventService : public EventService {
                          float value,
                          std::initializer_list<int> extra = std::initializer_list<int>());
 
+    virtual std::shared_ptr<StatAggregator>
+    intern(const std::string & name,
+           const char * event,
+           StatEventType type,
+           const std::vector<int> & extra = DefaultOutcomePercentiles);
+
     std::shared_ptr<CarbonConnector> connector;
 };
 
@@ -443,6 +467,38 @@ struct ServiceProxies {
 };
 
 
+/*****************************************************************************/
+/* EVENT HANDLE                                                              */
+/*****************************************************************************/
+
+/** Event that was interned through EventRecorder::internEvent().  Recording
+    through a handle goes straight to the aggregator of the event: its name
+    isn't formatted and isn't looked up which makes it cheap enough to record
+    on every request.
+
+    Handles are cheap to copy.  A default constructed handle records nothing.
+*/
+
+struct EventHandle {
+    EventHandle()
+    {
+    }
+
+    explicit EventHandle(std::shared_ptr<StatAggregator> stat)
+        : stat(std::move(stat))
+    {
+    }
+
+    /** Record an occurence of the event; hits should keep the default. */
+    void record(float value = 1.0) const;
+
+    JML_IMPLEMENT_OPERATOR_BOOL(stat.get());
+
+private:
+    std::shared_ptr<StatAggregator> stat;
+};
+
+
 /*****************************************************************************/
 /* EVENT RECORDER                                                            */
 /*****************************************************************************/
@@ -493,6 +549,17 @@ struct EventRecorder {
                         std::initializer_list<int> extra,
                         const char * fmt, ...) const JML_FORMAT_STRING(5, 6);
 
+    /** Resolve an event once so that it can be recorded through the returned
+        handle on hot paths.  The handle records into the event service that
+        was in place when it was interned so this shouldn't be called before
+        the services are set up.  Returns a null handle when there are no
+        services.
+    */
+    EventHandle internEvent(const std::string & event,
+                            StatEventType type = ET_HIT,
+                            const std::vector<int> & extra
+                                = DefaultOutcomePercentiles) const;
+
     template<typename... Args>
     void recordHit(const std::string & event, Args... args) const
     {
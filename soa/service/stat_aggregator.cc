@@ -14,8 +14,13 @@
 #include "jml/utils/floating_point.h"
 #include "jml/utils/smart_ptr_utils.h"
 #include "jml/utils/exc_check.h"
+#include "jml/utils/guard.h"
 #include <boost/tuple/tuple.hpp>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 
 using namespace std;
@@ -30,7 +35,7 @@ namespace Datacratic {
 
 CounterAggregator::
 CounterAggregator()
-    : start(Date::now()), total(0.0),
+    : start(Date::now()),
       totalsBuffer() // Keep 10sec of data.
 {
 }
@@ -40,10 +45,28 @@ CounterAggregator::
 {
 }
 
+namespace {
+
+/** Slot of the calling thread.  Threads are handed out slots round robin the
+    first time they record a count.
+*/
+unsigned threadSlot()
+{
+    static std::atomic<unsigned> nextSlot(0);
+    static __thread int slot = -1;
+
+    if (JML_UNLIKELY(slot < 0))
+        slot = nextSlot.fetch_add(1) & 0x7FFFFFFF;
+    return slot;
+}
+
+} // namespace anonymous
+
 void
 CounterAggregator::
 record(float value)
 {
+    double & total = slots[threadSlot() % NumSlots].total;
     double oldval = total;
 
     while (!ML::cmp_xchg(total, oldval, oldval + value));
@@ -53,14 +76,18 @@ std::pair<double, Date>
 CounterAggregator::
 reset()
 {
-    double oldval = total;
+    double result = 0.0;
 
-    while (!ML::cmp_xchg(total, oldval, 0.0));
+    for (Slot & slot: slots) {
+        double oldval = slot.total;
+        while (!ML::cmp_xchg(slot.total, oldval, 0.0));
+        result += oldval;
+    }
 
     Date oldStart = start;
     start = Date::now();
 
-    return make_pair(oldval, oldStart);
+    return make_pair(result, oldStart);
 }
 
 std::vector<StatReading>
@@ -85,72 +112,308 @@ read(const std::string & prefix)
 }
 
 
+/*****************************************************************************/
+/* GAUGE HISTOGRAM                                                           */
+/*****************************************************************************/
+
+GaugeHistogram::Page::
+Page()
+{
+    for (auto & count: counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+GaugeHistogram::
+GaugeHistogram()
+{
+    for (auto & page: pages)
+        page.store(nullptr, std::memory_order_relaxed);
+    zero.store(0, std::memory_order_relaxed);
+}
+
+GaugeHistogram::
+~GaugeHistogram()
+{
+    for (auto & page: pages)
+        delete page.load(std::memory_order_relaxed);
+}
+
+GaugeHistogram::Page *
+GaugeHistogram::
+getPage(int page)
+{
+    Page * result = pages[page].load(std::memory_order_acquire);
+    if (result)
+        return result;
+
+    std::unique_ptr<Page> newPage(new Page());
+    if (pages[page].compare_exchange_strong(result, newPage.get(),
+                                            std::memory_order_acq_rel))
+        return newPage.release();
+
+    // Another thread got there first; result is its page
+    return result;
+}
+
+template<typename Fn>
+void
+GaugeHistogram::
+forEachBucket(const Fn & fn) const
+{
+    auto doPages = [&] (int begin, int end)
+        {
+            for (int i = begin;  i < end;  ++i) {
+                Page * page = pages[i].load(std::memory_order_acquire);
+                if (!page)
+                    continue;
+                int first = firstBucket(i);
+                for (int j = 0;  j < SubBuckets;  ++j)
+                    fn(first + j, page->counts[j]);
+            }
+        };
+
+    // Only the non-const methods modify the counts through fn
+    doPages(0, NumPages / 2);
+    fn(int(ZeroBucket), const_cast<std::atomic<uint32_t> &>(zero));
+    doPages(NumPages / 2, NumPages);
+}
+
+void
+GaugeHistogram::
+merge(const GaugeHistogram & other)
+{
+    other.forEachBucket([&] (int bucket, std::atomic<uint32_t> & count)
+        {
+            uint32_t n = count.load(std::memory_order_relaxed);
+            if (!n)
+                return;
+            if (bucket == ZeroBucket)
+                zero.fetch_add(n, std::memory_order_relaxed);
+            else {
+                int page = pageOf(bucket);
+                getPage(page)->counts[bucket - firstBucket(page)]
+                    .fetch_add(n, std::memory_order_relaxed);
+            }
+        });
+}
+
+void
+GaugeHistogram::
+drain(GaugeHistogram & into)
+{
+    forEachBucket([&] (int bucket, std::atomic<uint32_t> & count)
+        {
+            // Most buckets are empty; don't dirty their cache lines
+            if (!count.load(std::memory_order_relaxed))
+                return;
+            uint32_t n = count.exchange(0, std::memory_order_relaxed);
+            if (bucket == ZeroBucket)
+                into.zero.fetch_add(n, std::memory_order_relaxed);
+            else {
+                int page = pageOf(bucket);
+                into.getPage(page)->counts[bucket - firstBucket(page)]
+                    .fetch_add(n, std::memory_order_relaxed);
+            }
+        });
+}
+
+void
+GaugeHistogram::
+clear()
+{
+    forEachBucket([&] (int bucket, std::atomic<uint32_t> & count)
+        {
+            if (count.load(std::memory_order_relaxed))
+                count.store(0, std::memory_order_relaxed);
+        });
+}
+
+uint64_t
+GaugeHistogram::
+count() const
+{
+    uint64_t result = 0;
+    forEachBucket([&] (int bucket, std::atomic<uint32_t> & count)
+        {
+            result += count.load(std::memory_order_relaxed);
+        });
+    return result;
+}
+
+double
+GaugeHistogram::
+percentile(float outOf100, uint64_t n) const
+{
+    if (n == 0)
+        return 0.0;
+
+    // Same element as the one a sorted list of the values would give
+    uint64_t element
+        = std::max<int64_t>(0, std::min<int64_t>(n - 1, outOf100 / 100.0 * n));
+
+    // Values recorded since n was counted may push it further; values
+    // drained since may leave it beyond the last bucket
+    int result = -1;
+    uint64_t seen = 0;
+    forEachBucket([&] (int bucket, std::atomic<uint32_t> & count)
+        {
+            if (result != -1)
+                return;
+            uint32_t c = count.load(std::memory_order_relaxed);
+            seen += c;
+            if (c && seen > element)
+                result = bucket;
+        });
+
+    return bucketValue(result == -1 ? NumBuckets - 1 : result);
+}
+
+int
+GaugeHistogram::
+bucketOf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    int exponent = int((bits >> 23) & 0xff) - 127;
+    if (exponent < MinExponent)
+        return ZeroBucket;
+
+    int index;
+    if (exponent > MaxExponent)
+        index = BucketsPerSign - 1;
+    else index = ((exponent - MinExponent) << SubBucketBits)
+             | ((bits >> (23 - SubBucketBits)) & (SubBuckets - 1));
+
+    return (bits >> 31) ? ZeroBucket - 1 - index : ZeroBucket + 1 + index;
+}
+
+double
+GaugeHistogram::
+bucketValue(int bucket)
+{
+    if (bucket == ZeroBucket)
+        return 0.0;
+
+    bool negative = bucket < ZeroBucket;
+    int index = negative ? ZeroBucket - 1 - bucket : bucket - ZeroBucket - 1;
+    int exponent = (index >> SubBucketBits) + MinExponent;
+    int sub = index & (SubBuckets - 1);
+
+    double value = std::ldexp(1.0 + (sub + 0.5) / SubBuckets, exponent);
+    return negative ? -value : value;
+}
+
+
 /*****************************************************************************/
 /* GAUGE AGGREGATOR                                                          */
 /*****************************************************************************/
 
+GaugeAggregator::Summary::
+Summary()
+    : count(0), total(0.0),
+      lower(std::numeric_limits<float>::infinity()),
+      upper(-std::numeric_limits<float>::infinity())
+{
+}
+
 GaugeAggregator::
 GaugeAggregator(Verbosity verbosity, const std::vector<int>& extra)
-    : verbosity(verbosity), values(new ML::distribution<float>())
-    , extra(extra)
+    : verbosity(verbosity),
+      lower(std::numeric_limits<float>::infinity()),
+      upper(-std::numeric_limits<float>::infinity()),
+      extra(extra)
 {
-    if (verbosity == Outcome)
+    if (verbosity == Outcome) {
         ExcCheck(this->extra.size() > 0, "Can not construct with empty percentiles");
-
-    values->reserve(100);
+        histogram.reset(new GaugeHistogram());
+        readHistogram.reset(new GaugeHistogram());
+    }
 }
 
 GaugeAggregator::
 ~GaugeAggregator()
 {
-    delete values;
 }
 
 void
 GaugeAggregator::
 record(float value)
 {
-    ML::distribution<float> * current = values;
-    while ((current = values) == 0 || !cmp_xchg(values, current,
-                                     (ML::distribution<float>*)0));
-    
-    current->push_back(value);
-
-    memory_barrier();
-
-    values = current;
+    if (std::isnan(value))
+        return;
+
+    Slot & slot = slots[threadSlot() % NumSlots];
+    double oldval = slot.total;
+    while (!ML::cmp_xchg(slot.total, oldval, oldval + value));
+    ML::atomic_inc(slot.count);
+
+    // The extremes only move a handful of times per period
+    float current = lower.load(std::memory_order_relaxed);
+    while (value < current && !lower.compare_exchange_weak(current, value));
+    current = upper.load(std::memory_order_relaxed);
+    while (value > current && !upper.compare_exchange_weak(current, value));
+
+    if (histogram)
+        histogram->record(value);
 }
 
-std::pair<ML::distribution<float> *, Date>
+void
 GaugeAggregator::
-reset()
+take(Summary & summary, GaugeHistogram * drainInto)
 {
-    ML::distribution<float> * current = values;
-    ML::distribution<float> * new_current = new ML::distribution<float>();
+    for (Slot & slot: slots) {
+        double oldval = slot.total;
+        while (!ML::cmp_xchg(slot.total, oldval, 0.0));
+        summary.total += oldval;
+
+        uint64_t oldcount = slot.count;
+        while (!ML::cmp_xchg(slot.count, oldcount, (uint64_t)0));
+        summary.count += oldcount;
+    }
 
-    // TODO: reserve memory for new_current
+    summary.lower = lower.exchange(std::numeric_limits<float>::infinity());
+    summary.upper = upper.exchange(-std::numeric_limits<float>::infinity());
 
-    while ((current = values) == 0 || !cmp_xchg(values, current, new_current));
+    if (histogram)
+        histogram->drain(*drainInto);
 
     // Date oldStart = start;
     start = Date::now();
+}
 
-    return make_pair(current, start);
+std::pair<GaugeAggregator::Summary, Date>
+GaugeAggregator::
+reset()
+{
+    Summary summary;
+    if (histogram)
+        summary.histogram.reset(new GaugeHistogram());
+    take(summary, summary.histogram.get());
+    return make_pair(std::move(summary), start);
 }
 
 std::vector<StatReading>
 GaugeAggregator::
 read(const std::string & prefix)
 {
-    ML::distribution<float> * values;
-    Date oldStart;
-
-    boost::tie(values, oldStart) = reset();
+    Summary summary;
+    take(summary, readHistogram.get());
 
-    std::auto_ptr<ML::distribution<float> > vptr(values);
+    // The histogram is kept for the next read
+    ML::Call_Guard clearHistogram([&] ()
+        {
+            if (readHistogram)
+                readHistogram->clear();
+        });
 
-    if (values->empty())
+    if (summary.count == 0)
         return vector<StatReading>();
+
+    // A value recorded during the reset may have been counted without its
+    // extremes being updated yet.
+    if (summary.lower > summary.upper)
+        summary.lower = summary.upper = summary.mean();
     
     vector<StatReading> result;
 
@@ -160,28 +423,26 @@ read(const std::string & prefix)
                                          value, start));
         };
     
+    // Values recorded during the reset can put the histogram slightly out
+    // of step with the extremes; never report a percentile outside of them.
+    uint64_t histogramCount = readHistogram ? readHistogram->count() : 0;
     auto percentile = [&] (float outOf100) -> double
         {
-            int element
-                = std::max(0,
-                           std::min<int>(values->size() - 1,
-                                         outOf100 / 100.0 * values->size()));
-            return (*values)[element];
+            double value = readHistogram->percentile(outOf100, histogramCount);
+            return std::max<double>(summary.lower,
+                                    std::min<double>(summary.upper, value));
         };
     
-    std::sort(values->begin(), values->end(),
-              ML::safe_less<float>());
-
     if (verbosity == StableLevel)
-        result.push_back(StatReading(prefix, values->mean(), start));
+        result.push_back(StatReading(prefix, summary.mean(), start));
     
     else {
-        addMetric("mean", values->mean());
-        addMetric("upper", values->back());
-        addMetric("lower", values->front());
+        addMetric("mean", summary.mean());
+        addMetric("upper", summary.upper);
+        addMetric("lower", summary.lower);
 
         if (verbosity == Outcome) {
-            addMetric("count", values->size());
+            addMetric("count", summary.count);
             for (int pct: extra) {
                 addMetric(ML::format("upper_%d", pct).c_str(), percentile(pct));
             }
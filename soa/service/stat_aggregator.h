@@ -13,6 +13,8 @@
 #include "soa/types/date.h"
 #include "stats_events.h"
 #include <unordered_map>
+#include <atomic>
+#include <memory>
 #include <map>
 #include <deque>
 #include <boost/scoped_ptr.hpp>
@@ -59,13 +61,21 @@ struct StatAggregator {
 /* COUNTER AGGREGATOR                                                        */
 /*****************************************************************************/
 
-/** Class that aggregates counts over a period of time. */
+/** Class that aggregates counts over a period of time.
+
+    The total is spread over cache line sized slots and each thread adds to
+    its own slot so that a counter hit from every request doesn't bounce a
+    single cache line between the threads.
+*/
 
 struct CounterAggregator : public StatAggregator {
     CounterAggregator();
 
     virtual ~CounterAggregator();
 
+    /** Record a value.  Lock-free; a single uncontended compare and swap in
+        the common case.
+    */
     virtual void record(float value);
 
     std::pair<double, Date> reset();
@@ -75,19 +85,165 @@ struct CounterAggregator : public StatAggregator {
     virtual std::vector<StatReading> read(const std::string & prefix);
 
 private:
+    enum { NumSlots = 16 };
+
+    // Padded rather than aligned as operator new doesn't honour alignment.
+    struct Slot {
+        Slot() : total(0.0) {}
+        double total;  //< total since we last added it up
+        char padding[64 - sizeof(double)];
+    };
+
     Date start;    //< Date at which we last cleared the counter
-    double total;  //< total since we last added it up
+    Slot slots[NumSlots];
 
     std::deque<double> totalsBuffer; //< Totals for the last n reads.
 
 };
 
 
+/*****************************************************************************/
+/* GAUGE HISTOGRAM                                                           */
+/*****************************************************************************/
+
+/** Fixed size histogram of float values with logarithmic buckets, used to
+    estimate the percentiles of a gauge without keeping its values around.
+
+    Each power of two between 2^MinExponent and 2^(MaxExponent + 1) is split
+    into 2^SubBucketBits linear buckets, for both signs, which bounds the
+    relative error on a percentile to half a bucket, or about 1.6%.  Values
+    closer to zero than 2^MinExponent are counted as zero and values
+    beyond the last bucket saturate into it.
+
+    Recording is a single atomic increment and the memory used doesn't
+    depend on the number of values recorded.  Histograms can be merged by
+    adding up their buckets.
+
+    The buckets of each power of two are only allocated once a value falls
+    into it, as a gauge rarely spans more than a few of them: an empty
+    histogram only takes about 1KB.
+*/
+
+struct GaugeHistogram {
+
+    enum {
+        SubBucketBits = 5,
+        SubBuckets = 1 << SubBucketBits,
+        MinExponent = -16,
+        MaxExponent = 47,
+        BucketsPerSign = (MaxExponent - MinExponent + 1) * SubBuckets,
+        ZeroBucket = BucketsPerSign,
+        NumBuckets = 2 * BucketsPerSign + 1,
+        NumPages = 2 * BucketsPerSign / SubBuckets
+    };
+
+    GaugeHistogram();
+    ~GaugeHistogram();
+
+    GaugeHistogram(const GaugeHistogram &) = delete;
+    void operator = (const GaugeHistogram &) = delete;
+
+    /** Record a value.  Lock-free; it only waits for an allocation the
+        first time that a value falls into a power of two.
+    */
+    void record(float value)
+    {
+        int bucket = bucketOf(value);
+        if (bucket == ZeroBucket) {
+            zero.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        int page = pageOf(bucket);
+        Page * p = pages[page].load(std::memory_order_acquire);
+        if (!p)
+            p = getPage(page);
+        p->counts[bucket - firstBucket(page)]
+            .fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** Add the counts of the other histogram to this one. */
+    void merge(const GaugeHistogram & other);
+
+    /** Move all the counts of this histogram over to the other one, leaving
+        this one empty.  Values recorded concurrently end up in one of the
+        two.
+    */
+    void drain(GaugeHistogram & into);
+
+    /** Reset all of the counts to zero, keeping the buckets allocated so
+        that the histogram can be reused. */
+    void clear();
+
+    /** Number of values in the histogram. */
+    uint64_t count() const;
+
+    /** Estimate of the value below which the given percentage of the values
+        lie.  Returns zero for an empty histogram.
+    */
+    double percentile(float outOf100) const
+    {
+        return percentile(outOf100, count());
+    }
+
+    /** Same as above, for a histogram known to hold count values.  Saves
+        counting them again when taking several percentiles.
+    */
+    double percentile(float outOf100, uint64_t count) const;
+
+    /** Bucket into which the value falls; buckets are ordered by value. */
+    static int bucketOf(float value);
+
+    /** Value at the middle of the given bucket. */
+    static double bucketValue(int bucket);
+
+private:
+    /** Buckets of one power of two and sign. */
+    struct Page {
+        Page();
+        std::atomic<uint32_t> counts[SubBuckets];
+    };
+
+    /** Pages in bucket order; the negative ones come before the zero
+        bucket. */
+    std::atomic<Page *> pages[NumPages];
+    std::atomic<uint32_t> zero;
+
+    static int pageOf(int bucket)
+    {
+        return bucket < ZeroBucket
+            ? bucket >> SubBucketBits
+            : NumPages / 2 + ((bucket - ZeroBucket - 1) >> SubBucketBits);
+    }
+
+    static int firstBucket(int page)
+    {
+        return page < NumPages / 2
+            ? page << SubBucketBits
+            : ZeroBucket + 1 + ((page - NumPages / 2) << SubBucketBits);
+    }
+
+    /** Return the page, allocating it if it doesn't exist yet. */
+    Page * getPage(int page);
+
+    /** Call fn(bucket, count) for each allocated bucket in order, where
+        count is the bucket's std::atomic<uint32_t>. */
+    template<typename Fn>
+    void forEachBucket(const Fn & fn) const;
+};
+
+
 /*****************************************************************************/
 /* GAUGE AGGREGATOR                                                          */
 /*****************************************************************************/
 
-/** Class that aggregates a gauge over a period of time. */
+/** Class that aggregates a gauge over a period of time.
+
+    The values themselves are not kept: the total and count are spread over
+    per thread slots like the CounterAggregator's, and the percentiles of an
+    Outcome come from a GaugeHistogram, so that the memory used is the same
+    whatever the rate at which values are recorded.
+*/
 
 struct GaugeAggregator : public StatAggregator {
 
@@ -103,11 +259,24 @@ struct GaugeAggregator : public StatAggregator {
 
     virtual ~GaugeAggregator();
 
-    /** Record a new value of the stat.  Lock-free but may spin briefly. */
+    /** Record a new value of the stat.  Lock-free; NaN values are ignored. */
     virtual void record(float value);
 
-    /** Obtain a the current statistics and replace with a new version. */
-    std::pair<ML::distribution<float> *, Date> reset();
+    /** Values recorded between two resets. */
+    struct Summary {
+        Summary();
+
+        uint64_t count;
+        double total;
+        float lower;
+        float upper;
+        std::unique_ptr<GaugeHistogram> histogram;  ///< Only for Outcome
+
+        double mean() const { return count ? total / count : 0.0; }
+    };
+
+    /** Obtain the current statistics and start over. */
+    std::pair<Summary, Date> reset();
 
     /** Read and reset the counter, providing output in Graphite's preferred
         format.
@@ -115,10 +284,32 @@ struct GaugeAggregator : public StatAggregator {
     virtual std::vector<StatReading> read(const std::string & prefix);
 
 private:
+    enum { NumSlots = 16 };
+
+    // Padded rather than aligned as operator new doesn't honour alignment.
+    struct Slot {
+        Slot() : total(0.0), count(0) {}
+        double total;
+        uint64_t count;
+        char padding[64 - sizeof(double) - sizeof(uint64_t)];
+    };
+
     Verbosity verbosity;
     Date start;  //< Date at which we last cleared the counter
-    ML::distribution<float> * volatile values;  //< List of added values
+    Slot slots[NumSlots];
+    std::atomic<float> lower;
+    std::atomic<float> upper;
+    std::unique_ptr<GaugeHistogram> histogram;  //< Only for Outcome
     std::vector<int> extra;
+
+    /** Histogram into which read() drains the values, kept between reads
+        so that its buckets don't need to be allocated every time. */
+    std::unique_ptr<GaugeHistogram> readHistogram;
+
+    /** Take the values recorded since the last reset, draining the
+        histogram into the given one.  The summary's histogram isn't set.
+    */
+    void take(Summary & summary, GaugeHistogram * drainInto);
 };
 
 
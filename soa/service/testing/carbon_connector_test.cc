@@ -14,6 +14,8 @@
 #include "jml/arch/timers.h"
 #include "soa/service/passive_endpoint.h"
 #include <boost/make_shared.hpp>
+#include <limits>
+#include <map>
 
 
 using namespace std;
@@ -88,32 +90,30 @@ BOOST_AUTO_TEST_CASE( test_gauge_aggregator )
 
     boost::mutex mutex;
 
-    ML::distribution<float> allValues;
+    uint64_t count = 0, histogramCount = 0;
+    double total = 0.0;
+
+    auto addSummary = [&] (const GaugeAggregator::Summary & summary)
+        {
+            count += summary.count;
+            total += summary.total;
+            histogramCount += summary.histogram->count();
+        };
 
     for (unsigned i = 0;  i < nthreads;  ++i) {
         auto doThread = [&] ()
             {
-                ML::distribution<float> threadValues;
-
                 barrier.wait();
 
                 for (unsigned i = 0;  i < iter;  ++i) {
                     aggregator.record(1.0 + (i % 2));
 
                     if (random() % 1000 == 0) {
-                        ML::distribution<float> * values
-                            = aggregator.reset().first;
-                       
-                        threadValues.insert(threadValues.end(),
-                                            values->begin(), values->end());
-
-                        delete values;
+                        auto summary = aggregator.reset().first;
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        addSummary(summary);
                     }
                 }
-                
-                boost::lock_guard<boost::mutex> lock(mutex);
-                allValues.insert(allValues.end(),
-                                 threadValues.begin(), threadValues.end());
             };
         
         tg.create_thread(doThread);
@@ -121,16 +121,118 @@ BOOST_AUTO_TEST_CASE( test_gauge_aggregator )
 
     tg.join_all();
 
-    ML::distribution<float> * values
-        = aggregator.reset().first;
-    
-    allValues.insert(allValues.end(),
-                     values->begin(), values->end());
-    std::sort(allValues.begin(), allValues.end());
+    addSummary(aggregator.reset().first);
+
+    BOOST_CHECK_EQUAL(count, iter * nthreads);
+    BOOST_CHECK_EQUAL(histogramCount, iter * nthreads);
+    BOOST_CHECK_EQUAL(total / count, 1.5);
+}
+
+BOOST_AUTO_TEST_CASE( test_gauge_histogram )
+{
+    GaugeHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.count(), 0);
+    BOOST_CHECK_EQUAL(histogram.percentile(50), 0.0);
+
+    // Buckets are ordered by value, whatever the sign
+    float previous = -1e20;
+    for (float v: { -1e20f, -1000.0f, -1.5f, -1.0f, -0.001f, 0.0f,
+                    0.001f, 1.0f, 1.5f, 1000.0f, 1e20f }) {
+        BOOST_CHECK_LE(GaugeHistogram::bucketOf(previous),
+                       GaugeHistogram::bucketOf(v));
+        previous = v;
+    }
+    BOOST_CHECK_EQUAL(GaugeHistogram::bucketOf(0.0),
+                      GaugeHistogram::ZeroBucket);
+    BOOST_CHECK_EQUAL(GaugeHistogram::bucketOf(-0.0),
+                      GaugeHistogram::ZeroBucket);
+    BOOST_CHECK_EQUAL(GaugeHistogram::bucketOf(1e-10),
+                      GaugeHistogram::ZeroBucket);
+    BOOST_CHECK_EQUAL(GaugeHistogram::bucketOf(1e30),
+                      GaugeHistogram::NumBuckets - 1);
+    BOOST_CHECK_EQUAL(GaugeHistogram::bucketOf(-1e30), 0);
+
+    // Percentiles are within half a bucket of the exact ones
+    std::vector<float> values;
+    for (unsigned i = 0;  i < 100000;  ++i) {
+        float v = (random() % 1000000) / 1000.0;
+        values.push_back(v);
+        histogram.record(v);
+    }
+    std::sort(values.begin(), values.end());
+
+    BOOST_CHECK_EQUAL(histogram.count(), values.size());
+    for (int pct: { 10, 50, 90, 95, 99 }) {
+        float exact = values[pct / 100.0 * values.size()];
+        BOOST_CHECK_CLOSE(histogram.percentile(pct), exact, 1.6);
+    }
+
+    // Merging adds up the counts
+    GaugeHistogram other;
+    for (unsigned i = 0;  i < 100000;  ++i)
+        other.record(2000.0);
+    other.merge(histogram);
+    BOOST_CHECK_EQUAL(other.count(), 200000);
+    BOOST_CHECK_CLOSE(other.percentile(99), 2000.0, 1.6);
+
+    // Draining empties the histogram
+    GaugeHistogram drained;
+    histogram.drain(drained);
+    BOOST_CHECK_EQUAL(histogram.count(), 0);
+    BOOST_CHECK_EQUAL(drained.count(), values.size());
+    BOOST_CHECK_EQUAL(drained.percentile(50, values.size()),
+                      drained.percentile(50));
+
+    // ... and so does clearing it, which keeps it usable
+    drained.clear();
+    BOOST_CHECK_EQUAL(drained.count(), 0);
+    drained.record(-3.0);
+    BOOST_CHECK_CLOSE(drained.percentile(50), -3.0, 1.6);
+
+    // Buckets are only allocated for the values that are recorded
+    BOOST_CHECK_LT(sizeof(GaugeHistogram), 2048);
+}
 
-    BOOST_CHECK_EQUAL(allValues.size(), iter * nthreads);
-    BOOST_CHECK_EQUAL(allValues.mean(), 1.5);
-    BOOST_CHECK_EQUAL(allValues.std(), 0.5);
+BOOST_AUTO_TEST_CASE( test_gauge_aggregator_read )
+{
+    GaugeAggregator aggregator(GaugeAggregator::Outcome, { 50, 99 });
+    BOOST_CHECK(aggregator.read("x").empty());
+
+    for (unsigned i = 1;  i <= 1000;  ++i)
+        aggregator.record(i);
+    aggregator.record(std::numeric_limits<float>::quiet_NaN());
+
+    std::map<std::string, float> readings;
+    for (auto & reading: aggregator.read("x"))
+        readings[reading.name] = reading.value;
+
+    BOOST_CHECK_EQUAL(readings.size(), 6);
+    BOOST_CHECK_EQUAL(readings["x.count"], 1000);
+    BOOST_CHECK_EQUAL(readings["x.mean"], 500.5);
+    BOOST_CHECK_EQUAL(readings["x.lower"], 1);
+    BOOST_CHECK_EQUAL(readings["x.upper"], 1000);
+    BOOST_CHECK_CLOSE(readings["x.upper_50"], 501, 1.6);
+    BOOST_CHECK_CLOSE(readings["x.upper_99"], 991, 1.6);
+
+    // Everything was reset by the read
+    BOOST_CHECK(aggregator.read("x").empty());
+
+    // The next read only sees the values recorded since
+    aggregator.record(2000);
+    readings.clear();
+    for (auto & reading: aggregator.read("x"))
+        readings[reading.name] = reading.value;
+    BOOST_CHECK_EQUAL(readings["x.count"], 1);
+    BOOST_CHECK_CLOSE(readings["x.upper_50"], 2000, 1.6);
+    BOOST_CHECK_CLOSE(readings["x.upper_99"], 2000, 1.6);
+
+    GaugeAggregator level(GaugeAggregator::StableLevel);
+    level.record(3.0);
+    level.record(5.0);
+    auto stable = level.read("y");
+    BOOST_REQUIRE_EQUAL(stable.size(), 1);
+    BOOST_CHECK_EQUAL(stable[0].name, "y");
+    BOOST_CHECK_EQUAL(stable[0].value, 4.0);
 }
 
 BOOST_AUTO_TEST_CASE( test_multi_aggregator )
@@ -169,6 +271,30 @@ BOOST_AUTO_TEST_CASE( test_multi_aggregator )
     BOOST_CHECK_EQUAL(readings[0].value, 50.0);
 }
 
+BOOST_AUTO_TEST_CASE( test_multi_aggregator_intern )
+{
+    // Interned stats must be the same aggregators that record() uses so that
+    // both ways of recording end up in the same reading.
+
+    MultiAggregator agg;
+
+    auto hits = agg.intern("hits", ET_HIT);
+    BOOST_CHECK_EQUAL(hits, agg.intern("hits", ET_HIT));
+    BOOST_CHECK(hits != agg.intern("other", ET_HIT));
+
+    for (unsigned i = 0;  i < 10;  ++i) {
+        hits->record(1.0);
+        agg.recordHit("hits");
+    }
+
+    auto counter = std::dynamic_pointer_cast<CounterAggregator>(hits);
+    BOOST_REQUIRE(counter);
+    BOOST_CHECK_EQUAL(counter->reset().first, 20.0);
+
+    auto level = agg.intern("level", ET_LEVEL);
+    BOOST_CHECK(std::dynamic_pointer_cast<GaugeAggregator>(level));
+}
+
 struct FakeCarbon : public PassiveEndpointT<SocketTransport> {
 
     FakeCarbon()
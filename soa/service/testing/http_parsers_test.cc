@@ -4,6 +4,7 @@
 #include <iostream>
 #include <boost/test/unit_test.hpp>
 
+#include "jml/arch/exception.h"
 #include "soa/service/http_parsers.h"
 #include "soa/utils/print_utils.h"
 
@@ -255,3 +256,100 @@ BOOST_AUTO_TEST_CASE( http_parser_chunked_encoding_test )
     BOOST_CHECK_EQUAL(numResponses, 3);
 }
 #endif
+
+/* This test feeds the HttpRequestParser with requests split at various
+ * points, as well as pipelined requests arriving in the same packet. */
+BOOST_AUTO_TEST_CASE( http_request_parser_test )
+{
+    HttpRequestParser parser;
+    HttpRequestView request;
+
+    /* a request fed progressively */
+    string packet("POST /auctions?id=1&x=%20 HTTP/1.1\r\n"
+                  "Host: localhost\r\n"
+                  "Content-Type:  application/json \r\n"
+                  "Content-Length: 7\r\n"
+                  "\r\n"
+                  "{\"a\":1}");
+    size_t headerEnd = packet.find("\r\n\r\n") + 4;
+
+    /* fed data is borrowed until retain() is called */
+    string part = packet.substr(0, 10);
+    parser.feed(part);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::NEED_MORE);
+    parser.retain();
+    parser.feed(packet.substr(10, headerEnd - 12));
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::NEED_MORE);
+    parser.feed(packet.substr(headerEnd - 2, 4));
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::HEADER);
+    BOOST_CHECK_EQUAL(request.verb.str(), "POST");
+    BOOST_CHECK_EQUAL(request.contentLength, 7);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::NEED_MORE);
+    parser.retain();
+
+    part = packet.substr(headerEnd + 2);
+    parser.feed(part);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::REQUEST);
+    BOOST_CHECK_EQUAL(request.verb.str(), "POST");
+    BOOST_CHECK_EQUAL(request.resource.str(), "/auctions");
+    BOOST_CHECK_EQUAL(request.query.str(), "id=1&x=%20");
+    BOOST_CHECK_EQUAL(request.version.str(), "HTTP/1.1");
+    BOOST_CHECK_EQUAL(request.headers.size(), 3);
+    BOOST_CHECK_EQUAL(request.findHeader("host").str(), "localhost");
+    BOOST_CHECK_EQUAL(request.contentType.str(), "application/json");
+    BOOST_CHECK_EQUAL(request.body.str(), "{\"a\":1}");
+    BOOST_CHECK(parser.empty());
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::NEED_MORE);
+
+    /* pipelined requests in a single packet are parsed in place */
+    string pipelined = (packet
+                        + "GET /ready HTTP/1.1\r\n\r\n"
+                        + packet.substr(0, 20));
+    parser.feed(pipelined);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::REQUEST);
+    BOOST_CHECK_EQUAL(request.body.data, pipelined.c_str() + headerEnd);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::REQUEST);
+    BOOST_CHECK_EQUAL(request.verb.str(), "GET");
+    BOOST_CHECK_EQUAL(request.resource.str(), "/ready");
+    BOOST_CHECK(request.query.empty());
+    BOOST_CHECK_EQUAL(request.contentLength, -1);
+    BOOST_CHECK(request.body.empty());
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::NEED_MORE);
+    BOOST_CHECK_EQUAL(parser.pending(), 20);
+
+    /* the remainder survives the packet once retained */
+    parser.retain();
+    pipelined.assign(pipelined.size(), 'x');
+    part = packet.substr(20);
+    parser.feed(part);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::REQUEST);
+    BOOST_CHECK_EQUAL(request.resource.str(), "/auctions");
+    BOOST_CHECK_EQUAL(request.body.str(), "{\"a\":1}");
+
+    /* the body of chunked requests is left to the caller */
+    part = ("POST /chunks HTTP/1.1\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n"
+            "3\r\nabc\r\n");
+    parser.feed(part);
+    BOOST_CHECK_EQUAL(parser.next(request), HttpRequestParser::REQUEST);
+    BOOST_CHECK(request.isChunked);
+    BOOST_CHECK_EQUAL(parser.takePending(), "3\r\nabc\r\n");
+    BOOST_CHECK(parser.empty());
+
+    /* malformed requests */
+    parser.clear();
+    part = "GET / HTTP/1.1\r\nContent-Length: 1a\r\n\r\n";
+    parser.feed(part);
+    BOOST_CHECK_THROW(parser.next(request), ML::Exception);
+    parser.clear();
+    part = "GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n";
+    parser.feed(part);
+    BOOST_CHECK_THROW(parser.next(request), ML::Exception);
+
+    parser.clear();
+    parser.maxHeaderSize = 64;
+    part = "GET / HTTP/1.1\r\nHeader: " + string(64, 'v');
+    parser.feed(part);
+    BOOST_CHECK_THROW(parser.next(request), ML::Exception);
+}
@@ -14,6 +14,7 @@
 #include "soa/service/message_loop.h"
 #include "soa/service/typed_message_channel.h"
 #include <sys/socket.h>
+#include <poll.h>
 #include "jml/utils/guard.h"
 #include "jml/arch/exception_handler.h"
 #include "jml/utils/testing/watchdog.h"
@@ -89,6 +90,105 @@ BOOST_AUTO_TEST_CASE( test_message_channel )
     }
 }
 
+BOOST_AUTO_TEST_CASE( test_per_thread_message_sink )
+{
+    // Each message is (thread number, sequence number within the thread)
+    typedef std::pair<int, int> Message;
+
+    const int numThreads = 8, numMessages = 100000;
+
+    // Small rings so that producers regularly find theirs full
+    PerThreadMessageSink<Message> sink(64);
+
+    std::vector<int> lastSeen(numThreads, -1);
+    int numReceived = 0;
+    bool outOfOrder = false;
+
+    sink.onEvent = [&] (Message && message)
+        {
+            if (message.second != lastSeen[message.first] + 1)
+                outOfOrder = true;
+            lastSeen[message.first] = message.second;
+            ++numReceived;
+        };
+
+    ML::Watchdog watchdog(30.0);
+
+    // The consumer only looks at the rings when the fd says so, which
+    // makes sure that no wakeup gets lost.
+    int numTimeouts = 0;
+    auto processThread = [&] ()
+        {
+            while (numReceived < numThreads * numMessages) {
+                struct pollfd fd = { sink.selectFd(), POLLIN, 0 };
+                int res = ::poll(&fd, 1, 1000);
+                if (res == 0) {
+                    ++numTimeouts;
+                    cerr << "timeout with " << numReceived << " received"
+                         << endl;
+                }
+                while (sink.processOne());
+            }
+        };
+
+    auto pushThread = [&] (int threadNum)
+        {
+            for (int i = 0;  i < numMessages;  ++i)
+                sink.push(Message(threadNum, i));
+        };
+
+    std::thread consumer(processThread);
+
+    std::vector<std::thread> producers;
+    for (int i = 0;  i < numThreads;  ++i)
+        producers.emplace_back(pushThread, i);
+    for (auto & producer: producers)
+        producer.join();
+
+    consumer.join();
+
+    BOOST_CHECK_EQUAL(numReceived, numThreads * numMessages);
+    BOOST_CHECK(!outOfOrder);
+    BOOST_CHECK_EQUAL(numTimeouts, 0);
+    BOOST_CHECK_EQUAL(sink.size(), 0);
+    BOOST_CHECK(!sink.poll());
+
+    // The rings of the threads that exited are forgotten once drained
+    BOOST_CHECK(!sink.processOne());
+    sink.push(Message(0, numMessages));
+    BOOST_CHECK_EQUAL(sink.size(), 1);
+    BOOST_CHECK(sink.poll());
+    BOOST_CHECK(!sink.processOne());
+    BOOST_CHECK_EQUAL(lastSeen[0], numMessages);
+}
+
+BOOST_AUTO_TEST_CASE( test_per_thread_message_sink_full )
+{
+    PerThreadMessageSink<std::string> sink(1);
+
+    std::vector<std::string> received;
+    sink.onEvent = [&] (std::string && message)
+        {
+            received.push_back(message);
+        };
+
+    std::string first = "first";
+    BOOST_CHECK(sink.tryPush(std::move(first)));
+
+    // A message that doesn't fit is left to the caller
+    std::string second = "second";
+    BOOST_CHECK(!sink.tryPush(std::move(second)));
+    BOOST_CHECK_EQUAL(second, "second");
+
+    while (sink.processOne());
+    BOOST_CHECK(sink.tryPush(std::move(second)));
+    while (sink.processOne());
+
+    BOOST_CHECK_EQUAL(received.size(), 2);
+    BOOST_CHECK_EQUAL(received.at(0), "first");
+    BOOST_CHECK_EQUAL(received.at(1), "second");
+}
+
 namespace Datacratic {
 
 BOOST_AUTO_TEST_CASE( test_typed_message_queue )
@@ -0,0 +1,84 @@
+/* rest_request_binding_test.cc
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   Tests for the extraction of the request parameters.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "soa/service/rest_request_binding.h"
+#include "soa/types/basic_value_descriptions.h"
+#include "soa/types/id.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+
+
+struct BindingTestItem {
+    Id id;
+    std::string name;
+    double price;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(BindingTestItem);
+
+BindingTestItemDescription::
+BindingTestItemDescription()
+{
+    addField("id", &BindingTestItem::id, "");
+    addField("name", &BindingTestItem::name, "");
+    addField("price", &BindingTestItem::price, "");
+}
+
+namespace {
+
+std::shared_ptr<BindingTestItem>
+extract(const std::string & payload)
+{
+    typedef std::shared_ptr<BindingTestItem> Ptr;
+
+    Json::Value help;
+    auto extractor = createParameterExtractor(
+            help, JsonOrBinaryParam<Ptr>("item"));
+
+    RestRequest request("POST", "/v1/items", RestParams(), payload);
+    RestRequestParsingContext context(request);
+    return extractor(RestServiceEndpoint::ConnectionId(), request, context);
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_json_or_binary_param )
+{
+    BindingTestItem item;
+    item.id = Id("abc-123");
+    item.name = "item \"1\"";
+    item.price = 1.25;
+
+    auto check = [&] (const std::shared_ptr<BindingTestItem> & result)
+        {
+            BOOST_REQUIRE(result);
+            BOOST_CHECK_EQUAL(result->id, item.id);
+            BOOST_CHECK_EQUAL(result->name, item.name);
+            BOOST_CHECK_EQUAL(result->price, item.price);
+        };
+
+    auto desc = getDefaultDescriptionShared((BindingTestItem *)0);
+
+    std::stringstream stream;
+    StreamJsonPrintingContext ctx(stream);
+    desc->printJson(&item, ctx);
+    check(extract(stream.str()));
+
+    std::string binary;
+    desc->printBinary(&item, binary);
+    BOOST_REQUIRE(BinaryJson::isBinaryJson(binary.c_str(), binary.size()));
+    check(extract(binary));
+
+    BOOST_CHECK_THROW(extract(binary.substr(0, binary.size() - 1)),
+                      std::exception);
+}
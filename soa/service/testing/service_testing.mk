@@ -19,6 +19,7 @@ $(eval $(call test,zmq_named_pub_sub_test,services,boost manual))
 $(eval $(call test,zmq_endpoint_test,services,boost manual))
 $(eval $(call test,message_channel_test,services,boost))
 $(eval $(call test,rest_service_endpoint_test,services,boost))
+$(eval $(call test,rest_request_binding_test,services,boost))
 $(eval $(call test,multiple_service_test,services,boost manual))
 
 $(eval $(call test,zookeeper_test,cloud,boost manual))
@@ -73,6 +74,7 @@ $(eval $(call test,logs_test,services,boost))
 
 $(eval $(call test,sns_mock_test,cloud services,boost))
 $(eval $(call test,zmq_message_loop_test,services,boost))
+$(eval $(call test,zmq_message_view_test,services,boost))
 
 $(eval $(call test,event_handler_test,cloud services,boost manual))
 #$(eval $(call test,mongo_basic_test,services boost_filesystem mongo_tmp_server,boost manual))
@@ -0,0 +1,114 @@
+/** zmq_message_view_test.cc                                 -*- C++ -*-
+    Copyright (c) 2016 Datacratic.  All rights reserved.
+
+    Tests for the views over zeromq messages and binary frames.
+
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+
+#include "soa/service/zmq_utils.h"
+#include "jml/db/persistent.h"
+#include <sstream>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+
+
+BOOST_AUTO_TEST_CASE( test_message_view )
+{
+    vector<zmq::message_t> frames;
+    frames.push_back(encodeMessage("RESPONSE"));
+    frames.push_back(encodeMessage(string()));
+    frames.push_back(encodeMessage(string("with\0nul", 8)));
+
+    ZmqMessageView message(frames);
+    BOOST_CHECK_EQUAL(message.size(), 3);
+
+    // Frames point into the messages
+    BOOST_CHECK_EQUAL((const void *)message[0].data(), frames[0].data());
+    BOOST_CHECK(message[0] == "RESPONSE");
+    BOOST_CHECK(message[0] != "RESPONSES");
+    BOOST_CHECK(message[0] == string("RESPONSE"));
+    BOOST_CHECK(message[1].empty());
+    BOOST_CHECK_EQUAL(message[2].size(), 8);
+    BOOST_CHECK_EQUAL(message[2].toString(), string("with\0nul", 8));
+    BOOST_CHECK_THROW(message.at(3), ML::Exception);
+
+    vector<string> strings = message.toStrings();
+    BOOST_CHECK_EQUAL(strings.size(), 3);
+    BOOST_CHECK_EQUAL(strings[0], "RESPONSE");
+    BOOST_CHECK_EQUAL(strings[2], string("with\0nul", 8));
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_frames )
+{
+    Date date = Date::fromSecondsSinceEpoch(1476612345.123456);
+    Id intId(123456789);
+    Id stringId("some-auction-id");
+
+    vector<zmq::message_t> frames;
+    frames.push_back(encodeMessage(binaryFrame(42)));
+    frames.push_back(encodeMessage(binaryFrame(uint64_t(1) << 40)));
+    frames.push_back(encodeMessage(binaryFrame(0.25)));
+    frames.push_back(encodeMessage(binaryFrame(date)));
+    frames.push_back(encodeMessage(binaryFrame(intId)));
+    frames.push_back(encodeMessage(binaryFrame(stringId)));
+
+    ZmqMessageView message(frames);
+    BOOST_CHECK_EQUAL(message[0].size(), sizeof(int));
+    BOOST_CHECK_EQUAL(message[0].binary<int>(), 42);
+    BOOST_CHECK_EQUAL(message[1].binary<uint64_t>(), uint64_t(1) << 40);
+    BOOST_CHECK_EQUAL(message[2].binary<double>(), 0.25);
+
+    // Dates keep their full precision, unlike the text encoding
+    BOOST_CHECK_EQUAL(message[3].binary<Date>(), date);
+
+    BOOST_CHECK_EQUAL(message[4].binary<Id>(), intId);
+    BOOST_CHECK_EQUAL(message[5].binary<Id>(), stringId);
+    BOOST_CHECK_EQUAL(message[5].binary<Id>().toString(), "some-auction-id");
+
+    // The size of the frame has to match
+    BOOST_CHECK_THROW(message[0].binary<uint64_t>(), ML::Exception);
+    BOOST_CHECK_THROW(message[1].binary<int>(), ML::Exception);
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_ids )
+{
+    vector<Id> ids = {
+        Id(),
+        Id("null"),
+        Id("0828398c-5965-11e0-84c8-0026b937c8e1"),
+        Id("CAESEAYra3NIxLT9C8twKrzqaA"),
+        Id(uint64_t(7394206091425759590ULL)),
+        Id(string(200, 'x')),
+        Id(Id("compound"), Id(42))
+    };
+
+    for (const Id & id: ids) {
+        zmq::message_t frame = encodeMessage(binaryFrame(id));
+
+        // Ids are framed in their serialized form
+        std::ostringstream stream;
+        ML::DB::Store_Writer store(stream);
+        id.serialize(store);
+        BOOST_CHECK_EQUAL(string((const char *)frame.data(), frame.size()),
+                          stream.str());
+
+        ZmqFrameView view(frame);
+        BOOST_CHECK_EQUAL(view.binary<Id>(), id);
+        BOOST_CHECK_EQUAL(view.binary<Id>().type, id.type);
+
+        // A truncated frame doesn't hold a valid Id
+        if (frame.size() > 2) {
+            zmq::message_t truncated(frame.size() - 1);
+            std::memcpy(truncated.data(), frame.data(), truncated.size());
+            BOOST_CHECK_THROW(ZmqFrameView(truncated).binary<Id>(),
+                              ML::Exception);
+        }
+    }
+}
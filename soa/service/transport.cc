@@ -317,6 +317,7 @@ associate(std::shared_ptr<ConnectionHandler> newSlave)
         if (slave_.get() == newSlave.get())
             throw Exception("re-associating the same slave of type "
                             + ML::type_name(*slave_));
+        slave().onReplace(*newSlave);
         slave().onDisassociate();
     }
 
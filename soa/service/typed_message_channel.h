@@ -8,11 +8,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <queue>
 #include <thread>
 
 #include "jml/utils/ring_buffer.h"
 #include "jml/arch/wakeup_fd.h"
+#include "jml/arch/thread_specific.h"
+#include "jml/arch/spinlock.h"
 #include "soa/service/async_event_source.h"
 
 
@@ -86,6 +91,255 @@ private:
 };
 
 
+/*****************************************************************************/
+/* PER THREAD MESSAGE SINK                                                   */
+/*****************************************************************************/
+
+/** Message sink with the same interface as TypedMessageSink, but where each
+    producing thread pushes into its own single producer, single consumer
+    ring.  Producers never contend with each other and a push is a store
+    into the thread's ring rather than a lock; the eventfd is only written
+    when the consumer has run out of messages and may be going to sleep.
+
+    Messages from a given thread are delivered in order, but there is no
+    ordering between the messages of different threads.
+
+    The bufferSize is the capacity of each thread's ring.  A producer that
+    finds its ring full yields until the consumer has made space.
+*/
+
+template<typename Message>
+struct PerThreadMessageSink: public AsyncEventSource {
+
+    PerThreadMessageSink(size_t bufferSize)
+        : wakeup(EFD_NONBLOCK), bufferSize(bufferSize), pending(false),
+          ringsVersion(0), readerVersion(0), nextRing(0)
+    {
+    }
+
+    std::function<void (Message && message)> onEvent;
+
+    template<typename MessageT>
+    void push(MessageT&& message)
+    {
+        Ring & ring = threadRing();
+        while (!ring.tryPush(std::forward<MessageT>(message))) {
+            signal();
+            std::this_thread::yield();
+        }
+        signal();
+    }
+
+    /** Returns false, leaving the message untouched, if the ring of the
+        thread is full.
+    */
+    template<typename MessageT>
+    bool tryPush(MessageT&& message)
+    {
+        if (!threadRing().tryPush(std::forward<MessageT>(message)))
+            return false;
+        signal();
+        return true;
+    }
+
+    //protected:
+    virtual int selectFd() const
+    {
+        return wakeup.fd();
+    }
+
+    virtual bool poll() const
+    {
+        return couldPop();
+    }
+
+    virtual bool processOne()
+    {
+        Message msg;
+        if (tryPop(msg))
+            onEvent(std::move(msg));
+
+        if (readerCouldPop())
+            return true;
+
+        // We're out of messages.  Producers signal the eventfd again as
+        // soon as they see pending go back to false; anything pushed
+        // before that is picked up by the check that follows.
+        wakeup.tryRead();
+        pending.store(false);
+
+        return readerCouldPop();
+    }
+
+    uint64_t size() const
+    {
+        uint64_t result = 0;
+        std::lock_guard<ML::Spinlock> guard(ringsLock);
+        for (auto & ring: rings)
+            result += ring->size();
+        return result;
+    }
+
+private:
+    /** Single producer, single consumer ring. */
+    struct Ring {
+        Ring(size_t size)
+            : head(0), tail(0), abandoned(false)
+        {
+            size_t capacity = 1;
+            while (capacity < size)
+                capacity *= 2;
+            slots.resize(capacity);
+            mask = capacity - 1;
+        }
+
+        /** The message is only moved from once there is space for it. */
+        template<typename MessageT>
+        bool tryPush(MessageT && message)
+        {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) > mask)
+                return false;
+            slots[h & mask] = std::forward<MessageT>(message);
+            head.store(h + 1);
+            return true;
+        }
+
+        bool tryPop(Message & message)
+        {
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load())
+                return false;
+            message = std::move(slots[t & mask]);
+            slots[t & mask] = Message();
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            return tail.load() == head.load();
+        }
+
+        uint64_t size() const
+        {
+            return head.load() - tail.load();
+        }
+
+        std::vector<Message> slots;
+        uint64_t mask;
+
+        // Padded rather than aligned as operator new doesn't honour
+        // alignment.
+        std::atomic<uint64_t> head;  ///< Next slot to write; producer only
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+        std::atomic<uint64_t> tail;  ///< Next slot to read; consumer only
+        std::atomic<bool> abandoned; ///< Producing thread has exited
+    };
+
+    /** Per thread handle on its ring.  Destroyed when the thread exits,
+        after which the consumer drains and forgets the ring.
+    */
+    struct Producer {
+        ~Producer()
+        {
+            if (ring)
+                ring->abandoned = true;
+        }
+
+        std::shared_ptr<Ring> ring;
+    };
+
+    Ring & threadRing()
+    {
+        Producer * producer = producers.get();
+        if (JML_UNLIKELY(!producer->ring)) {
+            producer->ring = std::make_shared<Ring>(bufferSize);
+            std::lock_guard<ML::Spinlock> guard(ringsLock);
+            rings.push_back(producer->ring);
+            ++ringsVersion;
+        }
+        return *producer->ring;
+    }
+
+    void signal()
+    {
+        if (!pending.load() && !pending.exchange(true))
+            wakeup.signal();
+    }
+
+    /** Pick up the rings of new producers.  Consumer thread only. */
+    void refreshRings()
+    {
+        if (readerVersion != ringsVersion.load()) {
+            std::lock_guard<ML::Spinlock> guard(ringsLock);
+            readerRings = rings;
+            readerVersion = ringsVersion;
+        }
+    }
+
+    /** Pop from the rings in turn.  Consumer thread only. */
+    bool tryPop(Message & message)
+    {
+        refreshRings();
+
+        for (size_t i = 0;  i < readerRings.size();  ++i) {
+            size_t n = nextRing++ % readerRings.size();
+            Ring & ring = *readerRings[n];
+            if (ring.tryPop(message))
+                return true;
+            if (ring.abandoned && ring.empty())
+                forget(readerRings[n]);
+        }
+        return false;
+    }
+
+    /** Lock-free version of couldPop().  Consumer thread only. */
+    bool readerCouldPop()
+    {
+        refreshRings();
+        for (auto & ring: readerRings)
+            if (!ring->empty())
+                return true;
+        return false;
+    }
+
+    bool couldPop() const
+    {
+        std::lock_guard<ML::Spinlock> guard(ringsLock);
+        for (auto & ring: rings)
+            if (!ring->empty())
+                return true;
+        return false;
+    }
+
+    void forget(std::shared_ptr<Ring> ring)
+    {
+        std::lock_guard<ML::Spinlock> guard(ringsLock);
+        auto it = std::find(rings.begin(), rings.end(), ring);
+        if (it != rings.end()) {
+            rings.erase(it);
+            ++ringsVersion;
+        }
+    }
+
+    ML::Wakeup_Fd wakeup;
+    size_t bufferSize;
+    std::atomic<bool> pending;  ///< Consumer has been signalled
+
+    ML::ThreadSpecificInstanceInfo<Producer, PerThreadMessageSink> producers;
+
+    mutable ML::Spinlock ringsLock;
+    std::vector<std::shared_ptr<Ring> > rings;
+    std::atomic<uint64_t> ringsVersion;
+
+    // Consumer side copy of the rings
+    std::vector<std::shared_ptr<Ring> > readerRings;
+    uint64_t readerVersion;
+    size_t nextRing;
+};
+
+
 /*****************************************************************************
  * TYPED MESSAGE QUEUE                                                       *
  *****************************************************************************/
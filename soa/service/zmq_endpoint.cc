@@ -103,6 +103,28 @@ processOne()
     if (!poll())
         return false;
 
+    if (messageViewHandler) {
+        for (;;) {
+            {
+                std::unique_lock<SocketLock> guard;
+                if (socketLock_)
+                    guard = std::unique_lock<SocketLock>(*socketLock_);
+
+                if (!recvAllNonBlocking(socket(), frames)) {
+                    if (currentEvents & ZMQ_POLLIN)
+                        throw ML::Exception("empty message with currentEvents");
+                    return false;  // no more events
+                }
+
+                updateEvents();
+            }
+
+            if (debug_)
+                cerr << "got message of length " << frames.size() << endl;
+            handleMessageView(ZmqMessageView(frames));
+        }
+    }
+
     std::vector<std::string> msg;
 
     // We process all events, as otherwise the select fd can't be guaranteed to wake us up
@@ -131,6 +153,13 @@ processOne()
     return currentEvents & ZMQ_POLLIN;
 }
 
+void
+ZmqEventSource::
+handleMessageView(const ZmqMessageView & message)
+{
+    messageViewHandler(message);
+}
+
 void
 ZmqEventSource::
 handleMessage(const std::vector<std::string> & message)
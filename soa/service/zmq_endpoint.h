@@ -52,6 +52,13 @@ struct ZmqEventSource : public AsyncEventSource {
         SyncMessageHandler;
     SyncMessageHandler syncMessageHandler;
 
+    /** Handler that receives views over the frames of each message instead
+        of copies of them.  When set, it takes precedence over the other
+        handlers.
+    */
+    typedef std::function<void (const ZmqMessageView &)> MessageViewHandler;
+    MessageViewHandler messageViewHandler;
+
     typedef std::mutex SocketLock;
 
     ZmqEventSource();
@@ -109,6 +116,11 @@ struct ZmqEventSource : public AsyncEventSource {
     virtual std::vector<std::string>
     handleSyncMessage(const std::vector<std::string> & message);
 
+    /** Handle a message received without being copied.  The default
+        implementation calls messageViewHandler.
+    */
+    virtual void handleMessageView(const ZmqMessageView & message);
+
     zmq::socket_t & socket() const
     {
         ExcAssert(socket_);
@@ -132,6 +144,9 @@ protected:
 
     /// Mask of current events that are pending on the socket.
     mutable int currentEvents;
+
+    /// Frames of the last message, kept to reuse the vector.
+    std::vector<zmq::message_t> frames;
 };
 
 
@@ -561,6 +576,32 @@ struct ZmqNamedEndpoint : public NamedEndpoint, public MessageLoop {
         }
     }
 
+    /** Receive a message if one is waiting.  Returns an empty message
+        otherwise.  Unlike reading from getSocketUnsafe(), this is safe to
+        call while other threads are sending on the socket.
+    */
+    std::vector<std::string> recvMessageNonBlocking()
+    {
+        std::unique_lock<Lock> guard(lock);
+        ExcAssert(socket_);
+        return recvAllNonBlocking(*socket_);
+    }
+
+    /** Return the file descriptor that zeromq signals when the state of
+        the socket changes (ZMQ_FD).  It is edge triggered, so once it
+        fires recvMessageNonBlocking() should be called until there are no
+        more messages.
+    */
+    int getNotificationFd() const
+    {
+        std::unique_lock<Lock> guard(lock);
+        ExcAssert(socket_);
+        int fd = -1;
+        size_t fdSize = sizeof(fd);
+        socket_->getsockopt(ZMQ_FD, &fd, &fdSize);
+        return fd;
+    }
+
     /** Very unsafe method as it bypasses all thread safety. */
     zmq::socket_t & getSocketUnsafe() const
     {
@@ -575,21 +616,30 @@ struct ZmqNamedEndpoint : public NamedEndpoint, public MessageLoop {
     typedef std::function<void (std::vector<std::string> &&)> MessageHandler;
     MessageHandler messageHandler;
 
+    typedef std::function<void (const ZmqMessageView &)> MessageViewHandler;
+    MessageViewHandler messageViewHandler;
+
     /** Handle a message.  The default implementation will call
-        syncMessageHandler if it is defined; otherwise it converts the message
-        to strings and calls handleMessage.
+        rawMessageHandler if it is defined; otherwise it calls
+        handleMessageView.
     */
     virtual void handleRawMessage(std::vector<zmq::message_t> && message)
     {
         if (rawMessageHandler)
             rawMessageHandler(std::move(message));
-        else {
-            std::vector<std::string> msg2;
-            for (unsigned i = 0;  i < message.size();  ++i) {
-                msg2.push_back(message[i].toString());
-            }
-            handleMessage(std::move(msg2));
-        }
+        else handleMessageView(ZmqMessageView(message));
+    }
+
+    /** Handle a message without copying its frames.  The default
+        implementation will call messageViewHandler if it is defined;
+        otherwise it converts the message to strings and calls
+        handleMessage.
+    */
+    virtual void handleMessageView(const ZmqMessageView & message)
+    {
+        if (messageViewHandler)
+            messageViewHandler(message);
+        else handleMessage(message.toStrings());
     }
 
     virtual void handleMessage(std::vector<std::string> && message)
@@ -746,6 +796,21 @@ struct ZmqNamedClientBus: public ZmqNamedEndpoint {
                                       std::forward<Args>(args)...);
     }
 
+    virtual void handleMessageView(const ZmqMessageView & message)
+    {
+        // Client messages are passed on as they are; only the bus messages
+        // need to be copied.
+        if (clientMessageViewHandler) {
+            ZmqFrameView topic = message.at(1);
+            if (topic != "HEARTBEAT" && topic != "HELLO") {
+                clientMessageViewHandler(message);
+                return;
+            }
+        }
+
+        ZmqNamedEndpoint::handleMessageView(message);
+    }
+
     virtual void handleMessage(std::vector<std::string> && message)
     {
         using namespace std;
@@ -797,6 +862,13 @@ struct ZmqNamedClientBus: public ZmqNamedEndpoint {
     ClientMessageHandler;
     ClientMessageHandler clientMessageHandler;
 
+    /** Handler for client messages that receives views over their frames.
+        When set, clientMessageHandler is not called.
+    */
+    typedef std::function<void (const ZmqMessageView &)>
+    ClientMessageViewHandler;
+    ClientMessageViewHandler clientMessageViewHandler;
+
     virtual void handleClientMessage(const std::vector<std::string> & message)
     {
         if (clientMessageHandler)
@@ -5,9 +5,114 @@
 */
 
 #include "zmq_utils.h"
+#include "jml/db/persistent.h"
+#include "jml/db/compact_size_types.h"
+#include "jml/utils/exc_assert.h"
+#include <cstring>
 
 namespace Datacratic {
 
+namespace {
+
+/* Ids are written in the format of Id::serialize(), straight into the
+   message, so that they can be read back with Id::reconstitute().
+*/
+
+size_t binaryIdSize(const Id & id)
+{
+    size_t result = 2;  // version and type
+
+    switch (id.type) {
+    case Id::NONE:
+    case Id::NULLID:
+        break;
+    case Id::UUID:
+    case Id::UUID_CAPS:
+    case Id::GOOG128:
+    case Id::BIGDEC:
+    case Id::HEX128LC:
+        result += 16;
+        break;
+    case Id::BASE64_96:
+        result += 12;
+        break;
+    case Id::STR:
+        result += ML::DB::compact_encode_length(id.len) + id.len;
+        break;
+    case Id::COMPOUND2:
+        result += binaryIdSize(id.compoundId1())
+            + binaryIdSize(id.compoundId2());
+        break;
+    default:
+        throw ML::Exception("unknown Id type");
+    }
+
+    return result;
+}
+
+void writeBinaryId(char * & p, char * end, const Id & id)
+{
+    *p++ = 1;
+    *p++ = id.type;
+
+    switch (id.type) {
+    case Id::NONE:
+    case Id::NULLID:
+        break;
+    case Id::UUID:
+    case Id::UUID_CAPS:
+    case Id::GOOG128:
+    case Id::BIGDEC:
+    case Id::HEX128LC:
+        std::memcpy(p, &id.val1, 8);
+        std::memcpy(p + 8, &id.val2, 8);
+        p += 16;
+        break;
+    case Id::BASE64_96:
+        std::memcpy(p, &id.val1, 8);
+        std::memcpy(p + 8, &id.val2, 4);
+        p += 12;
+        break;
+    case Id::STR:
+        ML::DB::encode_compact(p, end, id.len);
+        std::memcpy(p, id.str, id.len);
+        p += id.len;
+        break;
+    case Id::COMPOUND2:
+        writeBinaryId(p, end, id.compoundId1());
+        writeBinaryId(p, end, id.compoundId2());
+        break;
+    default:
+        throw ML::Exception("unknown Id type");
+    }
+}
+
+} // file scope
+
+zmq::message_t encodeMessage(const BinaryFrame<Id> & frame)
+{
+    zmq::message_t result(binaryIdSize(frame.value));
+    char * p = (char *)result.data();
+    char * end = p + result.size();
+    writeBinaryId(p, end, frame.value);
+    ExcAssert(p == end);
+    return result;
+}
+
+template<>
+Id
+ZmqFrameView::
+binary<Id>() const
+{
+    ML::DB::Store_Reader store(data_, size_);
+    Id result;
+    result.reconstitute(store);
+    if (store.avail())
+        throw ML::Exception("binary frame has %zd bytes after the Id",
+                            store.avail());
+    return result;
+}
+
 std::string printZmqEvent(int event)
 {
 #define printZmqEventImpl(ev) case ev: return #ev
@@ -12,11 +12,15 @@
 #include <iostream>
 #include <cstdio>
 #include <memory>
+#include <vector>
+#include <cstring>
+#include <type_traits>
 #include <boost/utility.hpp>
 #include "soa/service/zmq.hpp"
 #include "soa/jsoncpp/value.h"
 #include "soa/types/date.h"
 #include "soa/types/string.h"
+#include "soa/types/id.h"
 #include "soa/service/port_range_service.h"
 #include "jml/arch/format.h"
 #include "jml/arch/exception.h"
@@ -140,6 +144,142 @@ recvAllNonBlocking(zmq::socket_t & sock)
     return result;
 }
 
+/*****************************************************************************/
+/* ZMQ MESSAGE VIEWS                                                         */
+/*****************************************************************************/
+
+/** View of one frame of a received message, which references the buffer of
+    the zmq::message_t that holds it rather than copying it.
+*/
+
+struct ZmqFrameView {
+    ZmqFrameView()
+        : data_(nullptr), size_(0)
+    {
+    }
+
+    ZmqFrameView(const zmq::message_t & message)
+        : data_((const char *)message.data()), size_(message.size())
+    {
+    }
+
+    /** View of a frame that was already copied into a string, so that
+        binary frames can be decoded from a std::vector<std::string>.
+    */
+    ZmqFrameView(const std::string & frame)
+        : data_(frame.data()), size_(frame.size())
+    {
+    }
+
+    const char * data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    std::string toString() const { return std::string(data_, size_); }
+
+    bool operator == (const char * other) const
+    {
+        return std::strlen(other) == size_
+            && std::memcmp(data_, other, size_) == 0;
+    }
+
+    bool operator != (const char * other) const
+    {
+        return !operator == (other);
+    }
+
+    bool operator == (const std::string & other) const
+    {
+        return other.size() == size_
+            && std::memcmp(data_, other.data(), size_) == 0;
+    }
+
+    bool operator != (const std::string & other) const
+    {
+        return !operator == (other);
+    }
+
+    /** Decode a frame sent with binaryFrame().  Throws if the size of the
+        frame doesn't match the type.
+    */
+    template<typename T>
+    T binary() const;
+
+private:
+    const char * data_;
+    size_t size_;
+};
+
+inline std::ostream & operator << (std::ostream & stream,
+                                   const ZmqFrameView & frame)
+{
+    return stream.write(frame.data(), frame.size());
+}
+
+/** View of a multipart message.  It only references the frames, which must
+    outlive it, so it is only valid for the duration of the handler it is
+    passed to.
+*/
+
+struct ZmqMessageView {
+    ZmqMessageView(const std::vector<zmq::message_t> & frames)
+        : frames_(&frames)
+    {
+    }
+
+    size_t size() const { return frames_->size(); }
+    bool empty() const { return frames_->empty(); }
+
+    ZmqFrameView operator [] (size_t index) const
+    {
+        return ZmqFrameView((*frames_)[index]);
+    }
+
+    ZmqFrameView at(size_t index) const
+    {
+        if (index >= size())
+            throw ML::Exception("message has no frame %zd: only %zd frames",
+                                index, size());
+        return operator [] (index);
+    }
+
+    /** Copy all of the frames, for handlers that take strings. */
+    std::vector<std::string> toStrings() const
+    {
+        std::vector<std::string> result;
+        result.reserve(size());
+        for (const auto & frame: *frames_)
+            result.emplace_back((const char *)frame.data(), frame.size());
+        return result;
+    }
+
+private:
+    const std::vector<zmq::message_t> * frames_;
+};
+
+/** Receive all of the frames of a message without copying them.  The frames
+    vector is cleared first, which allows it to be reused from one message to
+    the next.  Returns false if no message was waiting.
+*/
+inline bool recvAllNonBlocking(zmq::socket_t & sock,
+                               std::vector<zmq::message_t> & frames)
+{
+    frames.clear();
+
+    int64_t more = 1;
+    size_t more_size = sizeof (more);
+
+    while (more) {
+        zmq::message_t message;
+        bool got = sock.recv(&message, frames.empty() ? ZMQ_NOBLOCK : 0);
+        if (!got) return false;  // no first part available
+        frames.emplace_back(std::move(message));
+        sock.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+    }
+
+    return true;
+}
+
 inline zmq::message_t encodeMessage(const std::string & message)
 {
     return message;
@@ -214,6 +354,77 @@ inline zmq::message_t encodeMessage(const Json::Value & j)
     return chomp(j.toString());
 }
 
+
+/*****************************************************************************/
+/* BINARY FRAMES                                                             */
+/*****************************************************************************/
+
+/** Wrapper that makes encodeMessage() send a number, Date or Id in binary
+    rather than formatting it as text, which saves the formatting and parsing
+    on both ends.  Only to be used where the receiver decodes the frame with
+    ZmqFrameView::binary(), which is why it needs to be asked for explicitly.
+
+    Numbers are sent in the native byte order, as they are everywhere else
+    between rtbkit services; a Date is sent as its seconds since the epoch
+    as a double, and an Id in its serialized form.
+*/
+
+template<typename T>
+struct BinaryFrame {
+    const T & value;
+};
+
+template<typename T>
+BinaryFrame<T> binaryFrame(const T & value)
+{
+    return BinaryFrame<T>{value};
+}
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, zmq::message_t>::type
+encodeMessage(const BinaryFrame<T> & frame)
+{
+    zmq::message_t result(sizeof(T));
+    std::memcpy(result.data(), &frame.value, sizeof(T));
+    return result;
+}
+
+inline zmq::message_t encodeMessage(const BinaryFrame<Date> & frame)
+{
+    double seconds = frame.value.secondsSinceEpoch();
+    return encodeMessage(binaryFrame(seconds));
+}
+
+zmq::message_t encodeMessage(const BinaryFrame<Id> & frame);
+
+template<typename T>
+T
+ZmqFrameView::
+binary() const
+{
+    static_assert(std::is_arithmetic<T>::value,
+                  "binary frames only hold numbers, Dates and Ids");
+    if (size_ != sizeof(T))
+        throw ML::Exception("binary frame has %zd bytes instead of %zd",
+                            size_, sizeof(T));
+    T result;
+    std::memcpy(&result, data_, sizeof(T));
+    return result;
+}
+
+template<>
+inline Date
+ZmqFrameView::
+binary<Date>() const
+{
+    return Date::fromSecondsSinceEpoch(binary<double>());
+}
+
+template<>
+Id
+ZmqFrameView::
+binary<Id>() const;
+
 inline bool sendMesg(zmq::socket_t & sock,
                      const std::string & msg,
                      int options = 0)
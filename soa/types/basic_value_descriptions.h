@@ -7,6 +7,8 @@
 #pragma once
 
 #include <limits>
+#include <atomic>
+#include <thread>
 
 #include "value_description.h"
 #include "soa/types/url.h"
@@ -745,6 +747,189 @@ struct Optional: public std::unique_ptr<T> {
     }
 };
 
+/*****************************************************************************/
+/* LAZY                                                                      */
+/*****************************************************************************/
+
+/** Value that is kept as the JSON text it was parsed from, and only decoded
+    the first time it is accessed.  Meant for the parts of a document that
+    are large and rarely looked at.
+
+    The text is only kept when the parsing context can hand it out without
+    decoding it (see JsonParsingContext::expectRawJson()), which is the case
+    of the IndexedJsonParsingContext used for documents in memory; it costs
+    a copy of the bytes.  Other contexts decode the value straight away.
+    A value that was never decoded is printed back out as the original
+    text when the printing context allows it.
+
+    Const access decodes the value at most once, even when several threads
+    access it at the same time, so a shared object can be read concurrently
+    as if it held a plain T.  Non const access requires exclusive access to
+    the object, as for any other value, and forgets the text since the
+    value may then be modified.
+*/
+
+template<typename T>
+struct Lazy {
+    Lazy()
+        : state(DECODED)
+    {
+    }
+
+    Lazy(T value)
+        : value(std::move(value)), state(DECODED)
+    {
+    }
+
+    Lazy(const Lazy & other)
+        : state(DECODED)
+    {
+        // Wait for a concurrent decoding to finish so that either the text
+        // or the value is in a stable state.  The text never changes
+        // while the object is shared, so it can be copied while another
+        // thread starts decoding it.
+        int otherState;
+        while ((otherState = other.state.load(std::memory_order_acquire))
+               == DECODING)
+            std::this_thread::yield();
+
+        if (otherState == DECODED)
+            value = other.value;
+        else {
+            raw = other.raw;
+            desc = other.desc;
+            state.store(RAW, std::memory_order_relaxed);
+        }
+    }
+
+    Lazy(Lazy && other)
+        : value(std::move(other.value)),
+          raw(std::move(other.raw)),
+          desc(std::move(other.desc)),
+          state(other.state.load(std::memory_order_relaxed))
+    {
+        other.state.store(DECODED, std::memory_order_relaxed);
+    }
+
+    Lazy & operator = (const Lazy & other)
+    {
+        Lazy newMe(other);
+        swap(newMe);
+        return *this;
+    }
+
+    Lazy & operator = (Lazy && other)
+    {
+        Lazy newMe(std::move(other));
+        swap(newMe);
+        return *this;
+    }
+
+    Lazy & operator = (T newValue)
+    {
+        value = std::move(newValue);
+        raw.clear();
+        desc.reset();
+        state.store(DECODED, std::memory_order_relaxed);
+        return *this;
+    }
+
+    void swap(Lazy & other)
+    {
+        using std::swap;
+        swap(value, other.value);
+        raw.swap(other.raw);
+        desc.swap(other.desc);
+        int s = state.load(std::memory_order_relaxed);
+        state.store(other.state.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        other.state.store(s, std::memory_order_relaxed);
+    }
+
+    const T & get() const
+    {
+        if (state.load(std::memory_order_acquire) != DECODED)
+            decode();
+        return value;
+    }
+
+    T & get()
+    {
+        if (state.load(std::memory_order_acquire) != DECODED)
+            decode();
+        raw.clear();
+        desc.reset();
+        return value;
+    }
+
+    const T & operator * () const { return get(); }
+    T & operator * () { return get(); }
+    const T * operator -> () const { return &get(); }
+    T * operator -> () { return &get(); }
+
+    /** Returns true if the value has been decoded, or never was text. */
+    bool decoded() const
+    {
+        return state.load(std::memory_order_acquire) == DECODED;
+    }
+
+    /** Text of the value.  Only meaningful when it hasn't been decoded. */
+    const std::string & rawJson() const
+    {
+        return raw;
+    }
+
+    /** Replace the value by the given JSON text, which will be decoded
+        with the given description on first access.
+    */
+    void setRawJson(std::string json,
+                    std::shared_ptr<const ValueDescriptionT<T> > description)
+    {
+        value = T();
+        raw = std::move(json);
+        desc = std::move(description);
+        state.store(RAW, std::memory_order_release);
+    }
+
+private:
+    enum {
+        RAW,       ///< Only the text is there
+        DECODING,  ///< A thread is decoding the text into the value
+        DECODED    ///< The value is there
+    };
+
+    void decode() const
+    {
+        for (;;) {
+            int current = state.load(std::memory_order_acquire);
+            if (current == DECODED)
+                return;
+
+            if (current == RAW
+                && state.compare_exchange_weak(current, DECODING,
+                                               std::memory_order_acq_rel)) {
+                try {
+                    value = T();
+                    IndexedJsonParsingContext context(raw, "lazy value");
+                    desc->parseJsonTyped(&value, context);
+                } catch (...) {
+                    state.store(RAW, std::memory_order_release);
+                    throw;
+                }
+                state.store(DECODED, std::memory_order_release);
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    mutable T value;
+    std::string raw;
+    std::shared_ptr<const ValueDescriptionT<T> > desc;
+    mutable std::atomic<int> state;
+};
+
 template<typename Cls, int defValue = -1>
 struct TaggedEnum {
     TaggedEnum(int v = defValue)
@@ -1475,6 +1660,63 @@ struct DefaultDescription<Optional<T> >
     }
 };
 
+template<typename T>
+struct DefaultDescription<Lazy<T> >
+    : public ValueDescriptionI<Lazy<T>, ValueKind::ANY> {
+
+    DefaultDescription(ValueDescriptionT<T> * inner)
+        : inner(inner)
+    {
+    }
+
+    DefaultDescription(std::shared_ptr<const ValueDescriptionT<T> > inner
+                       = getDefaultDescriptionShared((T *)0))
+        : inner(inner)
+    {
+    }
+
+    std::shared_ptr<const ValueDescriptionT<T> > inner;
+
+    virtual void parseJsonTyped(Lazy<T> * val,
+                                JsonParsingContext & context) const
+    {
+        const char * start;
+        const char * end;
+        if (context.expectRawJson(start, end)) {
+            val->setRawJson(std::string(start, end), inner);
+            return;
+        }
+
+        T value;
+        inner->parseJsonTyped(&value, context);
+        *val = std::move(value);
+    }
+
+    virtual void printJsonTyped(const Lazy<T> * val,
+                                JsonPrintingContext & context) const
+    {
+        if (!val->decoded()) {
+            const std::string & raw = val->rawJson();
+            if (context.writeRawJson(raw.c_str(), raw.c_str() + raw.size()))
+                return;
+        }
+        inner->printJsonTyped(&val->get(), context);
+    }
+
+    virtual bool isDefaultTyped(const Lazy<T> * val) const
+    {
+        // Checking would mean decoding it
+        if (!val->decoded())
+            return false;
+        return inner->isDefaultTyped(&val->get());
+    }
+
+    virtual const ValueDescription & contained() const
+    {
+        return *inner;
+    }
+};
+
 template<typename T>
 struct DefaultDescription<List<T> >
     : public ValueDescriptionI<List<T>, ValueKind::ARRAY>,
@@ -0,0 +1,871 @@
+/* binary_json.cc
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   Compact binary encoding of the JSON data model.
+*/
+
+#include "binary_json.h"
+#include "jml/arch/format.h"
+
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+
+using namespace std;
+
+
+namespace Datacratic {
+
+using namespace BinaryJson;
+
+
+/*****************************************************************************/
+/* BINARY JSON PRINTING CONTEXT                                              */
+/*****************************************************************************/
+
+BinaryJsonPrintingContext::
+BinaryJsonPrintingContext(std::string & output)
+    : output(output)
+{
+    output.push_back(char(Magic));
+    output.push_back(char(Version));
+}
+
+void
+BinaryJsonPrintingContext::
+writeVarint(uint64_t val)
+{
+    while (val >= 0x80) {
+        output.push_back(char(val | 0x80));
+        val >>= 7;
+    }
+    output.push_back(char(val));
+}
+
+void
+BinaryJsonPrintingContext::
+writeBytes(const char * data, size_t size)
+{
+    output.append(data, size);
+}
+
+void
+BinaryJsonPrintingContext::
+startObject()
+{
+    writeTag(Object);
+}
+
+void
+BinaryJsonPrintingContext::
+startMember(const std::string & memberName)
+{
+    auto it = keys.find(memberName);
+    if (it != keys.end()) {
+        writeVarint(it->second << 2 | 1);
+        return;
+    }
+
+    uint64_t index = keys.size() + tags.size();
+    keys.insert(make_pair(memberName, index));
+
+    writeVarint((uint64_t(memberName.size()) + 1) << 2);
+    writeBytes(memberName.c_str(), memberName.size());
+}
+
+void
+BinaryJsonPrintingContext::
+startField(const char * fieldName, uint32_t tag)
+{
+    auto it = tags.find(tag);
+    if (it != tags.end()) {
+        writeVarint(it->second << 2 | 1);
+        return;
+    }
+
+    uint64_t index = keys.size() + tags.size();
+    tags.insert(make_pair(tag, index));
+
+    // The name is sent too so that readers which don't know the field
+    // can still report it by name
+    size_t size = strlen(fieldName);
+    writeVarint(uint64_t(tag) << 2 | 2);
+    writeVarint(size);
+    writeBytes(fieldName, size);
+}
+
+void
+BinaryJsonPrintingContext::
+endObject()
+{
+    writeVarint(0);
+}
+
+void
+BinaryJsonPrintingContext::
+startArray(int knownSize)
+{
+    writeTag(Array);
+}
+
+void
+BinaryJsonPrintingContext::
+newArrayElement()
+{
+}
+
+void
+BinaryJsonPrintingContext::
+endArray()
+{
+    writeTag(End);
+}
+
+void
+BinaryJsonPrintingContext::
+skip()
+{
+    writeTag(Null);
+}
+
+void
+BinaryJsonPrintingContext::
+writeNull()
+{
+    writeTag(Null);
+}
+
+void
+BinaryJsonPrintingContext::
+writeInt(int i)
+{
+    writeLongLong(i);
+}
+
+void
+BinaryJsonPrintingContext::
+writeUnsignedInt(unsigned int i)
+{
+    writeUnsignedLongLong(i);
+}
+
+void
+BinaryJsonPrintingContext::
+writeLong(long int i)
+{
+    writeLongLong(i);
+}
+
+void
+BinaryJsonPrintingContext::
+writeUnsignedLong(unsigned long int i)
+{
+    writeUnsignedLongLong(i);
+}
+
+void
+BinaryJsonPrintingContext::
+writeLongLong(long long int i)
+{
+    writeTag(Int);
+    writeVarint((uint64_t(i) << 1) ^ uint64_t(i >> 63));
+}
+
+void
+BinaryJsonPrintingContext::
+writeUnsignedLongLong(unsigned long long int i)
+{
+    writeTag(UInt);
+    writeVarint(i);
+}
+
+void
+BinaryJsonPrintingContext::
+writeFloat(float f)
+{
+    writeTag(Float);
+    writeBytes((const char *)&f, sizeof(f));
+}
+
+void
+BinaryJsonPrintingContext::
+writeDouble(double d)
+{
+    writeTag(Double);
+    writeBytes((const char *)&d, sizeof(d));
+}
+
+void
+BinaryJsonPrintingContext::
+writeString(const std::string & s)
+{
+    writeTag(String);
+    writeVarint(s.size());
+    writeBytes(s.c_str(), s.size());
+}
+
+void
+BinaryJsonPrintingContext::
+writeStringUtf8(const Utf8String & s)
+{
+    writeString(s.rawString());
+}
+
+void
+BinaryJsonPrintingContext::
+writeJson(const Json::Value & val)
+{
+    switch (val.type()) {
+    case Json::nullValue:    writeNull();  break;
+    case Json::intValue:     writeLongLong(val.asInt());  break;
+    case Json::uintValue:    writeUnsignedLongLong(val.asUInt());  break;
+    case Json::realValue:    writeDouble(val.asDouble());  break;
+    case Json::stringValue:  writeString(val.asString());  break;
+    case Json::booleanValue: writeBool(val.asBool());  break;
+
+    case Json::arrayValue:
+        startArray(val.size());
+        for (unsigned i = 0;  i < val.size();  ++i) {
+            newArrayElement();
+            writeJson(val[i]);
+        }
+        endArray();
+        break;
+
+    case Json::objectValue:
+        startObject();
+        for (auto it = val.begin(), end = val.end();  it != end;  ++it) {
+            startMember(it.memberName());
+            writeJson(*it);
+        }
+        endObject();
+        break;
+
+    default:
+        throw ML::Exception("unknown JSON value type");
+    }
+}
+
+void
+BinaryJsonPrintingContext::
+writeBool(bool b)
+{
+    writeTag(b ? True : False);
+}
+
+
+/*****************************************************************************/
+/* BINARY JSON PARSING CONTEXT                                               */
+/*****************************************************************************/
+
+BinaryJsonParsingContext::
+BinaryJsonParsingContext(const char * data, size_t size)
+    : start(data), pos(data), end(data + size), currentKey(nullptr)
+{
+    if (!isBinaryJson(data, size))
+        exception("not a binary JSON message");
+
+    version = data[1];
+    if (version != 1 && version != Version)
+        exception(ML::format("unknown binary JSON version %d", int(version)));
+
+    pos += 2;
+}
+
+BinaryJsonParsingContext::
+BinaryJsonParsingContext(const std::string & data)
+    : BinaryJsonParsingContext(data.c_str(), data.size())
+{
+}
+
+void
+BinaryJsonParsingContext::
+exception(const std::string & message)
+{
+    throw ML::Exception("error parsing binary JSON at %s (%s): %s",
+                        printPath().c_str(), getContext().c_str(),
+                        message.c_str());
+}
+
+std::string
+BinaryJsonParsingContext::
+getContext() const
+{
+    return ML::format("offset %lld", (long long)(pos - start));
+}
+
+Tag
+BinaryJsonParsingContext::
+peek() const
+{
+    if (pos == end)
+        const_cast<BinaryJsonParsingContext *>(this)
+            ->exception("unexpected end of message");
+    return Tag(*pos);
+}
+
+Tag
+BinaryJsonParsingContext::
+readTag()
+{
+    Tag tag = peek();
+    ++pos;
+    return tag;
+}
+
+bool
+BinaryJsonParsingContext::
+endOfObject()
+{
+    if (peek() != 0)
+        return false;
+    ++pos;
+    return true;
+}
+
+uint64_t
+BinaryJsonParsingContext::
+readVarint()
+{
+    uint64_t result = 0;
+
+    for (unsigned shift = 0;  shift < 64;  shift += 7) {
+        if (pos == end)
+            exception("truncated varint");
+
+        uint8_t byte = *pos++;
+        result |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return result;
+    }
+
+    exception("varint too long");
+    return 0;
+}
+
+const char *
+BinaryJsonParsingContext::
+readBytes(size_t size)
+{
+    if (size > size_t(end - pos))
+        exception("truncated message");
+
+    const char * result = pos;
+    pos += size;
+    return result;
+}
+
+const BinaryJsonParsingContext::Key &
+BinaryJsonParsingContext::
+readKey()
+{
+    uint64_t key = readVarint();
+
+    if (version == 1) {
+        if (key & 1) {
+            uint64_t index = key >> 1;
+            if (index >= keys.size())
+                exception("reference to unknown member name");
+            return keys[index];
+        }
+
+        if (key == 0)
+            exception("unexpected end of object");
+
+        size_t size = (key >> 1) - 1;
+        const char * data = readBytes(size);
+        keys.push_back(Key{ std::string(data, size), false, 0 });
+        return keys.back();
+    }
+
+    switch (key & 3) {
+    case 1: {
+        uint64_t index = key >> 2;
+        if (index >= keys.size())
+            exception("reference to unknown member name");
+        return keys[index];
+    }
+
+    case 2: {
+        if ((key >> 2) > std::numeric_limits<uint32_t>::max())
+            exception("invalid field tag");
+        uint32_t tag = key >> 2;
+        size_t size = readVarint();
+        const char * data = readBytes(size);
+        keys.push_back(Key{ std::string(data, size), true, tag });
+        return keys.back();
+    }
+
+    case 0:
+        if (key != 0) {
+            size_t size = (key >> 2) - 1;
+            const char * data = readBytes(size);
+            keys.push_back(Key{ std::string(data, size), false, 0 });
+            return keys.back();
+        }
+        exception("unexpected end of object");
+
+    default:
+        exception("invalid member key");
+    }
+
+    return keys.back();  // unreachable
+}
+
+template<typename T>
+T
+BinaryJsonParsingContext::
+expectNumber()
+{
+    switch (readTag()) {
+    case Int: {
+        uint64_t val = readVarint();
+        return T(int64_t(val >> 1) ^ -int64_t(val & 1));
+    }
+    case UInt:
+        return T(readVarint());
+    case Float: {
+        float f;
+        memcpy(&f, readBytes(sizeof(f)), sizeof(f));
+        return T(f);
+    }
+    case Double: {
+        double d;
+        memcpy(&d, readBytes(sizeof(d)), sizeof(d));
+        return T(d);
+    }
+    default:
+        --pos;
+        exception("expected a number");
+        return T();
+    }
+}
+
+int
+BinaryJsonParsingContext::
+expectInt()
+{
+    return expectNumber<long long>();
+}
+
+unsigned int
+BinaryJsonParsingContext::
+expectUnsignedInt()
+{
+    return expectNumber<unsigned long long>();
+}
+
+long
+BinaryJsonParsingContext::
+expectLong()
+{
+    return expectNumber<long long>();
+}
+
+unsigned long
+BinaryJsonParsingContext::
+expectUnsignedLong()
+{
+    return expectNumber<unsigned long long>();
+}
+
+long long
+BinaryJsonParsingContext::
+expectLongLong()
+{
+    return expectNumber<long long>();
+}
+
+unsigned long long
+BinaryJsonParsingContext::
+expectUnsignedLongLong()
+{
+    return expectNumber<unsigned long long>();
+}
+
+float
+BinaryJsonParsingContext::
+expectFloat()
+{
+    return expectNumber<double>();
+}
+
+double
+BinaryJsonParsingContext::
+expectDouble()
+{
+    return expectNumber<double>();
+}
+
+bool
+BinaryJsonParsingContext::
+expectBool()
+{
+    switch (readTag()) {
+    case True: return true;
+    case False: return false;
+    default:
+        --pos;
+        exception("expected a boolean");
+        return false;
+    }
+}
+
+bool
+BinaryJsonParsingContext::
+matchUnsignedLongLong(unsigned long long & val)
+{
+    const char * saved = pos;
+
+    switch (readTag()) {
+    case UInt:
+        val = readVarint();
+        return true;
+
+    case Int: {
+        pos = saved;
+        long long v = expectLongLong();
+        if (v >= 0) {
+            val = v;
+            return true;
+        }
+        break;
+    }
+
+    case Float:
+    case Double: {
+        pos = saved;
+        double d = expectDouble();
+        unsigned long long v = d;
+        if (d >= 0 && v == d) {
+            val = v;
+            return true;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    pos = saved;
+    return false;
+}
+
+bool
+BinaryJsonParsingContext::
+matchLongLong(long long & val)
+{
+    const char * saved = pos;
+
+    switch (readTag()) {
+    case Int:
+        pos = saved;
+        val = expectLongLong();
+        return true;
+
+    case UInt: {
+        uint64_t v = readVarint();
+        if (v <= uint64_t(std::numeric_limits<long long>::max())) {
+            val = v;
+            return true;
+        }
+        break;
+    }
+
+    case Float:
+    case Double: {
+        pos = saved;
+        double d = expectDouble();
+        long long v = d;
+        if (v == d) {
+            val = v;
+            return true;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    pos = saved;
+    return false;
+}
+
+bool
+BinaryJsonParsingContext::
+matchDouble(double & val)
+{
+    if (!isNumber()) return false;
+    val = expectDouble();
+    return true;
+}
+
+void
+BinaryJsonParsingContext::
+expectString(const char * & ptr, size_t & size)
+{
+    if (readTag() != String) {
+        --pos;
+        exception("expected a string");
+    }
+
+    size = readVarint();
+    ptr = readBytes(size);
+}
+
+std::string
+BinaryJsonParsingContext::
+expectStringAscii()
+{
+    const char * ptr;
+    size_t size;
+    expectString(ptr, size);
+    return std::string(ptr, size);
+}
+
+ssize_t
+BinaryJsonParsingContext::
+expectStringAscii(char * value, size_t maxLen)
+{
+    const char * saved = pos;
+
+    const char * ptr;
+    size_t size;
+    expectString(ptr, size);
+
+    if (size >= maxLen) {
+        pos = saved;
+        return -1;
+    }
+
+    memcpy(value, ptr, size);
+    value[size] = '\0';
+    return size;
+}
+
+Utf8String
+BinaryJsonParsingContext::
+expectStringUtf8()
+{
+    return Utf8String(expectStringAscii(), false /* check */);
+}
+
+Json::Value
+BinaryJsonParsingContext::
+expectJson()
+{
+    switch (peek()) {
+    case Null:
+        ++pos;
+        return Json::Value();
+
+    case False:
+    case True:
+        return expectBool();
+
+    case Int:
+        return Json::Value(Json::Int(expectLongLong()));
+
+    case UInt:
+        return Json::Value(Json::UInt(expectUnsignedLongLong()));
+
+    case Float:
+    case Double:
+        return expectDouble();
+
+    case String:
+        return expectStringAscii();
+
+    case Object: {
+        Json::Value result(Json::objectValue);
+        ++pos;
+        while (!endOfObject()) {
+            const Key & key = readKey();
+            result[key.name] = expectJson();
+        }
+        return result;
+    }
+
+    case Array: {
+        Json::Value result(Json::arrayValue);
+        ++pos;
+        while (peek() != End)
+            result.append(expectJson());
+        ++pos;
+        return result;
+    }
+
+    default:
+        exception(ML::format("unknown tag %d", int(peek())));
+        return Json::Value();
+    }
+}
+
+void
+BinaryJsonParsingContext::
+expectNull()
+{
+    if (readTag() != Null) {
+        --pos;
+        exception("expected null");
+    }
+}
+
+bool
+BinaryJsonParsingContext::
+isBool() const
+{
+    Tag tag = peek();
+    return tag == True || tag == False;
+}
+
+bool
+BinaryJsonParsingContext::
+isNumber() const
+{
+    Tag tag = peek();
+    return tag == Int || tag == UInt || tag == Float || tag == Double;
+}
+
+void
+BinaryJsonParsingContext::
+skip()
+{
+    switch (readTag()) {
+    case Null:
+    case False:
+    case True:
+        break;
+
+    case Int:
+    case UInt:
+        readVarint();
+        break;
+
+    case Float:
+        readBytes(sizeof(float));
+        break;
+
+    case Double:
+        readBytes(sizeof(double));
+        break;
+
+    case String:
+        readBytes(readVarint());
+        break;
+
+    case Object:
+        while (!endOfObject()) {
+            readKey();
+            skip();
+        }
+        break;
+
+    case Array:
+        while (peek() != End)
+            skip();
+        ++pos;
+        break;
+
+    default:
+        --pos;
+        exception(ML::format("unknown tag %d", int(peek())));
+    }
+}
+
+std::string
+BinaryJsonParsingContext::
+printCurrent()
+{
+    const char * saved = pos;
+    size_t numKeys = keys.size();
+
+    std::string result = expectJson().toStringNoNewLine();
+
+    // Keys defined inside the current value will be seen again when it's
+    // actually parsed.
+    pos = saved;
+    keys.resize(numKeys);
+
+    return result;
+}
+
+void
+BinaryJsonParsingContext::
+forEachMember(const std::function<void ()> & fn)
+{
+    if (readTag() != Object) {
+        --pos;
+        exception("expected an object");
+    }
+
+    int memberNum = 0;
+
+    while (!endOfObject()) {
+        const Key & key = readKey();
+
+        // This structure takes care of pushing and popping our
+        // path entry.  It will make sure the member is always
+        // popped no matter what
+        struct PathPusher {
+            PathPusher(const char * memberName,
+                       int memberNum,
+                       BinaryJsonParsingContext * context)
+                : context(context)
+            {
+                context->pushPath(memberName, memberNum);
+            }
+
+            ~PathPusher()
+            {
+                context->popPath();
+            }
+
+            BinaryJsonParsingContext * const context;
+        } pusher(key.name.c_str(), memberNum++, this);
+
+        currentKey = &key;
+        fn();
+    }
+}
+
+bool
+BinaryJsonParsingContext::
+memberTag(uint32_t & tag) const
+{
+    if (!currentKey || !currentKey->tagged)
+        return false;
+    tag = currentKey->tag;
+    return true;
+}
+
+void
+BinaryJsonParsingContext::
+forEachElement(const std::function<void ()> & fn)
+{
+    if (readTag() != Array) {
+        --pos;
+        exception("expected an array");
+    }
+
+    int index = 0;
+
+    while (peek() != End) {
+        if (index == 0)
+            pushPath(index);
+        else replacePath(index);
+
+        fn();
+        ++index;
+    }
+
+    if (index != 0)
+        popPath();
+
+    ++pos;
+}
+
+} // namespace Datacratic
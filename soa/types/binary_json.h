@@ -0,0 +1,233 @@
+/* binary_json.h                                                   -*- C++ -*-
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   Compact binary encoding of the JSON data model.
+*/
+
+#pragma once
+
+#include "json_parsing.h"
+#include "json_printing.h"
+
+#include <deque>
+#include <unordered_map>
+
+
+namespace Datacratic {
+
+
+/*****************************************************************************/
+/* BINARY JSON                                                               */
+/*****************************************************************************/
+
+/** Binary encoding of the stream of events produced by a JSON printing
+    context. Any type with a value description can therefore be encoded and
+    decoded without extra code, and the format evolves like JSON does: new
+    fields are ignored or routed to the unknown field handlers by older
+    readers.
+
+    It's cheaper to decode than JSON because there's no number formatting,
+    no string escaping and no whitespace, and member names are only sent the
+    first time they appear in a message.  The fields of structures with a
+    value description also carry their tag
+    (StructureDescriptionBase::fieldTag()), so that readers can look them up
+    directly rather than by name.
+
+    Layout:
+
+        message := Magic Version value
+        value   := Null | False | True
+                 | Int varint(zigzag) | UInt varint | Float f32 | Double f64
+                 | String varint(len) bytes
+                 | Object (key value)* 0
+                 | Array value* End
+        key     := varint((index << 2) | 1)       reference to a previous key
+                 | varint((len + 1) << 2) bytes   new name, gets the next index
+                 | varint((tag << 2) | 2) varint(len) bytes
+                                                  new field tag and its name,
+                                                  gets the next index
+
+    Fixed size numbers are little endian.
+
+    Version 1 had no field tags and encoded keys on one bit instead of two:
+    varint((index << 1) | 1) or varint((len + 1) << 1) bytes.  It can still
+    be read.
+*/
+
+namespace BinaryJson {
+
+enum : uint8_t {
+    Magic = 0xBF,
+    Version = 2
+};
+
+enum Tag : uint8_t {
+    Null   = 0,
+    False  = 1,
+    True   = 2,
+    Int    = 3,
+    UInt   = 4,
+    Float  = 5,
+    Double = 6,
+    String = 7,
+    Object = 8,
+    Array  = 9,
+    End    = 10
+};
+
+/** Content type of HTTP bodies that hold binary JSON. */
+constexpr const char * ContentType = "application/x-binary-json";
+
+/** Returns true if the buffer starts with a binary JSON header. */
+inline bool isBinaryJson(const char * data, size_t size)
+{
+    return size >= 2 && uint8_t(data[0]) == Magic;
+}
+
+} // namespace BinaryJson
+
+
+/*****************************************************************************/
+/* BINARY JSON PRINTING CONTEXT                                              */
+/*****************************************************************************/
+
+/** Printing context which appends the binary encoding of the value to a
+    string.
+*/
+
+struct BinaryJsonPrintingContext
+    : public JsonPrintingContext {
+
+    BinaryJsonPrintingContext(std::string & output);
+
+    std::string & output;
+
+    virtual void startObject();
+    virtual void startMember(const std::string & memberName);
+    virtual void startField(const char * fieldName, uint32_t tag);
+    virtual void endObject();
+
+    virtual void startArray(int knownSize = -1);
+    virtual void newArrayElement();
+    virtual void endArray();
+
+    virtual void skip();
+
+    virtual void writeNull();
+    virtual void writeInt(int i);
+    virtual void writeUnsignedInt(unsigned int i);
+    virtual void writeLong(long int i);
+    virtual void writeUnsignedLong(unsigned long int i);
+    virtual void writeLongLong(long long int i);
+    virtual void writeUnsignedLongLong(unsigned long long int i);
+    virtual void writeFloat(float f);
+    virtual void writeDouble(double d);
+    virtual void writeString(const std::string & s);
+    virtual void writeStringUtf8(const Utf8String & s);
+    virtual void writeJson(const Json::Value & val);
+    virtual void writeBool(bool b);
+
+private:
+    void writeTag(BinaryJson::Tag tag) { output.push_back(char(tag)); }
+    void writeVarint(uint64_t val);
+    void writeBytes(const char * data, size_t size);
+
+    std::unordered_map<std::string, uint64_t> keys;
+    std::unordered_map<uint32_t, uint64_t> tags;
+};
+
+
+/*****************************************************************************/
+/* BINARY JSON PARSING CONTEXT                                               */
+/*****************************************************************************/
+
+/** Parsing context over a buffer produced by BinaryJsonPrintingContext. The
+    buffer must outlive the context.
+*/
+
+struct BinaryJsonParsingContext
+    : public JsonParsingContext {
+
+    BinaryJsonParsingContext(const char * data, size_t size);
+    BinaryJsonParsingContext(const std::string & data);
+
+    virtual void exception(const std::string & message);
+    virtual std::string getContext() const;
+
+    virtual int expectInt();
+    virtual unsigned int expectUnsignedInt();
+    virtual long expectLong();
+    virtual unsigned long expectUnsignedLong();
+    virtual long long expectLongLong();
+    virtual unsigned long long expectUnsignedLongLong();
+
+    virtual float expectFloat();
+    virtual double expectDouble();
+    virtual bool expectBool();
+    virtual bool matchUnsignedLongLong(unsigned long long & val);
+    virtual bool matchLongLong(long long & val);
+    virtual bool matchDouble(double & val);
+    virtual std::string expectStringAscii();
+    virtual ssize_t expectStringAscii(char * value, size_t maxLen);
+    virtual Utf8String expectStringUtf8();
+    virtual Json::Value expectJson();
+    virtual void expectNull();
+
+    virtual bool isObject() const { return peek() == BinaryJson::Object; }
+    virtual bool isString() const { return peek() == BinaryJson::String; }
+    virtual bool isArray() const { return peek() == BinaryJson::Array; }
+    virtual bool isNull() const { return peek() == BinaryJson::Null; }
+    virtual bool isBool() const;
+    virtual bool isNumber() const;
+
+    virtual void skip();
+
+    virtual std::string printCurrent();
+
+    virtual void forEachMember(const std::function<void ()> & fn);
+    virtual void forEachElement(const std::function<void ()> & fn);
+
+    virtual bool memberTag(uint32_t & tag) const;
+
+    /** True once the whole buffer has been consumed. */
+    bool eof() const { return pos == end; }
+
+private:
+    BinaryJson::Tag peek() const;
+    BinaryJson::Tag readTag();
+
+    /** Member of an object, with its field tag if it was written with
+        one.
+    */
+    struct Key {
+        std::string name;
+        bool tagged;
+        uint32_t tag;
+    };
+
+    /** Consumes the terminator if we're at the end of an object's members. */
+    bool endOfObject();
+    uint64_t readVarint();
+    const char * readBytes(size_t size);
+    const Key & readKey();
+
+    /** Reads any number and converts it to T. */
+    template<typename T> T expectNumber();
+
+    /** Reads a string into (ptr, size) without copying it. */
+    void expectString(const char * & ptr, size_t & size);
+
+    const char * start;
+    const char * pos;
+    const char * end;
+    uint8_t version;
+
+    // Keys in order of appearance. A deque is used as the path entries
+    // keep pointers to the names.
+    std::deque<Key> keys;
+
+    // Key of the member whose value is about to be parsed.
+    const Key * currentKey;
+};
+
+} // namespace Datacratic
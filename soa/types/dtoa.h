@@ -9,6 +9,8 @@
 #pragma once
 
 #include <string>
+#include <algorithm>
+#include <cstdio>
 
 extern "C" {
 
@@ -61,45 +63,71 @@ soa_strtod(const char *s00, char **se);
 
 namespace Datacratic {
 
-inline std::string dtoa(double floatVal)
+/** Size of a buffer that can hold any output of dtoa(). */
+enum { DTOA_BUFFER_SIZE = 32 };
+
+/** Print floatVal into buffer, which must have room for at least
+    DTOA_BUFFER_SIZE characters, and return a pointer to just past the
+    last character written.  No null terminator is written.  This avoids
+    the temporary strings of the std::string version below.
+*/
+inline char * dtoa(double floatVal, char * buffer)
 {
     // Use dtoa to make sure we print a value that will be converted
     // back to the same on input, without printing more digits than
     // necessary.
     int decpt;
     int sign;
+    char * end;
 
     char * result = soa_dtoa(floatVal, 1, -1 /* ndigits */,
-                             &decpt, &sign, nullptr);
-    std::string toReturn(result);
-    soa_freedtoa(result);
+                             &decpt, &sign, &end);
+    int numDigits = end - result;
 
-    //cerr << "decpt = " << decpt << " sign = " << sign
-    //     << " result = " << toReturn << " val = " << floatVal
-    //     << endl;
-    if (decpt > 0 && decpt <= toReturn.size())
-        toReturn.insert(decpt, ".");
-    else if (decpt == 9999)
-        ;
+    char * p = buffer;
+    if (sign)
+        *p++ = '-';
+
+    if (decpt > 0 && decpt <= numDigits) {
+        std::copy(result, result + decpt, p);
+        p += decpt;
+        if (decpt < numDigits) {
+            *p++ = '.';
+            std::copy(result + decpt, end, p);
+            p += numDigits - decpt;
+        }
+    }
+    else if (decpt == 9999) {
+        std::copy(result, end, p);
+        p += numDigits;
+    }
     else if (decpt <= 0 && decpt > -6) {
-        toReturn.insert(0, "0.");
-        for (unsigned i = 0;  i < -decpt;  ++i)
-            toReturn.insert(2, "0");
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = 0;  i < -decpt;  ++i)
+            *p++ = '0';
+        std::copy(result, end, p);
+        p += numDigits;
     }
     else {
-        if (toReturn.size() > 1)
-            toReturn.insert(1, ".");
-        toReturn += "e" + std::to_string(decpt - 1);
+        *p++ = result[0];
+        if (numDigits > 1) {
+            *p++ = '.';
+            std::copy(result + 1, end, p);
+            p += numDigits - 1;
+        }
+        p += snprintf(p, buffer + DTOA_BUFFER_SIZE - p, "e%d", decpt - 1);
     }
-        
-    if (sign)
-        toReturn.insert(0, "-");
 
-    if (toReturn.back() == '.') {
-        toReturn.erase(toReturn.size()-1, 1);
-    }
+    soa_freedtoa(result);
 
-    return toReturn;
+    return p;
+}
+
+inline std::string dtoa(double floatVal)
+{
+    char buffer[DTOA_BUFFER_SIZE];
+    return std::string(buffer, dtoa(floatVal, buffer));
 }
 
 
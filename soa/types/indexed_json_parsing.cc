@@ -0,0 +1,871 @@
+/* indexed_json_parsing.cc
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   JSON parsing context driven by a structural index of the document.
+*/
+
+#include "json_parsing.h"
+#include "jml/arch/format.h"
+#include "jml/utils/json_parsing.h"
+#include "jml/utils/exc_assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
+#include <tuple>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+using namespace std;
+
+
+namespace Datacratic {
+
+
+/*****************************************************************************/
+/* STRUCTURAL INDEX                                                          */
+/*****************************************************************************/
+
+namespace {
+
+/** Bit masks of the interesting characters of a 64 byte block; bit i
+    corresponds to the i-th character of the block.
+*/
+struct BlockMasks {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t structurals;   ///< {}[]:,
+};
+
+#if defined(__SSE2__)
+
+BlockMasks classify(const char * block)
+{
+    BlockMasks result = { 0, 0, 0 };
+
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lowercase = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+
+    for (unsigned i = 0;  i < 4;  ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(block + i * 16));
+
+        // '[' and ']' are '{' and '}' without the 0x20 bit.
+        __m128i folded = _mm_or_si128(v, lowercase);
+        __m128i structural
+            = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open),
+                                        _mm_cmpeq_epi8(folded, close)),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, colon),
+                                        _mm_cmpeq_epi8(v, comma)));
+
+        unsigned shift = i * 16;
+        result.quotes |= uint64_t(uint16_t(
+                        _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        result.backslashes |= uint64_t(uint16_t(
+                        _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        result.structurals |= uint64_t(uint16_t(
+                        _mm_movemask_epi8(structural))) << shift;
+    }
+
+    return result;
+}
+
+#else
+
+BlockMasks classify(const char * block)
+{
+    BlockMasks result = { 0, 0, 0 };
+
+    for (unsigned i = 0;  i < 64;  ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+        case '"':  result.quotes |= bit;  break;
+        case '\\': result.backslashes |= bit;  break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            result.structurals |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return result;
+}
+
+#endif
+
+/** Each bit of the result is the parity of the bits of x at or below it,
+    which turns the quotes into a mask of what's inside the strings.
+*/
+uint64_t prefixXor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDelimiter(char c)
+{
+    switch (c) {
+    case ' ': case '\n': case '\r': case '\t':
+    case ',': case '}': case ']': case ':':
+        return true;
+    default:
+        return false;
+    }
+}
+
+void appendUtf8(std::string & output, unsigned code)
+{
+    if (code < 0x80)
+        output.push_back(code);
+    else if (code < 0x800) {
+        output.push_back(0xC0 | (code >> 6));
+        output.push_back(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        output.push_back(0xE0 | (code >> 12));
+        output.push_back(0x80 | ((code >> 6) & 0x3F));
+        output.push_back(0x80 | (code & 0x3F));
+    }
+    else {
+        output.push_back(0xF0 | (code >> 18));
+        output.push_back(0x80 | ((code >> 12) & 0x3F));
+        output.push_back(0x80 | ((code >> 6) & 0x3F));
+        output.push_back(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace anonymous
+
+
+/*****************************************************************************/
+/* INDEXED JSON PARSING CONTEXT                                              */
+/*****************************************************************************/
+
+IndexedJsonParsingContext::
+IndexedJsonParsingContext(const char * data, size_t size,
+                          const std::string & filename)
+    : start(data), end(data + size), pos(data), next(0), filename(filename)
+{
+    index();
+}
+
+IndexedJsonParsingContext::
+IndexedJsonParsingContext(const std::string & data,
+                          const std::string & filename)
+    : IndexedJsonParsingContext(data.c_str(), data.size(), filename)
+{
+}
+
+void
+IndexedJsonParsingContext::
+index()
+{
+    size_t size = end - start;
+    if (size >= std::numeric_limits<uint32_t>::max())
+        exception("document is too large to be indexed");
+
+    structurals.reserve(size / 8 + 16);
+
+    uint64_t escapeCarry = 0;  // first character of the block is escaped
+    uint64_t stringCarry = 0;  // all ones if the block starts in a string
+
+    for (size_t base = 0;  base < size;  base += 64) {
+        const char * block = start + base;
+
+        char padded[64];
+        if (size - base < 64) {
+            memset(padded, ' ', 64);
+            memcpy(padded, block, size - base);
+            block = padded;
+        }
+
+        BlockMasks masks = classify(block);
+
+        // Backslashes are rare enough that walking them one by one beats
+        // doing the odd length sequence arithmetic on every block.
+        uint64_t escaped = escapeCarry;
+        escapeCarry = 0;
+        for (uint64_t b = masks.backslashes;  b;  b &= b - 1) {
+            unsigned i = __builtin_ctzll(b);
+            if (escaped & (uint64_t(1) << i)) continue;
+            if (i == 63) escapeCarry = 1;
+            else escaped |= uint64_t(1) << (i + 1);
+        }
+
+        uint64_t quotes = masks.quotes & ~escaped;
+        uint64_t inString = prefixXor(quotes) ^ stringCarry;
+        stringCarry = uint64_t(int64_t(inString) >> 63);
+
+        uint64_t bits = (masks.structurals & ~inString) | quotes;
+        while (bits) {
+            structurals.push_back(base + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    if (stringCarry) {
+        pos = end;
+        exception("unterminated string");
+    }
+
+    // Pair up the braces and brackets so that skipping a value is O(1).
+    matching.resize(structurals.size());
+    std::vector<uint32_t> open;
+
+    for (size_t i = 0;  i < structurals.size();  ++i) {
+        char c = start[structurals[i]];
+
+        if (c == '{' || c == '[')
+            open.push_back(i);
+        else if (c == '}' || c == ']') {
+            if (open.empty()
+                || start[structurals[open.back()]] != (c == '}' ? '{' : '[')) {
+                pos = start + structurals[i];
+                exception(ML::format("unbalanced '%c'", c));
+            }
+            matching[open.back()] = i;
+            open.pop_back();
+        }
+    }
+
+    if (!open.empty()) {
+        pos = start + structurals[open.back()];
+        exception("unterminated object or array");
+    }
+}
+
+void
+IndexedJsonParsingContext::
+exception(const std::string & message)
+{
+    throw ML::Exception(getContext() + ": " + message);
+}
+
+std::string
+IndexedJsonParsingContext::
+getContext() const
+{
+    size_t line = 1, col = 1;
+    for (const char * p = start;  p < pos && p < end;  ++p) {
+        if (*p == '\n') {
+            ++line;
+            col = 1;
+        }
+        else ++col;
+    }
+
+    return filename + ML::format(":%zd:%zd", line, col) + " at " + printPath();
+}
+
+char
+IndexedJsonParsingContext::
+peek() const
+{
+    while (pos < end && isWhitespace(*pos)) ++pos;
+    return pos < end ? *pos : 0;
+}
+
+void
+IndexedJsonParsingContext::
+expectStructural(char c)
+{
+    if (peek() != c)
+        exception(ML::format("expected '%c'", c));
+
+    ExcAssert(next < structurals.size() && start + structurals[next] == pos);
+    ++pos;
+    ++next;
+}
+
+const char *
+IndexedJsonParsingContext::
+scalarEnd() const
+{
+    const char * p = pos;
+    while (p < end && !isDelimiter(*p)) ++p;
+    return p;
+}
+
+void
+IndexedJsonParsingContext::
+expectRawString(const char * & first, const char * & last, bool & escaped)
+{
+    if (peek() != '"')
+        exception("expected a string");
+
+    // Quotes inside strings are escaped so the closing one is always the
+    // next entry of the index.
+    ExcAssert(next + 1 < structurals.size());
+    first = pos + 1;
+    last = start + structurals[next + 1];
+    escaped = memchr(first, '\\', last - first);
+
+    pos = last + 1;
+    next += 2;
+}
+
+void
+IndexedJsonParsingContext::
+expectString(std::string & output, bool ascii)
+{
+    const char * first;
+    const char * last;
+    bool escaped;
+    expectRawString(first, last, escaped);
+
+    auto checkAscii = [&] (int c) {
+        if (c < 0 || c >= 127)
+            exception("invalid JSON ASCII string character");
+    };
+
+    if (!escaped) {
+        if (ascii) {
+            for (const char * p = first;  p < last;  ++p)
+                checkAscii(*p);
+        }
+        output.assign(first, last);
+        return;
+    }
+
+    output.clear();
+    output.reserve(last - first);
+
+    auto hex4 = [&] (const char * & p) -> unsigned {
+        if (last - p < 4)
+            exception("truncated unicode escape");
+
+        unsigned code = 0;
+        for (unsigned i = 0;  i < 4;  ++i, ++p) {
+            char c = *p;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else exception("invalid unicode escape");
+        }
+        return code;
+    };
+
+    for (const char * p = first;  p < last;) {
+        char c = *p++;
+
+        if (c != '\\') {
+            if (ascii) checkAscii(c);
+            output.push_back(c);
+            continue;
+        }
+
+        if (p == last)
+            exception("invalid escaped char");
+
+        switch (*p++) {
+        case 't':  c = '\t';  break;
+        case 'n':  c = '\n';  break;
+        case 'r':  c = '\r';  break;
+        case 'f':  c = '\f';  break;
+        case 'b':  c = '\b';  break;
+        case '/':  c = '/';   break;
+        case '\\': c = '\\';  break;
+        case '"':  c = '"';   break;
+        case 'u': {
+            unsigned code = hex4(p);
+
+            if (ascii) {
+                if (code > 255)
+                    exception(ML::format("non 8bit char %d", code));
+                checkAscii(code);
+                output.push_back(code);
+                continue;
+            }
+
+            // Combine surrogate pairs into a single code point.
+            if (code >= 0xD800 && code < 0xDC00
+                && last - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                const char * low = p + 2;
+                unsigned code2 = hex4(low);
+                if (code2 >= 0xDC00 && code2 < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (code2 - 0xDC00);
+                    p = low;
+                }
+            }
+
+            appendUtf8(output, code);
+            continue;
+        }
+        default:
+            exception("invalid escaped char");
+        }
+
+        output.push_back(c);
+    }
+}
+
+template<typename T>
+bool
+IndexedJsonParsingContext::
+matchInteger(T & val)
+{
+    if (!peek()) return false;
+
+    const char * p = pos;
+    bool negative = false;
+    if (*p == '-') {
+        if (!std::is_signed<T>::value) return false;
+        negative = true;
+        ++p;
+    }
+
+    const char * digits = p;
+    unsigned long long result = 0;
+    const unsigned long long limit
+        = std::numeric_limits<unsigned long long>::max();
+
+    for (;  p < end && *p >= '0' && *p <= '9';  ++p) {
+        unsigned digit = *p - '0';
+        if (result > (limit - digit) / 10) return false;
+        result = result * 10 + digit;
+    }
+
+    if (p == digits || (p < end && !isDelimiter(*p)))
+        return false;
+
+    unsigned long long max = std::numeric_limits<T>::max();
+    if (negative) {
+        if (result > max + 1) return false;
+        val = result ? T(-T(result - 1) - 1) : T(0);
+    }
+    else {
+        if (result > max) return false;
+        val = T(result);
+    }
+
+    pos = p;
+    return true;
+}
+
+template<typename T>
+T
+IndexedJsonParsingContext::
+expectInteger(const char * type)
+{
+    T result = T();
+    if (!matchInteger(result))
+        exception(ML::format("expected %s", type));
+    return result;
+}
+
+int
+IndexedJsonParsingContext::
+expectInt()
+{
+    return expectInteger<int>("int");
+}
+
+unsigned int
+IndexedJsonParsingContext::
+expectUnsignedInt()
+{
+    return expectInteger<unsigned int>("unsigned int");
+}
+
+long
+IndexedJsonParsingContext::
+expectLong()
+{
+    return expectInteger<long>("long");
+}
+
+unsigned long
+IndexedJsonParsingContext::
+expectUnsignedLong()
+{
+    return expectInteger<unsigned long>("unsigned long");
+}
+
+long long
+IndexedJsonParsingContext::
+expectLongLong()
+{
+    return expectInteger<long long>("long long");
+}
+
+unsigned long long
+IndexedJsonParsingContext::
+expectUnsignedLongLong()
+{
+    return expectInteger<unsigned long long>("unsigned long long");
+}
+
+bool
+IndexedJsonParsingContext::
+matchUnsignedLongLong(unsigned long long & val)
+{
+    return matchInteger(val);
+}
+
+bool
+IndexedJsonParsingContext::
+matchLongLong(long long & val)
+{
+    return matchInteger(val);
+}
+
+bool
+IndexedJsonParsingContext::
+matchDouble(double & val)
+{
+    if (!peek()) return false;
+
+    // Integers are by far the most common numbers and don't need strtod.
+    long long i;
+    if (matchInteger(i)) {
+        val = i;
+        return true;
+    }
+
+    const char * last = scalarEnd();
+    size_t length = last - pos;
+
+    char buffer[64];
+    if (length == 0 || length >= sizeof(buffer)) return false;
+    memcpy(buffer, pos, length);
+    buffer[length] = 0;
+
+    char * parsed;
+    double result = strtod(buffer, &parsed);
+    if (parsed != buffer + length) return false;
+
+    val = result;
+    pos = last;
+    return true;
+}
+
+float
+IndexedJsonParsingContext::
+expectFloat()
+{
+    return expectDouble();
+}
+
+double
+IndexedJsonParsingContext::
+expectDouble()
+{
+    double result;
+    if (!matchDouble(result))
+        exception("expected a number");
+    return result;
+}
+
+bool
+IndexedJsonParsingContext::
+expectBool()
+{
+    peek();
+    const char * last = scalarEnd();
+    size_t length = last - pos;
+
+    if (length == 4 && !memcmp(pos, "true", 4)) {
+        pos = last;
+        return true;
+    }
+    if (length == 5 && !memcmp(pos, "false", 5)) {
+        pos = last;
+        return false;
+    }
+
+    exception("expected a boolean");
+    return false;
+}
+
+void
+IndexedJsonParsingContext::
+expectNull()
+{
+    if (!isNull())
+        exception("expected null");
+    pos += 4;
+}
+
+bool
+IndexedJsonParsingContext::
+isBool() const
+{
+    char c = peek();
+    return c == 't' || c == 'f';
+}
+
+bool
+IndexedJsonParsingContext::
+isNull() const
+{
+    peek();
+    return scalarEnd() - pos == 4 && !memcmp(pos, "null", 4);
+}
+
+bool
+IndexedJsonParsingContext::
+isNumber() const
+{
+    auto self = const_cast<IndexedJsonParsingContext *>(this);
+
+    const char * saved = pos;
+    double d;
+    bool result = self->matchDouble(d);
+    pos = saved;
+    return result;
+}
+
+std::string
+IndexedJsonParsingContext::
+expectStringAscii()
+{
+    std::string result;
+    expectString(result, true /* ascii */);
+    return result;
+}
+
+ssize_t
+IndexedJsonParsingContext::
+expectStringAscii(char * value, size_t maxLen)
+{
+    const char * savedPos = pos;
+    size_t savedNext = next;
+
+    const char * first;
+    const char * last;
+    bool escaped;
+    expectRawString(first, last, escaped);
+
+    size_t length = last - first;
+
+    if (escaped) {
+        pos = savedPos;
+        next = savedNext;
+        std::string result = expectStringAscii();
+        length = result.size();
+        if (length < maxLen)
+            memcpy(value, result.c_str(), length + 1);
+    }
+    else if (length < maxLen) {
+        for (const char * p = first;  p < last;  ++p)
+            if (*p < 0 || *p >= 127)
+                exception("invalid JSON ASCII string character");
+        memcpy(value, first, length);
+        value[length] = 0;
+    }
+
+    if (length >= maxLen) {
+        pos = savedPos;
+        next = savedNext;
+        return -1;
+    }
+
+    return length;
+}
+
+Utf8String
+IndexedJsonParsingContext::
+expectStringUtf8()
+{
+    std::string result;
+    expectString(result, false /* ascii */);
+    return Utf8String(std::move(result));
+}
+
+std::pair<const char *, const char *>
+IndexedJsonParsingContext::
+skipValue()
+{
+    char c = peek();
+    const char * first = pos;
+
+    switch (c) {
+    case '{':
+    case '[': {
+        ExcAssert(next < structurals.size() && start + structurals[next] == pos);
+        size_t close = matching[next];
+        pos = start + structurals[close] + 1;
+        next = close + 1;
+        break;
+    }
+
+    case '"': {
+        const char * s;
+        const char * e;
+        bool escaped;
+        expectRawString(s, e, escaped);
+        break;
+    }
+
+    case 0:
+        exception("unexpected end of input");
+        break;
+
+    default:
+        pos = scalarEnd();
+        if (pos == first)
+            exception(ML::format("unexpected character '%c'", c));
+    }
+
+    return std::make_pair(first, (const char *)pos);
+}
+
+void
+IndexedJsonParsingContext::
+skip()
+{
+    skipValue();
+}
+
+Json::Value
+IndexedJsonParsingContext::
+expectJson()
+{
+    auto value = skipValue();
+    ML::Parse_Context context(filename, value.first, value.second);
+    return ML::expectJson(context);
+}
+
+bool
+IndexedJsonParsingContext::
+expectRawJson(const char * & start, const char * & end)
+{
+    std::tie(start, end) = skipValue();
+    return true;
+}
+
+std::string
+IndexedJsonParsingContext::
+printCurrent()
+{
+    const char * savedPos = pos;
+    size_t savedNext = next;
+
+    std::string result;
+    try {
+        result = boost::trim_copy(expectJson().toString());
+    } catch (const std::exception & exc) {
+        pos = savedPos;
+        result = std::string(pos, std::find(pos, end, '\n'));
+    }
+
+    pos = savedPos;
+    next = savedNext;
+    return result;
+}
+
+void
+IndexedJsonParsingContext::
+forEachMember(const std::function<void ()> & fn)
+{
+    expectStructural('{');
+
+    if (peek() == '}') {
+        expectStructural('}');
+        return;
+    }
+
+    int memberNum = 0;
+
+    for (;;) {
+        // The path entry points to the key so it must outlive fn().  Most
+        // keys fit on the stack, which keeps member lookups (and skipping
+        // unknown members) free of allocations.
+        char buffer[128];
+        std::string longName;
+        const char * memberName = buffer;
+        if (expectStringAscii(buffer, sizeof(buffer)) == -1) {
+            expectString(longName, true /* ascii */);
+            memberName = longName.c_str();
+        }
+        expectStructural(':');
+
+        // This structure takes care of pushing and popping our
+        // path entry.  It will make sure the member is always
+        // popped no matter what
+        struct PathPusher {
+            PathPusher(const char * memberName,
+                       int memberNum,
+                       IndexedJsonParsingContext * context)
+                : context(context)
+            {
+                context->pushPath(memberName, memberNum);
+            }
+
+            ~PathPusher()
+            {
+                context->popPath();
+            }
+
+            IndexedJsonParsingContext * const context;
+        };
+
+        {
+            PathPusher pusher(memberName, memberNum++, this);
+            fn();
+        }
+
+        char c = peek();
+        if (c == ',')
+            expectStructural(',');
+        else if (c == '}') {
+            expectStructural('}');
+            return;
+        }
+        else exception("expected ',' or '}'");
+    }
+}
+
+void
+IndexedJsonParsingContext::
+forEachElement(const std::function<void ()> & fn)
+{
+    expectStructural('[');
+
+    if (peek() == ']') {
+        expectStructural(']');
+        return;
+    }
+
+    for (int index = 0;;  ++index) {
+        if (index == 0)
+            pushPath(index);
+        else replacePath(index);
+
+        fn();
+
+        char c = peek();
+        if (c == ',')
+            expectStructural(',');
+        else if (c == ']') {
+            expectStructural(']');
+            break;
+        }
+        else exception("expected ',' or ']'");
+    }
+
+    popPath();
+}
+
+} // namespace Datacratic
@@ -233,6 +233,27 @@ struct JsonParsingContext {
     
     virtual void forEachMember(const std::function<void ()> & fn) = 0;
     virtual void forEachElement(const std::function<void ()> & fn) = 0;
+
+    /** Binary formats may identify the members of structures by a field
+        tag rather than by name (see JsonPrintingContext::startField()).
+        Returns true and sets tag if the member being parsed was written
+        with one.  Only valid before the member's value is parsed.
+    */
+    virtual bool memberTag(uint32_t & tag) const
+    {
+        return false;
+    }
+
+    /** Contexts over a document that is entirely in memory can consume
+        the next value without decoding it.  Returns true and sets start
+        and end to the text of the value if that is the case; returns false
+        without consuming anything otherwise.  The text is only valid as
+        long as the document is.
+    */
+    virtual bool expectRawJson(const char * & start, const char * & end)
+    {
+        return false;
+    }
 };
 
 
@@ -523,6 +544,113 @@ struct StreamingJsonParsingContext
     }
 };
 
+
+/*****************************************************************************/
+/* INDEXED JSON PARSING CONTEXT                                              */
+/*****************************************************************************/
+
+/** Parsing context over a JSON document that's entirely in memory, which is
+    the case for every bid request that comes off the wire.
+
+    Rather than consuming the input one character at a time, the whole
+    document is first scanned 64 bytes at a time with SIMD compares to build
+    a structural index: the offset of every quote and of every brace,
+    bracket, colon and comma that isn't inside a string, along with the
+    position of the matching closing brace or bracket for every opening one.
+    Strings are then read directly between their two quotes, skip() jumps
+    over whole objects and arrays and only scalars are scanned character by
+    character.
+
+    The buffer must outlive the context.
+*/
+
+struct IndexedJsonParsingContext
+    : public JsonParsingContext {
+
+    IndexedJsonParsingContext(const char * data, size_t size,
+                              const std::string & filename = "<<internal>>");
+    IndexedJsonParsingContext(const std::string & data,
+                              const std::string & filename = "<<internal>>");
+
+    virtual void exception(const std::string & message);
+    virtual std::string getContext() const;
+
+    virtual int expectInt();
+    virtual unsigned int expectUnsignedInt();
+    virtual long expectLong();
+    virtual unsigned long expectUnsignedLong();
+    virtual long long expectLongLong();
+    virtual unsigned long long expectUnsignedLongLong();
+
+    virtual float expectFloat();
+    virtual double expectDouble();
+    virtual bool expectBool();
+    virtual bool matchUnsignedLongLong(unsigned long long & val);
+    virtual bool matchLongLong(long long & val);
+    virtual bool matchDouble(double & val);
+    virtual std::string expectStringAscii();
+    virtual ssize_t expectStringAscii(char * value, size_t maxLen);
+    virtual Utf8String expectStringUtf8();
+    virtual Json::Value expectJson();
+    virtual void expectNull();
+
+    virtual bool isObject() const { return peek() == '{'; }
+    virtual bool isString() const { return peek() == '"'; }
+    virtual bool isArray() const { return peek() == '['; }
+    virtual bool isBool() const;
+    virtual bool isNumber() const;
+    virtual bool isNull() const;
+
+    virtual void skip();
+
+    virtual std::string printCurrent();
+
+    virtual void forEachMember(const std::function<void ()> & fn);
+    virtual void forEachElement(const std::function<void ()> & fn);
+
+    virtual bool expectRawJson(const char * & start, const char * & end);
+
+private:
+    /** Builds the structural index of the document. */
+    void index();
+
+    /** Returns the next non whitespace character, or 0 at the end. */
+    char peek() const;
+
+    /** Consumes the structural character c which must come next. */
+    void expectStructural(char c);
+
+    /** Reads the string starting at the current position, returning its raw
+        contents between the quotes.  escaped is set if it contains escapes.
+    */
+    void expectRawString(const char * & start, const char * & end,
+                         bool & escaped);
+
+    /** Reads a string into output, decoding escapes; ascii restricts the
+        string to 7 bit characters.
+    */
+    void expectString(std::string & output, bool ascii);
+
+    /** Returns the extent of the scalar at the current position. */
+    const char * scalarEnd() const;
+
+    template<typename T> bool matchInteger(T & val);
+    template<typename T> T expectInteger(const char * type);
+
+    /** Consumes the next value and returns the text it spans. */
+    std::pair<const char *, const char *> skipValue();
+
+    const char * start;
+    const char * end;
+    mutable const char * pos;   ///< Current position in the document
+    size_t next;                ///< Next entry of the index after pos
+    std::string filename;
+
+    std::vector<uint32_t> structurals;  ///< Offsets of structural characters
+    std::vector<uint32_t> matching;     ///< Index of closing brace/bracket
+};
+
+
 struct StructuredJsonParsingContext: public JsonParsingContext {
 
     StructuredJsonParsingContext(const Json::Value & val)
@@ -9,6 +9,7 @@
 
 #include "json_printing.h"
 #include "dtoa.h"
+#include <cstring>
 
 using namespace std;
 
@@ -216,6 +217,14 @@ writeJson(const Json::Value & val)
     stream << val.toStringNoNewLine();
 }
 
+bool
+StreamJsonPrintingContext::
+writeRawJson(const char * start, const char * end)
+{
+    stream.write(start, end - start);
+    return true;
+}
+
 void
 StreamJsonPrintingContext::
 writeBool(bool b)
@@ -224,6 +233,327 @@ writeBool(bool b)
 }
 
 
+/*****************************************************************************/
+/* STRING JSON PRINTING CONTEXT                                              */
+/*****************************************************************************/
+
+namespace {
+
+const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/** Append the decimal representation of the given value, two digits at a
+    time.
+*/
+void appendUnsigned(std::string & output, unsigned long long val,
+                    bool negative = false)
+{
+    char buf[24];
+    char * end = buf + sizeof(buf);
+    char * p = end;
+
+    while (val >= 100) {
+        unsigned pair = val % 100;
+        val /= 100;
+        p -= 2;
+        p[0] = digitPairs[pair * 2];
+        p[1] = digitPairs[pair * 2 + 1];
+    }
+    if (val >= 10) {
+        p -= 2;
+        p[0] = digitPairs[val * 2];
+        p[1] = digitPairs[val * 2 + 1];
+    }
+    else *--p = '0' + val;
+
+    if (negative)
+        *--p = '-';
+
+    output.append(p, end);
+}
+
+void appendSigned(std::string & output, long long val)
+{
+    // Negate in unsigned arithmetic so that the minimum value works
+    if (val < 0)
+        appendUnsigned(output, -(unsigned long long)val, true);
+    else appendUnsigned(output, val);
+}
+
+void appendNonFinite(std::string & output, double d)
+{
+    output += '\"';
+    output += (std::isnan(d) ? (std::signbit(d) ? "-nan" : "nan")
+               : (d < 0 ? "-inf" : "inf"));
+    output += '\"';
+}
+
+} // file scope
+
+StringJsonPrintingContext::
+StringJsonPrintingContext(std::string & output)
+    : output(output), writeUtf8(true)
+{
+}
+
+void
+StringJsonPrintingContext::
+writeEscaped(const char * str, size_t length)
+{
+    const char * end = str + length;
+    const char * start = str;
+
+    for (const char * p = str;  p != end;  ++p) {
+        char c = *p;
+        if (c >= ' ' && c < 127 && c != '\"' && c != '\\')
+            continue;
+
+        // Append the unescaped run in one go
+        output.append(start, p);
+        start = p + 1;
+
+        switch (c) {
+        case '\t': output += "\\t";  break;
+        case '\n': output += "\\n";  break;
+        case '\r': output += "\\r";  break;
+        case '\f': output += "\\f";  break;
+        case '\b': output += "\\b";  break;
+        case '\\':
+        case '\"': output += '\\';  output += c;  break;
+        default:
+            throw ML::Exception("Invalid character in JSON string: "
+                                + std::string(str, length));
+        }
+    }
+
+    output.append(start, end);
+}
+
+void
+StringJsonPrintingContext::
+writeMemberName(const char * name, size_t length)
+{
+    ExcAssert(path.back().isObject);
+    ++path.back().memberNum;
+    if (path.back().memberNum != 0)
+        output += ',';
+    output += '\"';
+    writeEscaped(name, length);
+    output += "\":";
+}
+
+void
+StringJsonPrintingContext::
+startObject()
+{
+    path.push_back(true /* isObject */);
+    output += '{';
+}
+
+void
+StringJsonPrintingContext::
+startMember(const std::string & memberName)
+{
+    writeMemberName(memberName.c_str(), memberName.length());
+}
+
+void
+StringJsonPrintingContext::
+startField(const char * fieldName, uint32_t tag)
+{
+    // Avoids the std::string that startMember() would construct
+    writeMemberName(fieldName, strlen(fieldName));
+}
+
+void
+StringJsonPrintingContext::
+endObject()
+{
+    ExcAssert(path.back().isObject);
+    path.pop_back();
+    output += '}';
+}
+
+void
+StringJsonPrintingContext::
+startArray(int knownSize)
+{
+    path.push_back(false /* isObject */);
+    output += '[';
+}
+
+void
+StringJsonPrintingContext::
+newArrayElement()
+{
+    ExcAssert(!path.back().isObject);
+    ++path.back().memberNum;
+    if (path.back().memberNum != 0)
+        output += ',';
+}
+
+void
+StringJsonPrintingContext::
+endArray()
+{
+    ExcAssert(!path.back().isObject);
+    path.pop_back();
+    output += ']';
+}
+    
+void
+StringJsonPrintingContext::
+skip()
+{
+    output += "null";
+}
+
+void
+StringJsonPrintingContext::
+writeNull()
+{
+    output += "null";
+}
+
+void
+StringJsonPrintingContext::
+writeInt(int i)
+{
+    appendSigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeUnsignedInt(unsigned int i)
+{
+    appendUnsigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeLong(long int i)
+{
+    appendSigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeUnsignedLong(unsigned long int i)
+{
+    appendUnsigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeLongLong(long long int i)
+{
+    appendSigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeUnsignedLongLong(unsigned long long int i)
+{
+    appendUnsigned(output, i);
+}
+
+void
+StringJsonPrintingContext::
+writeFloat(float f)
+{
+    writeDouble(f);
+}
+
+void
+StringJsonPrintingContext::
+writeDouble(double d)
+{
+    if (!std::isfinite(d)) {
+        appendNonFinite(output, d);
+        return;
+    }
+
+    char buf[DTOA_BUFFER_SIZE];
+    output.append(buf, Datacratic::dtoa(d, buf));
+}
+
+void
+StringJsonPrintingContext::
+writeString(const std::string & s)
+{
+    output += '\"';
+    writeEscaped(s.c_str(), s.length());
+    output += '\"';
+}
+
+void
+StringJsonPrintingContext::
+writeStringUtf8(const Utf8String & s)
+{
+    output += '\"';
+
+    for (auto it = s.begin(), end = s.end();  it != end;  ++it) {
+        int c = *it;
+        if (c >= ' ' && c < 127 && c != '\"' && c != '\\')
+            output += (char)c;
+        else {
+            switch (c) {
+            case '\t': output += "\\t";  break;
+            case '\n': output += "\\n";  break;
+            case '\r': output += "\\r";  break;
+            case '\b': output += "\\b";  break;
+            case '\f': output += "\\f";  break;
+            case '\\':
+            case '\"': output += '\\';  output += (char)c;  break;
+            default:
+                if (writeUtf8) {
+                    char buf[4];
+                    char * p = utf8::unchecked::append(c, buf);
+                    output.append(buf, p);
+                }
+                else {
+                    ExcAssert(c >= 0 && c < 65536);
+                    output += ML::format("\\u%04x", (unsigned)c);
+                }
+            }
+        }
+    }
+
+    output += '\"';
+}
+
+void
+StringJsonPrintingContext::
+writeJson(const Json::Value & val)
+{
+    output += val.toStringNoNewLine();
+}
+
+bool
+StringJsonPrintingContext::
+writeRawJson(const char * start, const char * end)
+{
+    output.append(start, end);
+    return true;
+}
+
+void
+StringJsonPrintingContext::
+writeBool(bool b)
+{
+    output += (b ? "true": "false");
+}
+
+
 /*****************************************************************************/
 /* STRUCTURED JSON PRINTING CONTEXT                                          */
 /*****************************************************************************/
@@ -9,6 +9,7 @@
 
 #include <string>
 #include <ostream>
+#include <vector>
 
 #include "jml/utils/exc_assert.h"
 #include "jml/utils/json_parsing.h"
@@ -53,6 +54,26 @@ struct JsonPrintingContext {
 
     virtual void writeJson(const Json::Value & val) = 0;
     virtual void skip() = 0;
+
+    /** Starts a member of a structure.  tag is a stable identifier derived
+        from the field name, which binary formats can write instead of the
+        name.
+    */
+    virtual void startField(const char * fieldName, uint32_t tag)
+    {
+        startMember(fieldName);
+    }
+
+    /** Writes out a value that is already in JSON form, as returned by
+        JsonParsingContext::expectRawJson().  Textual contexts copy it as
+        is and return true.  The others return false without writing
+        anything, in which case the value needs to be decoded and printed
+        normally.
+    */
+    virtual bool writeRawJson(const char * start, const char * end)
+    {
+        return false;
+    }
 };
 
 
@@ -118,11 +139,94 @@ struct StreamJsonPrintingContext
     virtual void writeStringUtf8(const Utf8String & s);
 
     virtual void writeJson(const Json::Value & val);
+    virtual bool writeRawJson(const char * start, const char * end);
 
     virtual void writeBool(bool b);
 };
 
 
+/*****************************************************************************/
+/* STRING JSON PRINTING CONTEXT                                              */
+/*****************************************************************************/
+
+/** JSON printing context that appends directly to a string owned by the
+    caller, without going through an ostream.  The output is the same as
+    that of the StreamJsonPrintingContext.
+
+    The string is never cleared, so a buffer with reserved capacity can be
+    reused from one message to the next, or moved into a response once
+    printing is done.
+*/
+
+struct StringJsonPrintingContext
+    : public JsonPrintingContext {
+
+    StringJsonPrintingContext(std::string & output);
+
+    std::string & output;
+    bool writeUtf8;          ///< If true, utf8 chars in binary.  False: escaped ASCII
+
+    struct PathEntry {
+        PathEntry(bool isObject)
+            : isObject(isObject), memberNum(-1)
+        {
+        }
+
+        bool isObject;
+        int memberNum;
+    };
+
+    std::vector<PathEntry> path;
+
+    virtual void startObject();
+
+    virtual void startMember(const std::string & memberName);
+
+    virtual void startField(const char * fieldName, uint32_t tag);
+
+    virtual void endObject();
+
+    virtual void startArray(int knownSize = -1);
+
+    virtual void newArrayElement();
+
+    virtual void endArray();
+    
+    virtual void skip();
+
+    virtual void writeNull();
+
+    virtual void writeInt(int i);
+
+    virtual void writeUnsignedInt(unsigned int i);
+
+    virtual void writeLong(long int i);
+
+    virtual void writeUnsignedLong(unsigned long int i);
+
+    virtual void writeLongLong(long long int i);
+
+    virtual void writeUnsignedLongLong(unsigned long long int i);
+
+    virtual void writeFloat(float f);
+
+    virtual void writeDouble(double d);
+
+    virtual void writeString(const std::string & s);
+
+    virtual void writeStringUtf8(const Utf8String & s);
+
+    virtual void writeJson(const Json::Value & val);
+    virtual bool writeRawJson(const char * start, const char * end);
+
+    virtual void writeBool(bool b);
+
+private:
+    void writeMemberName(const char * name, size_t length);
+    void writeEscaped(const char * str, size_t length);
+};
+
+
 /*****************************************************************************/
 /* STRUCTURED JSON PRINTING CONTEXT                                          */
 /*****************************************************************************/
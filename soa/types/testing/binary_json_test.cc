@@ -0,0 +1,227 @@
+/* binary_json_test.cc
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   Tests for the binary JSON encoding.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "soa/types/binary_json.h"
+#include "soa/types/basic_value_descriptions.h"
+#include "soa/types/id.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+
+
+struct BinaryTestItem {
+    Id id;
+    std::string name;
+    double price;
+    int count;
+    bool active;
+    Json::Value ext;
+    std::vector<std::string> tags;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(BinaryTestItem);
+
+BinaryTestItemDescription::
+BinaryTestItemDescription()
+{
+    addField("id", &BinaryTestItem::id, "");
+    addField("name", &BinaryTestItem::name, "");
+    addField("price", &BinaryTestItem::price, "");
+    addField("count", &BinaryTestItem::count, "");
+    addField("active", &BinaryTestItem::active, "");
+    addField("ext", &BinaryTestItem::ext, "");
+    addField("tags", &BinaryTestItem::tags, "");
+}
+
+/** Older version of BinaryTestItem which doesn't know about some fields. */
+struct BinaryTestItemV0 {
+    Id id;
+    int count;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(BinaryTestItemV0);
+
+BinaryTestItemV0Description::
+BinaryTestItemV0Description()
+{
+    addField("id", &BinaryTestItemV0::id, "");
+    addField("count", &BinaryTestItemV0::count, "");
+}
+
+namespace {
+
+BinaryTestItem makeItem(int i)
+{
+    BinaryTestItem item;
+    item.id = Id(i % 2 ? "abc-" + to_string(i) : to_string(i));
+    item.name = "item \"" + to_string(i) + "\"\n";
+    item.price = i * 1.25;
+    item.count = -i;
+    item.active = i % 3;
+    item.ext["nested"]["values"][0] = i;
+    item.ext["nested"]["values"][1] = -1.5;
+    item.ext["nested"]["flag"] = true;
+    item.ext["big"] = Json::UInt(1ULL << 60);
+    item.tags = { "a", "b", to_string(i) };
+    return item;
+}
+
+template<typename T>
+std::string printJson(const T & val)
+{
+    static DefaultDescription<T> desc;
+    std::ostringstream stream;
+    StreamJsonPrintingContext context(stream);
+    desc.printJsonTyped(&val, context);
+    return stream.str();
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_binary_json_round_trip )
+{
+    DefaultDescription<std::vector<BinaryTestItem> > desc;
+
+    std::vector<BinaryTestItem> items;
+    for (int i = 0;  i < 10;  ++i)
+        items.push_back(makeItem(i));
+
+    std::string binary;
+    BinaryJsonPrintingContext printer(binary);
+    desc.printJsonTyped(&items, printer);
+
+    std::string json = printJson(items);
+    cerr << "json " << json.size() << " bytes, binary "
+         << binary.size() << " bytes" << endl;
+    BOOST_CHECK_LT(binary.size(), json.size());
+
+    std::vector<BinaryTestItem> decoded;
+    BinaryJsonParsingContext parser(binary);
+    desc.parseJsonTyped(&decoded, parser);
+    BOOST_CHECK(parser.eof());
+
+    BOOST_CHECK_EQUAL(printJson(decoded), json);
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_json_unknown_fields )
+{
+    BinaryTestItem item = makeItem(7);
+
+    std::string binary;
+    BinaryJsonPrintingContext printer(binary);
+    BinaryTestItemDescription desc;
+    desc.printJsonTyped(&item, printer);
+
+    // An older reader skips the fields it doesn't know about.
+    BinaryTestItemV0 old;
+    BinaryJsonParsingContext parser(binary);
+
+    std::vector<std::string> unknown;
+    parser.onUnknownFieldHandlers.push_back([&] (const ValueDescription *) {
+                unknown.push_back(parser.fieldName());
+                parser.skip();
+            });
+
+    BinaryTestItemV0Description oldDesc;
+    oldDesc.parseJsonTyped(&old, parser);
+    BOOST_CHECK(parser.eof());
+
+    BOOST_CHECK_EQUAL(old.id, item.id);
+    BOOST_CHECK_EQUAL(old.count, item.count);
+
+    std::vector<std::string> expected = { "name", "price", "active", "ext", "tags" };
+    BOOST_CHECK(unknown == expected);
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_json_version_1 )
+{
+    // {"a": 1, "b": [true], "a": null} as written by version 1, where keys
+    // are encoded on one bit and the third one refers back to the first.
+    const char data[] = {
+        char(BinaryJson::Magic), 1,
+        BinaryJson::Object,
+        (1 + 1) << 1, 'a', BinaryJson::UInt, 1,
+        (1 + 1) << 1, 'b', BinaryJson::Array, BinaryJson::True, BinaryJson::End,
+        (0 << 1) | 1, BinaryJson::Null,
+        0
+    };
+
+    BinaryJsonParsingContext parser(data, sizeof(data));
+    std::vector<std::string> names;
+    parser.forEachMember([&] () {
+            names.push_back(parser.fieldName());
+            parser.skip();
+        });
+    BOOST_CHECK(parser.eof());
+
+    std::vector<std::string> expected = { "a", "b", "a" };
+    BOOST_CHECK(names == expected);
+
+    BinaryJsonParsingContext parser2(data, sizeof(data));
+    Json::Value json = parser2.expectJson();
+    BOOST_CHECK_EQUAL(json["b"][0].asBool(), true);
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_encode_str )
+{
+    BinaryTestItem item = makeItem(3);
+
+    std::string binary = binaryEncodeStr(item);
+    BOOST_CHECK_EQUAL(jsonEncodeStr(binaryDecodeStr<BinaryTestItem>(binary)),
+                      jsonEncodeStr(item));
+
+    // Field tags don't depend on the order or number of fields, so a newer
+    // reader gets the fields an older writer knew about in any order.
+    BinaryTestItemV0 old;
+    old.id = Id("old");
+    old.count = 12;
+
+    BinaryTestItem item2;
+    binaryDecodeStr(binaryEncodeStr(old), item2);
+    BOOST_CHECK_EQUAL(item2.id, old.id);
+    BOOST_CHECK_EQUAL(item2.count, old.count);
+    BOOST_CHECK(item2.tags.empty());
+
+    // Tags are only sent once per message.
+    std::vector<BinaryTestItemV0> olds(10, old);
+    std::string many = binaryEncodeStr(olds);
+    BOOST_CHECK_LT(many.size(), 10 * binaryEncodeStr(old).size());
+    auto decoded = binaryDecodeStr<std::vector<BinaryTestItemV0> >(many);
+    BOOST_REQUIRE_EQUAL(decoded.size(), 10);
+    BOOST_CHECK_EQUAL(decoded[9].id, old.id);
+}
+
+BOOST_AUTO_TEST_CASE( test_binary_json_values )
+{
+    Json::Value val = Json::parse(
+            "{ \"a\": [1, -2, 3.5, \"x\", null, true, false, {}, []],"
+            "  \"b\": { \"a\": 18446744073709551615, \"c\": -9223372036854775807 } }");
+
+    std::string binary;
+    BinaryJsonPrintingContext printer(binary);
+    printer.writeJson(val);
+
+    BinaryJsonParsingContext parser(binary);
+    BOOST_CHECK_EQUAL(parser.printCurrent(), val.toStringNoNewLine());
+    BOOST_CHECK_EQUAL(parser.expectJson(), val);
+    BOOST_CHECK(parser.eof());
+
+    // Truncated messages are reported instead of read past the end.
+    for (size_t i = 0;  i < binary.size();  ++i) {
+        auto parseTruncated = [&] ()
+            {
+                BinaryJsonParsingContext truncated(binary.c_str(), i);
+                truncated.expectJson();
+            };
+        BOOST_CHECK_THROW(parseTruncated(), ML::Exception);
+    }
+}
@@ -0,0 +1,174 @@
+/* indexed_json_parsing_test.cc
+   Copyright (c) 2014 Datacratic Inc.  All rights reserved.
+
+   Tests for the indexed JSON parsing context.
+*/
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "soa/types/json_parsing.h"
+#include "soa/types/basic_value_descriptions.h"
+#include "soa/types/id.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace ML;
+using namespace Datacratic;
+
+
+struct IndexedTestItem {
+    IndexedTestItem()
+        : price(0), count(0), big(0), active(false)
+    {
+    }
+
+    Id id;
+    std::string name;
+    Utf8String text;
+    double price;
+    int count;
+    long long big;
+    bool active;
+    Json::Value ext;
+    std::vector<std::string> tags;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(IndexedTestItem);
+
+IndexedTestItemDescription::
+IndexedTestItemDescription()
+{
+    addField("id", &IndexedTestItem::id, "");
+    addField("name", &IndexedTestItem::name, "");
+    addField("text", &IndexedTestItem::text, "");
+    addField("price", &IndexedTestItem::price, "");
+    addField("count", &IndexedTestItem::count, "");
+    addField("big", &IndexedTestItem::big, "");
+    addField("active", &IndexedTestItem::active, "");
+    addField("ext", &IndexedTestItem::ext, "");
+    addField("tags", &IndexedTestItem::tags, "");
+}
+
+namespace {
+
+/** Unknown fields are skipped so that skip() gets exercised. */
+void skipUnknown(JsonParsingContext & context)
+{
+    context.onUnknownFieldHandlers.push_back([&] (const ValueDescription *)
+                                             { context.skip(); });
+}
+
+IndexedTestItem parseIndexed(const std::string & json)
+{
+    IndexedTestItem result;
+    IndexedJsonParsingContext context(json);
+    skipUnknown(context);
+    IndexedTestItemDescription desc;
+    desc.parseJson(&result, context);
+    return result;
+}
+
+IndexedTestItem parseStreaming(const std::string & json)
+{
+    IndexedTestItem result;
+    StreamingJsonParsingContext context(json, json.c_str(),
+                                        json.c_str() + json.size());
+    skipUnknown(context);
+    IndexedTestItemDescription desc;
+    desc.parseJson(&result, context);
+    return result;
+}
+
+void checkSame(const std::string & json)
+{
+    BOOST_TEST_CHECKPOINT(json);
+
+    IndexedTestItem indexed = parseIndexed(json);
+    IndexedTestItem streaming = parseStreaming(json);
+
+    BOOST_CHECK_EQUAL(indexed.id, streaming.id);
+    BOOST_CHECK_EQUAL(indexed.name, streaming.name);
+    BOOST_CHECK_EQUAL(indexed.text, streaming.text);
+    BOOST_CHECK_EQUAL(indexed.price, streaming.price);
+    BOOST_CHECK_EQUAL(indexed.count, streaming.count);
+    BOOST_CHECK_EQUAL(indexed.big, streaming.big);
+    BOOST_CHECK_EQUAL(indexed.active, streaming.active);
+    BOOST_CHECK_EQUAL(indexed.ext.toString(), streaming.ext.toString());
+    BOOST_CHECK(indexed.tags == streaming.tags);
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE( test_indexed_matches_streaming )
+{
+    checkSame("{}");
+    checkSame("{\"id\":\"abc\",\"name\":\"hello\",\"price\":1.25,"
+              "\"count\":-12,\"big\":9223372036854775807,\"active\":true,"
+              "\"ext\":{\"a\":[1,2,{\"b\":null}],\"c\":\"d\"},"
+              "\"tags\":[\"x\",\"y\",\"z\"]}");
+    checkSame(" {\n  \"count\" : 3 ,\n  \"tags\" : [ ] ,\n"
+              "  \"price\" : -1e-3 ,\"active\" : false }\n");
+
+    // Structural characters and escaped quotes inside strings.
+    checkSame("{\"name\":\"a{b}[c]:d,e\\\"f\\\\\",\"tags\":[\"\\\\\",\"\\\"\"]}");
+
+    // Escapes and multi byte characters.
+    checkSame("{\"name\":\"tab\\tnl\\nslash\\/u\\u0041\","
+              "\"text\":\"\\u00e9 caf\xc3\xa9\"}");
+
+    // Unknown fields are skipped.
+    checkSame("{\"unknown\":{\"x\":[[],[{}],\"]\"]},\"count\":1}");
+
+    // Strings and escapes spanning the 64 byte blocks of the index.
+    for (unsigned padding = 0;  padding < 70;  ++padding) {
+        std::string name(padding, 'p');
+        checkSame("{\"name\":\"" + name + "\\\\\\\"q\",\"tags\":[\""
+                  + name + "\"],\"count\":" + to_string(padding) + "}");
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_indexed_json_value )
+{
+    std::string json = "{\"ext\":{\"a\":[1,2.5,\"x\\u0041\",true,false,null],"
+                       "\"b\":{}}}";
+    IndexedTestItem item = parseIndexed(json);
+    BOOST_CHECK_EQUAL(item.ext["a"][2].asString(), "xA");
+    BOOST_CHECK_EQUAL(item.ext["a"][1].asDouble(), 2.5);
+    BOOST_CHECK(item.ext["b"].isObject());
+
+    // Surrogate pairs are combined into a single code point.
+    item = parseIndexed("{\"text\":\"\\ud83d\\ude00\"}");
+    BOOST_CHECK_EQUAL(item.text.rawString(), "\xf0\x9f\x98\x80");
+}
+
+BOOST_AUTO_TEST_CASE( test_indexed_errors )
+{
+    auto fails = [] (const std::string & json)
+        {
+            BOOST_TEST_CHECKPOINT(json);
+            BOOST_CHECK_THROW(parseIndexed(json), ML::Exception);
+        };
+
+    fails("");
+    fails("{\"name\":\"unterminated}");
+    fails("{\"tags\":[\"x\"}");
+    fails("{\"count\":1");
+    fails("{\"count\":1]}");
+    fails("{\"count\":1x}");
+    fails("{\"count\":99999999999}");
+    fails("{\"name\":1}");
+    fails("{\"active\":truex}");
+    fails("{\"count\":1 \"name\":\"x\"}");
+
+    // The error gives the location and the path in the document.
+    try {
+        parseIndexed("{\"tags\":[\"x\",\n 3]}");
+        BOOST_ERROR("should have thrown");
+    } catch (const ML::Exception & exc) {
+        string what = exc.what();
+        BOOST_CHECK_NE(what.find(":2:2"), string::npos);
+        BOOST_CHECK_NE(what.find("tags"), string::npos);
+    }
+}
@@ -10,6 +10,9 @@
 
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <functional>
+#include <limits>
+#include <cmath>
 #include "jml/db/persistent.h"
 #include "soa/types/string.h"
 #include "soa/types/json_parsing.h"
@@ -63,3 +66,103 @@ BOOST_AUTO_TEST_CASE(test_utf8_round_trip_streaming_ascii)
         BOOST_CHECK_EQUAL(str, str2);
     }
 }
+
+namespace {
+
+/** Print the same things to the stream and the string printing contexts
+    and check that they give the same output.
+*/
+void checkSamePrinting(const std::function<void (JsonPrintingContext &)> & fn)
+{
+    std::ostringstream stream;
+    StreamJsonPrintingContext streamContext(stream);
+    fn(streamContext);
+
+    std::string str = "prefix";
+    StringJsonPrintingContext stringContext(str);
+    fn(stringContext);
+
+    BOOST_CHECK_EQUAL(str, "prefix" + stream.str());
+}
+
+} // file scope
+
+BOOST_AUTO_TEST_CASE(test_string_printing_context)
+{
+    checkSamePrinting([] (JsonPrintingContext & context)
+        {
+            context.startObject();
+            context.startMember("int");
+            context.writeInt(-12345);
+            context.startField("field", 1234);
+            context.writeString("with \"quotes\", \\ and\ttab\n");
+            context.startMember("esc\"aped");
+            context.writeStringUtf8(Utf8String("\xe2\x80\xa2skin \"x\""));
+            context.startMember("array");
+            context.startArray();
+            context.newArrayElement();
+            context.writeNull();
+            context.newArrayElement();
+            context.writeBool(true);
+            context.newArrayElement();
+            context.writeBool(false);
+            context.newArrayElement();
+            context.startObject();
+            context.endObject();
+            context.newArrayElement();
+            context.skip();
+            context.endArray();
+            context.startMember("json");
+            context.writeJson(Json::parse("{\"a\":[1,2]}"));
+            context.endObject();
+        });
+
+    checkSamePrinting([] (JsonPrintingContext & context)
+        {
+            context.startArray();
+            long long ints[] = { 0, 1, -1, 9, 10, 99, 100, 101, 999, 1000,
+                                 12345678, -987654321,
+                                 std::numeric_limits<int>::min(),
+                                 std::numeric_limits<int>::max(),
+                                 std::numeric_limits<long long>::min(),
+                                 std::numeric_limits<long long>::max() };
+            for (long long i: ints) {
+                context.newArrayElement();
+                context.writeLongLong(i);
+                if (i >= std::numeric_limits<int>::min()
+                    && i <= std::numeric_limits<int>::max()) {
+                    context.newArrayElement();
+                    context.writeInt(i);
+                }
+            }
+            context.newArrayElement();
+            context.writeUnsignedLongLong(std::numeric_limits<unsigned long long>::max());
+            context.newArrayElement();
+            context.writeUnsignedInt(std::numeric_limits<unsigned>::max());
+            context.endArray();
+        });
+
+    checkSamePrinting([] (JsonPrintingContext & context)
+        {
+            context.startArray();
+            double doubles[] = { 0.0, -0.0, 1.0, -1.5, 100.0, 0.1, 0.001,
+                                 0.000001, 1e-7, 123456.789, 1e21, 1e23,
+                                 1.7976931348623157e308, 5e-324,
+                                 1.0 / 3.0, 1336313462.550589,
+                                 INFINITY, -INFINITY, NAN };
+            for (double d: doubles) {
+                context.newArrayElement();
+                context.writeDouble(d);
+                context.newArrayElement();
+                context.writeFloat(d);
+            }
+            context.endArray();
+        });
+}
+
+BOOST_AUTO_TEST_CASE(test_string_printing_invalid_character)
+{
+    std::string str;
+    StringJsonPrintingContext context(str);
+    BOOST_CHECK_THROW(context.writeString("bell\x07"), ML::Exception);
+}
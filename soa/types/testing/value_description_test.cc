@@ -10,6 +10,7 @@
 #define BOOST_TEST_DYN_LINK
 #include <sstream>
 #include <string>
+#include <thread>
 #include <boost/lexical_cast.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -394,6 +395,98 @@ S2Description::S2Description()
     addField("val2", &S2::val2, "second value");
 }
 
+BOOST_AUTO_TEST_CASE( test_structure_field_lookup )
+{
+    S2Description desc;
+
+    BOOST_CHECK(desc.hasField(nullptr, "val1"));
+    BOOST_CHECK(desc.hasField(nullptr, "val2"));
+    BOOST_CHECK(!desc.hasField(nullptr, "val"));
+    BOOST_CHECK(!desc.hasField(nullptr, "val12"));
+    BOOST_CHECK(!desc.hasField(nullptr, ""));
+    BOOST_CHECK_EQUAL(desc.getField("val1").fieldName, "val1");
+    BOOST_CHECK_THROW(desc.getField("val3"), ML::Exception);
+
+    S2 s = jsonDecodeStr<S2>("{\"val2\":\"b\",\"val1\":\"a\"}");
+    BOOST_CHECK_EQUAL(s.val1, "a");
+    BOOST_CHECK_EQUAL(s.val2, "b");
+
+    BOOST_CHECK_THROW(jsonDecodeStr<S2>("{\"val3\":\"c\"}"), ML::Exception);
+}
+
+/** Enough fields for the field table to need several seeds. */
+struct ManyFields {
+    int a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p, q, r, s, t;
+    int id, bidfloor, bidfloorcur, secure, instl, tagid, displaymanager;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(ManyFields);
+
+ManyFieldsDescription::ManyFieldsDescription()
+{
+    addField("a", &ManyFields::a, "");
+    addField("b", &ManyFields::b, "");
+    addField("c", &ManyFields::c, "");
+    addField("d", &ManyFields::d, "");
+    addField("e", &ManyFields::e, "");
+    addField("f", &ManyFields::f, "");
+    addField("g", &ManyFields::g, "");
+    addField("h", &ManyFields::h, "");
+    addField("i", &ManyFields::i, "");
+    addField("j", &ManyFields::j, "");
+    addField("k", &ManyFields::k, "");
+    addField("l", &ManyFields::l, "");
+    addField("m", &ManyFields::m, "");
+    addField("n", &ManyFields::n, "");
+    addField("o", &ManyFields::o, "");
+    addField("p", &ManyFields::p, "");
+    addField("q", &ManyFields::q, "");
+    addField("r", &ManyFields::r, "");
+    addField("s", &ManyFields::s, "");
+    addField("t", &ManyFields::t, "");
+    addField("id", &ManyFields::id, "");
+    addField("bidfloor", &ManyFields::bidfloor, "");
+    addField("bidfloorcur", &ManyFields::bidfloorcur, "");
+    addField("secure", &ManyFields::secure, "");
+    addField("instl", &ManyFields::instl, "");
+    addField("tagid", &ManyFields::tagid, "");
+    addField("displaymanager", &ManyFields::displaymanager, "");
+}
+
+BOOST_AUTO_TEST_CASE( test_structure_many_fields )
+{
+    ManyFieldsDescription desc;
+
+    // Every field must be found at its own offset, whatever the order of
+    // the members in the document.
+    std::vector<std::string> members;
+    desc.forEachField(nullptr, [&] (const ValueDescription::FieldDescription & fd)
+                      {
+                          BOOST_CHECK_EQUAL(desc.hasField(nullptr, fd.fieldName), &fd);
+                          members.push_back(ML::format("\"%s\":%zd",
+                                                       fd.fieldName.c_str(),
+                                                       members.size()));
+                      });
+    std::reverse(members.begin(), members.end());
+    std::string json = "{" + boost::algorithm::join(members, ",") + "}";
+    int n = members.size();
+
+    BOOST_CHECK_EQUAL(n, 27);
+
+    ManyFields result;
+    IndexedJsonParsingContext context(json);
+    desc.parseJson(&result, context);
+
+    BOOST_CHECK_EQUAL(result.a, 0);
+    BOOST_CHECK_EQUAL(result.t, 19);
+    BOOST_CHECK_EQUAL(result.id, 20);
+    BOOST_CHECK_EQUAL(result.displaymanager, 26);
+
+    BOOST_CHECK(!desc.hasField(nullptr, "bidfloo"));
+    BOOST_CHECK(!desc.hasField(nullptr, "bidfloorcurr"));
+    BOOST_CHECK(!desc.hasField(nullptr, "u"));
+}
+
 struct RecursiveStructure {
     std::map<std::string, std::shared_ptr<RecursiveStructure> > elements;
     std::vector<std::shared_ptr<RecursiveStructure> > vec;
@@ -440,6 +533,90 @@ BOOST_AUTO_TEST_CASE( test_recursive_description )
     BOOST_CHECK_EQUAL(j, j2);
 }
 
+struct LazyStructure {
+    int id;
+    Lazy<std::vector<int> > values;
+    Lazy<Optional<SomeTestStructure> > sub;
+};
+
+CREATE_STRUCTURE_DESCRIPTION(LazyStructure);
+
+LazyStructureDescription::LazyStructureDescription()
+{
+    addField("id", &LazyStructure::id, "id");
+    addField("values", &LazyStructure::values, "rarely used values");
+    addField("sub", &LazyStructure::sub, "rarely used structure");
+}
+
+BOOST_AUTO_TEST_CASE( test_lazy_description )
+{
+    LazyStructureDescription desc;
+    string json = "{\"id\":1,\"values\":[ 1, 2, 3 ],"
+        "\"sub\":{\"someId\":\"hello\",\"someText\":\"world\"}}";
+
+    // In memory documents keep the text of the lazy fields
+    LazyStructure s;
+    {
+        IndexedJsonParsingContext context(json);
+        desc.parseJson(&s, context);
+    }
+    BOOST_CHECK_EQUAL(s.id, 1);
+    BOOST_CHECK(!s.values.decoded());
+    BOOST_CHECK_EQUAL(s.values.rawJson(), "[ 1, 2, 3 ]");
+    BOOST_CHECK(!s.sub.decoded());
+
+    // and print it back out as it was
+    BOOST_CHECK_EQUAL(jsonEncodeStr(s), json);
+
+    // Copies are still undecoded
+    LazyStructure copy = s;
+    BOOST_CHECK(!copy.values.decoded());
+
+    // Decoding happens on access, from any number of threads at once
+    const LazyStructure & cs = s;
+    std::vector<std::thread> threads;
+    for (unsigned i = 0;  i < 4;  ++i) {
+        threads.emplace_back([&] ()
+            {
+                BOOST_CHECK_EQUAL(cs.values->size(), 3);
+                BOOST_CHECK_EQUAL(cs.sub.get()->someText, "world");
+            });
+    }
+    for (auto & thread: threads)
+        thread.join();
+
+    BOOST_CHECK(s.values.decoded());
+    BOOST_CHECK_EQUAL(s.values->at(2), 3);
+    BOOST_CHECK_EQUAL(s.sub.get()->someId, Id("hello"));
+    BOOST_CHECK_EQUAL(copy.values->at(0), 1);
+
+    // Modified values are printed from the value
+    s.values->push_back(4);
+    BOOST_CHECK_EQUAL(jsonEncode(s)["values"].size(), 4);
+
+    // Streaming contexts decode straight away
+    LazyStructure s2;
+    {
+        StreamingJsonParsingContext context(json, json.c_str(),
+                                            json.c_str() + json.size());
+        desc.parseJson(&s2, context);
+    }
+    BOOST_CHECK(s2.values.decoded());
+    BOOST_CHECK_EQUAL(s2.values->size(), 3);
+    BOOST_CHECK(s2.sub.decoded());
+
+    // Errors are only reported when the value is decoded
+    LazyStructure bad;
+    {
+        string badJson = "{\"id\":1,\"values\":[ 1, \"two\" ]}";
+        IndexedJsonParsingContext context(badJson);
+        desc.parseJson(&bad, context);
+    }
+    const LazyStructure & cbad = bad;
+    BOOST_CHECK_THROW(cbad.values.get(), std::exception);
+    BOOST_CHECK(!bad.values.decoded());
+}
+
 BOOST_AUTO_TEST_CASE( test_date_value_description )
 {
     auto desc = DefaultDescription<Date>();
@@ -32,7 +32,9 @@ $(eval $(call library,types,$(LIBTYPES_SOURCES),$(LIBTYPES_LINK)))
 LIBVALUE_DESCRIPTION_SOURCES := \
 	value_description.cc \
 	json_parsing.cc \
+	indexed_json_parsing.cc \
 	json_printing.cc \
+	binary_json.cc \
 	periodic_utils_value_descriptions.cc
 
 LIBVALUE_DESCRIPTION_LINK := \
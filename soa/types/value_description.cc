@@ -13,6 +13,7 @@
 #endif
 #include "jml/utils/exc_assert.h"
 #include "value_description.h"
+#include "binary_json.h"
 
 using namespace std;
 using namespace ML;
@@ -95,6 +96,22 @@ registerValueDescription(const std::type_info & type,
 #endif
 }
 
+void
+ValueDescription::
+printBinary(const void * val, std::string & output) const
+{
+    BinaryJsonPrintingContext context(output);
+    printJson(val, context);
+}
+
+void
+ValueDescription::
+parseBinary(void * val, const char * data, size_t size) const
+{
+    BinaryJsonParsingContext context(data, size);
+    parseJson(val, context);
+}
+
 void
 ValueDescription::
 convertAndCopy(const void * from,
@@ -108,4 +125,56 @@ convertAndCopy(const void * from,
     parseJson(to, context2);
 }
 
+
+/*****************************************************************************/
+/* STRUCTURE DESCRIPTION BASE                                                */
+/*****************************************************************************/
+
+void
+StructureDescriptionBase::
+indexFields()
+{
+    // Fields with the same tag couldn't be told apart in binary formats, and
+    // no seed would separate them.
+    std::unordered_map<uint32_t, const char *> tags;
+    for (auto & f: fields) {
+        auto res = tags.insert(make_pair(fieldTag(f.first), f.first));
+        if (!res.second)
+            throw ML::Exception("fields '%s' and '%s' of %s have the same tag",
+                                res.first->second, f.first, structName.c_str());
+    }
+
+    // With a table at least four times the number of fields, a random seed
+    // has a good chance of being collision free even for the 40 odd fields
+    // of the larger OpenRTB objects; if none is found, the table grows.
+    size_t size = 4;
+    while (size < 4 * fields.size())
+        size *= 2;
+
+    for (;;  size *= 2) {
+        for (uint32_t seed = 0;  seed < 256;  ++seed) {
+            std::vector<FieldSlot> table(size, FieldSlot{ nullptr, 0, nullptr });
+
+            bool collision = false;
+            for (auto & f: fields) {
+                uint32_t tag = fieldTag(f.first);
+                FieldSlot & slot = table[fieldSlot(tag, seed) & (size - 1)];
+                if (slot.name) {
+                    collision = true;
+                    break;
+                }
+                slot.name = f.first;
+                slot.tag = tag;
+                slot.field = &f.second;
+            }
+
+            if (!collision) {
+                fieldTable.swap(table);
+                fieldSeed = seed;
+                return;
+            }
+        }
+    }
+}
+
 } // namespace Datacratic
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <string>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <set>
@@ -107,6 +108,17 @@ struct ValueDescription {
 
     virtual void parseJson(void * val, JsonParsingContext & context) const = 0;
     virtual void printJson(const void * val, JsonPrintingContext & context) const = 0;
+
+    /** Appends the binary encoding of the value (see binary_json.h) to
+        output.  Structure fields are written as tags, so the encoding is
+        compatible both ways between versions of a structure in the same
+        way as JSON is.
+    */
+    void printBinary(const void * val, std::string & output) const;
+
+    /** Parses a value encoded by printBinary(). */
+    void parseBinary(void * val, const char * data, size_t size) const;
+
     virtual bool isDefault(const void * val) const = 0;
     virtual void setDefault(void * val) const = 0;
     virtual void copyValue(const void * from, void * to) const = 0;
@@ -190,6 +202,7 @@ struct ValueDescription {
         std::shared_ptr<const ValueDescription > description;
         int offset;
         int fieldNum;
+        uint32_t fieldTag;      ///< Identifies the field in binary formats
 
         void* getFieldPtr(void* obj) const
         {
@@ -750,7 +763,8 @@ struct StructureDescriptionBase {
         : type(type),
           structName(structName.empty() ? ML::demangle(type->name()) : structName),
           nullAccepted(nullAccepted),
-          owner(owner)
+          owner(owner),
+          fieldSeed(0)
     {
     }
 
@@ -787,10 +801,76 @@ struct StructureDescriptionBase {
     typedef std::map<const char *, FieldDescription, StrCompare> Fields;
     Fields fields;
 
-    std::vector<std::string> fieldNames;
+    // The keys of fields point into here, so it must never move its
+    // elements around.
+    std::deque<std::string> fieldNames;
 
     std::vector<Fields::const_iterator> orderedFields;
 
+    /** Tag of a field, which is a hash of its name.  Binary formats write
+        it in place of the name; as it only depends on the name, adding or
+        reordering fields doesn't change the tags of the others.
+    */
+    static uint32_t fieldTag(const char * name)
+    {
+        uint32_t h = 2166136261u;
+        for (;  *name;  ++name)
+            h = (h ^ uint8_t(*name)) * 16777619u;
+        return h ^ (h >> 16);
+    }
+
+    /** Slot of a field tag in the field table for the given seed. */
+    static uint32_t fieldSlot(uint32_t tag, uint32_t seed)
+    {
+        uint32_t h = (tag ^ seed) * 0x9e3779b1u;
+        return h ^ (h >> 16);
+    }
+
+    struct FieldSlot {
+        const char * name;
+        uint32_t tag;
+        const FieldDescription * field;
+    };
+
+    /** Collision free hash table of the fields, rebuilt by indexFields()
+        every time a field is added.  Looking up a member name costs one
+        hash and one strcmp, instead of a walk down the fields map.
+    */
+    std::vector<FieldSlot> fieldTable;
+    uint32_t fieldSeed;
+
+    /** Rebuilds fieldTable by looking for a seed under which none of the
+        field tags collide.
+    */
+    void indexFields();
+
+    /** Returns the field with the given name, or null if there is none. */
+    const FieldDescription * findField(const char * name) const
+    {
+        if (fieldTable.empty())
+            return nullptr;
+
+        uint32_t tag = fieldTag(name);
+        const FieldSlot & slot
+            = fieldTable[fieldSlot(tag, fieldSeed) & (fieldTable.size() - 1)];
+        if (slot.name && slot.tag == tag && strcmp(slot.name, name) == 0)
+            return slot.field;
+        return nullptr;
+    }
+
+    /** Returns the field with the given tag, or null if there is none. */
+    const FieldDescription * findFieldTag(uint32_t tag) const
+    {
+        if (fieldTable.empty())
+            return nullptr;
+
+        const FieldSlot & slot
+            = fieldTable[fieldSlot(tag, fieldSeed) & (fieldTable.size() - 1)];
+        if (slot.name && slot.tag == tag)
+            return slot.field;
+        return nullptr;
+    }
+
     struct Exception: public ML::Exception {
         Exception(JsonParsingContext & context,
                   const std::string & message)
@@ -820,15 +900,16 @@ struct StructureDescriptionBase {
             auto onMember = [&] ()
                 {
                     try {
-                        auto n = context.fieldNamePtr();
-                        auto it = fields.find(n);
-                        if (it == fields.end()) {
+                        uint32_t tag;
+                        auto fd = context.memberTag(tag)
+                            ? findFieldTag(tag)
+                            : findField(context.fieldNamePtr());
+                        if (!fd) {
                             context.onUnknownField(owner);
                         }
                         else {
-                            it->second.description
-                                ->parseJson(addOffset(output,
-                                                      it->second.offset),
+                            fd->description
+                                ->parseJson(addOffset(output, fd->offset),
                                             context);
                         }
                     }
@@ -868,7 +949,7 @@ struct StructureDescriptionBase {
             auto mbr = addOffset(input, fd.offset);
             if (fd.description->isDefault(mbr))
                 continue;
-            context.startMember(it->first);
+            context.startField(it->first, fd.fieldTag);
             fd.description->printJson(mbr, context);
         }
         
@@ -971,12 +1052,14 @@ struct StructureDescription
         
         FieldDescription & fd = it->second;
         fd.fieldName = fieldName;
+        fd.fieldTag = fieldTag(fieldName);
         fd.comment = comment;
         fd.description = description;
         Struct * p = nullptr;
         fd.offset = (size_t)&(p->*field);
         fd.fieldNum = fields.size() - 1;
         orderedFields.push_back(it);
+        indexFields();
         //using namespace std;
         //cerr << "offset = " << fd.offset << endl;
     }
@@ -1006,10 +1089,7 @@ struct StructureDescription
     virtual const FieldDescription *
     hasField(const void * val, const std::string & field) const
     {
-        auto it = fields.find(field.c_str());
-        if (it != fields.end())
-            return &it->second;
-        return nullptr;
+        return findField(field.c_str());
     }
 
     virtual void forEachField(const void * val,
@@ -1023,9 +1103,8 @@ struct StructureDescription
     virtual const FieldDescription & 
     getField(const std::string & field) const
     {
-        auto it = fields.find(field.c_str());
-        if (it != fields.end())
-            return it->second;
+        if (auto fd = findField(field.c_str()))
+            return *fd;
         throw ML::Exception("structure has no field " + field);
     }
 
@@ -1112,6 +1191,7 @@ addParent(ValueDescriptionT<V> * description_)
         auto it = fields.insert(Fields::value_type(fieldName, std::move(FieldDescription()))).first;
         FieldDescription & fd = it->second;
         fd.fieldName = fieldName;
+        fd.fieldTag = ofd.fieldTag;
         fd.comment = ofd.comment;
         fd.description = std::move(ofd.description);
         
@@ -1119,6 +1199,8 @@ addParent(ValueDescriptionT<V> * description_)
         fd.fieldNum = fields.size() - 1;
         orderedFields.push_back(it);
     }
+
+    indexFields();
 }
 
 
@@ -1772,7 +1854,7 @@ T jsonDecodeStr(const std::string & json, T * = 0,
     T result;
 
     static auto desc = getDefaultDescriptionShared<T>();
-    StreamingJsonParsingContext context(json, json.c_str(), json.c_str() + json.size());
+    IndexedJsonParsingContext context(json);
     desc->parseJson(&result, context);
     return result;
 }
@@ -1862,10 +1944,10 @@ std::string jsonEncodeStr(const T & obj,
                           typename std::enable_if<!hasToJson<T>::value>::type * = 0)
 {
     static auto desc = getDefaultDescriptionShared<T>();
-    std::ostringstream stream;
-    StreamJsonPrintingContext context(stream);
+    std::string result;
+    StringJsonPrintingContext context(result);
     desc->printJson(&obj, context);
-    return std::move(stream.str());
+    return result;
 }
 
 // jsonEncode implementation for any type which:
@@ -1888,6 +1970,36 @@ inline Json::Value jsonEncode(const char * str)
     return str;
 }
 
+// Binary encoding for any type which has a default description.
+template<typename T>
+std::string binaryEncodeStr(const T & obj,
+                            decltype(getDefaultDescription((T *)0)) * = 0)
+{
+    static auto desc = getDefaultDescriptionShared<T>();
+    std::string result;
+    desc->printBinary(&obj, result);
+    return result;
+}
+
+// Binary decoding for any type which has a default description.
+template<typename T>
+T binaryDecodeStr(const std::string & data, T * = 0,
+                  decltype(getDefaultDescription((T *)0)) * = 0)
+{
+    T result;
+
+    static auto desc = getDefaultDescriptionShared<T>();
+    desc->parseBinary(&result, data.c_str(), data.size());
+    return result;
+}
+
+// In-place binary decoding
+template<typename T>
+void binaryDecodeStr(const std::string & data, T & val)
+{
+    val = std::move(binaryDecodeStr(data, (T *)0));
+}
+
 } // namespace Datacratic
 
 